@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Alpha-beta tracker for the temperature probes. Each reading is
+// compared with where the last estimate said the vessel would be by
+// now; a fraction alpha of the difference corrects the temperature and a
+// fraction beta (per unit time) corrects the rate of rise. The result is
+// smoother than the probe's 1/16 degree steps, gives a rate of rise
+// without differencing noisy readings, and can be projected forward to
+// any time between conversions.
+//
+// Fixed point, and uses the measured time between readings, so it copes
+// with conversions that run late. Runs on the host too
+// (host/abfilter_bench.c).
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "abfilter.h"
+
+void ab_reset(struct ab_filter *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+// change over dt ms at rate_q
+static int32_t ab_rise_q(int32_t rate_q, int32_t dt)
+{
+    return (int32_t)(((int64_t)rate_q * dt / 1000) >> (AB_RATE_Q - AB_Q));
+}
+
+void ab_update(struct ab_filter *f, int32_t c100, unsigned long time)
+{
+    int32_t dt = (int32_t)(time - f->time);
+    int32_t predicted, residual;
+
+    if (!f->primed || dt <= 0)
+    {
+        f->temp_q = c100 << AB_Q;
+        f->rate_q = 0;
+        f->time = time;
+        f->primed = 1;
+        return;
+    }
+
+    predicted = f->temp_q + ab_rise_q(f->rate_q, dt);
+    residual = (c100 << AB_Q) - predicted;
+    if ((residual >> AB_Q) > AB_RESTART || (residual >> AB_Q) < -AB_RESTART)
+    {
+        f->primed = 0;
+        ab_update(f, c100, time);
+        return;
+    }
+
+    f->temp_q = predicted + ((residual * AB_ALPHA) >> 8);
+    f->rate_q += (int32_t)(((int64_t)residual * AB_BETA * 1000 / dt)
+                           >> (8 + AB_Q - AB_RATE_Q));
+    f->time = time;
+}
+
+int32_t ab_predict(const struct ab_filter *f, unsigned long time)
+{
+    return (f->temp_q + ab_rise_q(f->rate_q, (int32_t)(time - f->time))) >> AB_Q;
+}
+
+int32_t ab_temp(const struct ab_filter *f)
+{
+    return f->temp_q >> AB_Q;
+}
+
+int32_t ab_rate_per_min(const struct ab_filter *f)
+{
+    return (int32_t)(((int64_t)f->rate_q * 60) >> AB_RATE_Q);
+}
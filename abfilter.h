@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ABFILTER_H
+#define ABFILTER_H
+
+#include <stdint.h>
+
+// State is hundredths of a degree << AB_Q, and hundredths of a degree
+// per second << AB_RATE_Q
+#define AB_Q         8
+#define AB_RATE_Q    12
+
+// Gains, Q8. Beta follows alpha as alpha^2 / (2 - alpha), which is
+// critically damped for a constant rate of rise.
+#define AB_ALPHA     64      // 0.25
+#define AB_BETA      9       // 0.036
+
+// Readings further than this from the prediction restart the filter,
+// eg. a probe moved from one vessel to another
+#define AB_RESTART   1000
+
+struct ab_filter
+{
+    int32_t  temp_q;
+    int32_t  rate_q;
+    unsigned long time;      // ms, of the last update
+    uint8_t  primed;
+};
+
+void    ab_reset(struct ab_filter *f);
+
+// A new reading taken at time ms
+void    ab_update(struct ab_filter *f, int32_t c100, unsigned long time);
+
+// Filtered temperature, projected forward to time ms
+int32_t ab_predict(const struct ab_filter *f, unsigned long time);
+int32_t ab_temp(const struct ab_filter *f);
+
+// Rate of rise, hundredths of a degree per minute
+int32_t ab_rate_per_min(const struct ab_filter *f);
+
+#endif
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Analog inputs. ADC1 scans every channel continuously and DMA1 channel 1
+// writes the results round a circular buffer, so taking a sample costs
+// no CPU at all. The half and full transfer interrupts each get a
+// settled half of the buffer to decimate: the scans are summed per
+// channel, run through a short IIR filter, and the level probes are
+// debounced. Readers just pick up the latest values; each is a single
+// aligned halfword so no locking is needed.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "analog.h"
+#include "timer.h"
+
+static const uint8_t adc_channels[ANALOG_CHANNELS] =
+{
+    ADC_Channel_10, ADC_Channel_11, ADC_Channel_12, ADC_Channel_13,
+    ADC_Channel_15, ADC_Channel_17      // 17 is Vrefint
+};
+
+// written by the DMA, two halves of ANALOG_SCANS scans
+static volatile uint16_t adc_buf[2][ANALOG_SCANS][ANALOG_CHANNELS];
+
+static volatile uint16_t filtered[ANALOG_CHANNELS];
+static volatile uint32_t sequence;
+
+struct level
+{
+    uint8_t wet;
+    uint8_t count;           // readings the other way in a row
+    unsigned long changed;   // ulUptimeMs of the last change
+};
+
+static volatile struct level levels[LEVEL_PROBES];
+
+void analog_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    DMA_InitTypeDef DMA_InitStructure;
+    ADC_InitTypeDef ADC_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+    int ii;
+
+    GPIO_InitStructure.GPIO_Pin = ANALOG_PINS;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
+    GPIO_Init( ANALOG_PORT, &GPIO_InitStructure );
+
+    RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
+    RCC_ADCCLKConfig( RCC_PCLK2_Div6 );
+    RCC_APB2PeriphClockCmd( RCC_APB2Periph_ADC1, ENABLE );
+
+    DMA_DeInit( DMA1_Channel1 );
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)adc_buf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = sizeof(adc_buf) / sizeof(uint16_t);
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init( DMA1_Channel1, &DMA_InitStructure );
+    DMA_ITConfig( DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE );
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = ANALOG_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    DMA_Cmd( DMA1_Channel1, ENABLE );
+
+    ADC_DeInit( ADC1 );
+    ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
+    ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+    ADC_InitStructure.ADC_ContinuousConvMode = ENABLE;
+    ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_None;
+    ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+    ADC_InitStructure.ADC_NbrOfChannel = ANALOG_CHANNELS;
+    ADC_Init( ADC1, &ADC_InitStructure );
+
+    // the longest sample time, the probes and Vrefint are high impedance
+    for (ii = 0; ii < ANALOG_CHANNELS; ii++)
+        ADC_RegularChannelConfig( ADC1, adc_channels[ii], ii + 1, ADC_SampleTime_239Cycles5 );
+    ADC_TempSensorVrefintCmd( ENABLE );
+    ADC_DMACmd( ADC1, ENABLE );
+    ADC_Cmd( ADC1, ENABLE );
+
+    ADC_ResetCalibration( ADC1 );
+    while (ADC_GetResetCalibrationStatus( ADC1 ))
+        ;
+    ADC_StartCalibration( ADC1 );
+    while (ADC_GetCalibrationStatus( ADC1 ))
+        ;
+
+    // probes start dry and settled
+    for (ii = 0; ii < LEVEL_PROBES; ii++)
+    {
+        levels[ii].wet = 0;
+        levels[ii].count = 0;
+        levels[ii].changed = 0;
+    }
+
+    ADC_SoftwareStartConvCmd( ADC1, ENABLE );
+}
+
+static void level_debounce(uint8_t probe, uint16_t counts)
+{
+    volatile struct level *lv = &levels[probe];
+    uint8_t wet = lv->wet ? counts <= LEVEL_DRY_ABOVE : counts < LEVEL_WET_BELOW;
+
+    if (wet == lv->wet)
+    {
+        lv->count = 0;
+        return;
+    }
+    if (++lv->count >= LEVEL_DEBOUNCE)
+    {
+        lv->wet = wet;
+        lv->count = 0;
+        lv->changed = ulUptimeMs;
+    }
+}
+
+static void analog_decimate(volatile uint16_t (*half)[ANALOG_CHANNELS])
+{
+    uint32_t sum[ANALOG_CHANNELS] = { 0 };
+    int ii, ch;
+
+    for (ii = 0; ii < ANALOG_SCANS; ii++)
+        for (ch = 0; ch < ANALOG_CHANNELS; ch++)
+            sum[ch] += half[ii][ch];
+
+    for (ch = 0; ch < ANALOG_CHANNELS; ch++)
+    {
+        int32_t mean = sum[ch] << ANALOG_Q >> ANALOG_SCANS_SHIFT;
+        int32_t now = filtered[ch];
+
+        // the first pass starts the filter where the input is
+        filtered[ch] = sequence ? now + ((mean - now) >> ANALOG_FILTER_SHIFT) : mean;
+    }
+
+    for (ii = 0; ii < LEVEL_PROBES; ii++)
+        level_debounce(ii, filtered[ANALOG_LEVEL_HLT + ii] >> ANALOG_Q);
+
+    sequence++;
+}
+
+void DMA1_Channel1_IRQHandler( void )
+{
+    // the DMA is already into the other half of the buffer
+    if (DMA_GetITStatus( DMA1_IT_HT1 ))
+    {
+        DMA_ClearITPendingBit( DMA1_IT_HT1 );
+        analog_decimate(adc_buf[0]);
+    }
+    if (DMA_GetITStatus( DMA1_IT_TC1 ))
+    {
+        DMA_ClearITPendingBit( DMA1_IT_TC1 );
+        analog_decimate(adc_buf[1]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Readings
+////////////////////////////////////////////////////////////////////////////
+
+uint16_t analog_raw(uint8_t channel)
+{
+    return filtered[channel];
+}
+
+uint16_t analog_vdda_mv(void)
+{
+    uint32_t vref = filtered[ANALOG_VREFINT];
+
+    if (vref == 0)
+        return 3300;
+    return (uint16_t)(((uint32_t)ANALOG_VREFINT_MV * (4095 << ANALOG_Q)) / vref);
+}
+
+uint16_t analog_mv(uint8_t channel)
+{
+    return (uint16_t)(((uint32_t)filtered[channel] * analog_vdda_mv()) / (4095 << ANALOG_Q));
+}
+
+uint16_t analog_supply_mv(void)
+{
+    return analog_mv(ANALOG_SUPPLY) * ANALOG_SUPPLY_DIVIDER;
+}
+
+uint16_t analog_element_ma(uint8_t heater)
+{
+    return (uint16_t)((uint32_t)analog_mv(ANALOG_CURRENT_HLT + heater) *
+                      ANALOG_CURRENT_MA_PER_V / 1000);
+}
+
+uint32_t analog_sequence(void)
+{
+    return sequence;
+}
+
+uint8_t level_probe_wet(uint8_t probe)
+{
+    return levels[probe].wet;
+}
+
+uint8_t level_wait_for_steady_readings(unsigned long timeout_ms)
+{
+    unsigned long start = ulUptimeMs;
+
+    for (;;)
+    {
+        unsigned long now = ulUptimeMs;
+        uint8_t steady = 1;
+        int ii;
+
+        for (ii = 0; ii < LEVEL_PROBES; ii++)
+        {
+            if (levels[ii].count || now - levels[ii].changed < LEVEL_STEADY_MS)
+                steady = 0;
+        }
+        if (steady)
+            return 1;
+        if (now - start >= timeout_ms)
+            return 0;
+        vTaskDelay(100 / portTICK_RATE_MS);
+    }
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ANALOG_H
+#define ANALOG_H
+
+#include <stdint.h>
+
+// Scan order. The level probes come first so they share an index with
+// the heater channel of the same vessel.
+enum analog_channel
+{
+    ANALOG_LEVEL_HLT,      // PC0, ADC_IN10
+    ANALOG_LEVEL_MASH,     // PC1, ADC_IN11
+    ANALOG_CURRENT_HLT,    // PC2, ADC_IN12, element current sense
+    ANALOG_CURRENT_MASH,   // PC3, ADC_IN13
+    ANALOG_SUPPLY,         // PC5, ADC_IN15, 24V rail through a divider
+    ANALOG_VREFINT,        // internal 1.20V reference, gives VDDA
+    ANALOG_CHANNELS
+};
+
+enum level_probe
+{
+    LEVEL_HLT,
+    LEVEL_MASH,
+    LEVEL_PROBES
+};
+
+#define ANALOG_PORT  GPIOC
+#define ANALOG_PINS  (GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_5)
+
+// 12MHz ADC clock and 252 cycles a conversion is ~7.9kHz per channel.
+// Each half of the DMA buffer holds ANALOG_SCANS scans, so the decimation
+// interrupt comes every ~4ms.
+#define ANALOG_SCANS          32
+#define ANALOG_SCANS_SHIFT    5
+#define ANALOG_FILTER_SHIFT   3     // IIR over ~8 decimated readings
+#define ANALOG_IRQ_PRIORITY   13
+
+// Filtered readings are ADC counts << ANALOG_Q
+#define ANALOG_Q              4
+
+// Probes are pulled up and shorted to the vessel by the water, so they
+// read low when wet. Thresholds in ADC counts with some hysteresis, and
+// a change has to hold for LEVEL_DEBOUNCE readings (~100ms).
+#define LEVEL_WET_BELOW       1600
+#define LEVEL_DRY_ABOVE       2400
+#define LEVEL_DEBOUNCE        25
+#define LEVEL_STEADY_MS       2000  // no change for this long is steady
+
+#define ANALOG_VREFINT_MV     1200
+#define ANALOG_SUPPLY_DIVIDER 11    // 100k over 10k
+#define ANALOG_CURRENT_MA_PER_V 5000
+
+void     analog_init(void);
+
+// Lock free, the decimation interrupt updates these in place
+uint16_t analog_raw(uint8_t channel);       // counts << ANALOG_Q
+uint16_t analog_mv(uint8_t channel);        // at the pin
+uint16_t analog_vdda_mv(void);
+uint16_t analog_supply_mv(void);
+uint16_t analog_element_ma(uint8_t heater);
+uint32_t analog_sequence(void);             // bumps on every decimation
+
+uint8_t  level_probe_wet(uint8_t probe);
+
+// Waits until none of the probes has changed for LEVEL_STEADY_MS, eg.
+// for sloshing to die down. Returns 1 if they settled within timeout_ms.
+uint8_t  level_wait_for_steady_readings(unsigned long timeout_ms);
+
+#endif
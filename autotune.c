@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Relay feedback autotuning (Astrom-Hagglund). The element is switched
+// between two outputs around the setpoint, with some hysteresis to keep
+// sensor noise from chattering the relay. The vessel settles into a limit
+// cycle whose period is the ultimate period Pu, and whose amplitude a
+// gives the ultimate gain Ku = 4d / (pi a) for a relay of half swing d.
+// Gains then follow from the Ziegler-Nichols "some overshoot" rules,
+// which are gentler than the classic table on a slow, laggy vessel.
+//
+// No hardware is touched here, so the same code runs on the host against
+// a simulated vessel (host/autotune_bench.c).
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "autotune.h"
+#include "pid.h"
+
+static const char *state_names[] =
+{
+    "IDLE", "RUNNING", "DONE", "ABORTED", "TIMEOUT", "OVER TEMP", "NO OSCILLATION"
+};
+
+const char *autotune_state_name(uint8_t state)
+{
+    return state < sizeof(state_names) / sizeof(state_names[0]) ? state_names[state] : "?";
+}
+
+void autotune_start(struct autotune *at, const struct autotune_cfg *cfg)
+{
+    memset(at, 0, sizeof(*at));
+    at->cfg = *cfg;
+    if (at->cfg.cycles == 0)
+        at->cfg.cycles = 1;
+    at->state = AUTOTUNE_RUNNING;
+    at->relay_high = 1;
+}
+
+void autotune_abort(struct autotune *at)
+{
+    if (at->state == AUTOTUNE_RUNNING)
+        at->state = AUTOTUNE_ABORTED;
+}
+
+static void autotune_finish(struct autotune *at)
+{
+    uint32_t n = at->cfg.cycles;
+    int32_t  a = at->amplitude_sum / (int32_t)(2 * n);   // half peak to peak
+    int32_t  d = ((int32_t)at->cfg.out_high - at->cfg.out_low) / 2;
+    uint32_t pu16 = (at->period_sum << 4) / n;
+
+    if (a <= 0 || pu16 == 0)
+    {
+        at->state = AUTOTUNE_NO_OSCILLATION;
+        return;
+    }
+
+    // Ku = 4d / (pi a), pi as 355/113
+    at->ku = (int32_t)(((int64_t)4 * d * 113 * PID_ONE) / ((int64_t)355 * a));
+    at->pu = pu16;
+
+    // Kp = Ku/3, Ti = Pu/2, Td = Pu/3 with the loop's per sample units:
+    // ki = Kp / Ti, kd = Kp * Td
+    at->kp = at->ku / 3;
+    at->ki = (int32_t)(((int64_t)at->kp * 2 * 16) / pu16);
+    at->kd = (int32_t)(((int64_t)at->kp * pu16) / (3 * 16));
+    at->state = AUTOTUNE_DONE;
+}
+
+uint16_t autotune_step(struct autotune *at, int32_t temp)
+{
+    if (at->state != AUTOTUNE_RUNNING)
+        return at->cfg.out_low;
+
+    at->samples++;
+
+    if (temp > at->cfg.max_temp)
+    {
+        at->state = AUTOTUNE_OVER_TEMP;
+        return at->cfg.out_low;
+    }
+    if (at->samples > at->cfg.timeout)
+    {
+        at->state = AUTOTUNE_TIMEOUT;
+        return at->cfg.out_low;
+    }
+
+    if (at->relay_high)
+    {
+        if (temp > at->peak_high)
+            at->peak_high = temp;
+
+        if (temp > at->cfg.setpoint + at->cfg.hysteresis)
+        {
+            at->relay_high = 0;
+            at->peak_low = temp;
+        }
+    }
+    else
+    {
+        if (temp < at->peak_low)
+            at->peak_low = temp;
+
+        if (temp < at->cfg.setpoint - at->cfg.hysteresis)
+        {
+            // one full cycle ends each time the relay turns back on
+            at->relay_high = 1;
+            if (at->cycles_done > 0)
+            {
+                at->period_sum += at->samples - at->last_switch_on;
+                at->amplitude_sum += at->peak_high - at->peak_low;
+            }
+            at->cycles_done++;
+            at->last_switch_on = at->samples;
+            at->peak_high = temp;
+
+            if (at->cycles_done > at->cfg.cycles)
+            {
+                autotune_finish(at);
+                return at->cfg.out_low;
+            }
+        }
+    }
+
+    return at->relay_high ? at->cfg.out_high : at->cfg.out_low;
+}
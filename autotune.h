@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+
+enum autotune_state
+{
+    AUTOTUNE_IDLE,
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_DONE,
+    AUTOTUNE_ABORTED,
+    AUTOTUNE_TIMEOUT,
+    AUTOTUNE_OVER_TEMP,
+    AUTOTUNE_NO_OSCILLATION
+};
+
+struct autotune_cfg
+{
+    int32_t  setpoint;      // hundredths of a degree
+    int32_t  hysteresis;    // relay switches at setpoint +/- this
+    uint16_t out_high;
+    uint16_t out_low;
+    uint8_t  cycles;        // cycles to average, after the first is dropped
+    uint32_t timeout;       // samples
+    int32_t  max_temp;      // abort above this
+};
+
+struct autotune
+{
+    struct autotune_cfg cfg;
+    uint8_t  state;
+    uint8_t  relay_high;
+    uint8_t  cycles_done;   // includes the dropped first cycle
+    uint32_t samples;
+    uint32_t last_switch_on;
+    int32_t  peak_high;
+    int32_t  peak_low;
+    uint32_t period_sum;    // samples
+    int32_t  amplitude_sum; // peak to peak, hundredths of a degree
+
+    // results, valid in AUTOTUNE_DONE
+    uint32_t pu;            // ultimate period, samples << 4
+    int32_t  ku;            // ultimate gain, PID_Q fixed point
+    int32_t  kp;            // PID_Q gains in pid.h units
+    int32_t  ki;
+    int32_t  kd;
+};
+
+void     autotune_start(struct autotune *at, const struct autotune_cfg *cfg);
+void     autotune_abort(struct autotune *at);
+
+// One sample at the loop rate. Returns the output to apply until the
+// next sample; out_low once the experiment has finished for any reason.
+uint16_t autotune_step(struct autotune *at, int32_t temp);
+
+const char *autotune_state_name(uint8_t state);
+
+#endif
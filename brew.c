@@ -0,0 +1,799 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Brew sequencer. A recipe is a list of steps; each step type has start,
+// iterate and stop callbacks in brew_step_ops[]. The task calls the
+// current step's iterate callback once every BREW_TICK_MS, and moves on
+// when it reports the step done. A step that fails or runs past its
+// timeout stops the brew with the elements off, and it can be resumed
+// from the start of that step.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "brew.h"
+#include "heater.h"
+#include "crane.h"
+#include "ds1820.h"
+#include "speaker.h"
+#include "timer.h"
+#include "lcd.h"
+#include "journal.h"
+#include "analog.h"
+#include "fmt.h"
+
+static xQueueHandle xBrewQueue;
+
+static struct brew_task brew;
+static struct brew_status status;
+static struct brew_recipe running;       // the sequencer works from a copy
+static struct brew_recipe selected;      // what START will brew
+static int8_t selected_index = -1;       // in the flash image, -1 built in
+static uint8_t brew_state = BREW_IDLE;
+
+static int8_t journal_late = -1;         // event held while the crane moves
+
+static volatile uint8_t crane_state;
+static volatile uint8_t brew_applet_active;
+
+const struct brew_recipe brew_default_recipe =
+{
+    "Default Ale", 6,
+    {
+        { BREW_FILL,   HEATER_HLT,  0,     0,  30 },
+        { BREW_HEAT,   HEATER_HLT,  7200,  0,  120 },
+        { BREW_MASH,   HEATER_MASH, 6600,  60, 180 },
+        { BREW_SPARGE, HEATER_MASH, 0,     15, 30 },
+        { BREW_BOIL,   HEATER_MASH, 9900,  60, 180, 3, { 60, 15, 0 } },
+        { BREW_CHILL,  HEATER_MASH, 2000,  0,  90 },
+    }
+};
+
+static void brew_alarm(void)
+{
+    char beep = ALARM_BEEP;
+
+    if (xBeepQueue)
+        xQueueSendToBack(xBeepQueue, &beep, 0);
+}
+
+static int32_t brew_temp(struct brew_task *bt)
+{
+    struct heater_status hs;
+
+    heater_get_status(bt->step->vessel, &hs);
+    return hs.temp;
+}
+
+// Starts the timed part of a step the first time it is called
+static int32_t brew_hold(struct brew_task *bt)
+{
+    int32_t left;
+
+    if (bt->hold_start < 0)
+        bt->hold_start = bt->elapsed;
+
+    left = (int32_t)bt->step->minutes * 60 - (int32_t)(bt->elapsed - bt->hold_start);
+    bt->remaining = left > 0 ? left : 0;
+    return left;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Basket moves. The crane must be homed before it can be sent to a
+// position, so homing is run first as its own move when needed.
+////////////////////////////////////////////////////////////////////////////
+
+enum { CRANE_PHASE_IDLE, CRANE_PHASE_HOMING, CRANE_PHASE_MOVING, CRANE_PHASE_DONE };
+
+static void brew_crane_status(const struct crane_status *cs)
+{
+    crane_state = cs->state;
+}
+
+static uint8_t brew_crane_to(struct brew_task *bt, int32_t position)
+{
+    switch (bt->crane_phase)
+    {
+    case CRANE_PHASE_IDLE:
+        crane_state = CRANE_MOVING;
+        if (!crane_is_homed())
+        {
+            crane_post_home(brew_crane_status);
+            bt->crane_phase = CRANE_PHASE_HOMING;
+        }
+        else
+        {
+            crane_post_move(position, brew_crane_status);
+            bt->crane_phase = CRANE_PHASE_MOVING;
+        }
+        break;
+
+    case CRANE_PHASE_HOMING:
+        if (crane_state == CRANE_DONE)
+        {
+            crane_state = CRANE_MOVING;
+            crane_post_move(position, brew_crane_status);
+            bt->crane_phase = CRANE_PHASE_MOVING;
+        }
+        else if (crane_state != CRANE_MOVING)
+            return BREW_STEP_FAILED;
+        break;
+
+    case CRANE_PHASE_MOVING:
+        if (crane_state == CRANE_DONE)
+            bt->crane_phase = CRANE_PHASE_DONE;
+        else if (crane_state != CRANE_MOVING)
+            return BREW_STEP_FAILED;
+        break;
+
+    default:
+        break;
+    }
+
+    return bt->crane_phase == CRANE_PHASE_DONE ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Step callbacks
+////////////////////////////////////////////////////////////////////////////
+
+static const char *vessel_name(uint8_t vessel)
+{
+    return vessel == HEATER_HLT ? "HLT" : "mash tun";
+}
+
+static void fill_start(struct brew_task *bt)
+{
+    heater_off(bt->step->vessel);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Fill the %s, then NEXT",
+             vessel_name(bt->step->vessel));
+    brew_alarm();
+}
+
+// Done when the brewer says so, or when the level probe has been under
+// water long enough for the surface to have settled
+static uint8_t fill_iterate(struct brew_task *bt)
+{
+    if (bt->acked)
+        return BREW_STEP_DONE;
+    if (!level_probe_wet(bt->step->vessel))
+        return BREW_STEP_CONTINUE;
+    if (!level_wait_for_steady_readings(BREW_TICK_MS / 2))
+        return BREW_STEP_CONTINUE;
+    return level_probe_wet(bt->step->vessel) ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+static void heat_start(struct brew_task *bt)
+{
+    heater_set_target(bt->step->vessel, bt->step->temp);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Heating the %s",
+             vessel_name(bt->step->vessel));
+}
+
+static uint8_t heat_iterate(struct brew_task *bt)
+{
+    return brew_temp(bt) >= bt->step->temp - BREW_TEMP_BAND ?
+        BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+static void mash_start(struct brew_task *bt)
+{
+    heater_set_target(bt->step->vessel, bt->step->temp);
+
+    // the basket takes a few seconds to go in, well inside the vessel's
+    // dead time, so the loop can start on it now. Not again on a resume,
+    // the grain went in the first time.
+    if (bt->elapsed == 0)
+        heater_disturbance(bt->step->vessel, BREW_GRAIN_DROP);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Lowering the basket");
+}
+
+static uint8_t mash_iterate(struct brew_task *bt)
+{
+    uint8_t ret = brew_crane_to(bt, BREW_BASKET_DOWN);
+
+    if (ret != BREW_STEP_DONE)
+        return ret;
+
+    // the rest is timed from when the mash is up to temperature
+    if (bt->hold_start < 0 && brew_temp(bt) < bt->step->temp - BREW_TEMP_BAND)
+    {
+        fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Mash heating");
+        return BREW_STEP_CONTINUE;
+    }
+
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Mash rest");
+    return brew_hold(bt) <= 0 ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+static void sparge_start(struct brew_task *bt)
+{
+    heater_off(bt->step->vessel);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Lifting the basket");
+}
+
+static uint8_t sparge_iterate(struct brew_task *bt)
+{
+    uint8_t ret = brew_crane_to(bt, BREW_BASKET_UP);
+
+    if (ret != BREW_STEP_DONE)
+        return ret;
+
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Sparge and drain");
+    return brew_hold(bt) <= 0 ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+// Boiling at the step temperature, or wherever the temperature stops
+// climbing near it
+static uint8_t brew_boiling(struct brew_task *bt)
+{
+    struct heater_status hs;
+
+    heater_get_status(bt->step->vessel, &hs);
+    if (hs.stale)
+        return 0;
+    return hs.temp >= bt->step->temp ||
+        (hs.temp >= BREW_BOIL_MIN && hs.rate < BREW_BOIL_FLAT);
+}
+
+static void boil_start(struct brew_task *bt)
+{
+    heater_set_output(bt->step->vessel, HEATER_OUTPUT_MAX);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Heating to the boil");
+}
+
+static uint8_t boil_iterate(struct brew_task *bt)
+{
+    int32_t left;
+
+    if (bt->hold_start < 0 && !brew_boiling(bt))
+        return BREW_STEP_CONTINUE;
+
+    left = brew_hold(bt);
+
+    // hop additions are due at a number of minutes before the end
+    while (bt->next_hop < bt->step->hops &&
+           left <= (int32_t)bt->step->hop_minutes[bt->next_hop] * 60)
+    {
+        fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Add hop addition %d",
+                 bt->next_hop + 1);
+        bt->next_hop++;
+        brew_alarm();
+    }
+
+    return left <= 0 ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+static void chill_start(struct brew_task *bt)
+{
+    heater_off(bt->step->vessel);
+    fmt_snprintf(bt->message, BREW_MESSAGE_LEN, "Start the chiller");
+    brew_alarm();
+}
+
+static uint8_t chill_iterate(struct brew_task *bt)
+{
+    return brew_temp(bt) <= bt->step->temp ? BREW_STEP_DONE : BREW_STEP_CONTINUE;
+}
+
+// leaves the vessel holding whatever the step set up
+static void step_keep(struct brew_task *bt)
+{
+}
+
+static void step_off(struct brew_task *bt)
+{
+    heater_off(bt->step->vessel);
+}
+
+struct brew_step_ops
+{
+    const char *name;
+    void    (*start)(struct brew_task *bt);
+    uint8_t (*iterate)(struct brew_task *bt);
+    void    (*stop)(struct brew_task *bt);
+    uint8_t priority;     // of the step's element, see power.h
+};
+
+static const struct brew_step_ops brew_step_ops[BREW_STEP_TYPES] =
+{
+    { "Fill",   fill_start,   fill_iterate,   step_keep, POWER_PRIO_LOW    },
+    { "Heat",   heat_start,   heat_iterate,   step_keep, POWER_PRIO_LOW    },
+    { "Mash",   mash_start,   mash_iterate,   step_keep, POWER_PRIO_NORMAL },
+    { "Sparge", sparge_start, sparge_iterate, step_keep, POWER_PRIO_NORMAL },
+    { "Boil",   boil_start,   boil_iterate,   step_off,  POWER_PRIO_HIGH   },
+    { "Chill",  chill_start,  chill_iterate,  step_off,  POWER_PRIO_LOW    },
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Sequencer
+////////////////////////////////////////////////////////////////////////////
+
+static void brew_publish(void)
+{
+    struct brew_status st;
+    struct heater_status hs;
+
+    memset(&st, 0, sizeof(st));
+    st.state = brew_state;
+    st.step = brew.index;
+    st.n_steps = brew.recipe ? brew.recipe->n_steps : 0;
+    st.remaining = -1;
+    if (brew.step)
+    {
+        st.step_name = brew_step_ops[brew.step->type].name;
+        st.remaining = brew.remaining;
+        st.elapsed = brew.elapsed;
+        st.brew_time = brew.brew_time;
+        st.target = brew.step->temp;
+        heater_get_status(brew.step->vessel, &hs);
+        st.temp = hs.temp;
+        st.rate = hs.rate;
+    }
+    strncpy(st.message, brew.message, BREW_MESSAGE_LEN - 1);
+
+    taskENTER_CRITICAL();
+    status = st;
+    taskEXIT_CRITICAL();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Journal. Every record is a full snapshot, written on each transition
+// and every BREW_CHECKPOINT_S while brewing.
+////////////////////////////////////////////////////////////////////////////
+
+static uint16_t brew_recipe_crc(const struct brew_recipe *recipe)
+{
+    return recipe_crc32(0, recipe->steps, recipe->n_steps * sizeof(struct brew_step)) & 0xFFFF;
+}
+
+static void brew_journal(uint8_t event)
+{
+    struct journal_rec rec;
+    int ii;
+
+    // a page erase would stall the crane's step interrupt, so the record
+    // waits for the crane to stop; it is a full snapshot either way
+    if (journal_erase_due() && crane_is_running())
+    {
+        if (event != JOURNAL_CHECKPOINT || journal_late < 0)
+            journal_late = event;
+        return;
+    }
+    journal_late = -1;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.event = event;
+    rec.state = brew_state;
+    rec.step = brew.index;
+    rec.recipe = brew.slot < 0 ? 0xFF : brew.slot;
+    rec.brew_time = brew.brew_time;
+    rec.elapsed = brew.elapsed;
+    rec.hold_start = brew.hold_start;
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+        rec.element_s[ii] = brew.element_ms[ii] / 1000;
+    rec.recipe_crc = brew_recipe_crc(brew.recipe);
+    rec.next_hop = brew.next_hop;
+
+    if (journal_write(&rec) != 0)
+        fmt_snprintf(brew.message, BREW_MESSAGE_LEN, "Journal write failed");
+}
+
+// While the crane is still: a held record goes out, or the next journal
+// page is erased ready
+static void brew_journal_idle(void)
+{
+    if (crane_is_running())
+        return;
+    if (journal_late >= 0)
+        brew_journal(journal_late);
+    else if (journal_erase_ahead() != 0)
+        fmt_snprintf(brew.message, BREW_MESSAGE_LEN, "Journal erase failed");
+}
+
+static void brew_enter_step(uint8_t index, uint32_t elapsed)
+{
+    brew.index = index;
+    brew.step = &brew.recipe->steps[index];
+    brew.elapsed = elapsed;
+    brew.hold_start = -1;
+    brew.acked = 0;
+    brew.next_hop = 0;
+    brew.crane_phase = CRANE_PHASE_IDLE;
+    brew.remaining = -1;
+    brew.message[0] = 0;
+    brew_state = BREW_RUNNING;
+
+    // an element left heating by an earlier step keeps the priority it had
+    heater_set_priority(brew.step->vessel, brew_step_ops[brew.step->type].priority);
+    brew_step_ops[brew.step->type].start(&brew);
+    brew_journal(JOURNAL_STEP);
+}
+
+static void brew_stop(uint8_t state, const char *why)
+{
+    heater_all_off();
+    crane_post_stop();
+    brew_state = state;
+    if (why)
+        fmt_snprintf(brew.message, BREW_MESSAGE_LEN, "%s", why);
+    brew_journal(state == BREW_DONE ? JOURNAL_DONE :
+                 state == BREW_ABORTED ? JOURNAL_ABORTED : JOURNAL_FAILED);
+    brew_alarm();
+}
+
+//
+// Starting from cold: elements off and a fresh set of temperature
+// readings before any step looks at them.
+//
+static void brew_settle(void)
+{
+    unsigned long since = ulUptimeMs;
+    int tries = 0;
+
+    heater_all_off();
+    while ((long)(ds1820_sample_time() - since) < 0 && tries++ < 10)
+        vTaskDelay(500 / portTICK_RATE_MS);
+}
+
+static void brew_begin(const struct brew_recipe *recipe, int8_t slot,
+                       uint8_t step, uint32_t elapsed)
+{
+    if (step >= recipe->n_steps)
+        return;
+
+    brew_settle();
+    if (recipe != &running)
+        running = *recipe;
+    brew.recipe = &running;
+    brew.slot = slot;
+    brew.brew_time = 0;
+    memset(brew.element_ms, 0, sizeof(brew.element_ms));
+    brew_state = BREW_RUNNING;
+    brew_journal(JOURNAL_START);
+    brew_enter_step(step, elapsed);
+}
+
+//
+// Pick up the brew in the journal where it left off. The recipe must
+// still be the one it was started with.
+//
+static void brew_restore(void)
+{
+    struct journal_rec rec;
+    const uint8_t *image = recipe_image();
+    int ii;
+
+    if (!journal_last(&rec) || rec.event == JOURNAL_DONE)
+    {
+        fmt_snprintf(brew.message, BREW_MESSAGE_LEN, "Nothing to resume");
+        return;
+    }
+
+    if (rec.recipe == 0xFF)
+        running = brew_default_recipe;
+    else if (!image || recipe_load(image, rec.recipe, &running) != RECIPE_OK)
+        running.n_steps = 0;
+
+    if (rec.step >= running.n_steps || brew_recipe_crc(&running) != rec.recipe_crc)
+    {
+        fmt_snprintf(brew.message, BREW_MESSAGE_LEN, "Recipe has changed, can't resume");
+        return;
+    }
+
+    brew_settle();
+    brew.recipe = &running;
+    brew.slot = rec.recipe == 0xFF ? -1 : rec.recipe;
+    brew.brew_time = rec.brew_time;
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+        brew.element_ms[ii] = (uint32_t)rec.element_s[ii] * 1000;
+
+    brew_enter_step(rec.step, rec.elapsed);
+
+    // the crane has lost its position, so basket moves start over, but
+    // the timed part and hop additions carry on
+    brew.hold_start = rec.hold_start;
+    brew.next_hop = rec.next_hop;
+    brew_journal(JOURNAL_RESUMED);
+}
+
+static void brew_tick(void)
+{
+    const struct brew_step_ops *ops;
+    uint8_t ret;
+    int ii;
+
+    if (brew_state != BREW_RUNNING && brew_state != BREW_WAITING)
+        return;
+
+    ops = &brew_step_ops[brew.step->type];
+    brew.elapsed += BREW_TICK_MS / 1000;
+    brew.brew_time += BREW_TICK_MS / 1000;
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        struct heater_status hs;
+
+        heater_get_status(ii, &hs);
+        brew.element_ms[ii] += (uint32_t)hs.granted * BREW_TICK_MS / HEATER_OUTPUT_MAX;
+    }
+
+    ret = ops->iterate(&brew);
+    brew_state = (brew.step->type == BREW_FILL && ret == BREW_STEP_CONTINUE) ?
+        BREW_WAITING : BREW_RUNNING;
+
+    if (ret == BREW_STEP_CONTINUE && brew.step->timeout &&
+        brew.elapsed >= (uint32_t)brew.step->timeout * 60)
+    {
+        brew_stop(BREW_FAILED, "Step timed out");
+        return;
+    }
+
+    if (ret == BREW_STEP_FAILED)
+    {
+        brew_stop(BREW_FAILED, "Step failed");
+        return;
+    }
+
+    if (ret == BREW_STEP_DONE)
+    {
+        ops->stop(&brew);
+        if (brew.index + 1 >= brew.recipe->n_steps)
+        {
+            brew_stop(BREW_DONE, "Brew complete");
+            return;
+        }
+        brew_enter_step(brew.index + 1, 0);
+        return;
+    }
+
+    if (brew.brew_time % BREW_CHECKPOINT_S == 0)
+        brew_journal(JOURNAL_CHECKPOINT);
+}
+
+static void brew_command(const struct brew_cmd *cmd)
+{
+    switch (cmd->type)
+    {
+    case BREW_CMD_START:
+        brew_begin(cmd->recipe, cmd->slot, cmd->step, cmd->elapsed);
+        break;
+
+    case BREW_CMD_RESUME:
+        // run the step that stopped again from its start
+        if ((brew_state == BREW_FAILED || brew_state == BREW_ABORTED) && brew.recipe)
+        {
+            brew_settle();
+            brew_enter_step(brew.index, 0);
+            brew_journal(JOURNAL_RESUMED);
+        }
+        else if (brew_state == BREW_IDLE)
+            brew_restore();
+        break;
+
+    case BREW_CMD_NEXT:
+        if (brew_state == BREW_WAITING)
+            brew.acked = 1;
+        else if (brew_state == BREW_RUNNING)
+        {
+            // skip the rest of the step
+            brew_step_ops[brew.step->type].stop(&brew);
+            if (brew.index + 1 >= brew.recipe->n_steps)
+                brew_stop(BREW_DONE, "Brew complete");
+            else
+                brew_enter_step(brew.index + 1, 0);
+        }
+        break;
+
+    case BREW_CMD_ABORT:
+        if (brew_state == BREW_RUNNING || brew_state == BREW_WAITING)
+            brew_stop(BREW_ABORTED, "Aborted");
+        break;
+    }
+}
+
+static void brew_show(void);
+
+void vBrewTask( void *pvParameters )
+{
+    struct brew_cmd cmd;
+    portTickType next = xTaskGetTickCount();
+
+    for (;;)
+    {
+        portTickType now = xTaskGetTickCount();
+        portTickType wait = (portTickType)(next - now) <= BREW_TICK_MS / portTICK_RATE_MS ?
+            next - now : 0;
+
+        if (xQueueReceive(xBrewQueue, &cmd, wait) == pdTRUE)
+        {
+            brew_command(&cmd);
+            brew_publish();
+            continue;
+        }
+
+        next += BREW_TICK_MS / portTICK_RATE_MS;
+        brew_tick();
+        brew_journal_idle();
+        brew_publish();
+
+        if (brew_applet_active)
+            brew_show();
+    }
+}
+
+//
+// Steps through the recipes in flash, then the built in one.
+//
+void brew_select_next(void)
+{
+    const uint8_t *image = recipe_image();
+    int8_t next = selected_index + 1;
+
+    if (!image || next >= recipe_count(image) ||
+        recipe_load(image, next, &selected) != RECIPE_OK)
+    {
+        next = -1;
+        selected = brew_default_recipe;
+    }
+    selected_index = next;
+}
+
+const struct brew_recipe *brew_selected(void)
+{
+    return &selected;
+}
+
+void brew_init(void)
+{
+    xBrewQueue = xQueueCreate(BREW_QUEUE_SIZE, sizeof(struct brew_cmd));
+    journal_open();
+    brew_select_next();
+    brew_publish();
+}
+
+static portBASE_TYPE brew_post(uint8_t type, const struct brew_recipe *recipe,
+                               uint8_t step, uint32_t elapsed)
+{
+    struct brew_cmd cmd;
+
+    cmd.type = type;
+    cmd.recipe = recipe;
+    cmd.slot = recipe == &selected ? selected_index : -1;
+    cmd.step = step;
+    cmd.elapsed = elapsed;
+    return xQueueSendToBack(xBrewQueue, &cmd, 0);
+}
+
+portBASE_TYPE brew_start(const struct brew_recipe *recipe)
+{
+    return brew_post(BREW_CMD_START, recipe, 0, 0);
+}
+
+portBASE_TYPE brew_start_at(const struct brew_recipe *recipe, uint8_t step, uint32_t elapsed)
+{
+    return brew_post(BREW_CMD_START, recipe, step, elapsed);
+}
+
+portBASE_TYPE brew_resume(void)
+{
+    return brew_post(BREW_CMD_RESUME, NULL, 0, 0);
+}
+
+portBASE_TYPE brew_next(void)
+{
+    return brew_post(BREW_CMD_NEXT, NULL, 0, 0);
+}
+
+portBASE_TYPE brew_abort(void)
+{
+    return brew_post(BREW_CMD_ABORT, NULL, 0, 0);
+}
+
+void brew_get_status(struct brew_status *st)
+{
+    taskENTER_CRITICAL();
+    *st = status;
+    taskEXIT_CRITICAL();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Brew applets
+////////////////////////////////////////////////////////////////////////////
+
+static const char *brew_state_text[] =
+{
+    "IDLE", "RUNNING", "WAITING", "FAILED", "ABORTED", "DONE"
+};
+
+static void brew_show(void)
+{
+    struct brew_status st;
+
+    brew_get_status(&st);
+    lcd_printf(0, 2, 40, "%-8s step %d of %d  %s", brew_state_text[st.state],
+               st.step + 1, st.n_steps, st.step_name ? st.step_name : "");
+    if (st.remaining >= 0)
+        lcd_printf(0, 3, 40, "Remaining %3ld:%02ld", (long)st.remaining / 60,
+                   (long)st.remaining % 60);
+    else
+        lcd_printf(0, 3, 40, "Elapsed   %3lu:%02lu", (unsigned long)st.elapsed / 60,
+                   (unsigned long)st.elapsed % 60);
+    lcd_printf(0, 4, 40, "Temp %3ld.%02ld  Target %3ld.%02ld",
+               (long)st.temp / 100, (long)st.temp % 100,
+               (long)st.target / 100, (long)st.target % 100);
+    lcd_printf(0, 7, 40, "Rising %s%ld.%02ld degC/min", st.rate < 0 ? "-" : "",
+               (long)(st.rate < 0 ? -st.rate : st.rate) / 100,
+               (long)(st.rate < 0 ? -st.rate : st.rate) % 100);
+    lcd_printf(0, 5, 40, "%s", st.message);
+    lcd_printf(0, 6, 40, "Brewing %lu:%02lu", (unsigned long)st.brew_time / 3600,
+               (unsigned long)(st.brew_time / 60) % 60);
+}
+
+static void brew_draw(const char *title)
+{
+    lcd_printf(0, 0, 40, "%s: %s", title, selected.name);
+    lcd_printf(0, 1, 40, "%s", recipe_image() ? "Touch here to change recipe" : "No recipes in flash");
+    lcd_DrawRect(0,   140,  79, 199, Green);
+    lcd_DrawRect(80,  140, 159, 199, Green);
+    lcd_DrawRect(160, 140, 239, 199, Red);
+    lcd_DrawRect(240, 140, 319, 199, Blue);
+    lcd_printf(2,  10, 8, "START");
+    lcd_printf(12, 10, 8, "NEXT");
+    lcd_printf(22, 10, 8, "ABORT");
+    lcd_printf(32, 10, 8, "BACK");
+    brew_show();
+}
+
+void brew_start_applet(int init){
+    brew_applet_active = init;
+    if (init)
+        brew_draw("BREW");
+}
+
+void brew_resume_applet(int init){
+    brew_applet_active = init;
+    if (!init)
+        return;
+    brew_resume();
+    brew_draw("RESUME");
+}
+
+int brew_key(int xx, int yy){
+    struct brew_status st;
+
+    if (xx < 0 || yy >= 200)
+        return 0;
+
+    if (yy < 140)
+    {
+        brew_get_status(&st);
+        if (yy < 32 && st.state != BREW_RUNNING && st.state != BREW_WAITING)
+        {
+            brew_select_next();
+            lcd_printf(0, 0, 40, "BREW: %s", selected.name);
+        }
+        return 0;
+    }
+
+    if (xx < 80)
+    {
+        brew_get_status(&st);
+        if (st.state != BREW_RUNNING && st.state != BREW_WAITING)
+            brew_start(&selected);
+    }
+    else if (xx < 160)
+        brew_next();
+    else if (xx < 240)
+        brew_abort();
+    else
+        return 1;
+    return 0;
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BREW_H
+#define BREW_H
+
+#include <stdint.h>
+#include "recipe.h"
+
+#define BREW_TICK_MS      1000   // the sequencer runs once a second
+#define BREW_TEMP_BAND    50     // "at temperature" within 0.5 degC
+#define BREW_MESSAGE_LEN  40
+#define BREW_QUEUE_SIZE   4
+#define BREW_CHECKPOINT_S 60     // journal the brew this often
+#define BREW_BOIL_MIN     9500   // at altitude the boil may never reach the step temp,
+#define BREW_BOIL_FLAT    10     // so also when it stops rising, 0.1 degC/min, above this
+#define BREW_GRAIN_DROP   -500   // mash tun fall as the grain goes in, 5kg into 25l
+
+// crane positions for the grain basket
+#define BREW_BASKET_DOWN  CRANE_SOFT_MIN
+#define BREW_BASKET_UP    CRANE_SOFT_MAX
+
+enum brew_state
+{
+    BREW_IDLE,
+    BREW_RUNNING,
+    BREW_WAITING,   // for the operator to press NEXT
+    BREW_FAILED,
+    BREW_ABORTED,
+    BREW_DONE
+};
+
+struct brew_status
+{
+    uint8_t  state;
+    uint8_t  step;
+    uint8_t  n_steps;
+    const char *step_name;
+    int32_t  remaining;        // seconds left in the step, -1 if not known
+    uint32_t elapsed;          // seconds in the step
+    uint32_t brew_time;
+    int32_t  target;
+    int32_t  temp;
+    int32_t  rate;             // hundredths of a degree per minute
+    char     message[BREW_MESSAGE_LEN];
+};
+
+// Runtime context handed to the step callbacks
+struct brew_task
+{
+    const struct brew_recipe *recipe;
+    const struct brew_step *step;
+    uint8_t  index;
+    uint32_t elapsed;          // seconds in the step
+    int32_t  hold_start;       // elapsed when the timed part began, -1 before
+    uint8_t  acked;
+    uint8_t  next_hop;
+    uint8_t  crane_phase;
+    int32_t  remaining;
+    int8_t   slot;             // recipe's flash directory slot, -1 built in
+    uint32_t brew_time;        // seconds since START
+    uint32_t element_ms[2];    // full power time per heater channel
+    char     message[BREW_MESSAGE_LEN];
+};
+
+enum brew_step_result
+{
+    BREW_STEP_CONTINUE,
+    BREW_STEP_DONE,
+    BREW_STEP_FAILED
+};
+
+enum brew_cmd_type
+{
+    BREW_CMD_START,
+    BREW_CMD_RESUME,
+    BREW_CMD_NEXT,
+    BREW_CMD_ABORT
+};
+
+struct brew_cmd
+{
+    uint8_t  type;
+    const struct brew_recipe *recipe;
+    int8_t   slot;
+    uint8_t  step;
+    uint32_t elapsed;
+};
+
+extern const struct brew_recipe brew_default_recipe;
+
+void vBrewTask( void *pvParameters );
+void brew_init(void);
+
+portBASE_TYPE brew_start(const struct brew_recipe *recipe);
+portBASE_TYPE brew_start_at(const struct brew_recipe *recipe, uint8_t step, uint32_t elapsed);
+// After a failure or abort, runs the step that stopped again. From idle,
+// picks up the brew recorded in the journal, eg. after a reset.
+portBASE_TYPE brew_resume(void);
+portBASE_TYPE brew_next(void);
+portBASE_TYPE brew_abort(void);
+void brew_get_status(struct brew_status *status);
+
+// Recipe START will use, from flash when there is a valid image
+void brew_select_next(void);
+const struct brew_recipe *brew_selected(void);
+
+void brew_start_applet(int init);
+void brew_resume_applet(int init);
+int  brew_key(int xx, int yy);
+
+#endif
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "cobs.h"
+
+uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t code_at = 0;    // where the current block's code byte goes
+    uint16_t oo = 1;
+    uint8_t  code = 1;
+    uint16_t ii;
+
+    for (ii = 0; ii < len; ii++)
+    {
+        if (in[ii] == 0)
+        {
+            out[code_at] = code;
+            code_at = oo++;
+            code = 1;
+            continue;
+        }
+        out[oo++] = in[ii];
+        if (++code == 0xFF)
+        {
+            out[code_at] = code;
+            code_at = oo++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    return oo;
+}
+
+uint16_t cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t ii = 0;
+    uint16_t oo = 0;
+
+    while (ii < len)
+    {
+        uint8_t code = in[ii++];
+        uint8_t kk;
+
+        if (code == 0 || ii + code - 1 > len)
+            return 0;
+        for (kk = 1; kk < code; kk++)
+        {
+            if (in[ii] == 0)
+                return 0;
+            out[oo++] = in[ii++];
+        }
+        // a full block has no zero after it, nor does the last one
+        if (code != 0xFF && ii < len)
+            out[oo++] = 0;
+    }
+    return oo;
+}
+
+uint16_t crc16_ccitt(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    int bit;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Consistent overhead byte stuffing. The encoded data never contains a
+// zero, so a zero can mark the end of every frame and a receiver that
+// loses its place picks up again at the next one. The cost is one byte
+// in 254 plus one.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+
+#define COBS_MAX_ENCODED(len)  ((len) + (len) / 254 + 1)
+
+// Returns the encoded length, without a delimiter
+uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+// in is one frame without its delimiter. Returns the decoded length, or
+// 0 if it is malformed. out may be the same buffer as in.
+uint16_t cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+// CRC-16/CCITT-FALSE, start with 0xFFFF
+uint16_t crc16_ccitt(uint16_t crc, const uint8_t *data, uint16_t len);
+
+#endif
@@ -18,18 +18,270 @@
 //-------------------------------------------------------------------------
 #include <stdint.h>
 #include <stdio.h>
-#include "crane.h" 
+#ifndef CRANE_SIM
 #include "stm32f10x.h"
 #include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#else
+#include "crane_sim.h"
+#endif
+#include "crane.h" 
+#ifndef CRANE_SIM
 #include "lcd.h"
+#include "timer.h"
+#endif
+#include "crane_profile.h"
 //-------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------
 
 
+static struct crane_profile_cfg crane_cfg =
+{
+    CRANE_START_RATE,
+    CRANE_CRUISE_RATE,
+    CRANE_ACCEL,
+    CRANE_JERK
+};
+static struct crane_profile profile;
+
+// Position bookkeeping. TIM4 counts every rising edge of the step output
+// in hardware; the position is where the current move started plus
+// however many pulses have gone out since, in the move's direction.
+static volatile int32_t  move_origin;
+static volatile int8_t   move_dir = CRANE_UP;
+static volatile uint32_t pulse_base;
+static volatile uint16_t pulse_overflows;
+static volatile uint8_t  homed;
+static volatile uint8_t  homing;
+
+// Limit switches the EXTI handler has cut the step output for, and TIM4's
+// count when it did. The step interrupt finishes the stop.
+#define LIMIT_LOWER 0x01
+#define LIMIT_UPPER 0x02
+static volatile uint8_t  limit_hit;
+static volatile uint16_t limit_count;
+
+static struct crane_fault fault_log[CRANE_FAULT_LOG_SIZE];
+static volatile uint32_t  fault_count;
+
+#ifdef CRANE_ENCODER
+static uint16_t encoder_last;
+static int32_t  encoder_counts;    // since the start of the move
+#endif
+
+static void crane_pulse_counter_init(void)
+{
+    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM4, ENABLE );
+    TIM_DeInit( TIM4 );
+    TIM_TimeBaseStructInit( &TIM_TimeBaseStructure );
+    TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
+    TIM_TimeBaseStructure.TIM_Prescaler = 0;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit( TIM4, &TIM_TimeBaseStructure );
+
+    // TIM3 TRGO is ITR2 for TIM4. It follows the step output itself, so
+    // a pulse is counted when it starts and nothing else is.
+    TIM_SelectOutputTrigger( TIM3, TIM_TRGOSource_OC3Ref );
+    TIM_ITRxExternalClockConfig( TIM4, TIM_TS_ITR2 );
+
+    TIM_ClearITPendingBit( TIM4, TIM_IT_Update );
+    TIM_ITConfig( TIM4, TIM_IT_Update, ENABLE );
+
+    NVIC_InitStructure.NVIC_IRQChannel = TIM4_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = CRANE_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    TIM_Cmd( TIM4, ENABLE );
+}
+
+// extends the 16 bit pulse counter
+void TIM4_IRQHandler( void )
+{
+    TIM_ClearITPendingBit( TIM4, TIM_IT_Update );
+    pulse_overflows++;
+}
+
+static uint32_t crane_pulses(void)
+{
+    uint16_t hi, lo, pending;
+
+    do
+    {
+        hi = pulse_overflows;
+        lo = TIM4->CNT;
+        pending = TIM4->SR & TIM_FLAG_Update;
+    } while (hi != pulse_overflows);
+
+    // a wrap TIM4_IRQHandler has not seen yet, as when called from
+    // TIM3_IRQHandler at the same priority
+    if (pending && lo < 0x8000)
+        hi++;
+
+    return ((uint32_t)hi << 16) | lo;
+}
+
+int32_t crane_get_position(void)
+{
+    return move_origin + move_dir * (int32_t)(crane_pulses() - pulse_base);
+}
+
+portBASE_TYPE crane_is_homed(void)
+{
+    return homed;
+}
+
+static uint8_t crane_at_lower_limit(void)
+{
+    return GPIO_ReadInputDataBit( CRANE_LIMIT_PORT, CRANE_LOWER_LIMIT_PIN ) == CRANE_LIMIT_ACTIVE;
+}
+
+static uint8_t crane_at_upper_limit(void)
+{
+    return GPIO_ReadInputDataBit( CRANE_LIMIT_PORT, CRANE_UPPER_LIMIT_PIN ) == CRANE_LIMIT_ACTIVE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Fault log. Written from interrupts of differing priority, so the slot is
+// claimed with interrupts briefly disabled.
+////////////////////////////////////////////////////////////////////////////
+
+static void crane_log_fault(uint8_t type)
+{
+    struct crane_fault *f;
+
+    __disable_irq();
+    f = &fault_log[fault_count % CRANE_FAULT_LOG_SIZE];
+    fault_count++;
+    f->time_ms = ulUptimeMs;
+    f->type = type;
+    f->position = crane_get_position();
+    __enable_irq();
+}
+
+uint32_t crane_fault_count(void)
+{
+    return fault_count;
+}
+
+void crane_clear_faults(void)
+{
+    __disable_irq();
+    fault_count = 0;
+    __enable_irq();
+}
+
+// nth most recent fault, 0 being the latest
+portBASE_TYPE crane_get_fault(uint32_t nth, struct crane_fault *fault)
+{
+    portBASE_TYPE ret = pdFAIL;
+
+    __disable_irq();
+    if (nth < fault_count && nth < CRANE_FAULT_LOG_SIZE)
+    {
+        *fault = fault_log[(fault_count - 1 - nth) % CRANE_FAULT_LOG_SIZE];
+        ret = pdPASS;
+    }
+    __enable_irq();
+    return ret;
+}
+
+const char *crane_fault_name(uint8_t type)
+{
+    static const char *names[] = { "LOWER LIMIT", "UPPER LIMIT", "STALL", "E-STOP" };
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "?";
+}
+
+static void crane_set_direction(int8_t dir)
+{
+    move_origin = crane_get_position();
+    pulse_base = crane_pulses();
+    move_dir = dir;
+#ifdef CRANE_ENCODER
+    encoder_last = TIM5->CNT;
+    encoder_counts = 0;
+#endif
+    GPIO_WriteBit( CRANE_PORT, CRANE_DIR_PIN, dir == CRANE_UP ? CRANE_DIR_UP_LEVEL : !CRANE_DIR_UP_LEVEL );
+}
+
+//
+// The limit switches interrupt on closing. Their handler sits above
+// configMAX_SYSCALL_INTERRUPT_PRIORITY so no critical section can hold
+// it off. It can preempt the step interrupt and the critical sections
+// below, so it only turns the step output off and leaves the rest of the
+// stop to the step interrupt.
+//
+static void crane_limit_init(void)
+{
+    EXTI_InitTypeDef EXTI_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    GPIO_EXTILineConfig( CRANE_LIMIT_PORT_SOURCE, CRANE_LOWER_LIMIT_PIN_SOURCE );
+    GPIO_EXTILineConfig( CRANE_LIMIT_PORT_SOURCE, CRANE_UPPER_LIMIT_PIN_SOURCE );
+
+    EXTI_InitStructure.EXTI_Line = CRANE_LOWER_LIMIT_LINE | CRANE_UPPER_LIMIT_LINE;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = CRANE_LIMIT_ACTIVE ? EXTI_Trigger_Rising : EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init( &EXTI_InitStructure );
+
+    NVIC_InitStructure.NVIC_IRQChannel = EXTI15_10_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = CRANE_LIMIT_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+}
+
+#ifdef CRANE_ENCODER
+static void crane_encoder_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
+
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM5, ENABLE );
+
+    // TIM5_CH1/CH2 on PA0/PA1
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_0 | GPIO_Pin_1;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init( GPIOA, &GPIO_InitStructure );
+
+    TIM_DeInit( TIM5 );
+    TIM_TimeBaseStructInit( &TIM_TimeBaseStructure );
+    TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
+    TIM_TimeBaseInit( TIM5, &TIM_TimeBaseStructure );
+    TIM_EncoderInterfaceConfig( TIM5, TIM_EncoderMode_TI12,
+                                TIM_ICPolarity_Rising, TIM_ICPolarity_Rising );
+    TIM_Cmd( TIM5, ENABLE );
+}
+
+//
+// Compare the steps commanded so far with what the encoder saw. Called
+// from the step interrupt every CRANE_STALL_CHECK_STEPS steps.
+//
+static uint8_t crane_stalled(void)
+{
+    uint16_t now = TIM5->CNT;
+    int32_t expected, actual;
+
+    encoder_counts += (int16_t)(now - encoder_last);
+    encoder_last = now;
+
+    expected = (int32_t)(crane_pulses() - pulse_base) * CRANE_ENCODER_COUNTS_PER_STEP;
+    actual = encoder_counts * move_dir;
+
+    return expected - actual > CRANE_STALL_COUNTS;
+}
+#endif
+
 void vCraneInit(void){ 
     
-    unsigned long ulFrequency;
     TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
     NVIC_InitTypeDef NVIC_InitStructure;
     GPIO_InitTypeDef GPIO_InitStructure;
@@ -41,136 +293,605 @@ void vCraneInit(void){
     TIM_DeInit( TIM3 );
     TIM_TimeBaseStructInit( &TIM_TimeBaseStructure );
     
-    GPIO_InitStructure.GPIO_Pin =  CRANE_STEP_PIN;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;// Alt Function - Push Pull
+    GPIO_InitStructure.GPIO_Pin =  CRANE_ENABLE_PIN | CRANE_DIR_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
     GPIO_Init( CRANE_PORT, &GPIO_InitStructure );
-    GPIO_PinRemapConfig( GPIO_FullRemap_TIM3, ENABLE );// Map TIM3_CH3
-                                                       // to Step Pin    
-/*
-    GPIO_InitStructure.GPIO_Pin =  CRANE_ENABLE_PIN;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
-    GPIO_Init( CRANE_PORT, &GPIO_InitStructure );
-    GPIO_ResetBits(CRANE_PORT, CRANE_ENABLE_PIN);
+    GPIO_WriteBit( CRANE_PORT, CRANE_ENABLE_PIN, !CRANE_ENABLE_LEVEL );
+    GPIO_WriteBit( CRANE_PORT, CRANE_DIR_PIN, CRANE_DIR_UP_LEVEL );
 
-    GPIO_InitStructure.GPIO_Pin =  CRANE_DIR_PIN;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
-    GPIO_Init( CRANE_PORT, &GPIO_InitStructure );
-    GPIO_ResetBits(CRANE_PORT, CRANE_DIR_PIN);
-*/
+    // limit switches close to ground
+    GPIO_InitStructure.GPIO_Pin =  CRANE_LOWER_LIMIT_PIN | CRANE_UPPER_LIMIT_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_Init( CRANE_LIMIT_PORT, &GPIO_InitStructure );
+    crane_limit_init();
     
     // SET UP TIMER 3
     
-    //Period 10000, Prescaler 50, pulse = 26 gives 111Hz with 5us
-    //Pulse width.
-    TIM_TimeBaseStructure.TIM_Period = 10000; 
-    TIM_TimeBaseStructure.TIM_Prescaler = 50; //clock prescaler
-    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV4;
+    // Count at 1MHz so the period register holds the step interval in
+    // us. The profile generator rewrites it from the update interrupt
+    // after every step.
+    TIM_TimeBaseStructure.TIM_Period = 0xFFFF; 
+    TIM_TimeBaseStructure.TIM_Prescaler = (72000000 / CRANE_TIMER_HZ) - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
     TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
     TIM_TimeBaseInit( TIM3, &TIM_TimeBaseStructure );
     TIM_ARRPreloadConfig( TIM3, ENABLE );
+    TIM_UpdateRequestConfig( TIM3, TIM_UpdateSource_Regular );
     
     TIM_OCInitTypeDef TIM_OCInitStruct;
     TIM_OCStructInit( &TIM_OCInitStruct );
     TIM_OCInitStruct.TIM_OutputState = TIM_OutputState_Enable;
     TIM_OCInitStruct.TIM_OCMode = TIM_OCMode_PWM1;
-    // Initial duty cycle equals 25 which gives pulse of 5us
-    TIM_OCInitStruct.TIM_Pulse = 26;
+    TIM_OCInitStruct.TIM_Pulse = CRANE_PULSE_US;
     TIM_OC3Init( TIM3, &TIM_OCInitStruct );
-    
+    TIM_ForcedOC3Config( TIM3, TIM_ForcedAction_InActive );
+
+    // The step pin goes to the timer only now its output is held low;
+    // with the counter at 0 PWM mode would have started a pulse.
+    GPIO_InitStructure.GPIO_Pin =  CRANE_STEP_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;// Alt Function - Push Pull
+    GPIO_Init( CRANE_PORT, &GPIO_InitStructure );
+    GPIO_PinRemapConfig( GPIO_FullRemap_TIM3, ENABLE );// Map TIM3_CH3
+                                                       // to Step Pin    
 
+    NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = CRANE_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    crane_pulse_counter_init();
+#ifdef CRANE_ENCODER
+    crane_encoder_init();
+#endif
 }
 
-void vCraneUp(){
-    uint16_t speed; 
-    uint32_t ii = 0;
-    TIM_Cmd( TIM3, ENABLE );
-    //down counting increases speed
-    for (speed = 40000; speed > 11800; speed-=100)
+//
+// Stop pulse generation straight away. The output is forced low as the
+// counter may be stopped part way through a pulse.
+//
+static void crane_halt(void)
+{
+    TIM_Cmd( TIM3, DISABLE );
+    TIM_ITConfig( TIM3, TIM_IT_Update, DISABLE );
+    TIM_ForcedOC3Config( TIM3, TIM_ForcedAction_InActive );
+    TIM_SelectOnePulseMode( TIM3, TIM_OPMode_Repetitive );
+    profile.state = PROFILE_IDLE;
+    homing = 0;
+}
+
+//
+// The step going out is the last. The output drops at the end of its
+// pulse and stays down, and the counter stops at the end of its period,
+// so no further edge goes to the driver or to TIM4. OC3M is written
+// directly as TIM_SelectOCxM() would turn the output off mid pulse.
+//
+static void crane_last_step(void)
+{
+    TIM3->CCMR2 = (TIM3->CCMR2 & ~TIM_CCMR2_OC3M) | TIM_OCMode_Inactive;
+    TIM_SelectOnePulseMode( TIM3, TIM_OPMode_Single );
+}
+
+//
+// Finish a stop begun by EXTI15_10_IRQHandler(). Pulses TIM4 counted after
+// the output went off never reached the driver. Runs at
+// CRANE_IRQ_PRIORITY or in a critical section.
+//
+static void crane_limit_stop(void)
+{
+    uint8_t was_homing = homing;
+    uint8_t hit;
+
+    // once idle the EXTI handler leaves limit_hit alone
+    crane_halt();
+    hit = limit_hit;
+    limit_hit = 0;
+    pulse_base += (uint16_t)(TIM4->CNT - limit_count);
+
+    if (hit & LIMIT_LOWER)
+    {
+        if (was_homing)
         {
-            vTaskDelay(1);
-            TIM_SetAutoreload(TIM3, speed);
+            move_origin = CRANE_HOME_POSITION;
+            pulse_base = crane_pulses();
+            homed = 1;
         }
-    //input logic here. 
-    
+        else
+            crane_log_fault(CRANE_FAULT_LOWER_LIMIT);
+    }
+    if (hit & LIMIT_UPPER)
+        crane_log_fault(CRANE_FAULT_UPPER_LIMIT);
+}
+
+static void crane_start(const struct crane_profile_cfg *cfg, int8_t dir, uint32_t steps)
+{
+    uint16_t period;
+
+    portENTER_CRITICAL();
+    if (limit_hit)
+        crane_limit_stop();
+    else
+        crane_halt();
+
+    if ((dir == CRANE_UP && crane_at_upper_limit()) ||
+        (dir == CRANE_DOWN && crane_at_lower_limit()))
+    {
+        crane_log_fault(dir == CRANE_UP ? CRANE_FAULT_UPPER_LIMIT : CRANE_FAULT_LOWER_LIMIT);
+        portEXIT_CRITICAL();
+        return;
+    }
+
+    crane_set_direction(dir);
+    GPIO_WriteBit( CRANE_PORT, CRANE_ENABLE_PIN, CRANE_ENABLE_LEVEL );
+
+    period = crane_profile_start(&profile, cfg, steps);
+    if (period == 0)
+    {
+        portEXIT_CRITICAL();
+        return;
+    }
+
+    // the update event loads the first period; the first pulse starts
+    // as the output goes back to PWM with the counter at 0
+    TIM_SetAutoreload( TIM3, period - 1 );
+    TIM_SetCounter( TIM3, 0 );
+    TIM_GenerateEvent( TIM3, TIM_EventSource_Update );
+    TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+    TIM_SelectOCxM( TIM3, TIM_Channel_3, TIM_OCMode_PWM1 );
+    TIM_CCxCmd( TIM3, TIM_Channel_3, TIM_CCx_Enable );
+    if (crane_profile_last(&profile))
+        crane_last_step();
+    TIM_ITConfig( TIM3, TIM_IT_Update, ENABLE );
+    TIM_Cmd( TIM3, ENABLE );
+    portEXIT_CRITICAL();
+}
+
+// Every update event ends a step period and, unless that step was the
+// last, starts the next pulse. The limit switch handler also pends this
+// interrupt to have its stop finished.
+void TIM3_IRQHandler( void )
+{
+    uint16_t period;
+
+    if (limit_hit)
+    {
+        TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+        crane_limit_stop();
+        return;
+    }
+
+    // pended for a stop that crane_start() has already finished
+    if (TIM_GetITStatus( TIM3, TIM_IT_Update ) == RESET)
+        return;
+    TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
+
+#ifdef CRANE_ENCODER
+    if ((profile.steps_done % CRANE_STALL_CHECK_STEPS) == 0 && crane_stalled())
+    {
+        crane_halt();
+        crane_log_fault(CRANE_FAULT_STALL);
+        return;
+    }
+#endif
+
+    period = crane_profile_next(&profile);
+    if (period == 0)
+    {
+        crane_halt();
+        return;
+    }
+    TIM3->ARR = period - 1;
+    if (crane_profile_last(&profile))
+        crane_last_step();
+}
+
+//
+// A closed limit switch stops any move heading into it. The lower switch
+// doubles as the home reference.
+//
+// Nothing below this priority writes CCER while a move is running, so a
+// step interrupt this preempts cannot turn the output back on. It is
+// pended to do the rest, and checks limit_hit before writing anything.
+//
+void EXTI15_10_IRQHandler( void )
+{
+    uint8_t hit = 0;
+
+    if (EXTI_GetITStatus( CRANE_LOWER_LIMIT_LINE ) != RESET)
+    {
+        EXTI_ClearITPendingBit( CRANE_LOWER_LIMIT_LINE );
+        if (profile.state != PROFILE_IDLE && move_dir == CRANE_DOWN)
+            hit |= LIMIT_LOWER;
+    }
+
+    if (EXTI_GetITStatus( CRANE_UPPER_LIMIT_LINE ) != RESET)
+    {
+        EXTI_ClearITPendingBit( CRANE_UPPER_LIMIT_LINE );
+        if (profile.state != PROFILE_IDLE && move_dir == CRANE_UP)
+            hit |= LIMIT_UPPER;
+    }
+
+    if (hit)
+    {
+        TIM_CCxCmd( TIM3, TIM_Channel_3, TIM_CCx_Disable );
+        if (!limit_hit)
+            limit_count = TIM4->CNT;
+        limit_hit |= hit;
+        NVIC_SetPendingIRQ( TIM3_IRQn );
+    }
+}
+
+void crane_set_profile(const struct crane_profile_cfg *cfg)
+{
+    crane_cfg = *cfg;
+}
+
+void crane_get_profile(struct crane_profile_cfg *cfg)
+{
+    *cfg = crane_cfg;
+}
+
+portBASE_TYPE crane_is_running(void)
+{
+    return profile.state != PROFILE_IDLE;
+}
+
+portBASE_TYPE crane_move_to(int32_t position)
+{
+    int32_t here;
+
+    if (!homed || crane_is_running())
+        return pdFAIL;
+    if (position < CRANE_SOFT_MIN || position > CRANE_SOFT_MAX)
+        return pdFAIL;
+
+    here = crane_get_position();
+    if (position == here)
+        return pdPASS;
+
+    if (position > here)
+        crane_start(&crane_cfg, CRANE_UP, position - here);
+    else
+        crane_start(&crane_cfg, CRANE_DOWN, here - position);
+    return pdPASS;
+}
+
+//
+// Creep down at the start rate until the lower limit switch closes, which
+// then defines CRANE_HOME_POSITION.
+//
+void crane_home(void)
+{
+    struct crane_profile_cfg cfg = crane_cfg;
 
-    //then call vCraneStop();
+    portENTER_CRITICAL();
+    homed = 0;
+    if (crane_at_lower_limit())
+    {
+        if (limit_hit)
+            crane_limit_stop();
+        else
+            crane_halt();
+        move_origin = CRANE_HOME_POSITION;
+        pulse_base = crane_pulses();
+        homed = 1;
+    }
+    else
+    {
+        // homing is set before the step interrupt can run
+        cfg.cruise_rate = cfg.start_rate;
+        crane_start(&cfg, CRANE_DOWN, 0);
+        homing = 1;
+    }
+    portEXIT_CRITICAL();
+}
+
+//
+// Open ended runs stay inside the soft limits once the crane is homed.
+//
+void vCraneRun(uint16_t speed){
+    struct crane_profile_cfg cfg = crane_cfg;
+    int32_t here = crane_get_position();
+
+    cfg.cruise_rate = speed;
+    if (homed)
+    {
+        if (here < CRANE_SOFT_MAX)
+            crane_start(&cfg, CRANE_UP, CRANE_SOFT_MAX - here);
+    }
+    else
+        crane_start(&cfg, CRANE_UP, 0);
+}
+
+void vCraneUp(){
+    vCraneRun(crane_cfg.cruise_rate);
 }
 
 void vCraneStop(){
-    
-    uint16_t currentSpeed = TIM3->ARR, setSpeed;
-    //up counting decreases speed... then stop when steps get too large
-    for (setSpeed = currentSpeed; setSpeed < 40000; setSpeed+=100)
+    portENTER_CRITICAL();
+    crane_profile_stop(&profile);
+    portEXIT_CRITICAL();
+}
+
+void vCraneDisable(void){
+    portENTER_CRITICAL();
+    crane_halt();
+    portEXIT_CRITICAL();
+    GPIO_WriteBit( CRANE_PORT, CRANE_ENABLE_PIN, !CRANE_ENABLE_LEVEL );
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Crane controller task
+////////////////////////////////////////////////////////////////////////////
+
+xQueueHandle xCraneQueue;
+
+static struct crane_status crane_status;
+static struct crane_cmd    crane_active;   // command being executed
+static struct crane_cmd    crane_pending;  // waiting for the active one to ramp down
+static uint8_t             have_active, have_pending;
+
+static void crane_report(uint8_t state)
+{
+    crane_status.state = state;
+    crane_status.position = crane_get_position();
+    if (crane_active.callback)
+        crane_active.callback(&crane_status);
+}
+
+static void crane_execute(const struct crane_cmd *cmd)
+{
+    portBASE_TYPE ok = pdPASS;
+
+    crane_active = *cmd;
+    have_active = 1;
+    crane_status.cmd = cmd->type;
+    crane_status.target = cmd->position;
+
+    switch (cmd->type)
     {
-        vTaskDelay(1);
-        TIM_SetAutoreload(TIM3, setSpeed);
+    case CRANE_CMD_MOVE:
+        ok = crane_move_to(cmd->position);
+        break;
+    case CRANE_CMD_HOME:
+        crane_status.target = CRANE_HOME_POSITION;
+        crane_home();
+        break;
+    default:
+        break;
     }
-    TIM_Cmd( TIM3, DISABLE );
+
+    if (ok != pdPASS)
+    {
+        crane_report(CRANE_FAILED);
+        have_active = 0;
+    }
+    else
+        crane_report(CRANE_MOVING);
 }
 
+void vCraneTask( void *pvParameters )
+{
+    struct crane_cmd cmd;
 
-void manual_crane_applet(){
-    lcd_printf(30,0,  20, "MANUAL CRANE", Green, Black);
-    lcd_printf(30,16, 20, "Green = UP", Green, Black);
-    lcd_printf(30,32, 20, "Red = Stop", Green, Black);
-//    lcd_draw_buttons();
+    for (;;)
+    {
+        if (xQueueReceive(xCraneQueue, &cmd, have_active ? CRANE_PROGRESS_MS : portMAX_DELAY) == pdTRUE)
+        {
+            switch (cmd.type)
+            {
+            case CRANE_CMD_ESTOP:
+                // the motor has already been stopped by crane_estop()
+                have_pending = 0;
+                if (have_active)
+                {
+                    crane_report(CRANE_STOPPED);
+                    have_active = 0;
+                }
+                break;
+
+            case CRANE_CMD_STOP:
+                have_pending = 0;
+                vCraneStop();
+                break;
+
+            default:
+                if (have_active)
+                {
+                    // latest command wins: ramp down then run it
+                    crane_pending = cmd;
+                    have_pending = 1;
+                    vCraneStop();
+                }
+                else
+                    crane_execute(&cmd);
+                break;
+            }
+        }
+
+        if (!have_active)
+            continue;
+
+        if (crane_is_running())
+        {
+            crane_report(CRANE_MOVING);
+            continue;
+        }
+
+        if (crane_active.type == CRANE_CMD_HOME && !crane_is_homed())
+            crane_report(CRANE_FAILED);
+        else if (crane_active.type == CRANE_CMD_MOVE &&
+                 crane_get_position() != crane_active.position)
+            crane_report(CRANE_STOPPED);
+        else
+            crane_report(CRANE_DONE);
+        have_active = 0;
+
+        if (have_pending)
+        {
+            have_pending = 0;
+            crane_execute(&crane_pending);
+        }
+    }
 }
 
-/*
-void manual_crane_key(uint16_t x, uint16_t y){
+void crane_task_init(void)
+{
+    xCraneQueue = xQueueCreate(CRANE_QUEUE_SIZE, sizeof(struct crane_cmd));
+}
 
-    uint16_t window = 0;
-    static uint16_t last_window = 0; 
-    
-    if (touchIsInWindow(x,y, 0,0, 150,50) == pdTRUE)
-        window = 0;
-    
-    else  if (touchIsInWindow(x,y, 0,50, 150,100) == pdTRUE)
-        window = 1;
-    
-    
-    else  if (touchIsInWindow(x,y, 0,100, 150,150) == pdTRUE)
-        window = 2;
+static portBASE_TYPE crane_post(uint8_t type, int32_t position,
+                                void (*callback)(const struct crane_status *))
+{
+    struct crane_cmd cmd;
 
-    
-    else  if (touchIsInWindow(x,y, 0,150, 150,200) == pdTRUE)
-        window = 3;
-    
-    else  if (touchIsInWindow(x,y, 0,200, 150,250) == pdTRUE)
-        window = 4;
-    
-    
-    else  if (touchIsInWindow(x,y, 0,250, 150,300) == pdTRUE)
-        window = 5;
-    
-    else  if (touchIsInWindow(x,y, 160, 0, 230,100) == pdTRUE)
-        window = 6;
+    cmd.type = type;
+    cmd.position = position;
+    cmd.callback = callback;
+    return xQueueSendToBack(xCraneQueue, &cmd, 0);
+}
 
-    else  if (touchIsInWindow(x,y, 160, 100, 230,200) == pdTRUE)
-        window = 7;
+portBASE_TYPE crane_post_move(int32_t position, void (*callback)(const struct crane_status *))
+{
+    return crane_post(CRANE_CMD_MOVE, position, callback);
+}
 
-    else  if (touchIsInWindow(x,y, 160, 200, 230,300) == pdTRUE)
-        window = 8;
-    else window = 255;
+portBASE_TYPE crane_post_home(void (*callback)(const struct crane_status *))
+{
+    return crane_post(CRANE_CMD_HOME, 0, callback);
+}
 
-    
-    //Back Button
-    if (window == 6)
+portBASE_TYPE crane_post_stop(void)
+{
+    return crane_post(CRANE_CMD_STOP, 0, NULL);
+}
+
+//
+// Emergency stop. Pulses stop before this returns, without waiting for
+// any ramp; the controller task is told afterwards so it can drop queued
+// work and report. The driver stays disabled until the next move.
+//
+void crane_estop(void)
+{
+    struct crane_cmd cmd = { CRANE_CMD_ESTOP, 0, NULL };
+
+    vCraneDisable();
+    crane_log_fault(CRANE_FAULT_ESTOP);
+    xQueueSendToFront(xCraneQueue, &cmd, 0);
+}
+
+void crane_estop_from_isr(portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+    struct crane_cmd cmd = { CRANE_CMD_ESTOP, 0, NULL };
+
+    crane_halt();
+    GPIO_WriteBit( CRANE_PORT, CRANE_ENABLE_PIN, !CRANE_ENABLE_LEVEL );
+    crane_log_fault(CRANE_FAULT_ESTOP);
+    xQueueSendToFrontFromISR(xCraneQueue, &cmd, pxHigherPriorityTaskWoken);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Manual crane applet
+////////////////////////////////////////////////////////////////////////////
+
+static const char *crane_state_text[] = { "MOVING", "DONE", "STOPPED", "FAILED" };
+static volatile uint8_t crane_applet_active;
+
+static void manual_crane_status(const struct crane_status *status)
+{
+    if (!crane_applet_active)
+        return;
+    lcd_printf(0, 13, 40, "Pos %ld  %s", (long)status->position,
+               crane_state_text[status->state]);
+}
+
+void manual_crane_applet(int init){
+    crane_applet_active = init;
+    if (!init)
+        return;
+
+    lcd_printf(0, 0, 40, "MANUAL CRANE");
+    lcd_DrawRect(0,   20, 159,  79, Green);
+    lcd_DrawRect(0,   80, 159, 139, Green);
+    lcd_DrawRect(0,  140, 159, 199, Green);
+    lcd_DrawRect(160, 20, 319, 139, Red);
+    lcd_DrawRect(160,140, 319, 199, Blue);
+    lcd_printf(6,  3, 8, "UP");
+    lcd_printf(6,  6, 8, "DOWN");
+    lcd_printf(6, 10, 8, "HOME");
+    lcd_printf(26, 4, 8, "STOP");
+    lcd_printf(26,10, 8, "BACK");
+    lcd_printf(0, 13, 40, "Pos %ld  %s", (long)crane_get_position(),
+               crane_is_homed() ? "" : "NOT HOMED");
+}
+
+//
+// UP and DOWN jog towards the soft limits for as long as they are held.
+//
+int manual_crane_key(int xx, int yy){
+    static uint8_t jogging = 0;
+
+    if (xx < 0 || yy < 0)
     {
-        vCraneStop();
-      
+        if (jogging)
+            crane_post_stop();
+        jogging = 0;
+        return 0;
     }
-  
-    else if (window == 7){
-        vCraneUp();
-  
+
+    if (xx < 160)
+    {
+        if (yy >= 20 && yy < 140)
+        {
+            if (!crane_is_homed())
+            {
+                lcd_printf(0, 13, 40, "Home the crane first");
+                return 0;
+            }
+            crane_post_move(yy < 80 ? CRANE_SOFT_MAX : CRANE_SOFT_MIN, manual_crane_status);
+            jogging = 1;
+        }
+        else if (yy >= 140 && yy < 200)
+            crane_post_home(manual_crane_status);
+    }
+    else
+    {
+        if (yy >= 20 && yy < 140)
+            crane_estop();
+        else if (yy >= 140 && yy < 200)
+        {
+            crane_post_stop();
+            return 1;
+        }
     }
-  
-    else if (window == 8){
-        vCraneStop();
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Crane fault list
+////////////////////////////////////////////////////////////////////////////
+
+void crane_faults_applet(int init){
+    struct crane_fault fault;
+    uint32_t ii;
 
+    if (!init)
+        return;
+
+    lcd_printf(0, 0, 40, "CRANE FAULTS (%lu total)", (unsigned long)crane_fault_count());
+    for (ii = 0; ii < 12; ii++)
+    {
+        if (crane_get_fault(ii, &fault) != pdPASS)
+            break;
+        lcd_printf(0, ii + 2, 40, "%6lu.%03lus %-11s pos %ld",
+                   fault.time_ms / 1000, fault.time_ms % 1000,
+                   crane_fault_name(fault.type), (long)fault.position);
     }
+    lcd_printf(0, 14, 40, "Touch to go back");
+}
 
+int crane_faults_key(int xx, int yy){
+    return xx >= 0 && yy >= 0;
 }
-*/
@@ -13,15 +13,138 @@
 #ifndef CRANE_H
 #define CRANE_H
 
-#define CRANE_ENABLE_PIN GPIO_Pin_7
+#define CRANE_ENABLE_PIN GPIO_Pin_7 // LED D2 on the board, not used as one
 #define CRANE_STEP_PIN GPIO_Pin_8
 #define CRANE_DIR_PIN GPIO_Pin_9
 #define CRANE_PORT GPIOC
 
+#define CRANE_ENABLE_LEVEL 0       // driver enable is active low
+#define CRANE_DIR_UP_LEVEL 1
+
+#define CRANE_LOWER_LIMIT_PIN GPIO_Pin_11
+#define CRANE_UPPER_LIMIT_PIN GPIO_Pin_12
+#define CRANE_LIMIT_PORT GPIOC
+#define CRANE_LIMIT_ACTIVE 0       // switches pull the input to ground
+#define CRANE_LIMIT_PORT_SOURCE       GPIO_PortSourceGPIOC
+#define CRANE_LOWER_LIMIT_PIN_SOURCE  GPIO_PinSource11
+#define CRANE_UPPER_LIMIT_PIN_SOURCE  GPIO_PinSource12
+#define CRANE_LOWER_LIMIT_LINE        EXTI_Line11
+#define CRANE_UPPER_LIMIT_LINE        EXTI_Line12
+
+// Define CRANE_ENCODER when a quadrature encoder is fitted to the crane
+// shaft (TIM5 on PA0/PA1). The step interrupt then compares commanded
+// steps with encoder counts and stops the crane on a stall.
+//#define CRANE_ENCODER
+#define CRANE_ENCODER_COUNTS_PER_STEP 4
+#define CRANE_STALL_CHECK_STEPS       16
+#define CRANE_STALL_COUNTS            (8 * CRANE_ENCODER_COUNTS_PER_STEP)
+
+#define CRANE_UP    1
+#define CRANE_DOWN -1
+
+// Positions are in steps above the lower limit switch
+#define CRANE_HOME_POSITION 0
+#define CRANE_SOFT_MIN      50
+#define CRANE_SOFT_MAX      12000
+
+// Step pulse width in us, and the default motion profile
+#define CRANE_PULSE_US    5
+#define CRANE_START_RATE  35     // steps/s
+#define CRANE_CRUISE_RATE 120    // steps/s
+#define CRANE_ACCEL       300    // steps/s^2
+#define CRANE_JERK        3000   // steps/s^3, 0 for a trapezoidal ramp
+
+// Numerically lowest priority allowed to use the FreeRTOS FromISR API
+#define CRANE_IRQ_PRIORITY 11
+// Above the kernel's mask, so critical sections never delay a limit stop
+#define CRANE_LIMIT_IRQ_PRIORITY 4
+
+enum crane_fault_type
+{
+    CRANE_FAULT_LOWER_LIMIT,
+    CRANE_FAULT_UPPER_LIMIT,
+    CRANE_FAULT_STALL,
+    CRANE_FAULT_ESTOP
+};
+
+struct crane_fault
+{
+    uint32_t time_ms;    // ulUptimeMs when it happened
+    uint8_t  type;
+    int32_t  position;
+};
+
+#define CRANE_FAULT_LOG_SIZE 16
+
+#define CRANE_QUEUE_SIZE   4
+#define CRANE_PROGRESS_MS  100     // progress report period during a move
+
+enum crane_cmd_type
+{
+    CRANE_CMD_MOVE,
+    CRANE_CMD_HOME,
+    CRANE_CMD_STOP,
+    CRANE_CMD_ESTOP
+};
+
+enum crane_move_state
+{
+    CRANE_MOVING,
+    CRANE_DONE,
+    CRANE_STOPPED,   // stopped short of the target
+    CRANE_FAILED     // rejected, or homing did not find the switch
+};
+
+struct crane_status
+{
+    uint8_t cmd;
+    uint8_t state;
+    int32_t position;
+    int32_t target;
+};
+
+// Callbacks run on the crane task, every CRANE_PROGRESS_MS while moving
+// and once more when the command finishes.
+struct crane_cmd
+{
+    uint8_t type;
+    int32_t position;
+    void  (*callback)(const struct crane_status *status);
+};
+
+extern xQueueHandle xCraneQueue;
+
+struct crane_profile_cfg;
+
 void vCraneInit(void);
 void vCraneRun(uint16_t speed);
-void manual_crane_applet();
-void manual_crane_key(uint16_t x, uint16_t y);
+void vCraneUp(void);
+void vCraneStop(void);
+void vCraneDisable(void);
+void crane_home(void);
+portBASE_TYPE crane_move_to(int32_t position);
+int32_t crane_get_position(void);
+portBASE_TYPE crane_is_homed(void);
+void crane_set_profile(const struct crane_profile_cfg *cfg);
+void crane_get_profile(struct crane_profile_cfg *cfg);
+portBASE_TYPE crane_is_running(void);
+void crane_task_init(void);
+void vCraneTask( void *pvParameters );
+portBASE_TYPE crane_post_move(int32_t position, void (*callback)(const struct crane_status *));
+portBASE_TYPE crane_post_home(void (*callback)(const struct crane_status *));
+portBASE_TYPE crane_post_stop(void);
+void crane_estop(void);
+void crane_estop_from_isr(portBASE_TYPE *pxHigherPriorityTaskWoken);
+
+uint32_t crane_fault_count(void);
+portBASE_TYPE crane_get_fault(uint32_t nth, struct crane_fault *fault);
+const char *crane_fault_name(uint8_t type);
+void crane_clear_faults(void);
+
+void manual_crane_applet(int init);
+void crane_faults_applet(int init);
+int  crane_faults_key(int xx, int yy);
+int  manual_crane_key(int xx, int yy);
 
 #endif
 
@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Step rate profile generator for the crane stepper. Like the AVR446
+// scheme it works one step at a time, in integers, from the timer update
+// interrupt: the rate is integrated over the period of the step that has
+// just gone out, giving the period of the next one. Integrating the
+// acceleration as well (bounded by the jerk setting) turns the
+// trapezoidal ramp into an S-curve. Division remainders are carried over
+// so the ramp does not drift at low rates.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "crane_profile.h"
+
+#define TICKS_PER_Q8 (CRANE_TIMER_HZ / 256)
+
+static uint16_t rate_to_period(uint32_t rate_q8)
+{
+    return (uint16_t)(((uint32_t)CRANE_TIMER_HZ * 256) / rate_q8);
+}
+
+// velocity gained while an acceleration of `accel' is held
+static uint32_t accel_overshoot(const struct crane_profile *p, int32_t accel)
+{
+    uint32_t aa;
+
+    if (p->cfg.jerk == 0)
+        return 0;
+    aa = accel < 0 ? -accel : accel;
+    return (aa * aa) / (2 * (uint32_t)p->cfg.jerk);
+}
+
+uint32_t crane_profile_stop_distance(const struct crane_profile *p)
+{
+    uint32_t rate  = (p->rate_q8 >> 8);
+    uint32_t start = p->cfg.start_rate;
+    uint32_t dist;
+
+    if (p->state == PROFILE_IDLE)
+        return 0;
+
+    if (p->accel > 0)
+        rate += accel_overshoot(p, p->accel);
+    if (rate <= start)
+        return 0;
+
+    dist = (rate * rate - start * start) / (2 * (uint32_t)p->cfg.accel);
+
+    // with a jerk limit the deceleration has to be ramped in and out
+    if (p->cfg.jerk)
+        dist += (rate * p->cfg.accel) / (2 * (uint32_t)p->cfg.jerk);
+
+    return dist;
+}
+
+uint16_t crane_profile_start(struct crane_profile *p,
+                             const struct crane_profile_cfg *cfg,
+                             uint32_t steps)
+{
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+
+    if (p->cfg.start_rate < CRANE_MIN_RATE)
+        p->cfg.start_rate = CRANE_MIN_RATE;
+    if (p->cfg.cruise_rate < p->cfg.start_rate)
+        p->cfg.cruise_rate = p->cfg.start_rate;
+    if (p->cfg.accel == 0)
+        p->cfg.accel = 1;
+
+    p->rate_q8 = (uint32_t)p->cfg.start_rate << 8;
+    p->steps = steps;
+    p->steps_done = 1;   // the first step goes out when the timer starts
+    p->period = rate_to_period(p->rate_q8);
+    p->state = PROFILE_ACCEL;
+
+    if (steps == 1)
+        p->state = PROFILE_DECEL;
+
+    return p->period;
+}
+
+void crane_profile_stop(struct crane_profile *p)
+{
+    if (p->state == PROFILE_IDLE || p->state == PROFILE_DECEL)
+        return;
+    p->state = PROFILE_DECEL;
+    p->stopping = 1;
+    p->rate_rem = 0;
+    p->accel_rem = 0;
+}
+
+uint16_t crane_profile_next(struct crane_profile *p)
+{
+    uint32_t dt = p->period;
+    uint32_t rate = p->rate_q8 >> 8;
+    uint32_t start_q8 = (uint32_t)p->cfg.start_rate << 8;
+    uint32_t cruise_q8 = (uint32_t)p->cfg.cruise_rate << 8;
+    int32_t  target;
+    uint32_t dv;
+
+    if (p->state == PROFILE_IDLE)
+        return 0;
+    if (crane_profile_last(p))
+    {
+        p->state = PROFILE_IDLE;
+        return 0;
+    }
+
+    p->steps_done++;
+
+    if (p->steps && p->state != PROFILE_DECEL &&
+        p->steps - p->steps_done <= crane_profile_stop_distance(p))
+    {
+        p->state = PROFILE_DECEL;
+        p->rate_rem = 0;
+        p->accel_rem = 0;
+    }
+
+    // acceleration we are heading for
+    switch (p->state)
+    {
+    case PROFILE_ACCEL:
+        target = (rate + accel_overshoot(p, p->accel) >= p->cfg.cruise_rate) ?
+            0 : p->cfg.accel;
+        break;
+    case PROFILE_DECEL:
+        target = (rate <= p->cfg.start_rate + accel_overshoot(p, p->accel)) ?
+            0 : -(int32_t)p->cfg.accel;
+        break;
+    default:
+        target = 0;
+        break;
+    }
+
+    // slew the acceleration, limited by jerk
+    if (p->cfg.jerk == 0)
+    {
+        p->accel = target;
+    }
+    else
+    {
+        int32_t da;
+
+        p->accel_rem += p->cfg.jerk * dt;
+        da = p->accel_rem / CRANE_TIMER_HZ;
+        p->accel_rem %= CRANE_TIMER_HZ;
+
+        if (p->accel < target)
+            p->accel = (p->accel + da > target) ? target : p->accel + da;
+        else if (p->accel > target)
+            p->accel = (p->accel - da < target) ? target : p->accel - da;
+    }
+
+    // integrate the rate over the step that has just been emitted
+    p->rate_rem += (uint32_t)(p->accel < 0 ? -p->accel : p->accel) * dt;
+    dv = p->rate_rem / TICKS_PER_Q8;
+    p->rate_rem %= TICKS_PER_Q8;
+
+    if (p->accel > 0)
+        p->rate_q8 += dv;
+    else if (p->accel < 0)
+        p->rate_q8 = (p->rate_q8 > dv) ? p->rate_q8 - dv : 0;
+
+    if (p->state == PROFILE_ACCEL && p->rate_q8 >= cruise_q8)
+    {
+        p->rate_q8 = cruise_q8;
+        p->accel = 0;
+        p->state = PROFILE_CRUISE;
+    }
+    else if (p->state == PROFILE_DECEL && p->rate_q8 <= start_q8 + 256)
+    {
+        p->rate_q8 = start_q8;
+        p->accel = 0;
+
+        // an open ended or stopped run is finished once it is back at
+        // the start rate, a counted move crawls the rest of the way
+        if (p->steps == 0 || p->stopping)
+            p->steps = p->steps_done;
+    }
+
+    p->period = rate_to_period(p->rate_q8);
+    return p->period;
+}
+
+uint8_t crane_profile_last(const struct crane_profile *p)
+{
+    return p->steps && p->steps_done >= p->steps;
+}
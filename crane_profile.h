@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CRANE_PROFILE_H
+#define CRANE_PROFILE_H
+
+#include <stdint.h>
+
+// Step timer tick rate. Periods handed back by crane_profile_next() are in
+// ticks of this clock.
+#define CRANE_TIMER_HZ     1000000
+#define CRANE_MIN_RATE     16       // keeps the period inside 16 bits
+
+struct crane_profile_cfg
+{
+    uint16_t start_rate;   // steps/s the move starts and finishes at
+    uint16_t cruise_rate;  // steps/s
+    uint16_t accel;        // steps/s^2
+    uint16_t jerk;         // steps/s^3, 0 gives a trapezoidal profile
+};
+
+enum crane_profile_state
+{
+    PROFILE_IDLE,
+    PROFILE_ACCEL,
+    PROFILE_CRUISE,
+    PROFILE_DECEL
+};
+
+struct crane_profile
+{
+    struct crane_profile_cfg cfg;
+    uint32_t rate_q8;      // current rate, steps/s << 8
+    int32_t  accel;        // current acceleration, steps/s^2
+    uint32_t rate_rem;     // remainders carried between steps so
+    uint32_t accel_rem;    // nothing is lost to integer truncation
+    uint32_t steps;        // steps in this move, 0 = run until stopped
+    uint32_t steps_done;
+    uint16_t period;       // ticks of the step that was just emitted
+    uint8_t  state;
+    uint8_t  stopping;     // cut short, ends at the start rate
+};
+
+// Returns the period of the first step, or 0 if there is nothing to do.
+uint16_t crane_profile_start(struct crane_profile *p,
+                             const struct crane_profile_cfg *cfg,
+                             uint32_t steps);
+
+// Begin decelerating to the start rate from wherever the profile is, and
+// end the move there even if it has steps left.
+void     crane_profile_stop(struct crane_profile *p);
+
+// Call at the end of every step period. Returns the period of the step
+// that starts now, or 0 when the one just finished was the last.
+uint16_t crane_profile_next(struct crane_profile *p);
+
+// 1 when the step going out now is the last, so the timer must not start
+// another at the end of its period
+uint8_t  crane_profile_last(const struct crane_profile *p);
+
+// Steps needed to come to rest from the current rate and acceleration.
+uint32_t crane_profile_stop_distance(const struct crane_profile *p);
+
+#endif
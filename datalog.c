@@ -0,0 +1,500 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Data logger, see datalog.h. Records are 32 bytes, eight to a 256 byte
+// flash page, and are written in order through the ring of sectors, each
+// with its own seq and CRC like the journal (journal.c).
+//
+// Records collect in a RAM copy of the page they will go to and the page
+// is programmed with one page program (sflash.c) when it is full, or
+// sooner for datalog_flush(), after which the rest of the page is
+// programmed into the still erased bytes. As the first page of a sector
+// is taken the sector after it is queued for erase, a whole sector before
+// it is needed. Programs and erases are submitted and their status looked
+// at on the next tick, so the task never waits on the chip; a page for a
+// sector whose erase hasn't finished is held back. An erase that fails
+// is tried again, and the sector's pages wait until one works. With a second page
+// buffer the records that come in during an erase, up to 3s on the
+// M25P64, wait in RAM.
+//
+// At start up the newest sector is the one whose first record has the
+// highest seq. A binary search on page first records finds its last
+// written page, and logging carries on in that page after its last
+// record, good or torn. That costs (sectors + 8) record reads, one page,
+// and a blank check of the sector ahead.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "datalog.h"
+#include "sflash.h"
+#include "timer.h"
+#include "ds1820.h"
+#include "heater.h"
+#include "brew.h"
+#include "cobs.h"
+#include "eeprom.h"
+
+typedef char datalog_rec_size_check[sizeof(struct datalog_rec) == DATALOG_REC_SIZE ? 1 : -1];
+
+#define RING_PAGES     (DATALOG_SECTORS * DATALOG_SECTOR_PAGES)
+#define NO_SECTOR      0xFFFF
+
+struct page_buf
+{
+    uint32_t page;           // in the ring
+    uint8_t  filled;         // records in data
+    uint8_t  written;        // of those, programmed
+    uint8_t  data[DATALOG_PAGE_SIZE];
+};
+
+static struct page_buf bufs[DATALOG_BUFFERS];
+static uint8_t  buf_first;       // oldest, the one being written out
+static uint8_t  buf_count;
+static uint32_t next_page;       // the next buffer goes here
+static uint32_t next_seq;
+static uint16_t erased_ahead = NO_SECTOR;
+static uint16_t erase_queue[2];
+static uint8_t  n_erase;
+static uint8_t  boot_flag = DATALOG_BOOT;
+static volatile uint8_t  flush_req;
+static volatile uint32_t period = DATALOG_PERIOD_MS;
+static uint32_t pages, erases, dropped, failed;
+
+static struct sflash_req prog_req, erase_req;
+static uint8_t  prog_to;         // filled when prog_req went in
+static uint16_t erasing = NO_SECTOR;
+static struct sflash_req task_read, dump_read;
+
+static uint32_t page_addr(uint32_t page)
+{
+    return DATALOG_BASE + page * DATALOG_PAGE_SIZE;
+}
+
+static uint32_t sector_addr(uint16_t sector)
+{
+    return DATALOG_BASE + (uint32_t)sector * DATALOG_SECTOR_SIZE;
+}
+
+static uint16_t rec_crc(const struct datalog_rec *rec)
+{
+    return crc16_ccitt(0xFFFF, (const uint8_t *)rec, DATALOG_REC_SIZE - sizeof(rec->crc));
+}
+
+static uint8_t rec_valid(const struct datalog_rec *rec)
+{
+    return rec->seq != 0xFFFFFFFF && rec_crc(rec) == rec->crc;
+}
+
+static uint8_t rec_erased(const struct datalog_rec *rec)
+{
+    const uint32_t *pp = (const uint32_t *)rec;
+    int ii;
+
+    for (ii = 0; ii < DATALOG_REC_SIZE / 4; ii++)
+        if (pp[ii] != 0xFFFFFFFF)
+            return 0;
+    return 1;
+}
+
+// Waits for it, with the task's or the dump's request
+static uint8_t flash_read(struct sflash_req *req, uint32_t addr, void *buf, uint16_t len)
+{
+    req->op = SFLASH_READ;
+    req->addr = addr;
+    req->buf = buf;
+    req->len = len;
+    return sflash_do(req);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Start up
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t sector_blank(uint16_t sector, uint8_t *page)
+{
+    const uint32_t *pp = (const uint32_t *)page;
+    uint32_t addr;
+    int ii;
+
+    for (addr = 0; addr < DATALOG_SECTOR_SIZE; addr += DATALOG_PAGE_SIZE)
+    {
+        flash_read(&task_read, sector_addr(sector) + addr, page, DATALOG_PAGE_SIZE);
+        for (ii = 0; ii < DATALOG_PAGE_SIZE / 4; ii++)
+            if (pp[ii] != 0xFFFFFFFF)
+                return 0;
+    }
+    return 1;
+}
+
+// Erasing, or waiting to be
+static uint8_t erase_pending(uint16_t sector)
+{
+    uint8_t ii;
+
+    if (sector == erasing)
+        return 1;
+    for (ii = 0; ii < n_erase; ii++)
+        if (erase_queue[ii] == sector)
+            return 1;
+    return 0;
+}
+
+// Pages are held while their sector is pending, so no more than the
+// sector after that one can be queued behind it
+static void queue_erase(uint16_t sector)
+{
+    if (!erase_pending(sector) && n_erase < sizeof(erase_queue) / sizeof(erase_queue[0]))
+        erase_queue[n_erase++] = sector;
+    erased_ahead = sector;
+}
+
+static void find_head(void)
+{
+    static uint8_t page[DATALOG_PAGE_SIZE];
+    const struct datalog_rec *recs = (const struct datalog_rec *)page;
+    struct datalog_rec rec;
+    uint32_t lo, hi, mid, first_seq = 0;
+    uint16_t sector, newest = NO_SECTOR;
+    int ii;
+
+    for (sector = 0; sector < DATALOG_SECTORS; sector++)
+    {
+        flash_read(&task_read, sector_addr(sector), &rec, sizeof(rec));
+        if (rec_valid(&rec) && (newest == NO_SECTOR || (int32_t)(rec.seq - first_seq) > 0))
+        {
+            newest = sector;
+            first_seq = rec.seq;
+        }
+    }
+
+    if (newest == NO_SECTOR)
+    {
+        next_page = 0;
+        next_seq = 0;
+    }
+    else
+    {
+        // page lo is written, hi is not
+        lo = 0;
+        hi = DATALOG_SECTOR_PAGES;
+        while (hi - lo > 1)
+        {
+            mid = (lo + hi) / 2;
+            flash_read(&task_read, sector_addr(newest) + mid * DATALOG_PAGE_SIZE, &rec, sizeof(rec));
+            if (rec_erased(&rec))
+                hi = mid;
+            else
+                lo = mid;
+        }
+
+        flash_read(&task_read, sector_addr(newest) + lo * DATALOG_PAGE_SIZE, page, DATALOG_PAGE_SIZE);
+        for (ii = DATALOG_PAGE_RECS; ii > 0 && rec_erased(&recs[ii - 1]); ii--)
+            ;
+
+        // every slot since the start of the sector has used a seq
+        next_page = newest * DATALOG_SECTOR_PAGES + lo;
+        next_seq = first_seq + lo * DATALOG_PAGE_RECS + ii;
+        if (ii < DATALOG_PAGE_RECS)
+        {
+            // carry on filling it
+            bufs[0].page = next_page;
+            bufs[0].filled = ii;
+            bufs[0].written = ii;
+            buf_count = 1;
+        }
+        next_page = (next_page + 1) % RING_PAGES;
+    }
+
+    // the sector the next new page goes in, if it starts one, or the one after
+    sector = next_page / DATALOG_SECTOR_PAGES;
+    if (next_page % DATALOG_SECTOR_PAGES)
+        sector = (sector + 1) % DATALOG_SECTORS;
+    if (sector_blank(sector, page))
+        erased_ahead = sector;
+    else
+        queue_erase(sector);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Logging
+////////////////////////////////////////////////////////////////////////////
+
+static struct page_buf *new_buf(void)
+{
+    struct page_buf *buf;
+    uint16_t ahead;
+
+    if (buf_count == DATALOG_BUFFERS)
+        return NULL;
+    buf = &bufs[(buf_first + buf_count) % DATALOG_BUFFERS];
+    buf->page = next_page;
+    buf->filled = 0;
+    buf->written = 0;
+    buf_count++;
+    next_page = (next_page + 1) % RING_PAGES;
+
+    if (buf->page % DATALOG_SECTOR_PAGES == 0)
+    {
+        ahead = (buf->page / DATALOG_SECTOR_PAGES + 1) % DATALOG_SECTORS;
+        if (ahead != erased_ahead)
+            queue_erase(ahead);
+    }
+    return buf;
+}
+
+static void sample(struct datalog_rec *rec)
+{
+    struct heater_status hs;
+    struct brew_status bs;
+    int ii;
+
+    rec->time = ulUptimeMs;
+    for (ii = 0; ii < 4; ii++)
+        rec->temp[ii] = ds1820_get_temp_c100(ii);
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        heater_get_status(ii, &hs);
+        rec->target[ii] = hs.target;
+        rec->output[ii] = hs.granted;
+        rec->mode[ii] = hs.mode;
+    }
+    brew_get_status(&bs);
+    rec->state = bs.state;
+    rec->step = bs.step;
+    rec->reserved = 0;
+}
+
+static void append(struct datalog_rec *rec)
+{
+    struct page_buf *buf = NULL;
+
+    if (buf_count)
+        buf = &bufs[(buf_first + buf_count - 1) % DATALOG_BUFFERS];
+    if (!buf || buf->filled == DATALOG_PAGE_RECS)
+        buf = new_buf();
+    if (!buf)
+    {
+        dropped++;
+        return;
+    }
+
+    rec->seq = next_seq++;
+    rec->flags = boot_flag;
+    boot_flag = 0;
+    rec->crc = rec_crc(rec);
+    memcpy(buf->data + buf->filled * DATALOG_REC_SIZE, rec, DATALOG_REC_SIZE);
+    buf->filled++;
+}
+
+static uint32_t unwritten(void)
+{
+    uint32_t nn = 0;
+    int ii;
+
+    for (ii = 0; ii < buf_count; ii++)
+    {
+        const struct page_buf *buf = &bufs[(buf_first + ii) % DATALOG_BUFFERS];
+
+        nn += buf->filled - buf->written;
+    }
+    return nn;
+}
+
+// Looks at what finished since last time and submits what is due
+static void service(void)
+{
+    struct page_buf *buf = &bufs[buf_first];
+    uint32_t offset;
+
+    if (erase_req.status == SFLASH_DONE)
+    {
+        erase_req.status = SFLASH_IDLE;
+        erasing = NO_SECTOR;
+    }
+    else if (erase_req.status == SFLASH_FAILED)
+    {
+        // failed or not taken; the same sector goes again
+        failed++;
+        erase_req.status = SFLASH_IDLE;
+    }
+    if (erase_req.status == SFLASH_IDLE && (erasing != NO_SECTOR || n_erase))
+    {
+        if (erasing == NO_SECTOR)
+        {
+            erasing = erase_queue[0];
+            erase_queue[0] = erase_queue[1];
+            n_erase--;
+        }
+        erase_req.op = SFLASH_ERASE;
+        erase_req.addr = sector_addr(erasing);
+        if (sflash_submit(&erase_req))
+            erases++;
+    }
+
+    if (prog_req.status == SFLASH_DONE || prog_req.status == SFLASH_FAILED)
+    {
+        // a failed page is given up on rather than holding up the rest
+        if (prog_req.status == SFLASH_DONE)
+            pages++;
+        else
+            failed++;
+        prog_req.status = SFLASH_IDLE;
+        buf->written = prog_to;
+        if (buf->written == DATALOG_PAGE_RECS)
+        {
+            buf_first = (buf_first + 1) % DATALOG_BUFFERS;
+            buf_count--;
+            buf = &bufs[buf_first];
+        }
+    }
+    if (prog_req.status == SFLASH_IDLE && buf_count && buf->written < buf->filled &&
+        (buf->filled == DATALOG_PAGE_RECS || flush_req) &&
+        !erase_pending(buf->page / DATALOG_SECTOR_PAGES))
+    {
+        offset = buf->written * DATALOG_REC_SIZE;
+        prog_to = buf->filled;
+        prog_req.op = SFLASH_PROGRAM;
+        prog_req.addr = page_addr(buf->page) + offset;
+        prog_req.buf = buf->data + offset;
+        prog_req.len = (prog_to - buf->written) * DATALOG_REC_SIZE;
+        sflash_submit(&prog_req);
+    }
+}
+
+void vDataLogTask( void *pvParameters )
+{
+    struct datalog_rec rec;
+    portTickType wake;
+    unsigned long due;
+
+    find_head();
+
+    due = ulUptimeMs;
+    wake = xTaskGetTickCount();
+    for (;;)
+    {
+        vTaskDelayUntil(&wake, DATALOG_TICK_MS / portTICK_RATE_MS);
+
+        if (period && (long)(ulUptimeMs - due) >= 0)
+        {
+            due = ulUptimeMs + period;
+            sample(&rec);
+            append(&rec);
+        }
+
+        service();
+        if (unwritten() == 0)
+            flush_req = 0;
+    }
+}
+
+void datalog_init(void)
+{
+    uint16_t ticks;
+
+    task_read.done = sflash_done_create();
+    dump_read.done = sflash_done_create();
+    if (eeprom_read(EEPROM_DATALOG_PERIOD, &ticks) == EEPROM_OK)
+        period = (uint32_t)ticks * DATALOG_TICK_MS;
+}
+
+void datalog_set_period(uint32_t ms)
+{
+    uint32_t ticks = ms / DATALOG_TICK_MS + (ms % DATALOG_TICK_MS >= DATALOG_TICK_MS / 2);
+
+    // only 0 stops it; runs the same after a restart as it does now
+    if (ms && ticks == 0)
+        ticks = 1;
+    if (ticks > 0xFFFF)
+        ticks = 0xFFFF;
+    period = ticks * DATALOG_TICK_MS;
+    eeprom_write(EEPROM_DATALOG_PERIOD, ticks);
+}
+
+void datalog_flush(void)
+{
+    flush_req = 1;
+}
+
+void datalog_get_status(struct datalog_status *status)
+{
+    taskENTER_CRITICAL();
+    status->period = period;
+    status->next_seq = next_seq;
+    status->head = buf_count ?
+        page_addr(bufs[(buf_first + buf_count - 1) % DATALOG_BUFFERS].page) +
+        bufs[(buf_first + buf_count - 1) % DATALOG_BUFFERS].filled * DATALOG_REC_SIZE :
+        page_addr(next_page);
+    status->buffered = unwritten();
+    status->pages = pages;
+    status->erases = erases;
+    status->dropped = dropped;
+    status->failed = failed;
+    taskEXIT_CRITICAL();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reading back
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t in_range(uint32_t seq, uint32_t start, uint32_t end)
+{
+    return (int32_t)(seq - start) >= 0 && (int32_t)(seq - end) < 0;
+}
+
+uint32_t datalog_dump(uint32_t n, uint8_t (*send)(const struct datalog_rec *rec))
+{
+    static uint8_t page[DATALOG_PAGE_SIZE];   // off the caller's stack
+    const struct datalog_rec *recs = (const struct datalog_rec *)page;
+    struct datalog_rec first;
+    uint32_t start, end, pp, sent = 0;
+    uint16_t head_sector, sector, ss;
+    int ii;
+
+    datalog_flush();
+    for (ii = 0; ii < 50 && flush_req; ii++)
+        vTaskDelay(DATALOG_TICK_MS / portTICK_RATE_MS);
+
+    taskENTER_CRITICAL();
+    end = next_seq;
+    head_sector = (next_page + RING_PAGES - 1) % RING_PAGES / DATALOG_SECTOR_PAGES;
+    taskEXIT_CRITICAL();
+    start = n && n < end ? end - n : end - 0x7FFFFFFF;
+
+    // the oldest sector is the one after the head
+    for (ss = 1; ss <= DATALOG_SECTORS; ss++)
+    {
+        sector = (head_sector + ss) % DATALOG_SECTORS;
+
+        // all older than wanted if the next sector starts before start
+        if (sector != head_sector)
+        {
+            flash_read(&dump_read, sector_addr((sector + 1) % DATALOG_SECTORS), &first, sizeof(first));
+            if (rec_valid(&first) && (int32_t)(first.seq - start) <= 0)
+                continue;
+        }
+
+        for (pp = 0; pp < DATALOG_SECTOR_PAGES; pp++)
+        {
+            flash_read(&dump_read, sector_addr(sector) + pp * DATALOG_PAGE_SIZE, page, DATALOG_PAGE_SIZE);
+            if (rec_erased(&recs[0]))
+                break;
+            for (ii = 0; ii < DATALOG_PAGE_RECS; ii++)
+            {
+                if (!rec_valid(&recs[ii]) || !in_range(recs[ii].seq, start, end))
+                    continue;
+                if (!send(&recs[ii]))
+                    return sent;
+                sent++;
+            }
+        }
+    }
+    return sent;
+}
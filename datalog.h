@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Brew data logger on the M25P64 SPI flash. A sample of the temperatures,
+// heater outputs and brew step is taken every period and kept in a ring
+// of 64K sectors, oldest overwritten, so the last couple of weeks of
+// brewing and standing around are always there to be dumped to the PC.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DATALOG_H
+#define DATALOG_H
+
+#include <stdint.h>
+
+// M25P64 geometry
+#define DATALOG_PAGE_SIZE     256
+#define DATALOG_SECTOR_SIZE   0x10000
+
+// The ring, leaving the top 512K of the 8M for other things
+#define DATALOG_BASE          0
+#define DATALOG_SECTORS       120
+
+#define DATALOG_PERIOD_MS     5000     // default sample period
+#define DATALOG_TICK_MS       100
+#define DATALOG_BUFFERS       2        // pages held in RAM, see datalog.c
+
+#define DATALOG_BOOT          0x01     // first record since a reset
+
+struct datalog_rec
+{
+    uint32_t seq;            // increases by one per record, 0xFFFFFFFF is erased
+    uint32_t time;           // ulUptimeMs
+    int16_t  temp[4];        // HLT, MASH, CABINET, AMBIENT, hundredths of a degree
+    int16_t  target[2];      // heater targets, hundredths of a degree
+    uint16_t output[2];      // heater power granted, tenths of a percent
+    uint8_t  state;          // enum brew_state
+    uint8_t  step;
+    uint8_t  mode[2];        // heater modes
+    uint8_t  flags;
+    uint8_t  reserved;
+    uint16_t crc;            // CRC-16/CCITT of the above; a torn write fails it
+};
+
+#define DATALOG_REC_SIZE      32
+#define DATALOG_PAGE_RECS     (DATALOG_PAGE_SIZE / DATALOG_REC_SIZE)
+#define DATALOG_SECTOR_PAGES  (DATALOG_SECTOR_SIZE / DATALOG_PAGE_SIZE)
+
+struct datalog_status
+{
+    uint32_t period;         // ms, 0 when stopped
+    uint32_t next_seq;
+    uint32_t head;           // flash address the next record goes to
+    uint32_t buffered;       // records not yet in flash
+    uint32_t pages;          // page programs since power up
+    uint32_t erases;
+    uint32_t dropped;        // records lost with both buffers waiting on the flash
+    uint32_t failed;         // programs given up on, erase attempts that failed
+};
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Before the scheduler starts, after sflash_init() and eeprom_open()
+void datalog_init(void);
+
+// Finds where it left off, then samples and writes
+void vDataLogTask( void *pvParameters );
+
+// Sample period in ms, 0 stops logging. Rounded to the nearest
+// DATALOG_TICK_MS, at least one, up to 109 minutes, and kept in the
+// emulated EEPROM.
+void datalog_set_period(uint32_t ms);
+
+// Programs any part page held in RAM now, rather than when it fills
+void datalog_flush(void);
+
+void datalog_get_status(struct datalog_status *status);
+
+// Reads the ring back oldest first, just the newest n records unless n
+// is 0, flushing the RAM pages first. Each good record goes to send,
+// which stops the dump by returning 0. Returns the records sent.
+uint32_t datalog_dump(uint32_t n, uint8_t (*send)(const struct datalog_rec *rec));
+
+#endif
@@ -1,47 +1,280 @@
 /* Scheduler includes. */
 #include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
 
 /* Library includes. */
 #include "stm32f10x.h"
 
+#include <string.h>
 #include "serial.h"
 /*-----------------------------------------------------------*/
 
-static uint32_t g_usart;
+/* Interrupt and DMA driven USART. Writers copy into the TX ring and the
+   DMA sends it out from there, one contiguous run of the ring per
+   transfer; the transfer complete interrupt frees the run and starts the
+   next. The RXNE interrupt puts received bytes in the RX ring.
+
+   Each ring has one producer and one consumer, and the head only moves on
+   the producer side and the tail on the consumer side, so the interrupts
+   never wait on a task. Tasks writing at the same time are kept apart by
+   a critical section round the copy, which also keeps each write whole on
+   the wire. The indexes run freely and are masked on use, so the ring
+   sizes must be powers of two. */
+
+struct serial_port
+{
+        USART_TypeDef *usart;
+        DMA_Channel_TypeDef *tx_dma;
+        uint32_t tx_dma_tc;
+        uint8_t usart_irq;
+        uint8_t dma_irq;
+};
+
+static const struct serial_port ports[] =
+{
+        { USART1, DMA1_Channel4, DMA1_FLAG_TC4, USART1_IRQn, DMA1_Channel4_IRQn },
+        { USART2, DMA1_Channel7, DMA1_FLAG_TC7, USART2_IRQn, DMA1_Channel7_IRQn },
+};
+
+static const struct serial_port *port;
+
+static char tx_buf[SERIAL_TX_SIZE];
+static volatile uint16_t tx_head, tx_tail;
+static volatile uint16_t tx_run;        /* bytes the DMA is sending, 0 when idle */
+
+static char rx_buf[SERIAL_RX_SIZE];
+static volatile uint16_t rx_head, rx_tail;
+static volatile uint32_t rx_overruns;
+
+static xSemaphoreHandle tx_space;       /* given as each transfer completes */
+static xSemaphoreHandle rx_ready;       /* given as bytes arrive */
+
+/* Called with the channel idle, from the interrupt or a critical section */
+static void tx_start(void)
+{
+        uint16_t at = tx_tail & (SERIAL_TX_SIZE - 1);
+        uint16_t run = tx_head - tx_tail;
+
+        if (run > SERIAL_TX_SIZE - at)
+                run = SERIAL_TX_SIZE - at;
+        tx_run = run;
+        if (run == 0)
+                return;
+
+        port->tx_dma->CCR &= ~DMA_CCR1_EN;
+        port->tx_dma->CMAR = (uint32_t)&tx_buf[at];
+        port->tx_dma->CNDTR = run;
+        port->tx_dma->CCR |= DMA_CCR1_EN;
+}
+
+static void tx_done(void)
+{
+        tx_tail += tx_run;
+        tx_run = 0;
+        tx_start();
+}
+
+static int scheduler_running(void)
+{
+        return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+/* Before the scheduler starts, or with interrupts off, nothing else will
+   service the DMA */
+static void tx_poll(void)
+{
+        taskENTER_CRITICAL();
+        if (tx_run && DMA_GetFlagStatus(port->tx_dma_tc) == SET)
+        {
+                DMA_ClearFlag(port->tx_dma_tc);
+                tx_done();
+        }
+        taskEXIT_CRITICAL();
+}
+
+static void tx_wait(void)
+{
+        if (scheduler_running())
+                xSemaphoreTake(tx_space, 10);
+        else
+                tx_poll();
+}
+
+int comm_write(const char *buf, int len, int block)
+{
+        int done = 0;
+
+        if (!port)
+                return 0;
+        if (!scheduler_running())
+                tx_poll();
+
+        for (;;)
+        {
+                uint16_t at, run, first;
+
+                taskENTER_CRITICAL();
+                run = SERIAL_TX_SIZE - (uint16_t)(tx_head - tx_tail);
+                if (run > len - done)
+                        run = len - done;
+
+                /* in two pieces if it wraps */
+                at = tx_head & (SERIAL_TX_SIZE - 1);
+                first = run < SERIAL_TX_SIZE - at ? run : SERIAL_TX_SIZE - at;
+                memcpy(&tx_buf[at], buf + done, first);
+                memcpy(tx_buf, buf + done + first, run - first);
+                tx_head += run;
+
+                if (tx_run == 0)
+                        tx_start();
+                taskEXIT_CRITICAL();
+
+                done += run;
+                if (done >= len || !block)
+                        return done;
+                tx_wait();
+        }
+}
+
+int comm_tx_space(void)
+{
+        return SERIAL_TX_SIZE - (uint16_t)(tx_head - tx_tail);
+}
+
+void comm_flush(void)
+{
+        while (port && (tx_run || tx_head != tx_tail))
+                tx_wait();
+}
+
+int comm_read(char *buf, int len, int block)
+{
+        int done = 0;
+
+        while (done < len)
+        {
+                if (rx_head == rx_tail)
+                {
+                        if (done || !block)
+                                break;
+                        if (scheduler_running())
+                                xSemaphoreTake(rx_ready, portMAX_DELAY);
+                        continue;
+                }
+                buf[done++] = rx_buf[rx_tail & (SERIAL_RX_SIZE - 1)];
+                rx_tail++;
+        }
+        return done;
+}
+
+uint32_t comm_rx_overruns(void)
+{
+        return rx_overruns;
+}
+
+void comm_clear_stats(void)
+{
+        rx_overruns = 0;
+}
 
 int comm_test(void)
 {
-        return ( USART_GetFlagStatus(g_usart, USART_FLAG_RXNE) == RESET ) ? 0 : 1;
+        return rx_head != rx_tail;
 }
 
 char comm_get(void)
 {
-        while(USART_GetFlagStatus(g_usart, USART_FLAG_RXNE) == RESET) { ; }
-        return (char)USART_ReceiveData(g_usart);
+        char c;
+
+        comm_read(&c, 1, 1);
+        return c;
 }
 
 void comm_put(char d)
 {
-        while(USART_GetFlagStatus(g_usart, USART_FLAG_TXE) == RESET) { ; }
-        USART_SendData(g_usart, (uint16_t)d);
+        comm_write(&d, 1, 1);
 }
 
 void comm_puts(const char* s)
 {
-        char c;
-        while ( ( c = *s++) != '\0' ) {
-                comm_put(c);
+        comm_write(s, strlen(s), 1);
+}
+
+/*-----------------------------------------------------------*/
+/* Interrupts */
+
+static void serial_usart_irq(void)
+{
+        portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+        /* reading DR after SR also clears an overrun */
+        if (port->usart->SR & (USART_FLAG_RXNE | USART_FLAG_ORE))
+        {
+                char c = (char)port->usart->DR;
+
+                if ((uint16_t)(rx_head - rx_tail) < SERIAL_RX_SIZE)
+                {
+                        rx_buf[rx_head & (SERIAL_RX_SIZE - 1)] = c;
+                        rx_head++;
+                }
+                else
+                        rx_overruns++;
+                xSemaphoreGiveFromISR(rx_ready, &xHigherPriorityTaskWoken);
+        }
+        portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+
+static void serial_dma_irq(void)
+{
+        portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+        if (DMA_GetFlagStatus(port->tx_dma_tc) == SET)
+        {
+                DMA_ClearFlag(port->tx_dma_tc);
+                if (tx_run)
+                        tx_done();
+                xSemaphoreGiveFromISR(tx_space, &xHigherPriorityTaskWoken);
         }
+        portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+
+void USART1_IRQHandler(void)
+{
+        serial_usart_irq();
+}
+
+void USART2_IRQHandler(void)
+{
+        serial_usart_irq();
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+        serial_dma_irq();
 }
 
-void USARTInit(uint16_t tx_pin, uint16_t rx_pin, uint32_t usart)
+void DMA1_Channel7_IRQHandler(void)
+{
+        serial_dma_irq();
+}
+
+/*-----------------------------------------------------------*/
+
+void USARTInit(uint16_t tx_pin, uint16_t rx_pin, USART_TypeDef *usart)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
-        
+        DMA_InitTypeDef DMA_InitStructure;
+        NVIC_InitTypeDef NVIC_InitStructure;
 
 	USART_InitTypeDef USART_InitStructure;
 	USART_ClockInitTypeDef  USART_ClockInitStructure;
-	g_usart = usart; // keep track of which USART we are using
+	port = &ports[usart == USART1 ? 0 : 1]; // keep track of which USART we are using
+
+        vSemaphoreCreateBinary(tx_space);
+        xSemaphoreTake(tx_space, 0);
+        vSemaphoreCreateBinary(rx_ready);
+        xSemaphoreTake(rx_ready, 0);
 
 	//enable bus clocks
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_AFIO, ENABLE);
@@ -49,6 +282,7 @@ void USARTInit(uint16_t tx_pin, uint16_t rx_pin, uint32_t usart)
 	    RCC_APB2PeriphClockCmd( RCC_APB2Periph_USART1, ENABLE );
 	else
 	    RCC_APB1PeriphClockCmd( RCC_APB1Periph_USART2, ENABLE);
+        RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
 
 	//Configure USART1 Tx (PA.02) as alternate function push-pull
 	GPIO_InitStructure.GPIO_Pin = tx_pin;
@@ -77,11 +311,38 @@ void USARTInit(uint16_t tx_pin, uint16_t rx_pin, uint32_t usart)
         USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
 
         /* Configure USART2 */
-        USART_Init(g_usart, &USART_InitStructure);
-        
+        USART_Init(port->usart, &USART_InitStructure);
+
+        /* TX DMA, the address and count are set per transfer */
+        DMA_DeInit(port->tx_dma);
+        DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&port->usart->DR;
+        DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)tx_buf;
+        DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+        DMA_InitStructure.DMA_BufferSize = 1;
+        DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+        DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+        DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+        DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+        DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+        DMA_Init(port->tx_dma, &DMA_InitStructure);
+        DMA_ITConfig(port->tx_dma, DMA_IT_TC, ENABLE);
+
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = SERIAL_IRQ_PRIORITY;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_InitStructure.NVIC_IRQChannel = port->dma_irq;
+        NVIC_Init(&NVIC_InitStructure);
+        NVIC_InitStructure.NVIC_IRQChannel = port->usart_irq;
+        NVIC_Init(&NVIC_InitStructure);
+
+        USART_DMACmd(port->usart, USART_DMAReq_Tx, ENABLE);
+        USART_ITConfig(port->usart, USART_IT_RXNE, ENABLE);
+
         /* Enable the USART1 */
-        USART_Cmd(g_usart, ENABLE);
-        
+        USART_Cmd(port->usart, ENABLE);
+
         comm_puts("TEST\r\n");
 }
 
@@ -1,7 +1,8 @@
 #ifndef SERIAL_COMMS_H
 #define SERIAL_COMMS_H
 
-typedef void * xComPortHandle;
+#include <stdint.h>
+#include "stm32f10x.h"
 
 typedef enum
 { 
@@ -38,33 +39,29 @@ typedef enum
 	serBITS_8 
 } eDataBits;
 
-typedef enum 
-{ 
-	ser50,		
-	ser75,		
-	ser110,		
-	ser134,		
-	ser150,    
-	ser200,
-	ser300,		
-	ser600,		
-	ser1200,	
-	ser1800,	
-	ser2400,   
-	ser4800,
-	ser9600,		
-	ser19200,	
-	ser38400,	
-	ser57600,	
-	ser115200
-} eBaud;
-
 #define USART_PARAMS1 GPIO_Pin_9, GPIO_Pin_10, USART1
 #define USART_PARAMS2 GPIO_Pin_2, GPIO_Pin_3,  USART2
 
+/* Ring sizes, powers of two. printf costs a copy into the TX ring unless
+   it is full. */
+#define SERIAL_TX_SIZE      1024
+#define SERIAL_RX_SIZE      128
+#define SERIAL_IRQ_PRIORITY 14
+
+/* block waits for room, or for the first byte to read; otherwise these
+   return how much they could do straight away */
+int  comm_write(const char *buf, int len, int block);
+int  comm_read(char *buf, int len, int block);
+void comm_flush(void);               /* until the TX ring is on the wire */
+int  comm_tx_space(void);
+uint32_t comm_rx_overruns(void);
+void comm_clear_stats(void);
+
+int  comm_test(void);                /* anything to read */
+char comm_get(void);
 void comm_put(char d);
 void comm_puts(const char* s);
-void USARTInit(uint16_t tx_pin, uint16_t rx_pin, uint32_t clock);
+void USARTInit(uint16_t tx_pin, uint16_t rx_pin, USART_TypeDef *usart);
 
 #endif
 
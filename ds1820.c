@@ -11,16 +11,15 @@
 #include <stdlib.h>
 #include "ds1820.h"
 #include "queue.h"
-#include "console.h"
 #include "lcd.h"
+#include "timer.h"
+#include "abfilter.h"
+#include "sensor.h"
+#include "kv.h"
 
+#define LOG_MODULE LOG_MOD_DS1820
+#include "log.h"
 
-// ROM COMMANDS
-#define MATCH_ROM	0x55
-#define	SEARCH_ROM	0xF0
-#define SKIP_ROM	0xCC
-#define READ_ROM        0x33
-#define ALARM_SEARCH    0xEC
 
 // FUNCTION COMMANDS
 #define CONVERT_TEMP     0x44
@@ -32,58 +31,44 @@
 
 #define MAX_SENSORS      10
 
-// ERROR DEFINES
-#define BUS_ERROR      0xFE
-#define PRESENCE_ERROR 0xFD
-#define NO_ERROR       0x00
-
 //Default Temp Sensor Addresses
 #define HLT_TEMP_SENSOR "\x10\x9c\xa4\x1e\x02\x08\x00\xf"
 #define MASH_TEMP_SENSOR "\x10\xe3\x9b\x1e\x02\x08\x00\x58"
 #define CABINET_TEMP_SENSOR "\x10\x99\xd7\x39\x01\x08\x00\xd5"
 #define AMBIENT_TEMP_SENSOR "\x10\xe3\x9b\x1e\x02\x08\x00\x32"
 
-// BUS COMMANDS
-#define DQ_IN()  {DS1820_PORT->CRH&=0xFFFFF0FF;DS1820_PORT->CRH |= 0x00000400;}
-#define DQ_OUT() {DS1820_PORT->CRH&=0xFFFFF0FF;DS1820_PORT->CRH |= 0x00000300;}
-#define DQ_SET()   GPIO_SetBits(DS1820_PORT, DS1820_PIN)
-#define DQ_RESET() GPIO_ResetBits(DS1820_PORT, DS1820_PIN)
-#define DQ_READ()  GPIO_ReadInputDataBit(DS1820_PORT, DS1820_PIN)
-
 // STATIC FUNCTIONS
 static void ds1820_convert(void);
-static void ds1820_init(void);
-static unsigned char ds1820_reset(void);
-static void ds1820_write_bit(uint8_t bit);
-static uint8_t ds1820_read_bit(void);
-static void ds1820_write_byte(uint8_t byte);
-static uint8_t ds1820_read_byte(void);
-static void ds1820_convert(void);
 static uint8_t ds1820_search();
-static float ds1820_read_device(uint8_t * rom_code);
-static void delay_us(uint16_t count); 
+static uint8_t ds1820_read_device(uint8_t * rom_code, int16_t * c100);
+static void ds1820_load_roms(void);
 
 
 
 
 uint8_t rom[8]; //temporary to store rom codes
 float temps[4]; // holds the converted temperatures from the devices
+static volatile int16_t temps_c100[4]; // the same in hundredths of a degree
+static volatile unsigned long sample_time; // ulUptimeMs of the last update
+static struct ab_filter filters[4]; // smoothed temperature and rate of rise
+static struct sensor sensors[4]; // fault state of each probe
+static volatile uint8_t expect_change[4]; // set while an element drives it
+static volatile uint8_t roms_changed; // ds1820_set_rom() saved a new code
 char * b[5]; // holds the 64 bit addresses of the temp sensors
 
 ////////////////////////////////////////////////////////////////////////////
 // Interfacing Function
 ////////////////////////////////////////////////////////////////////////////
 void vTaskDS1820Convert( void *pvParameters ){
-    char buf[30];
     int ii = 0;
+    uint32_t events;
 
 
     // initialise the bus
-    ds1820_init();
-    if (ds1820_reset() ==PRESENCE_ERROR)
+    ow_hw_init();
+    if (ow_reset() ==PRESENCE_ERROR)
     {
-        sprintf(buf, "NO SENSOR DETECTED\r\n");
-        xQueueSendToBack(xConsoleQueue, &buf, 1000);
+        LOG_ERROR("NO SENSOR DETECTED\r\n");
         vTaskDelete(NULL); // if this task fails... delete it
     }
   
@@ -99,32 +84,69 @@ void vTaskDS1820Convert( void *pvParameters ){
     memcpy(b[MASH], MASH_TEMP_SENSOR, sizeof(MASH_TEMP_SENSOR)+1);
     memcpy(b[CABINET], CABINET_TEMP_SENSOR, sizeof(CABINET_TEMP_SENSOR)+1);
     memcpy(b[AMBIENT], AMBIENT_TEMP_SENSOR, sizeof(AMBIENT_TEMP_SENSOR)+1);  
+    ds1820_load_roms();
 
+    for (ii = 0 ; ii < 4; ii++)
+        sensor_init(&sensors[ii]);
   
     
     for (;;)
     {
+        if (roms_changed)
+        {
+            roms_changed = 0;
+            ds1820_load_roms();
+        }
         ds1820_convert();
         
         vTaskDelay(2000); // wait for conversion
 
         // save values in array for use by application
+        events = sensor_event_count();
         for (ii = 0 ; ii < 4; ii++)
-            temps[ii] = ds1820_read_device(b[ii]);
+        {
+            int16_t raw = DS1820_TEMP_ERROR;
+            uint8_t read = ds1820_read_device(b[ii], &raw);
+            uint8_t state;
+
+            taskENTER_CRITICAL();
+            state = sensor_update(&sensors[ii], ii, read, raw, ulUptimeMs,
+                                  expect_change[ii]);
+
+            // a suspect reading is dropped and the last good one stands;
+            // a failed sensor starts its filter again when it comes back
+            if (state == SENSOR_FAILED)
+            {
+                temps_c100[ii] = DS1820_TEMP_ERROR;
+                ab_reset(&filters[ii]);
+            }
+            else
+            {
+                temps_c100[ii] = (int16_t)sensors[ii].value;
+                if (state == SENSOR_OK)
+                    ab_update(&filters[ii], temps_c100[ii], ulUptimeMs);
+            }
+            taskEXIT_CRITICAL();
+            temps[ii] = (float)temps_c100[ii] / 100;
+        }
+        sample_time = ulUptimeMs;
+
+        // log every change of state; the names are string constants
+        for (; events != sensor_event_count(); events++)
+        {
+            struct sensor_event ev;
+
+            if (!sensor_get_event(sensor_event_count() - 1 - events, &ev))
+                continue;
+            LOG_WARN("Sensor %d %s %s\r\n", ev.sensor,
+                     sensor_state_name(ev.state), sensor_fault_name(ev.fault));
+        }
 
                  
-      // Uncomment below to send temps to the console
-        /*
-        sprintf(buf, "HLT Temp = %.2fDeg-C\r\n", temps[HLT]);
-        xQueueSendToBack(xConsoleQueue, &buf, 100);
-        sprintf(buf, "Mash Temp = %.2fDeg-C\r\n", temps[MASH]);
-        xQueueSendToBack(xConsoleQueue, &buf, 100);
-        sprintf(buf, "Cabinet Temp = %.2fDeg-C\r\n", temps[CABINET]);
-        xQueueSendToBack(xConsoleQueue, &buf, 100);
-        sprintf(buf, "Ambient Temp = %.2fDeg-C\r\n", temps[AMBIENT]);
-        xQueueSendToBack(xConsoleQueue, &buf, 100);
-        */
-        
+        LOG_DEBUG("HLT %.2q Mash %.2q Cabinet %.2q Ambient %.2q\r\n",
+                  temps_c100[HLT], temps_c100[MASH], temps_c100[CABINET],
+                  temps_c100[AMBIENT]);
+
         taskYIELD();
     }
     
@@ -135,6 +157,86 @@ float ds1820_get_temp(unsigned char sensor){
     
     return temps[sensor];
 }
+
+int16_t ds1820_get_temp_c100(unsigned char sensor){
+    return temps_c100[sensor];
+}
+
+unsigned long ds1820_sample_time(void){
+    return sample_time;
+}
+
+int32_t ds1820_get_filtered_c100(unsigned char sensor){
+    int32_t temp;
+
+    taskENTER_CRITICAL();
+    temp = filters[sensor].primed ? ab_temp(&filters[sensor]) : DS1820_TEMP_ERROR;
+    taskEXIT_CRITICAL();
+    return temp;
+}
+
+int32_t ds1820_predict_c100(unsigned char sensor, unsigned long time){
+    int32_t temp;
+
+    taskENTER_CRITICAL();
+    temp = filters[sensor].primed ? ab_predict(&filters[sensor], time) : DS1820_TEMP_ERROR;
+    taskEXIT_CRITICAL();
+    return temp;
+}
+
+int32_t ds1820_get_rate(unsigned char sensor){
+    int32_t rate;
+
+    taskENTER_CRITICAL();
+    rate = ab_rate_per_min(&filters[sensor]);
+    taskEXIT_CRITICAL();
+    return rate;
+}
+
+uint8_t ds1820_sensor_state(unsigned char sensor){
+    return sensors[sensor].state;
+}
+
+uint8_t ds1820_sensor_fault(unsigned char sensor){
+    return sensors[sensor].fault;
+}
+
+void ds1820_expect_change(unsigned char sensor, uint8_t expect){
+    expect_change[sensor] = expect;
+}
+
+// Codes saved in the settings store replace the defaults above; one that
+// isn't a DS1820's, or a missing value, leaves the sensor's default.
+static void ds1820_load_roms(void){
+    uint8_t roms[4][8];
+    int ii;
+
+    if (kv_get(KV_SENSOR_ROMS, roms, sizeof(roms)) != sizeof(roms))
+        return;
+    for (ii = 0; ii < 4; ii++)
+        if (roms[ii][0] == 0x10 && ow_crc8(roms[ii], 8) == 0)
+            memcpy(b[ii], roms[ii], 8);
+}
+
+uint8_t ds1820_set_rom(unsigned char sensor, const uint8_t *code){
+    uint8_t roms[4][8];
+
+    if (sensor > AMBIENT || code[0] != 0x10 || ow_crc8(code, 8) != 0)
+        return 0;
+    if (kv_get(KV_SENSOR_ROMS, roms, sizeof(roms)) != sizeof(roms))
+    {
+        memcpy(roms[HLT], HLT_TEMP_SENSOR, 8);
+        memcpy(roms[MASH], MASH_TEMP_SENSOR, 8);
+        memcpy(roms[CABINET], CABINET_TEMP_SENSOR, 8);
+        memcpy(roms[AMBIENT], AMBIENT_TEMP_SENSOR, 8);
+    }
+    memcpy(roms[sensor], code, 8);
+    if (!kv_set(KV_SENSOR_ROMS, roms, sizeof(roms)))
+        return 0;
+    // the task picks it up between conversions, never mid read
+    roms_changed = 1;
+    return 1;
+}
 ////////////////////////////////////////////////////////////////////////////
 
 void ds1820_search_key(uint16_t x, uint16_t y){
@@ -195,7 +297,7 @@ void ds1820_search_key(uint16_t x, uint16_t y){
     }
     //get temp button
     else if (window == 1){
-        sensor_temp = ds1820_read_device(rom);
+        sensor_temp = (float)ds1820_read_device(rom) / 100;
         sprintf(code, "Current Sensor = %.2f\0", sensor_temp);
         lcd_PutString(2, 117, code, Blue, Black);
         
@@ -268,10 +370,10 @@ void  ds1820_display_temps(void){
 //    lcd_draw_back_button();
     lcd_printf(1,1, 15, "TEMPERATURES");
   
-    lcd_printf(1, 40, 20, "HLT = %.2f\0", ds1820_get_temp(HLT));
-    lcd_printf(1, 56, 20, "Mash = %.2f\0", ds1820_get_temp(MASH));
-    lcd_printf(1, 72, 20, "Cabinet = %.2f\0", ds1820_get_temp(CABINET));
-    lcd_printf(1, 88, 20, "Ambient = %.2f\0", ds1820_get_temp(AMBIENT));
+    lcd_printf(1, 40, 20, "HLT = %.2q", ds1820_get_temp_c100(HLT));
+    lcd_printf(1, 56, 20, "Mash = %.2q", ds1820_get_temp_c100(MASH));
+    lcd_printf(1, 72, 20, "Cabinet = %.2q", ds1820_get_temp_c100(CABINET));
+    lcd_printf(1, 88, 20, "Ambient = %.2q", ds1820_get_temp_c100(AMBIENT));
 }
 ////////////////////////////////////////////////////////////////////////////
 
@@ -281,209 +383,105 @@ void  ds1820_display_temps(void){
 // Static Functions 
 ////////////////////////////////////////////////////////////////////////////
 
-static void delay_us(uint16_t count){ 
-    
-    uint16_t TIMCounter = count;
-    TIM_Cmd(TIM2, ENABLE);
-    TIM_SetCounter(TIM2, TIMCounter);
-    while (TIMCounter)
-    {
-        TIMCounter = TIM_GetCounter(TIM2);
-    }
-    TIM_Cmd(TIM2, DISABLE);
-}
-////////////////////////////////////////////////////////////////////////////
-
-static void ds1820_init(void) {
-    // intialise timer 2 for counting 
-    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
-    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
-    TIM_TimeBaseStructure.TIM_Period = 1;                
-    TIM_TimeBaseStructure.TIM_Prescaler = 72;       //72MHz->1MHz
-    TIM_TimeBaseStructure.TIM_ClockDivision = 0;   
-    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Down;  
-    TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
-
-    GPIO_InitTypeDef GPIO_InitStructure;
-    
-    // PC10-DQ
-    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOC, ENABLE);
-
-    GPIO_InitStructure.GPIO_Pin =  GPIO_Pin_10;
-    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
-    GPIO_Init(GPIOC, &GPIO_InitStructure);
-    //printf("ioMode = %x\r\n", GPIOC->CRH);
-
-
-}
-////////////////////////////////////////////////////////////////////////////
-
-static unsigned char ds1820_reset(void)
-{
-    portENTER_CRITICAL();
-    DQ_OUT();
-    DQ_SET();
-    DQ_RESET();
-    delay_us(500);
-    DQ_IN();
-    
-    delay_us(60);
-    if (DQ_READ()!= 0)
-    {
-        portEXIT_CRITICAL();
-        return PRESENCE_ERROR;
-       
-    }
-    portEXIT_CRITICAL();
-
-    delay_us(240); 
-    
-    return NO_ERROR;
-
-}
-////////////////////////////////////////////////////////////////////////////
-
-static void ds1820_write_bit(uint8_t bit){
-
-    DQ_OUT();
-    DQ_SET(); // make sure bus is high
-    portENTER_CRITICAL();
-    DQ_RESET(); // pull low for 2us
-    delay_us(2);
-    if (bit){
-        DQ_IN();
-    }
-    else DQ_RESET();
-    delay_us(60);
-    portEXIT_CRITICAL();
-    DQ_IN(); // return bus
-}
-////////////////////////////////////////////////////////////////////////////
-
-static uint8_t ds1820_read_bit(void){
-    uint8_t bit;
-    delay_us(1);
-    DQ_OUT();
-    DQ_SET(); // make sure bus is high
-    portENTER_CRITICAL();
-    DQ_RESET(); // pull low for 2us
-    delay_us(1);
-    DQ_IN(); // give bus back to DS1820;
-    delay_us(5); 
-    bit = DQ_READ();
-    delay_us(56);
-    //DQ_OUT();
-    //DQ_SET();
-    portEXIT_CRITICAL();
-    if (bit) 
-        return 1;
-    else return 0; 
-}
-////////////////////////////////////////////////////////////////////////////
-
-static void ds1820_write_byte(uint8_t byte){
-
-    delay_us(100);
-    portENTER_CRITICAL();
-    int ii;
-    for (ii = 0; ii < 8; ii++) {
-        if (byte&0x01){
-            ds1820_write_bit(1);
-            // printf("1 written\r\n");
-        }
-        else {
-            ds1820_write_bit(0);
-            //printf("0 written\r\n");
-        }
-        byte = byte>>1;
-    } 
-    //delay_us(100);
-   portEXIT_CRITICAL();
-}
-////////////////////////////////////////////////////////////////////////////
-
-static uint8_t ds1820_read_byte(void){
-    int ii;
-    uint8_t bit, byte = 0;
-    portENTER_CRITICAL();
-    delay_us(1);
-    for (ii = 0; ii < 8; ii++) {
-        byte = byte >> 1;
-        bit = ds1820_read_bit();
-        if (bit==0) {
-            byte = byte & 0x7F;
-        }
-        else byte = byte | 0x80;
-        
-        
-    }
-     portEXIT_CRITICAL();
-    return byte;
-}
-////////////////////////////////////////////////////////////////////////////
-
 static void ds1820_convert(void){
     portENTER_CRITICAL();
-    ds1820_reset();
-    ds1820_write_byte(SKIP_ROM); 
-    ds1820_write_byte(CONVERT_TEMP);
-    ds1820_reset();
+    ow_reset();
+    ow_write_byte(SKIP_ROM); 
+    ow_write_byte(CONVERT_TEMP);
+    ow_reset();
     portEXIT_CRITICAL();
-    DQ_IN();
+    ow_hw_release();
        
 }
 ////////////////////////////////////////////////////////////////////////////
 
 static uint8_t ds1820_search(){
-    uint8_t ii;
-    char console_text[30];
-    
-    ds1820_reset();
-    ds1820_write_byte(READ_ROM); 
-    portENTER_CRITICAL();
-    for (ii = 0; ii < 8; ii++){
-        rom[ii] = ds1820_read_byte();
-    }
-    portEXIT_CRITICAL();
-    ds1820_reset();
-    sprintf(console_text, "Sensor search complete\r\n\0");
-    xQueueSendToBack(xConsoleQueue, &console_text, 0);
+    ow_read_rom(rom);
+    ow_reset();
+    LOG_INFO("Sensor search complete\r\n");
    
 }
 ////////////////////////////////////////////////////////////////////////////
 
-static float ds1820_read_device(uint8_t * rom_code){
-    float retval;
+static uint8_t ds1820_read_device(uint8_t * rom_code, int16_t * c100){
     uint16_t ds1820_temperature1 = 10000;
     int ii; 
     uint8_t sp1[9]; //temp to hold scratchpad memory
+    uint8_t err;
+    uint8_t ones = 0xFF;
    
     portENTER_CRITICAL();
-    if (ds1820_reset()!= NO_ERROR)
-        return 211.00;
-    ds1820_reset();
-    ds1820_write_byte(MATCH_ROM);
-
-    for (ii = 0; ii < 8; ii++)
+    err = ow_reset();
+    if (err != NO_ERROR)
     {
-        ds1820_write_byte(rom_code[ii]);
+        portEXIT_CRITICAL();
+        return err == BUS_ERROR ? SENSOR_READ_SHORT : SENSOR_READ_ABSENT;
     }
-    ds1820_write_byte(READ_SCRATCHPAD);
+    ow_reset();
+    ow_match_rom(rom_code);
+    ow_write_byte(READ_SCRATCHPAD);
     for (ii = 0; ii < 9; ii++){
-        sp1[ii] = ds1820_read_byte();
+        sp1[ii] = ow_read_byte();
     }
     
-    ds1820_reset();
+    ow_reset();
+
+    // the other sensors answer the reset, so one that has come unplugged
+    // just leaves the bus floating high
+    for (ii = 0; ii < 9; ii++)
+        ones &= sp1[ii];
+    if (ones == 0xFF)
+    {
+        portEXIT_CRITICAL();
+        return SENSOR_READ_ABSENT;
+    }
+    if (ow_crc8(sp1, 9) != 0)
+    {
+        portEXIT_CRITICAL();
+        return SENSOR_READ_CRC;
+    }
+
     ds1820_temperature1 = sp1[1] & 0x0f;
     ds1820_temperature1 <<= 8;
     ds1820_temperature1 |= sp1[0];
     unsigned char remain = sp1[6];
     ds1820_temperature1 >>= 1;
     ds1820_temperature1 = (ds1820_temperature1 * 100) -  25  + (100 * 16 - remain * 100) / (16);
-    retval = ((float)ds1820_temperature1/100);
     portEXIT_CRITICAL();
-    return retval;
+    *c100 = (int16_t)ds1820_temperature1;
+    return SENSOR_READ_OK;
+}
+////////////////////////////////////////////////////////////////////////////
+
+// Current state of each probe, then the latest changes
+void ds1820_faults_applet(int init)
+{
+    static const char *names[4] = { "HLT", "Mash", "Cabinet", "Ambient" };
+    struct sensor_event ev;
+    uint32_t ii;
+
+    if (!init)
+        return;
+
+    lcd_printf(0, 0, 40, "SENSOR FAULTS (%lu changes)", (unsigned long)sensor_event_count());
+    for (ii = 0; ii < 4; ii++)
+        lcd_printf(0, ii + 1, 40, "%-8s %-8s %s", names[ii],
+                   sensor_state_name(sensors[ii].state),
+                   sensor_fault_name(sensors[ii].fault));
+    for (ii = 0; ii < 8; ii++)
+    {
+        if (!sensor_get_event(ii, &ev))
+            break;
+        lcd_printf(0, ii + 6, 40, "%6lu.%03lus %-7s %-7s %s",
+                   ev.time_ms / 1000, ev.time_ms % 1000, names[ev.sensor],
+                   sensor_state_name(ev.state), sensor_fault_name(ev.fault));
+    }
+    lcd_printf(0, 14, 40, "Touch to go back");
+}
+
+int ds1820_faults_key(int xx, int yy)
+{
+    return xx >= 0 && yy >= 0;
 }
 ////////////////////////////////////////////////////////////////////////////
 
@@ -516,13 +514,13 @@ float ds1820_one_device_get_temp(void){
     uint8_t sp[9]; //scratchpad
     int16_t ds1820_temperature = 0;
 
-    ds1820_reset();
-    ds1820_write_byte(SKIP_ROM); 
-    ds1820_write_byte(READ_SCRATCHPAD);
+    ow_reset();
+    ow_write_byte(SKIP_ROM); 
+    ow_write_byte(READ_SCRATCHPAD);
     for (ii = 0; ii < 9; ii++){
-        sp[ii] = ds1820_read_byte();
+        sp[ii] = ow_read_byte();
     }
-    ds1820_reset();
+    ow_reset();
     ds1820_temperature = sp[1] & 0x0f;
     ds1820_temperature <<= 8;
     ds1820_temperature |= sp[0];
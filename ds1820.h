@@ -8,14 +8,11 @@
 #ifndef DS1820_H
 #define DS1820_H
 
+#include "onewire.h"
+
 #define DS1820_PORT GPIOC
 #define DS1820_PIN  GPIO_Pin_10
 
-
-#define BUS_ERROR      0xFE
-#define PRESENCE_ERROR 0xFD
-#define NO_ERROR       0x00
-
 // DS1820 Sensor defines: Use these macro's when calling ds1820_get_temp()
 #define HLT 0
 #define MASH 1
@@ -23,15 +20,44 @@
 #define AMBIENT 3
 #define SPARE 4
 
+// Reading returned when a sensor does not answer, in hundredths of a degree
+#define DS1820_TEMP_ERROR 21100
+
 //Scheduled task for FreeRTOS
 void          vTaskDS1820Convert( void *pvParameters ); //task to
 
 //get temp of a particular sensor
 float         ds1820_get_temp(unsigned char sensor);
+int16_t       ds1820_get_temp_c100(unsigned char sensor);
+
+//ulUptimeMs when the last set of readings was taken
+unsigned long ds1820_sample_time(void);
+
+//alpha-beta filtered readings, see abfilter.h. DS1820_TEMP_ERROR until
+//the sensor has answered.
+int32_t       ds1820_get_filtered_c100(unsigned char sensor);
+//the filtered reading projected forward to ulUptimeMs time
+int32_t       ds1820_predict_c100(unsigned char sensor, unsigned long time);
+//rate of rise, hundredths of a degree per minute
+int32_t       ds1820_get_rate(unsigned char sensor);
+
+//fault detection, see sensor.h. A SUSPECT sensor reads its last good
+//value, a FAILED one DS1820_TEMP_ERROR.
+uint8_t       ds1820_sensor_state(unsigned char sensor);
+uint8_t       ds1820_sensor_fault(unsigned char sensor);
+//set while an element is driving the sensor's vessel hard, so a reading
+//that never moves counts as stuck
+void          ds1820_expect_change(unsigned char sensor, uint8_t expect);
+//saves the 8 byte ROM code (family 0x10, CRC last) the sensor is read
+//from, in place of the built in one. Returns 0 if the code is bad or the
+//settings store write failed.
+uint8_t       ds1820_set_rom(unsigned char sensor, const uint8_t *code);
 
 
 //Menu functions
 void          ds1820_search_applet(void);
 void          ds1820_search_key(uint16_t x, uint16_t y);
 void          ds1820_display_temps(void);
+void          ds1820_faults_applet(int init);
+int           ds1820_faults_key(int xx, int yy);
 #endif
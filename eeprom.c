@@ -0,0 +1,309 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Emulated EEPROM, see eeprom.h. A page's status half word says what it
+// holds:
+//
+//   0xFFFF  erased
+//   0xEEEE  receiving the values from the other page
+//   0x0000  in use
+//
+// and after it come 4 byte entries, the value half word then the id, in
+// the order written. The id goes in last, so an entry a reset cut short
+// has none and is passed over.
+//
+// A swap marks the erased page receiving, writes the new value into it
+// then the newest of every other variable, erases the full page and only
+// then marks the new one in use; 0x0000 can be programmed over 0xEEEE.
+// Whichever step a reset lands on, the pages' two statuses say how far it
+// got and eeprom_init() carries on from there.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "iflash.h"
+#include "eeprom.h"
+
+#ifndef IFLASH_SIM
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "crane.h"
+#endif
+
+#define PAGES        2
+#define ENTRY_SIZE   4
+
+#define PAGE_ERASED  0xFFFF
+#define PAGE_RECEIVE 0xEEEE
+#define PAGE_VALID   0x0000
+
+typedef char eeprom_vars_check[EEPROM_VARS <= 32 ? 1 : -1];
+
+static const uint8_t *e_base;
+static uint8_t  e_page;          // the page in use
+static uint16_t e_next;          // entry the next write goes to
+static uint16_t values[EEPROM_VARS];
+static uint32_t have;            // a bit per variable with a value
+static struct eeprom_stats stats;
+
+#ifndef IFLASH_SIM
+static xSemaphoreHandle lock;
+#endif
+
+static void eeprom_lock(void)
+{
+#ifndef IFLASH_SIM
+    xSemaphoreTake(lock, portMAX_DELAY);
+#endif
+}
+
+static void eeprom_unlock(void)
+{
+#ifndef IFLASH_SIM
+    xSemaphoreGive(lock);
+#endif
+}
+
+static const uint8_t *page_at(uint8_t page)
+{
+    return e_base + page * IFLASH_PAGE_SIZE;
+}
+
+static const uint16_t *entry_at(uint8_t page, uint16_t index)
+{
+    return (const uint16_t *)(page_at(page) + ENTRY_SIZE + index * ENTRY_SIZE);
+}
+
+static uint16_t page_status(uint8_t page)
+{
+    return *(const uint16_t *)page_at(page);
+}
+
+static uint8_t page_erased(uint8_t page)
+{
+    const uint32_t *pp = (const uint32_t *)page_at(page);
+    int ii;
+
+    for (ii = 0; ii < IFLASH_PAGE_SIZE / 4; ii++)
+        if (pp[ii] != 0xFFFFFFFF)
+            return 0;
+    return 1;
+}
+
+static uint8_t erase(uint8_t page)
+{
+    stats.erases++;
+    return iflash_erase_page(page_at(page)) == IFLASH_OK;
+}
+
+static uint8_t set_status(uint8_t page, uint16_t status)
+{
+    return iflash_program(page_at(page), &status, 2) == IFLASH_OK &&
+           page_status(page) == status;
+}
+
+//
+// Loads the page's values over what is in RAM. Returns the entries used,
+// torn ones included, and sets *found to a bit per variable it holds.
+//
+static uint16_t scan(uint8_t page, uint32_t *found)
+{
+    const uint16_t *ee;
+    uint16_t ii;
+
+    *found = 0;
+    for (ii = 0; ii < EEPROM_PAGE_ENTRIES; ii++)
+    {
+        ee = entry_at(page, ii);
+        if (ee[0] == 0xFFFF && ee[1] == 0xFFFF)
+            break;
+        if (ee[1] < EEPROM_VARS)
+        {
+            values[ee[1]] = ee[0];
+            have |= 1UL << ee[1];
+            *found |= 1UL << ee[1];
+        }
+    }
+    return ii;
+}
+
+static uint8_t append(uint8_t page, uint16_t *next, uint16_t var, uint16_t value)
+{
+    const uint16_t *ee = entry_at(page, *next);
+    uint16_t entry[2];
+
+    if (*next >= EEPROM_PAGE_ENTRIES)
+        return 0;
+
+    // the slot is used whether or not the write worked
+    (*next)++;
+    entry[0] = value;
+    entry[1] = var;
+    return iflash_program(ee, entry, ENTRY_SIZE) == IFLASH_OK &&
+           ee[0] == value && ee[1] == var;
+}
+
+// The values not yet in the page, as RAM has them
+static uint8_t copy_rest(uint8_t page, uint16_t *next, uint32_t done)
+{
+    uint16_t var;
+
+    for (var = 0; var < EEPROM_VARS; var++)
+        if ((have & ~done) & (1UL << var) && !append(page, next, var, values[var]))
+            return 0;
+    return 1;
+}
+
+// The last steps of a swap, from the receiving page being filled
+static uint8_t finish_swap(uint8_t to, uint16_t next, uint32_t done)
+{
+    if (!copy_rest(to, &next, done) || !erase(to ^ 1) || !set_status(to, PAGE_VALID))
+        return 0;
+    e_page = to;
+    e_next = next;
+    stats.swaps++;
+    return 1;
+}
+
+static uint8_t swap(uint16_t var, uint16_t value)
+{
+    uint8_t to = e_page ^ 1;
+    uint16_t next = 0;
+
+#ifndef IFLASH_SIM
+    // the erase stalls every interrupt running from flash, the crane's
+    // step interrupt among them, so it waits for the crane to stop
+    while (crane_is_running())
+        vTaskDelay(EEPROM_CRANE_POLL_MS / portTICK_RATE_MS);
+#endif
+    if (!page_erased(to) && !erase(to))
+        return 0;
+    if (!set_status(to, PAGE_RECEIVE) || !append(to, &next, var, value))
+        return 0;
+    return finish_swap(to, next, 1UL << var);
+}
+
+static uint8_t format(void)
+{
+    uint8_t page;
+
+    have = 0;
+    for (page = 0; page < PAGES; page++)
+        if (!page_erased(page) && !erase(page))
+            return 0;
+    e_page = 0;
+    e_next = 0;
+    return set_status(0, PAGE_VALID);
+}
+
+uint8_t eeprom_init(const uint8_t *base)
+{
+    uint8_t valid = 0, receive = 0, page, ok = 1;
+    uint16_t next;
+    uint32_t found;
+
+    e_base = base;
+    have = 0;
+
+    for (page = 0; page < PAGES; page++)
+    {
+        if (page_status(page) == PAGE_VALID)
+            valid |= 1 << page;
+        else if (page_status(page) == PAGE_RECEIVE)
+            receive |= 1 << page;
+    }
+
+    if (valid == 1 || valid == 2)
+    {
+        page = valid == 1 ? 0 : 1;
+        e_page = page;
+        e_next = scan(page, &found);
+        if (receive)
+        {
+            // cut short while the other page was being filled; what is in
+            // it is newer
+            next = scan(page ^ 1, &found);
+            ok = finish_swap(page ^ 1, next, found);
+        }
+        else if (!page_erased(page ^ 1))
+        {
+            ok = erase(page ^ 1);
+        }
+    }
+    else if (valid == 0 && (receive == 1 || receive == 2))
+    {
+        // cut short erasing the full page or just after
+        page = receive == 1 ? 0 : 1;
+        e_page = page;
+        e_next = scan(page, &found);
+        ok = (page_erased(page ^ 1) || erase(page ^ 1)) && set_status(page, PAGE_VALID);
+    }
+    else
+    {
+        ok = format();
+    }
+
+    return ok ? EEPROM_OK : EEPROM_ERROR;
+}
+
+uint8_t eeprom_read(uint16_t var, uint16_t *value)
+{
+    if (var >= EEPROM_VARS || !(have & (1UL << var)))
+        return EEPROM_NO_VALUE;
+    *value = values[var];
+    return EEPROM_OK;
+}
+
+uint8_t eeprom_write(uint16_t var, uint16_t value)
+{
+    uint8_t ok = 1;
+
+    if (var >= EEPROM_VARS || !e_base)
+        return EEPROM_ERROR;
+
+    eeprom_lock();
+    if (!(have & (1UL << var)) || values[var] != value)
+    {
+        if (e_next < EEPROM_PAGE_ENTRIES)
+            ok = append(e_page, &e_next, var, value);
+        else
+            ok = swap(var, value);
+        if (ok)
+        {
+            values[var] = value;
+            have |= 1UL << var;
+            stats.writes++;
+        }
+    }
+    eeprom_unlock();
+    return ok ? EEPROM_OK : EEPROM_ERROR;
+}
+
+void eeprom_get_stats(struct eeprom_stats *out)
+{
+    uint16_t var;
+
+    eeprom_lock();
+    stats.page = e_page;
+    stats.used = e_next;
+    stats.live = 0;
+    for (var = 0; var < EEPROM_VARS; var++)
+        stats.live += (have >> var) & 1;
+    *out = stats;
+    eeprom_unlock();
+}
+
+#ifndef IFLASH_SIM
+// Pages reserved in stm32_flash.ld
+extern const uint8_t __eeprom_start[];
+
+void eeprom_open(void)
+{
+    lock = xSemaphoreCreateMutex();
+    eeprom_init(__eeprom_start);
+}
+#endif
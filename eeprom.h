@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// EEPROM emulation in the last two pages of the STM32's own flash, the
+// way ST's AN2594 does it, for small settings that change often and
+// should not need the SPI bus. A write appends a variable's id and 16 bit
+// value to the page in use; when it fills, the newest value of each
+// variable moves to the other page and the full one is erased. A RAM copy
+// of every value makes reads free.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdint.h>
+#include "iflash.h"
+
+// Ids are indexes into the RAM copy and must never be reused for
+// something else
+enum eeprom_var
+{
+    EEPROM_DATALOG_PERIOD,   // in DATALOG_TICK_MS, see datalog.h
+    EEPROM_VARS = 16
+};
+
+enum eeprom_error
+{
+    EEPROM_OK,
+    EEPROM_NO_VALUE,
+    EEPROM_ERROR
+};
+
+#define EEPROM_CRANE_POLL_MS 50
+
+// Each page starts with a status half word then holds this many entries
+#define EEPROM_PAGE_ENTRIES  (IFLASH_PAGE_SIZE / 4 - 1)
+
+struct eeprom_stats
+{
+    uint8_t  page;           // the one in use
+    uint16_t used;           // entries in it
+    uint8_t  live;           // variables with a value
+    uint32_t writes;         // since power up, not counting ones that changed nothing
+    uint32_t swaps;
+    uint32_t erases;
+};
+
+// Reads both pages, finishing a page swap a reset cut short, or formats
+// them if neither is in use. Before the scheduler starts.
+uint8_t eeprom_init(const uint8_t *base);
+
+uint8_t eeprom_read(uint16_t var, uint16_t *value);
+
+// Usually two half words programmed, 100us or so; the write that fills a
+// page also swaps, which is up to 2 * EEPROM_VARS more and a page erase,
+// 20-40ms. The swap waits for the crane to stop first, polling every
+// EEPROM_CRANE_POLL_MS. Writing a variable's current value does nothing.
+uint8_t eeprom_write(uint16_t var, uint16_t value);
+
+void    eeprom_get_stats(struct eeprom_stats *stats);
+
+#ifndef IFLASH_SIM
+// eeprom_init() on the pages reserved in stm32_flash.ld
+void    eeprom_open(void);
+#endif
+
+#endif
@@ -0,0 +1,621 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Formatter, see fmt.h. Each conversion is built right to left in a
+// small buffer on the stack and written to a sink with its padding; the
+// sink either fills the caller's buffer or, for fmt_printf, collects a
+// few bytes at a time for comm_write(). Nothing recurses.
+//
+// Doubles are split into whole integers instead of being printed digit
+// by digit in floating point: %f takes the whole part as a 64 bit
+// integer and the places as another, scaled and rounded by a power of
+// ten, and %e scales the value into [1, 10) by powers of ten first. So
+// the last place can be out by one where glibc, which works exactly,
+// would round the other way, but no more than that.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "fmt.h"
+
+#define FLAG_LEFT    0x01
+#define FLAG_ZERO    0x02
+#define FLAG_PLUS    0x04
+#define FLAG_SPACE   0x08
+#define FLAG_ALT     0x10
+#define FLAG_UPPER   0x20
+
+// the longest conversion: 22 octal digits of a 64 bit value, or a double
+// as 20 whole digits, a point and FMT_MAX_PREC places
+#define FIELD_LEN    32
+
+struct sink
+{
+    void (*put)(struct sink *sink, const char *str, int len);
+    int count;
+};
+
+struct spec
+{
+    uint8_t flags;
+    int width;
+    int prec;           // -1 for none
+};
+
+static const uint64_t pow10[FMT_MAX_PREC + 2] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000, 10000000000ULL
+};
+
+static void out(struct sink *sink, const char *str, int len)
+{
+    if (len > 0)
+    {
+        sink->put(sink, str, len);
+        sink->count += len;
+    }
+}
+
+static void pad(struct sink *sink, char cc, int count)
+{
+    static const char spaces[] = "                ";
+    static const char zeros[]  = "0000000000000000";
+    const char *fill = cc == '0' ? zeros : spaces;
+
+    while (count > 0)
+    {
+        int nn = count < 16 ? count : 16;
+
+        out(sink, fill, nn);
+        count -= nn;
+    }
+}
+
+// prefix ("-", "0x" ...), then zeros to make up prec digits, then the
+// digits, padded to the width
+static void field(struct sink *sink, const struct spec *sp, const char *prefix,
+                  int zeros, const char *body, int len)
+{
+    int plen = strlen(prefix);
+    int fill = sp->width - plen - zeros - len;
+
+    if (fill > 0 && (sp->flags & FLAG_ZERO) && !(sp->flags & FLAG_LEFT))
+    {
+        zeros += fill;
+        fill = 0;
+    }
+    if (!(sp->flags & FLAG_LEFT))
+        pad(sink, ' ', fill);
+    out(sink, prefix, plen);
+    pad(sink, '0', zeros);
+    out(sink, body, len);
+    if (sp->flags & FLAG_LEFT)
+        pad(sink, ' ', fill);
+}
+
+// digits of val into the end of buf, returning where they start
+static char *digits(char *end, uint64_t val, unsigned base, int upper)
+{
+    const char *set = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    do
+    {
+        *--end = set[val % base];
+        val /= base;
+    } while (val);
+    return end;
+}
+
+static const char *sign(const struct spec *sp, int negative)
+{
+    if (negative)
+        return "-";
+    if (sp->flags & FLAG_PLUS)
+        return "+";
+    if (sp->flags & FLAG_SPACE)
+        return " ";
+    return "";
+}
+
+static void fmt_int(struct sink *sink, struct spec *sp, uint64_t val,
+                    int negative, unsigned base)
+{
+    char buf[FIELD_LEN];
+    char *end = buf + sizeof(buf);
+    char *start = end;
+    const char *prefix = sign(sp, negative);
+    int zeros;
+
+    if (base != 10)
+        prefix = (sp->flags & FLAG_ALT) && val ?
+            (base == 16 ? (sp->flags & FLAG_UPPER ? "0X" : "0x") : "0") : "";
+    // a precision of 0 prints nothing for 0
+    if (val || sp->prec != 0)
+        start = digits(end, val, base, sp->flags & FLAG_UPPER);
+    if (sp->prec >= 0)
+        sp->flags &= ~FLAG_ZERO;
+    zeros = sp->prec - (end - start);
+    if (base == 8 && *prefix && zeros > 0)
+        prefix = "";
+    field(sink, sp, prefix, zeros > 0 ? zeros : 0, start, end - start);
+}
+
+// val as the whole and places of a fixed point number
+static void fmt_fixed(struct sink *sink, struct spec *sp, uint64_t whole,
+                      uint64_t places, int prec, int negative)
+{
+    char buf[FIELD_LEN];
+    char *end = buf + sizeof(buf);
+    char *start = end;
+
+    if (prec > 0)
+    {
+        int ii;
+
+        for (ii = 0; ii < prec; ii++)
+        {
+            *--start = '0' + places % 10;
+            places /= 10;
+        }
+    }
+    if (prec > 0 || (sp->flags & FLAG_ALT))
+        *--start = '.';
+    start = digits(start, whole, 10, 0);
+    field(sink, sp, sign(sp, negative), 0, start, end - start);
+}
+
+// %q, the value is already scaled by 10^prec
+static void fmt_q(struct sink *sink, struct spec *sp, int64_t val)
+{
+    int prec = sp->prec < 0 ? FMT_Q_PREC : sp->prec;
+    uint64_t mag = val < 0 ? -(uint64_t)val : (uint64_t)val;
+
+    if (prec > FMT_MAX_PREC)
+        prec = FMT_MAX_PREC;
+    fmt_fixed(sink, sp, mag / pow10[prec], mag % pow10[prec], prec, val < 0);
+}
+
+// halves go to even, as glibc does; only a value that really is a half,
+// such as 46.25 to one place, can land on one
+static uint64_t round_even(double val)
+{
+    uint64_t whole = (uint64_t)val;
+    double frac = val - whole;
+
+    if (frac > 0.5 || (frac == 0.5 && (whole & 1)))
+        whole++;
+    return whole;
+}
+
+// val in [1, 10) times a power of ten, which is returned; val must be > 0
+static int normalise(double *val)
+{
+    static const double big[] = { 1e256, 1e128, 1e64, 1e32, 1e16, 1e8, 1e4, 1e2, 1e1 };
+    static const int    exps[] = { 256, 128, 64, 32, 16, 8, 4, 2, 1 };
+    int exp = 0;
+    int ii;
+
+    for (ii = 0; ii < 9; ii++)
+    {
+        if (*val >= big[ii])
+        {
+            *val /= big[ii];
+            exp += exps[ii];
+        }
+    }
+    for (ii = 0; ii < 9; ii++)
+    {
+        if (*val * big[ii] < 10)
+        {
+            *val *= big[ii];
+            exp -= exps[ii];
+        }
+    }
+    return exp;
+}
+
+// sig significant digits of val, as an integer, and its power of ten
+static uint64_t significant(double val, int sig, int *exp)
+{
+    uint64_t mant;
+
+    if (val == 0)
+    {
+        *exp = 0;
+        return 0;
+    }
+    *exp = normalise(&val);
+    mant = round_even(val * pow10[sig - 1]);
+    // rounded up to 10.00...
+    if (mant >= pow10[sig])
+    {
+        mant /= 10;
+        (*exp)++;
+    }
+    return mant;
+}
+
+static void fmt_exp(struct sink *sink, struct spec *sp, double val, int prec,
+                    int negative, int strip)
+{
+    char buf[FIELD_LEN];
+    char *end = buf + sizeof(buf);
+    char *start;
+    uint64_t mant;
+    int exp, mag;
+
+    mant = significant(val, prec + 1, &exp);
+    mag = exp < 0 ? -exp : exp;
+    start = digits(end, mag, 10, 0);
+    if (mag < 10)
+        *--start = '0';
+    *--start = exp < 0 ? '-' : '+';
+    *--start = sp->flags & FLAG_UPPER ? 'E' : 'e';
+
+    while (strip && prec > 0 && mant % 10 == 0)
+    {
+        mant /= 10;
+        prec--;
+    }
+    if (prec > 0)
+    {
+        start = digits(start, mant % pow10[prec], 10, 0);
+        while (end - start < prec + 4 + (mag >= 100))
+            *--start = '0';
+        *--start = '.';
+    }
+    else if (sp->flags & FLAG_ALT)
+        *--start = '.';
+    *--start = '0' + mant / pow10[prec];
+    field(sink, sp, sign(sp, negative), 0, start, end - start);
+}
+
+static void fmt_double(struct sink *sink, struct spec *sp, double val, char conv)
+{
+    int negative = val < 0 || (val == 0 && 1 / val < 0);
+    int prec = sp->prec < 0 ? 6 : sp->prec;
+    uint64_t whole, places;
+
+    if (negative)
+        val = -val;
+    // inf - inf and nan - nan are both nan
+    if (val - val != 0)
+    {
+        sp->flags &= ~FLAG_ZERO;
+        field(sink, sp, sign(sp, negative && val == val), 0,
+              val != val ? (sp->flags & FLAG_UPPER ? "NAN" : "nan")
+                         : (sp->flags & FLAG_UPPER ? "INF" : "inf"), 3);
+        return;
+    }
+    if (prec > FMT_MAX_PREC)
+        prec = FMT_MAX_PREC;
+
+    if (conv == 'g')
+    {
+        uint64_t mant;
+        int exp;
+
+        // %e's exponent for this many significant digits picks the style
+        if (prec == 0)
+            prec = 1;
+        mant = significant(val, prec, &exp);
+        if (exp < -4 || exp >= prec)
+        {
+            fmt_exp(sink, sp, val, prec - 1, negative, !(sp->flags & FLAG_ALT));
+            return;
+        }
+
+        // the same digits as %f; up to 3 more places than FMT_MAX_PREC
+        prec -= exp + 1;
+        whole = exp < 0 ? 0 : mant / pow10[prec];
+        places = exp < 0 ? mant : mant % pow10[prec];
+        while (!(sp->flags & FLAG_ALT) && prec > 0 && places % 10 == 0)
+        {
+            places /= 10;
+            prec--;
+        }
+        fmt_fixed(sink, sp, whole, places, prec, negative);
+        return;
+    }
+    if (conv == 'e' || val >= 1.8e19)
+    {
+        fmt_exp(sink, sp, val, prec, negative, 0);
+        return;
+    }
+
+    whole = (uint64_t)val;
+    places = round_even((val - whole) * pow10[prec]);
+    if (places >= pow10[prec])
+    {
+        places -= pow10[prec];
+        whole++;
+    }
+    fmt_fixed(sink, sp, whole, places, prec, negative);
+}
+
+static int fmt_format(struct sink *sink, const char *fmt, va_list ap)
+{
+    while (*fmt)
+    {
+        struct spec sp = { 0, 0, -1 };
+        const char *run = fmt;
+        int size = 0;           // -2 hh, -1 h, 1 l, 2 ll
+        char conv;
+
+        while (*fmt && *fmt != '%')
+            fmt++;
+        out(sink, run, fmt - run);
+        if (!*fmt)
+            break;
+        fmt++;
+
+        for (;; fmt++)
+        {
+            if (*fmt == '-')
+                sp.flags |= FLAG_LEFT;
+            else if (*fmt == '0')
+                sp.flags |= FLAG_ZERO;
+            else if (*fmt == '+')
+                sp.flags |= FLAG_PLUS;
+            else if (*fmt == ' ')
+                sp.flags |= FLAG_SPACE;
+            else if (*fmt == '#')
+                sp.flags |= FLAG_ALT;
+            else
+                break;
+        }
+
+        if (*fmt == '*')
+        {
+            sp.width = va_arg(ap, int);
+            if (sp.width < 0)
+            {
+                sp.flags |= FLAG_LEFT;
+                sp.width = -sp.width;
+            }
+            fmt++;
+        }
+        else
+            while (*fmt >= '0' && *fmt <= '9')
+                sp.width = sp.width * 10 + *fmt++ - '0';
+
+        if (*fmt == '.')
+        {
+            fmt++;
+            sp.prec = 0;
+            if (*fmt == '*')
+            {
+                sp.prec = va_arg(ap, int);
+                if (sp.prec < 0)
+                    sp.prec = -1;
+                fmt++;
+            }
+            else
+                while (*fmt >= '0' && *fmt <= '9')
+                    sp.prec = sp.prec * 10 + *fmt++ - '0';
+        }
+
+        for (;; fmt++)
+        {
+            if (*fmt == 'h')
+                size--;
+            else if (*fmt == 'l')
+                size++;
+            else if (*fmt == 'z')
+                size = sizeof(size_t) > sizeof(long) ? 2 : 1;
+            else
+                break;
+        }
+
+        conv = *fmt;
+        if (!conv)
+            break;
+        fmt++;
+        if (conv >= 'A' && conv <= 'Z' && conv != 'X')
+        {
+            sp.flags |= FLAG_UPPER;
+            conv += 'a' - 'A';
+        }
+
+        switch (conv)
+        {
+        case 'd':
+        case 'i':
+        {
+            int64_t val;
+
+            if (size >= 2)
+                val = va_arg(ap, long long);
+            else if (size == 1)
+                val = va_arg(ap, long);
+            else
+                val = va_arg(ap, int);
+            if (size == -1)
+                val = (short)val;
+            else if (size <= -2)
+                val = (signed char)val;
+            fmt_int(sink, &sp, val < 0 ? -(uint64_t)val : (uint64_t)val, val < 0, 10);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        {
+            uint64_t val;
+
+            if (size >= 2)
+                val = va_arg(ap, unsigned long long);
+            else if (size == 1)
+                val = va_arg(ap, unsigned long);
+            else
+                val = va_arg(ap, unsigned int);
+            if (size == -1)
+                val = (unsigned short)val;
+            else if (size <= -2)
+                val = (unsigned char)val;
+            if (conv == 'X')
+                sp.flags |= FLAG_UPPER;
+            sp.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+            fmt_int(sink, &sp, val, 0, conv == 'o' ? 8 : conv == 'u' ? 10 : 16);
+            break;
+        }
+        case 'p':
+            sp.flags |= FLAG_ALT;
+            sp.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+            fmt_int(sink, &sp, (uintptr_t)va_arg(ap, void *), 0, 16);
+            break;
+        case 'c':
+        {
+            char cc = va_arg(ap, int);
+
+            sp.flags &= ~FLAG_ZERO;
+            field(sink, &sp, "", 0, &cc, 1);
+            break;
+        }
+        case 's':
+        {
+            const char *str = va_arg(ap, const char *);
+            int len = 0;
+
+            if (!str)
+                str = "(null)";
+            // not strlen, the precision may be all there is
+            while (str[len] && (sp.prec < 0 || len < sp.prec))
+                len++;
+            sp.flags &= ~FLAG_ZERO;
+            field(sink, &sp, "", 0, str, len);
+            break;
+        }
+        case 'q':
+            if (size >= 2)
+                fmt_q(sink, &sp, va_arg(ap, long long));
+            else if (size == 1)
+                fmt_q(sink, &sp, va_arg(ap, long));
+            else
+                fmt_q(sink, &sp, va_arg(ap, int));
+            break;
+        case 'f':
+        case 'e':
+        case 'g':
+            fmt_double(sink, &sp, va_arg(ap, double), conv);
+            break;
+        case '%':
+            out(sink, "%", 1);
+            break;
+        default:
+            // not understood, shown as it was
+            out(sink, fmt - 1, 1);
+            break;
+        }
+    }
+    return sink->count;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Into a buffer
+////////////////////////////////////////////////////////////////////////////
+
+struct buf_sink
+{
+    struct sink sink;
+    char *buf;
+    size_t size;
+};
+
+static void buf_put(struct sink *sink, const char *str, int len)
+{
+    struct buf_sink *bs = (struct buf_sink *)sink;
+    size_t at = sink->count;
+
+    if (at + 1 >= bs->size)
+        return;
+    if (at + len + 1 > bs->size)
+        len = bs->size - 1 - at;
+    memcpy(bs->buf + at, str, len);
+}
+
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+    struct buf_sink bs = { { buf_put, 0 }, buf, size };
+    int len = fmt_format(&bs.sink, fmt, ap);
+
+    if (size)
+        buf[(size_t)len < size ? (size_t)len : size - 1] = '\0';
+    return len;
+}
+
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = fmt_vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return len;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// To the console
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef FMT_HOST
+#include "serial.h"
+
+#define CONSOLE_CHUNK  32
+
+struct console_sink
+{
+    struct sink sink;
+    uint8_t len;
+    char buf[CONSOLE_CHUNK];
+};
+
+static void console_put(struct sink *sink, const char *str, int len)
+{
+    struct console_sink *cs = (struct console_sink *)sink;
+
+    while (len > 0)
+    {
+        int nn = CONSOLE_CHUNK - cs->len;
+
+        if (nn > len)
+            nn = len;
+        memcpy(cs->buf + cs->len, str, nn);
+        cs->len += nn;
+        str += nn;
+        len -= nn;
+        if (cs->len == CONSOLE_CHUNK)
+        {
+            comm_write(cs->buf, cs->len, 1);
+            cs->len = 0;
+        }
+    }
+}
+
+int fmt_vprintf(const char *fmt, va_list ap)
+{
+    struct console_sink cs = { { console_put, 0 }, 0 };
+    int len = fmt_format(&cs.sink, fmt, ap);
+
+    comm_write(cs.buf, cs.len, 1);
+    return len;
+}
+
+int fmt_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = fmt_vprintf(fmt, ap);
+    va_end(ap);
+    return len;
+}
+#endif
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// printf without newlib. Never allocates, keeps no state between calls
+// and uses a fixed amount of stack, so any task can call it. Newlib's
+// float printing goes through _dtoa, which mallocs from the FreeRTOS heap.
+//
+// Conversions: d i u x X o c s p %, with the flags - 0 + space #, a
+// width and precision (or *), and the lengths hh h l ll z. Also:
+//
+//   f e g (F E G)  doubles, to at most FMT_MAX_PREC places; %f of 1.8e19
+//                  or more comes out as %e
+//   q              fixed point: an int (l for a long) with the precision
+//                  as its decimal places, default 2, so
+//                  ("%.2q", 6525) is 65.25 and ("%.1q", 505) is 50.5
+//
+// The return value is the length the whole output would have had, as C99.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#define FMT_MAX_PREC   9
+#define FMT_Q_PREC     2       // %q without a precision, hundredths
+
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...);
+
+#ifndef FMT_HOST
+// To the console, see serial.h; blocks while the TX ring is full
+int fmt_vprintf(const char *fmt, va_list ap);
+int fmt_printf(const char *fmt, ...);
+#endif
+
+#endif
@@ -0,0 +1,777 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Element control for the HLT and mash tun. TIM6 steps through a
+// time-proportioning window and switches the solid state relays itself,
+// so the switching never jitters with task load. At the start of each
+// window it latches the outputs the task posted and wakes the task, which
+// runs the PID loops on the probes' filtered temperatures. The loop rate is
+// therefore set by the timer, and each result goes out in the following
+// window.
+//
+// Each channel's on slots are laid out by the load scheduler (power.c)
+// rather than all starting with the window, so the elements never draw
+// more together than the supply allows.
+//
+// The loop is two degrees of freedom: a model of the vessel (thermal.c)
+// plans the output for the target and says what the vessel should read
+// on the way, and the PID loop corrects around that. The model is refitted
+// from the logged windows as the channel runs.
+//
+// A probe fault (sensor.c) doesn't have to stop the brew: the channel
+// moves to its backup probe if it has one, or holds its last output for a
+// bounded time, before it gives up and turns off.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "heater.h"
+#include "pid.h"
+#include "autotune.h"
+#include "lcd.h"
+#include "ds1820.h"
+#include "timer.h"
+#include "analog.h"
+#include "kv.h"
+
+// Control interface requests on the loop's own state, taken by the task
+// at the next window
+#define HEATER_REQ_TUNE_START   0x01
+#define HEATER_REQ_TUNE_ABORT   0x02
+#define HEATER_REQ_GAINS        0x04
+#define HEATER_REQ_MODEL        0x08
+
+// The control interface and the task share the settings and the status
+// under the lock. The loop state below them is the task's alone, so the
+// loops themselves run outside the lock.
+struct heater
+{
+    uint16_t pin;
+    uint8_t  sensor;     // ds1820 sensor index
+    uint8_t  backup;     // used if sensor fails, or SENSOR_NONE
+    uint8_t  fallback;
+    uint16_t ma;
+    uint8_t  priority;
+    uint8_t  mode;
+    int32_t  target;
+    uint16_t manual;
+    int32_t  disturbance;  // announced, not yet in the plan
+    uint8_t  requests;   // HEATER_REQ_*
+    struct autotune_cfg tune_cfg;
+    int32_t  gains[3];   // kp, ki, kd as last set or tuned
+    struct thermal_model shared_model;  // as last set or fitted
+    struct heater_status status;
+
+    uint8_t  run_mode;   // mode the loop last ran in
+    struct pid pid;
+    struct autotune tune;
+    struct thermal_model model;
+    struct thermal_ff ff;
+    struct thermal_fit fit;
+    uint8_t  ff_reset;   // restart the plan from the next sample
+    uint8_t  held;       // windows run blind on the last output
+    uint8_t  tuned;      // autotune gains not yet saved
+};
+
+// The settings one window runs on
+struct heater_input
+{
+    uint8_t  mode;
+    int32_t  target;
+    uint16_t manual;
+    int32_t  disturbance;
+    uint8_t  backup;
+    uint8_t  fallback;
+};
+
+static struct heater heaters[HEATER_COUNT] =
+{
+    { HEATER_HLT_PIN,  HLT,  HEATER_HLT_BACKUP,  HEATER_HLT_FALLBACK,
+      HEATER_HLT_MA,  POWER_PRIO_NORMAL },
+    { HEATER_MASH_PIN, MASH, HEATER_MASH_BACKUP, HEATER_MASH_FALLBACK,
+      HEATER_MASH_MA, POWER_PRIO_NORMAL },
+};
+
+// Shared with the ISR. The task writes next_mask, the ISR latches it at
+// the window boundary.
+static volatile uint32_t next_mask[HEATER_COUNT][POWER_MASK_WORDS];
+static volatile uint32_t on_mask[HEATER_COUNT][POWER_MASK_WORDS];
+static volatile uint8_t  slot;
+static volatile uint8_t  windows_unfed;
+static volatile uint8_t  gains_unsaved; // for heater_save_tuned()
+
+static xSemaphoreHandle xHeaterWindow;
+
+void vHeaterInit(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+    int ii;
+
+    GPIO_ResetBits( HEATER_PORT, HEATER_HLT_PIN | HEATER_MASH_PIN );
+    GPIO_InitStructure.GPIO_Pin =  HEATER_HLT_PIN | HEATER_MASH_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;
+    GPIO_Init( HEATER_PORT, &GPIO_InitStructure );
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        struct heater *h = &heaters[ii];
+
+        h->mode = HEATER_MODE_OFF;
+        h->run_mode = HEATER_MODE_OFF;
+        h->gains[0] = HEATER_DEFAULT_KP;
+        h->gains[1] = HEATER_DEFAULT_KI;
+        h->gains[2] = HEATER_DEFAULT_KD;
+        pid_init(&h->pid, h->gains[0], h->gains[1], h->gains[2], 0, HEATER_OUTPUT_MAX);
+        thermal_init(&h->model, HEATER_MODEL_GAIN, HEATER_MODEL_TAU,
+                     HEATER_MODEL_DEAD, HEATER_MODEL_AMBIENT, HEATER_OUTPUT_MAX);
+        h->shared_model = h->model;
+        thermal_fit_reset(&h->fit);
+    }
+
+    vSemaphoreCreateBinary( xHeaterWindow );
+    xSemaphoreTake( xHeaterWindow, 0 );
+
+    // 10kHz count, one update per slot
+    RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM6, ENABLE );
+    TIM_DeInit( TIM6 );
+    TIM_TimeBaseStructInit( &TIM_TimeBaseStructure );
+    TIM_TimeBaseStructure.TIM_Prescaler = (72000000 / 10000) - 1;
+    TIM_TimeBaseStructure.TIM_Period = (HEATER_SLOT_MS * 10) - 1;
+    TIM_TimeBaseInit( TIM6, &TIM_TimeBaseStructure );
+    TIM_ClearITPendingBit( TIM6, TIM_IT_Update );
+    TIM_ITConfig( TIM6, TIM_IT_Update, ENABLE );
+
+    NVIC_InitStructure.NVIC_IRQChannel = TIM6_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = HEATER_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init( &NVIC_InitStructure );
+
+    TIM_Cmd( TIM6, ENABLE );
+}
+
+void TIM6_IRQHandler( void )
+{
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+    uint16_t on = 0, off = 0;
+    int ii, jj;
+
+    TIM_ClearITPendingBit( TIM6, TIM_IT_Update );
+
+    if (++slot >= HEATER_WINDOW_SLOTS)
+    {
+        slot = 0;
+
+        // a task that has stopped posting outputs must not leave the
+        // elements running
+        if (windows_unfed < HEATER_WATCHDOG_WINDOWS)
+            windows_unfed++;
+
+        for (ii = 0; ii < HEATER_COUNT; ii++)
+        {
+            for (jj = 0; jj < POWER_MASK_WORDS; jj++)
+                on_mask[ii][jj] = windows_unfed < HEATER_WATCHDOG_WINDOWS ? next_mask[ii][jj] : 0;
+        }
+
+        xSemaphoreGiveFromISR( xHeaterWindow, &xHigherPriorityTaskWoken );
+    }
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        if (POWER_SLOT_ON(on_mask[ii], slot))
+            on |= heaters[ii].pin;
+        else
+            off |= heaters[ii].pin;
+    }
+    if (on)
+        GPIO_SetBits( HEATER_PORT, on );
+    if (off)
+        GPIO_ResetBits( HEATER_PORT, off );
+
+    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+
+static uint8_t heater_probe(struct heater *h, const struct heater_input *in)
+{
+    if (ds1820_sensor_state(h->sensor) == SENSOR_FAILED && in->backup != SENSOR_NONE &&
+        ds1820_sensor_state(in->backup) == SENSOR_OK)
+        return in->backup;
+    return h->sensor;
+}
+
+// Takes the window's settings and hands the requests on to the loop
+// state. Runs under the lock, so is kept to copies.
+static void heater_take(struct heater *h, struct heater_input *in)
+{
+    in->mode = h->mode;
+    in->target = h->target;
+    in->manual = h->manual;
+    in->disturbance = h->disturbance;
+    in->backup = h->backup;
+    in->fallback = h->fallback;
+    h->disturbance = 0;
+
+    if (h->requests & HEATER_REQ_TUNE_ABORT)
+        autotune_abort(&h->tune);
+    if (h->requests & HEATER_REQ_TUNE_START)
+        autotune_start(&h->tune, &h->tune_cfg);
+    if (h->requests & HEATER_REQ_GAINS)
+        pid_set_gains(&h->pid, h->gains[0], h->gains[1], h->gains[2]);
+    if (h->requests & HEATER_REQ_MODEL)
+        h->model = h->shared_model;
+    h->requests = 0;
+}
+
+// Runs the loop outside the lock, on the task's own state, into a copy
+// of the status
+static uint16_t heater_run(struct heater *h, const struct heater_input *in,
+                           struct heater_status *st)
+{
+    uint8_t probe = heater_probe(h, in);
+    uint8_t state = ds1820_sensor_state(probe);
+    unsigned long age = ulUptimeMs - ds1820_sample_time();
+    int32_t temp = ds1820_get_temp_c100(probe);
+    uint8_t mode = in->mode;
+    uint16_t output = 0;
+
+    // switched into the loop, carry on from the output it was left at
+    if (mode == HEATER_MODE_PID && h->run_mode != HEATER_MODE_PID)
+    {
+        pid_reset(&h->pid, h->run_mode == HEATER_MODE_MANUAL ? in->manual : 0);
+        h->ff_reset = 1;
+    }
+    h->run_mode = mode;
+
+    st->stale = (age > HEATER_SAMPLE_TIMEOUT_MS || state != SENSOR_OK ||
+                 temp == DS1820_TEMP_ERROR);
+    st->probe = probe;
+    st->fault = ds1820_sensor_fault(h->sensor);
+
+    // the filtered reading brought up to now, so the loop is not working
+    // from a conversion up to a window old
+    if (!st->stale)
+        temp = ds1820_predict_c100(probe, ulUptimeMs);
+    st->temp = temp;
+    st->rate = ds1820_get_rate(probe);
+
+    // Heating blind, so only for a while. The plan restarts from wherever
+    // the vessel has got to when the probe is back.
+    if (!st->stale)
+        h->held = 0;
+    else if ((mode == HEATER_MODE_PID || mode == HEATER_MODE_MANUAL) &&
+             (state == SENSOR_SUSPECT || in->fallback == HEATER_FALLBACK_HOLD) &&
+             h->held < HEATER_HOLD_WINDOWS)
+    {
+        h->held++;
+        h->ff_reset = 1;
+        st->holding = 1;
+        thermal_fit_reset(&h->fit);
+        st->mode = mode;
+        return st->output;
+    }
+    st->holding = 0;
+
+    switch (mode)
+    {
+    case HEATER_MODE_PID:
+        if (st->stale)
+        {
+            pid_set_feedforward(&h->pid, 0);
+            pid_reset(&h->pid, 0);
+            h->ff_reset = 1;
+            break;
+        }
+        if (h->ff_reset)
+        {
+            // carry on from the output the loop was left at
+            thermal_ff_reset(&h->ff, &h->model, temp);
+            pid_set_feedforward(&h->pid, h->ff.output);
+            pid_reset(&h->pid, h->pid.output);
+            h->ff_reset = 0;
+        }
+        thermal_ff_disturb(&h->ff, in->disturbance);
+        thermal_ff_step(&h->ff, &h->model, in->target);
+        pid_set_feedforward(&h->pid, h->ff.output);
+        output = pid_update(&h->pid, h->ff.reference, temp);
+        break;
+
+    case HEATER_MODE_MANUAL:
+        if (!st->stale)
+            output = in->manual;
+        break;
+
+    case HEATER_MODE_AUTOTUNE:
+        if (st->stale)
+            autotune_abort(&h->tune);
+        else
+            output = autotune_step(&h->tune, temp);
+
+        if (h->tune.state != AUTOTUNE_RUNNING)
+        {
+            if (h->tune.state == AUTOTUNE_DONE)
+            {
+                pid_set_gains(&h->pid, h->tune.kp, h->tune.ki, h->tune.kd);
+                h->tuned = 1;
+            }
+            mode = HEATER_MODE_OFF;
+            output = 0;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    ds1820_expect_change(h->sensor, !st->stale && mode == HEATER_MODE_PID &&
+                         output >= HEATER_STUCK_OUTPUT &&
+                         in->target - temp > HEATER_STUCK_MARGIN);
+
+    if (st->stale)
+        thermal_fit_reset(&h->fit);
+    else
+        thermal_fit_sample(&h->fit, &h->model, output, temp);
+    if (h->fit.blocks >= THERMAL_FIT_BLOCKS)
+    {
+        if (thermal_fit_solve(&h->fit, &h->model))
+            st->model_fits++;
+        thermal_fit_reset(&h->fit);
+    }
+
+    st->mode = mode;
+    st->target = in->target;
+    st->output = output;
+    st->reference = mode == HEATER_MODE_PID ? h->ff.reference : temp;
+    st->feedforward = mode == HEATER_MODE_PID ? h->ff.output : 0;
+    return output;
+}
+
+// Publishes what the window found. Runs under the lock. A setting made
+// while the loop ran is newer than the result, so wins.
+static void heater_publish(struct heater *h, const struct heater_input *in,
+                           const struct heater_status *st)
+{
+    if (in->mode == HEATER_MODE_AUTOTUNE && st->mode != HEATER_MODE_AUTOTUNE &&
+        h->mode == HEATER_MODE_AUTOTUNE && !(h->requests & HEATER_REQ_TUNE_START))
+        h->mode = HEATER_MODE_OFF;
+
+    if (h->tuned && !(h->requests & HEATER_REQ_GAINS))
+    {
+        h->gains[0] = h->pid.kp;
+        h->gains[1] = h->pid.ki;
+        h->gains[2] = h->pid.kd;
+    }
+
+    if (st->model_fits != h->status.model_fits && !(h->requests & HEATER_REQ_MODEL))
+        h->shared_model = h->model;
+
+    h->status = *st;
+}
+
+static void heater_clear_mask(uint8_t channel)
+{
+    int jj;
+
+    for (jj = 0; jj < POWER_MASK_WORDS; jj++)
+    {
+        next_mask[channel][jj] = 0;
+        on_mask[channel][jj] = 0;
+    }
+}
+
+// Saved gains replace the defaults
+static void heater_load_gains(void)
+{
+    int32_t gains[3];
+    int ii;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+        if (kv_get(KV_GAINS_HLT + ii, gains, sizeof(gains)) == sizeof(gains))
+            heater_set_gains(ii, gains[0], gains[1], gains[2]);
+}
+
+void vHeaterTask( void *pvParameters )
+{
+    struct power_load loads[HEATER_COUNT];
+    struct heater_input in[HEATER_COUNT];
+    uint16_t granted[HEATER_COUNT];
+    uint8_t tuned;
+    int ii, jj;
+
+    heater_load_gains();
+
+    for (;;)
+    {
+        xSemaphoreTake( xHeaterWindow, portMAX_DELAY );
+
+        tuned = 0;
+        for (ii = 0; ii < HEATER_COUNT; ii++)
+        {
+            struct heater *h = &heaters[ii];
+            struct heater_status st = h->status;   // only the task writes it
+            uint16_t output;
+
+            taskENTER_CRITICAL();
+            heater_take(h, &in[ii]);
+            loads[ii].ma = h->ma;
+            loads[ii].priority = h->priority;
+            taskEXIT_CRITICAL();
+
+            output = heater_run(h, &in[ii], &st);
+
+            taskENTER_CRITICAL();
+            heater_publish(h, &in[ii], &st);
+            taskEXIT_CRITICAL();
+
+            tuned |= h->tuned;
+            h->tuned = 0;
+
+            loads[ii].slots = (uint8_t)(((uint32_t)output * HEATER_WINDOW_SLOTS +
+                                         HEATER_OUTPUT_MAX / 2) / HEATER_OUTPUT_MAX);
+        }
+
+        power_schedule(loads, HEATER_COUNT, HEATER_SUPPLY_BUDGET_MA - HEATER_BASE_LOAD_MA);
+
+        for (ii = 0; ii < HEATER_COUNT; ii++)
+        {
+            granted[ii] = (uint16_t)((uint32_t)loads[ii].granted * HEATER_OUTPUT_MAX /
+                                     HEATER_WINDOW_SLOTS);
+
+            // the loop must not wind up over power it was never given
+            if (in[ii].mode == HEATER_MODE_PID && loads[ii].granted < loads[ii].slots)
+                pid_track(&heaters[ii].pid, granted[ii]);
+        }
+
+        taskENTER_CRITICAL();
+        for (ii = 0; ii < HEATER_COUNT; ii++)
+        {
+            struct heater *h = &heaters[ii];
+
+            // turned off since it ran
+            if (h->mode == HEATER_MODE_OFF)
+            {
+                heater_clear_mask(ii);
+                granted[ii] = 0;
+            }
+            else
+            {
+                for (jj = 0; jj < POWER_MASK_WORDS; jj++)
+                    next_mask[ii][jj] = loads[ii].mask[jj];
+            }
+            h->status.granted = granted[ii];
+            h->status.priority = h->priority;
+        }
+        windows_unfed = 0;
+        taskEXIT_CRITICAL();
+
+        // a finished autotune survives a restart; writing it waits on the
+        // flash, so a low priority task does that
+        if (tuned)
+            gains_unsaved = 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Control interface. Changes take effect at the next window.
+////////////////////////////////////////////////////////////////////////////
+
+void heater_autotune_start(uint8_t channel, int32_t setpoint)
+{
+    struct autotune_cfg cfg;
+
+    cfg.setpoint = setpoint;
+    cfg.hysteresis = HEATER_AUTOTUNE_HYSTERESIS;
+    cfg.out_high = HEATER_OUTPUT_MAX;
+    cfg.out_low = 0;
+    cfg.cycles = HEATER_AUTOTUNE_CYCLES;
+    cfg.timeout = HEATER_AUTOTUNE_TIMEOUT;
+    cfg.max_temp = setpoint + HEATER_AUTOTUNE_MAX_RISE;
+
+    taskENTER_CRITICAL();
+    heaters[channel].tune_cfg = cfg;
+    heaters[channel].requests = (heaters[channel].requests & ~HEATER_REQ_TUNE_ABORT) |
+                                HEATER_REQ_TUNE_START;
+    heaters[channel].target = setpoint;
+    heaters[channel].mode = HEATER_MODE_AUTOTUNE;
+    taskEXIT_CRITICAL();
+}
+
+void heater_autotune_abort(uint8_t channel)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].requests = (heaters[channel].requests & ~HEATER_REQ_TUNE_START) |
+                                HEATER_REQ_TUNE_ABORT;
+    if (heaters[channel].mode == HEATER_MODE_AUTOTUNE)
+        heaters[channel].mode = HEATER_MODE_OFF;
+    heater_clear_mask(channel);
+    taskEXIT_CRITICAL();
+}
+
+// A run asked for counts as running until the task starts it
+uint8_t heater_autotune_state(uint8_t channel)
+{
+    uint8_t state;
+
+    taskENTER_CRITICAL();
+    if (heaters[channel].requests & HEATER_REQ_TUNE_START)
+        state = AUTOTUNE_RUNNING;
+    else
+        state = heaters[channel].tune.state;
+    taskEXIT_CRITICAL();
+    return state;
+}
+
+void heater_set_target(uint8_t channel, int32_t c100)
+{
+    struct heater *h = &heaters[channel];
+
+    taskENTER_CRITICAL();
+    h->target = c100;
+    h->mode = HEATER_MODE_PID;
+    taskEXIT_CRITICAL();
+}
+
+void heater_set_output(uint8_t channel, uint16_t output)
+{
+    struct heater *h = &heaters[channel];
+
+    if (output > HEATER_OUTPUT_MAX)
+        output = HEATER_OUTPUT_MAX;
+
+    taskENTER_CRITICAL();
+    h->manual = output;
+    h->mode = HEATER_MODE_MANUAL;
+    taskEXIT_CRITICAL();
+}
+
+void heater_off(uint8_t channel)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].mode = HEATER_MODE_OFF;
+    heater_clear_mask(channel);
+    taskEXIT_CRITICAL();
+}
+
+void heater_all_off(void)
+{
+    int ii;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+        heater_off(ii);
+}
+
+void heater_set_gains(uint8_t channel, int32_t kp, int32_t ki, int32_t kd)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].gains[0] = kp;
+    heaters[channel].gains[1] = ki;
+    heaters[channel].gains[2] = kd;
+    heaters[channel].requests |= HEATER_REQ_GAINS;
+    taskEXIT_CRITICAL();
+}
+
+void heater_get_gains(uint8_t channel, int32_t *kp, int32_t *ki, int32_t *kd)
+{
+    taskENTER_CRITICAL();
+    *kp = heaters[channel].gains[0];
+    *ki = heaters[channel].gains[1];
+    *kd = heaters[channel].gains[2];
+    taskEXIT_CRITICAL();
+}
+
+uint8_t heater_save_gains(void)
+{
+    int32_t gains[3];
+    uint8_t ok = 1;
+    int ii;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        heater_get_gains(ii, &gains[0], &gains[1], &gains[2]);
+        ok &= kv_set(KV_GAINS_HLT + ii, gains, sizeof(gains));
+    }
+    return ok;
+}
+
+void heater_save_tuned(void)
+{
+    if (!gains_unsaved)
+        return;
+    gains_unsaved = 0;
+    heater_save_gains();
+}
+
+void heater_get_status(uint8_t channel, struct heater_status *status)
+{
+    taskENTER_CRITICAL();
+    *status = heaters[channel].status;
+    taskEXIT_CRITICAL();
+}
+
+void heater_set_priority(uint8_t channel, uint8_t priority)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].priority = priority;
+    taskEXIT_CRITICAL();
+}
+
+void heater_set_fallback(uint8_t channel, uint8_t backup, uint8_t fallback)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].backup = backup;
+    heaters[channel].fallback = fallback;
+    taskEXIT_CRITICAL();
+}
+
+void heater_disturbance(uint8_t channel, int32_t c100)
+{
+    taskENTER_CRITICAL();
+    if (heaters[channel].mode == HEATER_MODE_PID)
+        heaters[channel].disturbance += c100;
+    taskEXIT_CRITICAL();
+}
+
+void heater_get_model(uint8_t channel, struct thermal_model *model)
+{
+    taskENTER_CRITICAL();
+    *model = heaters[channel].shared_model;
+    taskEXIT_CRITICAL();
+}
+
+void heater_set_model(uint8_t channel, const struct thermal_model *model)
+{
+    taskENTER_CRITICAL();
+    heaters[channel].shared_model = *model;
+    heaters[channel].requests |= HEATER_REQ_MODEL;
+    taskEXIT_CRITICAL();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// HLT autotune applet
+////////////////////////////////////////////////////////////////////////////
+
+static void heater_autotune_show(void)
+{
+    struct heater_status status;
+    struct autotune *at = &heaters[HEATER_HLT].tune;
+    struct thermal_model model;
+    int32_t kp, ki, kd;
+
+    heater_get_status(HEATER_HLT, &status);
+    heater_get_gains(HEATER_HLT, &kp, &ki, &kd);
+    heater_get_model(HEATER_HLT, &model);
+
+    lcd_printf(0, 9, 40, "Model%s %ldC tau %um dead %us",
+               status.model_fits ? "" : "*", (long)model.gain / 100,
+               (unsigned)(model.tau * HEATER_WINDOW_MS / 60000),
+               (unsigned)(model.dead * HEATER_WINDOW_MS / 1000));
+
+    lcd_printf(0, 10, 40, "%-14s %3ld.%02ld degC",
+               autotune_state_name(at->state),
+               (long)status.temp / 100, (long)status.temp % 100);
+    lcd_printf(0, 11, 40, "Cycle %d of %d, %lu min",
+               at->cycles_done, HEATER_AUTOTUNE_CYCLES + 1,
+               (unsigned long)(at->samples * HEATER_WINDOW_MS / 60000));
+    lcd_printf(0, 12, 40, "Kp %ld Ki %ld Kd %ld", (long)kp, (long)ki, (long)kd);
+}
+
+void heater_autotune_applet(int init){
+    if (!init)
+        return;
+
+    lcd_printf(0, 0, 40, "HLT AUTOTUNE at %d degC", HEATER_AUTOTUNE_DEFAULT_SP / 100);
+    lcd_printf(0, 1, 40, "Fill the HLT before starting");
+    lcd_DrawRect(0,   20, 159, 139, Green);
+    lcd_DrawRect(160, 20, 319, 139, Red);
+    lcd_DrawRect(0,  200, 319, 239, Blue);
+    lcd_printf(6,  4, 8, "START");
+    lcd_printf(26, 4, 8, "ABORT");
+    lcd_printf(16,13, 8, "BACK");
+    heater_autotune_show();
+}
+
+// Leaving the applet does not stop a run in progress; the status is
+// refreshed on every touch.
+int heater_autotune_key(int xx, int yy){
+    if (xx >= 0 && yy >= 20 && yy < 140)
+    {
+        if (xx < 160)
+        {
+            if (heater_autotune_state(HEATER_HLT) != AUTOTUNE_RUNNING)
+                heater_autotune_start(HEATER_HLT, HEATER_AUTOTUNE_DEFAULT_SP);
+        }
+        else
+            heater_autotune_abort(HEATER_HLT);
+    }
+    else if (yy >= 200)
+        return 1;
+
+    heater_autotune_show();
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Power applet, how the scheduler has shared out the window
+////////////////////////////////////////////////////////////////////////////
+
+static const char *priority_names[] = { "low", "normal", "high" };
+
+static void heater_power_show(void)
+{
+    static const char *names[HEATER_COUNT] = { "HLT", "Mash" };
+    uint32_t mask[POWER_MASK_WORDS];
+    int ii, jj;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        struct heater_status st;
+        int row = 2 + ii * 4;
+
+        heater_get_status(ii, &st);
+        taskENTER_CRITICAL();
+        for (jj = 0; jj < POWER_MASK_WORDS; jj++)
+            mask[jj] = next_mask[ii][jj];
+        taskEXIT_CRITICAL();
+
+        lcd_printf(0, row, 30, "%-4s %-6s %3d%% -> %3d%%", names[ii],
+                   priority_names[st.priority], st.output / 10, st.granted / 10);
+        lcd_printf(0, row + 1, 30, "element %2u.%u A",
+                   analog_element_ma(ii) / 1000, (analog_element_ma(ii) / 100) % 10);
+
+        // one 3 pixel column per slot
+        for (jj = 0; jj < HEATER_WINDOW_SLOTS; jj++)
+            lcd_fill(10 + jj * 3, (row + 2) * 16 + 2, 3, 12,
+                     POWER_SLOT_ON(mask, jj) ? Red : Grey);
+    }
+}
+
+void heater_power_applet(int init){
+    if (!init)
+        return;
+
+    lcd_printf(0, 0, 30, "POWER  budget %u.%u A",
+               (HEATER_SUPPLY_BUDGET_MA - HEATER_BASE_LOAD_MA) / 1000,
+               ((HEATER_SUPPLY_BUDGET_MA - HEATER_BASE_LOAD_MA) / 100) % 10);
+    lcd_DrawRect(0, 200, 319, 239, Blue);
+    lcd_printf(16,13, 8, "BACK");
+    heater_power_show();
+}
+
+// Touch anywhere to refresh
+int heater_power_key(int xx, int yy){
+    if (yy >= 200)
+        return 1;
+
+    heater_power_show();
+    return 0;
+}
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HEATER_H
+#define HEATER_H
+
+#include <stdint.h>
+#include "thermal.h"
+#include "power.h"
+#include "sensor.h"
+
+// Solid state relays for the elements, active high
+#define HEATER_PORT      GPIOE
+#define HEATER_HLT_PIN   GPIO_Pin_2
+#define HEATER_MASH_PIN  GPIO_Pin_3
+
+enum heater_channel
+{
+    HEATER_HLT,
+    HEATER_MASH,
+    HEATER_COUNT
+};
+
+enum heater_mode
+{
+    HEATER_MODE_OFF,
+    HEATER_MODE_PID,     // hold a target temperature
+    HEATER_MODE_MANUAL,  // fixed output
+    HEATER_MODE_AUTOTUNE // relay experiment, see autotune.c
+};
+
+// What a channel does when its probe fails (see sensor.h). If it has a
+// backup probe that is still good it carries on from that either way.
+enum heater_fallback
+{
+    HEATER_FALLBACK_OFF,
+    HEATER_FALLBACK_HOLD   // keep the last output for HEATER_HOLD_WINDOWS
+};
+
+// TIM6 ticks once per slot. The elements are switched on for the first
+// `output' slots of each window, so the window is the PID sample period.
+#define HEATER_SLOT_MS       20    // one mains cycle at 50Hz
+#define HEATER_WINDOW_SLOTS  POWER_SLOTS
+#define HEATER_WINDOW_MS     (HEATER_SLOT_MS * HEATER_WINDOW_SLOTS)
+#define HEATER_OUTPUT_MAX    1000  // output is in tenths of a percent
+
+// Windows the ISR will keep repeating an output for without the task
+// posting a new one, before it turns the elements off.
+#define HEATER_WATCHDOG_WINDOWS 3
+
+// Temperature samples older than this turn the channel off
+#define HEATER_SAMPLE_TIMEOUT_MS 10000
+
+// Without a good reading a channel holds its output this long at most,
+// then turns off. A SUSPECT probe is always ridden out this way.
+#define HEATER_HOLD_WINDOWS      30    // 1 minute
+
+#define HEATER_HLT_BACKUP        SENSOR_NONE
+#define HEATER_MASH_BACKUP       SENSOR_NONE
+#define HEATER_HLT_FALLBACK      HEATER_FALLBACK_HOLD
+#define HEATER_MASH_FALLBACK     HEATER_FALLBACK_HOLD
+
+// A PID channel this far below target with the output this high should
+// see its probe move; one that doesn't is stuck.
+#define HEATER_STUCK_OUTPUT      800
+#define HEATER_STUCK_MARGIN      200
+
+// Mains current. The elements are scheduled so the total, including
+// the controller, pump and crane, stays within the supply breaker.
+#define HEATER_SUPPLY_BUDGET_MA  15000
+#define HEATER_BASE_LOAD_MA      1500
+#define HEATER_HLT_MA            10000   // 2.4kW
+#define HEATER_MASH_MA           10000
+
+// Able to give the window semaphore
+#define HEATER_IRQ_PRIORITY 12
+
+// Default gains, PID_Q fixed point. Error is in hundredths of a degree.
+#define HEATER_DEFAULT_KP 384      // 150 per degree
+#define HEATER_DEFAULT_KI 4        // per window
+#define HEATER_DEFAULT_KD 1280     // 500 per degree per window
+
+// Vessel model the loop starts from until one has been fitted, roughly
+// 40l heated by 2.4kW. See thermal.h.
+#define HEATER_MODEL_GAIN     17200   // 172 degC over ambient at full power
+#define HEATER_MODEL_TAU      6000    // windows, 3h20m
+#define HEATER_MODEL_DEAD     20      // windows, 40s
+#define HEATER_MODEL_AMBIENT  1800
+
+// Relay autotune settings
+#define HEATER_AUTOTUNE_HYSTERESIS  20     // 0.2 degC, a few DS1820 counts
+#define HEATER_AUTOTUNE_CYCLES      3
+#define HEATER_AUTOTUNE_TIMEOUT     (4UL * 3600 * 1000 / HEATER_WINDOW_MS)
+#define HEATER_AUTOTUNE_MAX_RISE    1000   // abort 10 degC over the setpoint
+#define HEATER_AUTOTUNE_DEFAULT_SP  6500
+
+struct heater_status
+{
+    uint8_t  mode;
+    int32_t  target;     // hundredths of a degree
+    int32_t  temp;       // filtered, projected to the window, hundredths of a degree
+    int32_t  rate;       // rate of rise, hundredths of a degree per minute
+    uint16_t output;     // tenths of a percent, what the loop asked for
+    uint16_t granted;    // what the load scheduler let it have
+    uint8_t  priority;
+    uint8_t  stale;      // no good sample, output forced off unless holding
+    uint8_t  holding;    // riding out a probe fault on the last output
+    uint8_t  probe;      // ds1820 sensor in use, the backup if the main one failed
+    uint8_t  fault;      // the main probe's, see sensor.h
+    int32_t  reference;  // what the model expects the vessel to read
+    uint16_t feedforward;
+    uint8_t  model_fits; // models fitted since power up
+};
+
+void vHeaterInit(void);
+void vHeaterTask( void *pvParameters );
+
+void heater_set_target(uint8_t channel, int32_t c100);
+void heater_set_output(uint8_t channel, uint16_t output);
+void heater_off(uint8_t channel);
+void heater_all_off(void);
+
+void heater_set_gains(uint8_t channel, int32_t kp, int32_t ki, int32_t kd);
+void heater_get_gains(uint8_t channel, int32_t *kp, int32_t *ki, int32_t *kd);
+
+// Both channels' gains to the settings store, see kv.h; the task loads
+// them when it starts. Returns 1 if they were written.
+uint8_t heater_save_gains(void);
+// Saves them if an autotune has finished since the last call. A kv_set()
+// can take a second or more when the store clears out a sector, so this
+// is for a low priority task to poll, never the heater task.
+void    heater_save_tuned(void);
+void heater_get_status(uint8_t channel, struct heater_status *status);
+
+// Which element goes short when both can't be on, see power.h
+void heater_set_priority(uint8_t channel, uint8_t priority);
+
+// backup is a ds1820 sensor index or SENSOR_NONE
+void heater_set_fallback(uint8_t channel, uint8_t backup, uint8_t fallback);
+
+// Tell the loop about a step the vessel is about to take, eg. the grain
+// basket going in, so it heats through it rather than waiting for the
+// temperature to fall.
+void heater_disturbance(uint8_t channel, int32_t c100);
+
+// The model is refitted from the channel's own heating every
+// THERMAL_FIT_BLOCKS; these read or replace the current one.
+void heater_get_model(uint8_t channel, struct thermal_model *model);
+void heater_set_model(uint8_t channel, const struct thermal_model *model);
+
+// Tuned gains replace the channel's gains when the experiment completes,
+// and are saved by heater_save_tuned()
+void    heater_autotune_start(uint8_t channel, int32_t setpoint);
+void    heater_autotune_abort(uint8_t channel);
+uint8_t heater_autotune_state(uint8_t channel);
+
+void heater_autotune_applet(int init);
+int  heater_autotune_key(int xx, int yy);
+
+void heater_power_applet(int init);
+int  heater_power_key(int xx, int yy);
+
+#endif
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Runs abfilter.c over a simulated boil: a vessel heating at a steady
+// rate, levelling off at the boil, read at DS1820 resolution with a
+// little noise and some jitter in the conversion time. Reports how far
+// the raw readings, the filter and its prediction to the middle of the
+// next interval are from the truth, the rate of rise error, and how long
+// after the boil the rate reads flat.
+//
+// Build on Linux from the top of the tree:
+//   gcc -I. -o abfilter_bench host/abfilter_bench.c abfilter.c -lm
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "abfilter.h"
+
+#define RATE_PER_MIN  1.0     // degC
+#define BOIL          98.6
+#define START         80.0
+
+static double truth(double secs)
+{
+    double temp = START + RATE_PER_MIN * secs / 60.0;
+
+    // rounds over into the boil rather than stopping dead
+    if (temp > BOIL - 0.5)
+        temp = BOIL - 0.5 * exp(-(temp - (BOIL - 0.5)) / 0.5);
+    return temp;
+}
+
+// 1/16 degree steps, hundredths
+static int32_t probe(double temp)
+{
+    double noisy = temp + ((rand() % 1000) - 500) / 1000.0 * 0.1;
+    return (int32_t)floor(noisy * 16.0) * 100 / 16;
+}
+
+int main(void)
+{
+    struct ab_filter f;
+    unsigned long ms = 0;
+    double raw_err = 0, filt_err = 0, pred_err = 0, rate_err = 0;
+    int n = 0, n_rate = 0;
+    double boil_at = -1, flat_at = -1;
+
+    srand(1);
+    ab_reset(&f);
+
+    while (ms < 40UL * 60 * 1000)
+    {
+        double secs = ms / 1000.0;
+        double now = truth(secs);
+        int32_t raw = probe(now);
+        unsigned long next = ms + 2000 + rand() % 200;
+        double mid = truth((ms + next) / 2000.0);
+
+        ab_update(&f, raw, ms);
+
+        // skip the first few minutes while it locks on
+        if (secs > 180)
+        {
+            raw_err += pow(raw / 100.0 - now, 2);
+            filt_err += pow(ab_temp(&f) / 100.0 - now, 2);
+            pred_err += pow(ab_predict(&f, (ms + next) / 2) / 100.0 - mid, 2);
+            n++;
+            if (now < BOIL - 1.0)
+            {
+                rate_err += pow(ab_rate_per_min(&f) / 100.0 - RATE_PER_MIN, 2);
+                n_rate++;
+            }
+        }
+        if (boil_at < 0 && now > BOIL - 0.05)
+            boil_at = secs;
+        if (boil_at >= 0 && flat_at < 0 && ab_rate_per_min(&f) < 10)
+            flat_at = secs;
+        ms = next;
+    }
+
+    printf("rms error, degC:  raw %.3f  filtered %.3f  predicted %.3f\n",
+           sqrt(raw_err / n), sqrt(filt_err / n), sqrt(pred_err / n));
+    printf("rate of rise rms error %.3f degC/min at %.1f degC/min\n",
+           sqrt(rate_err / n_rate), RATE_PER_MIN);
+    printf("within 0.05 degC of the boil at %.0f s, rate under 0.1/min at %.0f s\n",
+           boil_at, flat_at);
+    return 0;
+}
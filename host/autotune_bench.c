@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Runs autotune.c against a simulated vessel: a first order lag with dead
+// time, heated by time-proportioned windows as heater.c does, read
+// through a sensor with DS1820 resolution. Prints the tuning result, then
+// steps the PID loop with the tuned and default gains for comparison.
+//
+// Build on Linux from the top of the tree:
+//   gcc -I. -Ihost -o autotune_bench host/autotune_bench.c autotune.c pid.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "autotune.h"
+#include "pid.h"
+#include "heater.h"
+
+#define WINDOW_S    (HEATER_WINDOW_MS / 1000.0)
+#define MAX_DELAY   64
+
+struct vessel
+{
+    double temp;           // degC
+    double ambient;
+    double rise_full;      // degC above ambient at full power, steady state
+    double tau;            // s
+    int    delay;          // windows of dead time
+    double history[MAX_DELAY];
+    int    head;
+};
+
+static void vessel_init(struct vessel *v, double litres, double watts, double tau,
+                        double dead_s, double start)
+{
+    memset(v, 0, sizeof(*v));
+    v->temp = start;
+    v->ambient = 18.0;
+    v->tau = tau;
+    v->rise_full = watts / (litres * 4186.0) * tau;
+    v->delay = (int)(dead_s / WINDOW_S);
+    if (v->delay >= MAX_DELAY)
+        v->delay = MAX_DELAY - 1;
+}
+
+// output in tenths of a percent, for one window
+static void vessel_step(struct vessel *v, int output)
+{
+    double heat = v->history[(v->head + MAX_DELAY - v->delay) % MAX_DELAY];
+
+    v->history[v->head] = output / (double)HEATER_OUTPUT_MAX;
+    v->head = (v->head + 1) % MAX_DELAY;
+    v->temp += WINDOW_S * (heat * v->rise_full - (v->temp - v->ambient)) / v->tau;
+}
+
+// hundredths of a degree at 1/16 degree resolution
+static int32_t vessel_read(const struct vessel *v)
+{
+    int32_t c16 = (int32_t)(v->temp * 16.0);
+    return (c16 * 100) / 16;
+}
+
+static void run_loop(const char *title, int32_t kp, int32_t ki, int32_t kd,
+                     int32_t target)
+{
+    struct vessel v;
+    struct pid pid;
+    int32_t peak = 0;
+    int     settled = -1;
+    int     ii;
+
+    vessel_init(&v, 40, 2400, 12000, 40, 20.0);
+    pid_init(&pid, kp, ki, kd, 0, HEATER_OUTPUT_MAX);
+
+    for (ii = 0; ii < 5400; ii++)
+    {
+        int32_t temp = vessel_read(&v);
+
+        vessel_step(&v, pid_update(&pid, target, temp));
+        if (temp > peak)
+            peak = temp;
+        if (temp > target - 25 && temp < target + 25)
+        {
+            if (settled < 0)
+                settled = ii;
+        }
+        else
+            settled = -1;
+    }
+
+    peak -= target;
+    printf("%-8s kp %5ld ki %4ld kd %6ld  overshoot %s%ld.%02ld degC  settled (+/-0.25) ",
+           title, (long)kp, (long)ki, (long)kd, peak < 0 ? "-" : "",
+           (long)(peak < 0 ? -peak : peak) / 100, (long)(peak < 0 ? -peak : peak) % 100);
+    if (settled >= 0)
+        printf("after %d min\n", (int)(settled * WINDOW_S / 60));
+    else
+        printf("never\n");
+}
+
+int main(void)
+{
+    struct autotune_cfg cfg = { 6500, 20, HEATER_OUTPUT_MAX, 0, 3, 7200, 8500 };
+    struct autotune at;
+    struct vessel v;
+    uint16_t output = 0;
+
+    vessel_init(&v, 40, 2400, 12000, 40, 20.0);
+    autotune_start(&at, &cfg);
+
+    while (at.state == AUTOTUNE_RUNNING)
+    {
+        output = autotune_step(&at, vessel_read(&v));
+        vessel_step(&v, output);
+    }
+
+    printf("autotune %s after %lu windows (%lu min)\n", autotune_state_name(at.state),
+           (unsigned long)at.samples, (unsigned long)(at.samples * WINDOW_S / 60));
+    if (at.state != AUTOTUNE_DONE)
+        return 1;
+
+    printf("Pu %lu.%02lu windows  Ku %ld/256 per 0.01 degC\n\n",
+           (unsigned long)(at.pu >> 4), (unsigned long)((at.pu & 15) * 100 / 16),
+           (long)at.ku);
+
+    run_loop("tuned", at.kp, at.ki, at.kd, 6600);
+    run_loop("default", HEATER_DEFAULT_KP, HEATER_DEFAULT_KI, HEATER_DEFAULT_KD, 6600);
+    return 0;
+}
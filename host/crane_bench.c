@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Runs crane.c and crane_profile.c against the simulated step timer in
+// crane_sim.c. Homes the crane onto the lower switch, then makes random
+// moves at several interrupt latencies and checks that each puts out
+// exactly as many full width pulses as steps asked for, and that the
+// position crane.c counts from TIM4 is where the carriage really is.
+// Also checks that moves before homing and outside the soft limits go
+// nowhere, that stopped runs keep count, and that the upper switch stops
+// a move heading into it and logs a fault, also when the switch interrupt
+// preempts the step interrupt.
+//
+// Build on Linux from the top of the tree:
+//   gcc -DCRANE_SIM -I. -Ihost -o crane_bench host/crane_bench.c
+//       host/crane_sim.c crane.c crane_profile.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "crane_sim.h"
+#include "crane.h"
+#include "crane_profile.h"
+
+#define MOVES       250
+#define START_AT    700        // carriage steps above the lower switch
+#define UPPER_AT    11000      // upper switch, inside CRANE_SOFT_MAX
+#define RUN_LIMIT   60000000   // us before a move counts as hung
+
+static const struct crane_profile_cfg fast = { 2000, 20000, 60000, 0 };
+static const struct crane_profile_cfg fast_jerk = { 2000, 15000, 60000, 60000 };
+
+static const uint32_t latencies[] = { 0, 3, 12, 40 };
+
+static unsigned failures;
+
+static void fail(const char *what, long got, long want)
+{
+    printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+    failures++;
+}
+
+static void check(const char *what, long got, long want)
+{
+    if (got != want)
+        fail(what, got, want);
+}
+
+static uint32_t pulses(void)
+{
+    struct crane_sim_stats st;
+
+    crane_sim_stats(&st);
+    return st.pulses;
+}
+
+static uint32_t runts(void)
+{
+    struct crane_sim_stats st;
+
+    crane_sim_stats(&st);
+    return st.runts;
+}
+
+// a crane that never stops makes the rest meaningless
+static void settle(const char *what)
+{
+    if (crane_sim_run(RUN_LIMIT, 1) == 0 || crane_is_running())
+    {
+        printf("FAIL %s: still running after %us\n", what, RUN_LIMIT / 1000000);
+        exit(1);
+    }
+}
+
+static void check_position(const char *what)
+{
+    check(what, crane_get_position(), crane_sim_carriage());
+}
+
+static void move(int32_t target, const char *what)
+{
+    int32_t from = crane_get_position();
+    uint32_t before = pulses();
+    uint32_t r = runts();
+
+    check(what, crane_move_to(target), pdPASS);
+    settle(what);
+    check(what, pulses() - before, labs(target - from));
+    check(what, crane_get_position(), target);
+    check_position(what);
+    check(what, runts() - r, 0);
+}
+
+// Run into the upper switch, which must stop the crane and log it, then
+// home again
+static void limits(uint16_t rate)
+{
+    struct crane_profile_cfg cfg = fast;
+    struct crane_fault fault;
+    uint32_t before = crane_fault_count();
+
+    cfg.cruise_rate = rate;
+    crane_set_profile(&cfg);
+    check("into upper switch", crane_move_to(CRANE_SOFT_MAX), pdPASS);
+    settle("into upper switch");
+    check("upper stop", crane_sim_carriage(), UPPER_AT);
+    check_position("upper stop");
+    check("upper faults", crane_fault_count() - before, 1);
+    check("upper fault read", crane_get_fault(0, &fault), pdPASS);
+    check("upper fault type", fault.type, CRANE_FAULT_UPPER_LIMIT);
+    check("upper fault position", fault.position, UPPER_AT);
+
+    // a move further up is refused at the switch
+    crane_move_to(CRANE_SOFT_MAX);
+    settle("upper refused");
+    check("upper refused carriage", crane_sim_carriage(), UPPER_AT);
+    check("upper refused faults", crane_fault_count() - before, 2);
+
+    move(UPPER_AT - 1000 - rand() % 5000, "away from upper");
+    crane_home();
+    settle("rehome");
+    check("rehomed", crane_is_homed(), 1);
+    check("rehome carriage", crane_sim_carriage(), 0);
+    check_position("rehome");
+    move(CRANE_SOFT_MIN, "after rehome");
+    crane_set_profile(&fast);
+}
+
+int main(void)
+{
+    struct crane_profile_cfg slow;
+    uint32_t before, ii, ll;
+
+    srand(1);
+    crane_sim_init(START_AT, UPPER_AT);
+    vCraneInit();
+    crane_task_init();
+    crane_get_profile(&slow);
+
+    // start TIM4 just short of its wrap so the overflow path is used
+    TIM4->CNT = 0xFFF0;
+
+    // nothing moves before homing
+    check("unhomed move", crane_move_to(1000), pdFAIL);
+    check("unhomed pulses", pulses(), 0);
+
+    crane_set_profile(&fast);
+    crane_home();
+    settle("home");
+    check("homed", crane_is_homed(), 1);
+    check("home position", crane_get_position(), CRANE_HOME_POSITION);
+    check("home carriage", crane_sim_carriage(), 0);
+    check("home pulses", pulses(), START_AT);
+    printf("homed from %d steps up\n", START_AT);
+
+    before = pulses();
+    check("below soft min", crane_move_to(CRANE_SOFT_MIN - 1), pdFAIL);
+    check("above soft max", crane_move_to(CRANE_SOFT_MAX + 1), pdFAIL);
+    check("rejected pulses", pulses() - before, 0);
+    move(CRANE_SOFT_MIN, "to soft min");
+
+    // each latency is below the shortest period, 50us at 20000 steps/s
+    for (ll = 0; ll < sizeof(latencies) / sizeof(latencies[0]); ll++)
+    {
+        crane_sim_latency(latencies[ll]);
+        before = pulses();
+        for (ii = 0; ii < MOVES; ii++)
+        {
+            crane_set_profile(ii & 1 ? &fast_jerk : &fast);
+            move(CRANE_SOFT_MIN + rand() % (UPPER_AT - 100 - CRANE_SOFT_MIN), "random move");
+            // short hops never leave the start rate
+            move(crane_get_position() + (rand() % 3 + 1) * (rand() & 1 ? 1 : -1) +
+                 (crane_get_position() < 100 ? 5 : 0), "short move");
+        }
+        printf("latency %2luus: %u moves, %lu pulses\n", (unsigned long)latencies[ll],
+               2 * MOVES, (unsigned long)(pulses() - before));
+    }
+    crane_sim_latency(3);
+
+    // at the real rates
+    crane_set_profile(&slow);
+    move(800, "slow move");
+    move(400, "slow move");
+    move(401, "slow single step");
+    crane_set_profile(&fast);
+
+    // open ended runs ramp down wherever they are stopped
+    for (ii = 0; ii < 50; ii++)
+    {
+        move(CRANE_SOFT_MIN + rand() % 1000, "before run");
+        vCraneRun(20000);
+        crane_sim_run(1000 + rand() % 200000, 0);
+        before = runts();
+        vCraneStop();
+        settle("stopped run");
+        check("stopped run runts", runts() - before, 0);
+        check_position("stopped run");
+    }
+    check("runt pulses", runts(), 0);
+    printf("%lu pulses, %lu runts\n", (unsigned long)pulses(), (unsigned long)runts());
+
+    // the switches, with the limit interrupt also landing inside the
+    // step interrupt
+    for (ll = 0; ll < sizeof(latencies) / sizeof(latencies[0]); ll++)
+    {
+        crane_sim_latency(latencies[ll]);
+        crane_sim_nest(ll & 1);
+        for (ii = 0; ii < 20; ii++)
+            limits(rand() % 20000 + 1000);
+    }
+    check("limit runts", runts(), 0);
+    printf("%lu limit stops, last at %ld\n", (unsigned long)crane_fault_count(),
+           (long)crane_get_position());
+
+    printf("%u failures\n", failures);
+    return failures != 0;
+}
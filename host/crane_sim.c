@@ -0,0 +1,554 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdarg.h>
+#include "crane_sim.h"
+#include "crane.h"
+
+TIM_TypeDef  sim_tim3, sim_tim4, sim_tim5;
+GPIO_TypeDef sim_gpioa, sim_gpioc;
+
+volatile unsigned long ulUptimeMs;
+
+void TIM3_IRQHandler(void);
+void TIM4_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+
+#define OC3M_FORCE_ACTIVE 0x0050
+
+static uint16_t arr_shadow[2];      // TIM3, TIM4
+static uint8_t  tim4_ext_clock;
+static uint8_t  oc3ref;
+static uint8_t  step_af;            // step pin handed to TIM3
+static uint8_t  step_pin;
+static uint32_t pulse_start;
+
+static uint32_t exti_enabled, exti_pending;
+static uint8_t  exti_irq_enabled;
+static uint8_t  nvic_pended[2];     // TIM3, TIM4 by NVIC_SetPendingIRQ
+static uint32_t irq_since[2];       // when each was first seen pending
+static uint8_t  irq_waiting[2];
+static uint32_t latency;
+static uint8_t  nest, in_tim3;
+
+static int32_t  carriage, upper_at;
+static uint8_t  lower_closed, upper_closed;
+static uint32_t now_us;
+static struct crane_sim_stats stats;
+
+static uint16_t *shadow(TIM_TypeDef *tim)
+{
+    return tim == TIM4 ? &arr_shadow[1] : &arr_shadow[0];
+}
+
+// a held limit interrupt preempting the step interrupt
+static void preempt(void)
+{
+    if (in_tim3 && exti_irq_enabled && exti_pending)
+    {
+        in_tim3 = 0;
+        EXTI15_10_IRQHandler();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Limit switches and the carriage
+////////////////////////////////////////////////////////////////////////////
+
+static void set_switch(uint16_t pin, uint32_t line, uint8_t *closed, uint8_t now)
+{
+    if (now == *closed)
+        return;
+    *closed = now;
+    if (now ? CRANE_LIMIT_ACTIVE : !CRANE_LIMIT_ACTIVE)
+        sim_gpioc.IDR |= pin;
+    else
+        sim_gpioc.IDR &= ~pin;
+    // the line is set up to trigger on closing
+    if (now && (exti_enabled & line))
+        exti_pending |= line;
+}
+
+static void update_switches(void)
+{
+    set_switch(CRANE_LOWER_LIMIT_PIN, CRANE_LOWER_LIMIT_LINE, &lower_closed, carriage <= 0);
+    set_switch(CRANE_UPPER_LIMIT_PIN, CRANE_UPPER_LIMIT_LINE, &upper_closed, carriage >= upper_at);
+}
+
+uint8_t crane_sim_enabled(void)
+{
+    return ((sim_gpioc.ODR & CRANE_ENABLE_PIN) != 0) == CRANE_ENABLE_LEVEL;
+}
+
+static void step_edge(uint8_t level)
+{
+    if (level == step_pin)
+        return;
+    step_pin = level;
+    if (level)
+    {
+        pulse_start = now_us;
+        stats.pulses++;
+        if (crane_sim_enabled())
+        {
+            uint8_t up = ((sim_gpioc.ODR & CRANE_DIR_PIN) != 0) == CRANE_DIR_UP_LEVEL;
+            carriage += up ? 1 : -1;
+        }
+    }
+    else
+    {
+        if (now_us - pulse_start < CRANE_PULSE_US)
+            stats.runts++;
+        // the step lands long after its edge, so a switch it closes can
+        // not cut the pulse short
+        update_switches();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Timers
+////////////////////////////////////////////////////////////////////////////
+
+static void tim4_count(void)
+{
+    if (!tim4_ext_clock || !(sim_tim4.CR1 & TIM_CR1_CEN))
+        return;
+    if (sim_tim4.CNT >= arr_shadow[1])
+    {
+        sim_tim4.CNT = 0;
+        sim_tim4.SR |= TIM_FLAG_Update;
+        arr_shadow[1] = sim_tim4.ARR;
+    }
+    else
+        sim_tim4.CNT++;
+}
+
+// OC3REF from the mode and the count, then what follows from it changing
+static void oc3_eval(void)
+{
+    uint8_t ref = oc3ref;
+
+    switch (sim_tim3.CCMR2 & TIM_CCMR2_OC3M)
+    {
+    case TIM_OCMode_PWM1:
+        ref = sim_tim3.CNT < sim_tim3.CCR3;
+        break;
+    case TIM_OCMode_Inactive:
+        if (sim_tim3.CNT == sim_tim3.CCR3)
+            ref = 0;
+        break;
+    case TIM_ForcedAction_InActive:
+        ref = 0;
+        break;
+    case OC3M_FORCE_ACTIVE:
+        ref = 1;
+        break;
+    }
+
+    // TRGO is OC3REF
+    if (ref && !oc3ref)
+        tim4_count();
+    oc3ref = ref;
+    step_edge(step_af && (sim_tim3.CCER & TIM_CCER_CC3E) ? oc3ref : 0);
+}
+
+static void update_event(TIM_TypeDef *tim)
+{
+    tim->SR |= TIM_FLAG_Update;
+    *shadow(tim) = tim->ARR;
+    if (tim->CR1 & TIM_CR1_OPM)
+        tim->CR1 &= ~TIM_CR1_CEN;
+}
+
+static void tim3_tick(void)
+{
+    uint16_t top = (sim_tim3.CR1 & TIM_CR1_ARPE) ? arr_shadow[0] : sim_tim3.ARR;
+
+    if (!(sim_tim3.CR1 & TIM_CR1_CEN))
+        return;
+    if (sim_tim3.CNT >= top)
+    {
+        sim_tim3.CNT = 0;
+        update_event(TIM3);
+    }
+    else
+        sim_tim3.CNT++;
+}
+
+void TIM_DeInit(TIM_TypeDef *tim)
+{
+    tim->CR1 = tim->DIER = tim->SR = tim->CCMR2 = tim->CCER = 0;
+    tim->CNT = tim->CCR3 = 0;
+    tim->ARR = *shadow(tim) = 0xFFFF;
+    if (tim == TIM3)
+        oc3ref = 0;
+    if (tim == TIM4)
+        tim4_ext_clock = 0;
+}
+
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init)
+{
+    init->TIM_Period = 0xFFFF;
+    init->TIM_Prescaler = 0;
+    init->TIM_ClockDivision = TIM_CKD_DIV1;
+    init->TIM_CounterMode = TIM_CounterMode_Up;
+    init->TIM_RepetitionCounter = 0;
+}
+
+// Like the library, generates an update to load the prescaler
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init)
+{
+    tim->ARR = init->TIM_Period;
+    tim->CNT = 0;
+    update_event(tim);
+}
+
+void TIM_OCStructInit(TIM_OCInitTypeDef *init)
+{
+    init->TIM_OCMode = 0;
+    init->TIM_OutputState = 0;
+    init->TIM_Pulse = 0;
+}
+
+void TIM_OC3Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init)
+{
+    tim->CCMR2 = (tim->CCMR2 & ~TIM_CCMR2_OC3M) | init->TIM_OCMode;
+    tim->CCR3 = init->TIM_Pulse;
+    if (init->TIM_OutputState == TIM_OutputState_Enable)
+        tim->CCER |= TIM_CCER_CC3E;
+    oc3_eval();
+}
+
+void TIM_ARRPreloadConfig(TIM_TypeDef *tim, FunctionalState state)
+{
+    if (state)
+        tim->CR1 |= TIM_CR1_ARPE;
+    else
+        tim->CR1 &= ~TIM_CR1_ARPE;
+}
+
+void TIM_UpdateRequestConfig(TIM_TypeDef *tim, uint16_t source)
+{
+    if (source == TIM_UpdateSource_Regular)
+        tim->CR1 |= TIM_CR1_URS;
+    else
+        tim->CR1 &= ~TIM_CR1_URS;
+}
+
+void TIM_SelectOutputTrigger(TIM_TypeDef *tim, uint16_t source)
+{
+}
+
+void TIM_ITRxExternalClockConfig(TIM_TypeDef *tim, uint16_t source)
+{
+    if (tim == TIM4 && source == TIM_TS_ITR2)
+        tim4_ext_clock = 1;
+}
+
+void TIM_EncoderInterfaceConfig(TIM_TypeDef *tim, uint16_t mode, uint16_t pol1, uint16_t pol2)
+{
+}
+
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state)
+{
+    preempt();
+    if (state)
+        tim->DIER |= it;
+    else
+        tim->DIER &= ~it;
+}
+
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it)
+{
+    preempt();
+    tim->SR &= ~it;
+}
+
+ITStatus TIM_GetITStatus(TIM_TypeDef *tim, uint16_t it)
+{
+    preempt();
+    return (tim->SR & tim->DIER & it) ? SET : RESET;
+}
+
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state)
+{
+    preempt();
+    if (state)
+        tim->CR1 |= TIM_CR1_CEN;
+    else
+        tim->CR1 &= ~TIM_CR1_CEN;
+}
+
+void TIM_SetAutoreload(TIM_TypeDef *tim, uint16_t arr)
+{
+    tim->ARR = arr;
+}
+
+void TIM_SetCounter(TIM_TypeDef *tim, uint16_t cnt)
+{
+    tim->CNT = cnt;
+    if (tim == TIM3)
+        oc3_eval();
+}
+
+// With URS set an update from UG reloads the registers but flags nothing
+void TIM_GenerateEvent(TIM_TypeDef *tim, uint16_t source)
+{
+    uint16_t sr = tim->SR;
+
+    tim->CNT = 0;
+    update_event(tim);
+    if (tim->CR1 & TIM_CR1_URS)
+        tim->SR = sr;
+    if (tim == TIM3)
+        oc3_eval();
+}
+
+// Like the library, turns the channel off while changing its mode
+void TIM_SelectOCxM(TIM_TypeDef *tim, uint16_t channel, uint16_t mode)
+{
+    tim->CCER &= ~TIM_CCER_CC3E;
+    tim->CCMR2 = (tim->CCMR2 & ~TIM_CCMR2_OC3M) | mode;
+    oc3_eval();
+}
+
+void TIM_CCxCmd(TIM_TypeDef *tim, uint16_t channel, uint16_t state)
+{
+    if (state == TIM_CCx_Enable)
+        tim->CCER |= TIM_CCER_CC3E;
+    else
+        tim->CCER &= ~TIM_CCER_CC3E;
+    oc3_eval();
+}
+
+void TIM_ForcedOC3Config(TIM_TypeDef *tim, uint16_t action)
+{
+    preempt();
+    tim->CCMR2 = (tim->CCMR2 & ~TIM_CCMR2_OC3M) | action;
+    oc3_eval();
+}
+
+void TIM_SelectOnePulseMode(TIM_TypeDef *tim, uint16_t mode)
+{
+    preempt();
+    tim->CR1 = (tim->CR1 & ~TIM_CR1_OPM) | mode;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// GPIO, EXTI, NVIC and clocks
+////////////////////////////////////////////////////////////////////////////
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    if (port == CRANE_PORT && (init->GPIO_Pin & CRANE_STEP_PIN))
+        step_af = init->GPIO_Mode == GPIO_Mode_AF_PP;
+    oc3_eval();
+}
+
+void GPIO_WriteBit(GPIO_TypeDef *port, uint16_t pin, BitAction val)
+{
+    if (val)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~pin;
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) != 0;
+}
+
+void GPIO_PinRemapConfig(uint32_t remap, FunctionalState state)
+{
+}
+
+void GPIO_EXTILineConfig(uint8_t port, uint8_t pin)
+{
+}
+
+void EXTI_Init(EXTI_InitTypeDef *init)
+{
+    if (init->EXTI_LineCmd)
+        exti_enabled |= init->EXTI_Line;
+    else
+        exti_enabled &= ~init->EXTI_Line;
+}
+
+ITStatus EXTI_GetITStatus(uint32_t line)
+{
+    return (exti_pending & line) ? SET : RESET;
+}
+
+void EXTI_ClearITPendingBit(uint32_t line)
+{
+    exti_pending &= ~line;
+}
+
+void NVIC_Init(NVIC_InitTypeDef *init)
+{
+    if (init->NVIC_IRQChannel == EXTI15_10_IRQn)
+        exti_irq_enabled = init->NVIC_IRQChannelCmd;
+}
+
+void NVIC_SetPendingIRQ(int irq)
+{
+    if (irq == TIM3_IRQn)
+        nvic_pended[0] = 1;
+    else if (irq == TIM4_IRQn)
+        nvic_pended[1] = 1;
+    else if (irq == EXTI15_10_IRQn)
+        EXTI15_10_IRQHandler();
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+// FreeRTOS and LCD stubs
+////////////////////////////////////////////////////////////////////////////
+
+xQueueHandle xQueueCreate(unsigned len, unsigned size)
+{
+    return 0;
+}
+
+portBASE_TYPE xQueueReceive(xQueueHandle queue, void *item, unsigned long wait)
+{
+    return pdFALSE;
+}
+
+portBASE_TYPE xQueueSendToBack(xQueueHandle queue, const void *item, unsigned long wait)
+{
+    return pdPASS;
+}
+
+portBASE_TYPE xQueueSendToFront(xQueueHandle queue, const void *item, unsigned long wait)
+{
+    return pdPASS;
+}
+
+portBASE_TYPE xQueueSendToFrontFromISR(xQueueHandle queue, const void *item,
+                                       portBASE_TYPE *woken)
+{
+    return pdPASS;
+}
+
+void lcd_printf(uint8_t col, uint8_t row, uint8_t ww, const char *fmt, ...)
+{
+}
+
+void lcd_DrawRect(int x1, int y1, int x2, int y2, int col)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Interrupt delivery and time
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t irq_ready(int n, uint8_t pending)
+{
+    if (!pending)
+    {
+        irq_waiting[n] = 0;
+        return 0;
+    }
+    if (!irq_waiting[n])
+    {
+        irq_waiting[n] = 1;
+        irq_since[n] = now_us;
+    }
+    return now_us - irq_since[n] >= latency;
+}
+
+static uint8_t tim_pending(TIM_TypeDef *tim, int n)
+{
+    return ((tim->SR & tim->DIER & TIM_IT_Update) != 0) || nvic_pended[n];
+}
+
+static void deliver(int n, void (*handler)(void))
+{
+    nvic_pended[n] = 0;
+    irq_waiting[n] = 0;
+    handler();
+}
+
+// EXTI goes first as it has the higher priority, then the timers in
+// vector order
+static void run_interrupts(void)
+{
+    uint8_t hold = nest && irq_waiting[0];
+
+    if (exti_irq_enabled && exti_pending && !hold)
+        EXTI15_10_IRQHandler();
+
+    if (irq_ready(0, tim_pending(TIM3, 0)))
+    {
+        in_tim3 = hold;
+        deliver(0, TIM3_IRQHandler);
+        in_tim3 = 0;
+    }
+    if (irq_ready(1, tim_pending(TIM4, 1)))
+        deliver(1, TIM4_IRQHandler);
+}
+
+static uint8_t busy(void)
+{
+    return (sim_tim3.CR1 & TIM_CR1_CEN) || tim_pending(TIM3, 0) ||
+           tim_pending(TIM4, 1) || (exti_irq_enabled && exti_pending);
+}
+
+void crane_sim_init(int32_t at, int32_t upper)
+{
+    carriage = at;
+    upper_at = upper;
+    // switches start open
+    lower_closed = upper_closed = 1;
+    set_switch(CRANE_LOWER_LIMIT_PIN, CRANE_LOWER_LIMIT_LINE, &lower_closed, 0);
+    set_switch(CRANE_UPPER_LIMIT_PIN, CRANE_UPPER_LIMIT_LINE, &upper_closed, 0);
+    update_switches();
+    exti_pending = 0;
+    stats.pulses = stats.runts = 0;
+}
+
+uint32_t crane_sim_run(uint32_t us, uint8_t until_idle)
+{
+    while (us)
+    {
+        if (until_idle && !busy())
+            break;
+        now_us++;
+        us--;
+        if (now_us % 1000 == 0)
+            ulUptimeMs++;
+        tim3_tick();
+        oc3_eval();
+        run_interrupts();
+    }
+    return us;
+}
+
+int32_t crane_sim_carriage(void)
+{
+    return carriage;
+}
+
+void crane_sim_stats(struct crane_sim_stats *out)
+{
+    *out = stats;
+}
+
+void crane_sim_latency(uint32_t us)
+{
+    latency = us;
+}
+
+void crane_sim_nest(uint8_t on)
+{
+    nest = on;
+}
@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Host side stand in for the parts of the STM32 and FreeRTOS that crane.c
+// uses, so the real step and limit code runs on Linux when built with
+// -DCRANE_SIM. TIM3 is modelled a microsecond at a time: preloaded ARR,
+// the OC3 modes crane.c uses, one pulse mode and the update interrupt.
+// Its OC3REF drives TIM4's count, the step pin and a carriage that moves
+// a step on each rising edge and closes the limit switches, which raise
+// the EXTI interrupt. Interrupts run when they are pended, EXTI first.
+//
+// Queues, the LCD and the init-only peripheral calls are stubs.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CRANE_SIM_H
+#define CRANE_SIM_H
+
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////
+// Peripherals
+////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+    volatile uint16_t CR1, DIER, SR, CCMR2, CCER, CNT, ARR, CCR3;
+} TIM_TypeDef;
+
+typedef struct
+{
+    volatile uint16_t IDR, ODR;
+} GPIO_TypeDef;
+
+extern TIM_TypeDef sim_tim3, sim_tim4, sim_tim5;
+extern GPIO_TypeDef sim_gpioa, sim_gpioc;
+
+#define TIM3   (&sim_tim3)
+#define TIM4   (&sim_tim4)
+#define TIM5   (&sim_tim5)
+#define GPIOA  (&sim_gpioa)
+#define GPIOC  (&sim_gpioc)
+
+typedef enum { DISABLE = 0, ENABLE = 1 } FunctionalState;
+typedef enum { RESET = 0, SET = 1 } FlagStatus, ITStatus;
+typedef enum { Bit_RESET = 0, Bit_SET } BitAction;
+
+#define TIM_CR1_CEN                 0x0001
+#define TIM_CR1_URS                 0x0004
+#define TIM_CR1_OPM                 0x0008
+#define TIM_CR1_ARPE                0x0080
+#define TIM_CCMR2_OC3M              0x0070
+#define TIM_CCER_CC3E               0x0100
+#define TIM_OCMode_Inactive         0x0020
+#define TIM_OCMode_PWM1             0x0060
+#define TIM_ForcedAction_InActive   0x0040
+#define TIM_OPMode_Single           0x0008
+#define TIM_OPMode_Repetitive       0x0000
+#define TIM_IT_Update               0x0001
+#define TIM_FLAG_Update             0x0001
+#define TIM_EventSource_Update      0x0001
+#define TIM_Channel_3               0x0008
+#define TIM_CCx_Enable              0x0001
+#define TIM_CCx_Disable             0x0000
+#define TIM_OutputState_Enable      0x0001
+#define TIM_CounterMode_Up          0x0000
+#define TIM_CKD_DIV1                0x0000
+#define TIM_UpdateSource_Regular    0x0001
+#define TIM_TRGOSource_OC3Ref       0x0060
+#define TIM_TS_ITR2                 0x0020
+#define TIM_EncoderMode_TI12        0x0003
+#define TIM_ICPolarity_Rising       0x0000
+
+typedef struct
+{
+    uint16_t TIM_Prescaler, TIM_CounterMode, TIM_Period, TIM_ClockDivision;
+    uint8_t  TIM_RepetitionCounter;
+} TIM_TimeBaseInitTypeDef;
+
+typedef struct
+{
+    uint16_t TIM_OCMode, TIM_OutputState, TIM_OutputNState, TIM_Pulse;
+    uint16_t TIM_OCPolarity, TIM_OCNPolarity, TIM_OCIdleState, TIM_OCNIdleState;
+} TIM_OCInitTypeDef;
+
+void TIM_DeInit(TIM_TypeDef *tim);
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init);
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init);
+void TIM_OCStructInit(TIM_OCInitTypeDef *init);
+void TIM_OC3Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init);
+void TIM_ARRPreloadConfig(TIM_TypeDef *tim, FunctionalState state);
+void TIM_UpdateRequestConfig(TIM_TypeDef *tim, uint16_t source);
+void TIM_SelectOutputTrigger(TIM_TypeDef *tim, uint16_t source);
+void TIM_ITRxExternalClockConfig(TIM_TypeDef *tim, uint16_t source);
+void TIM_EncoderInterfaceConfig(TIM_TypeDef *tim, uint16_t mode, uint16_t pol1, uint16_t pol2);
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state);
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it);
+ITStatus TIM_GetITStatus(TIM_TypeDef *tim, uint16_t it);
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state);
+void TIM_SetAutoreload(TIM_TypeDef *tim, uint16_t arr);
+void TIM_SetCounter(TIM_TypeDef *tim, uint16_t cnt);
+void TIM_GenerateEvent(TIM_TypeDef *tim, uint16_t source);
+void TIM_SelectOCxM(TIM_TypeDef *tim, uint16_t channel, uint16_t mode);
+void TIM_CCxCmd(TIM_TypeDef *tim, uint16_t channel, uint16_t state);
+void TIM_ForcedOC3Config(TIM_TypeDef *tim, uint16_t action);
+void TIM_SelectOnePulseMode(TIM_TypeDef *tim, uint16_t mode);
+
+#define GPIO_Pin_0   0x0001
+#define GPIO_Pin_1   0x0002
+#define GPIO_Pin_7   0x0080
+#define GPIO_Pin_8   0x0100
+#define GPIO_Pin_9   0x0200
+#define GPIO_Pin_11  0x0800
+#define GPIO_Pin_12  0x1000
+
+enum { GPIO_Speed_50MHz = 3 };
+enum { GPIO_Mode_IN_FLOATING, GPIO_Mode_IPU, GPIO_Mode_Out_PP, GPIO_Mode_AF_PP };
+
+typedef struct
+{
+    uint16_t GPIO_Pin;
+    int      GPIO_Speed;
+    int      GPIO_Mode;
+} GPIO_InitTypeDef;
+
+#define GPIO_FullRemap_TIM3          0
+#define GPIO_PortSourceGPIOC         2
+#define GPIO_PinSource11             11
+#define GPIO_PinSource12             12
+
+void    GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void    GPIO_WriteBit(GPIO_TypeDef *port, uint16_t pin, BitAction val);
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *port, uint16_t pin);
+void    GPIO_PinRemapConfig(uint32_t remap, FunctionalState state);
+void    GPIO_EXTILineConfig(uint8_t port, uint8_t pin);
+
+#define EXTI_Line11  0x0800
+#define EXTI_Line12  0x1000
+
+enum { EXTI_Mode_Interrupt };
+enum { EXTI_Trigger_Rising, EXTI_Trigger_Falling };
+
+typedef struct
+{
+    uint32_t EXTI_Line;
+    int      EXTI_Mode;
+    int      EXTI_Trigger;
+    FunctionalState EXTI_LineCmd;
+} EXTI_InitTypeDef;
+
+void     EXTI_Init(EXTI_InitTypeDef *init);
+ITStatus EXTI_GetITStatus(uint32_t line);
+void     EXTI_ClearITPendingBit(uint32_t line);
+
+enum { TIM3_IRQn = 29, TIM4_IRQn = 30, EXTI15_10_IRQn = 40 };
+
+typedef struct
+{
+    uint8_t NVIC_IRQChannel;
+    uint8_t NVIC_IRQChannelPreemptionPriority;
+    uint8_t NVIC_IRQChannelSubPriority;
+    FunctionalState NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+void NVIC_Init(NVIC_InitTypeDef *init);
+void NVIC_SetPendingIRQ(int irq);
+
+#define RCC_APB1Periph_TIM3  0x0002
+#define RCC_APB1Periph_TIM4  0x0004
+#define RCC_APB1Periph_TIM5  0x0008
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+
+#define __disable_irq()
+#define __enable_irq()
+
+////////////////////////////////////////////////////////////////////////////
+// FreeRTOS
+////////////////////////////////////////////////////////////////////////////
+
+typedef long portBASE_TYPE;
+typedef void *xQueueHandle;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
+#define portMAX_DELAY 0xFFFFFFFF
+
+// interrupts only ever run between crane.c calls
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+xQueueHandle  xQueueCreate(unsigned len, unsigned size);
+portBASE_TYPE xQueueReceive(xQueueHandle queue, void *item, unsigned long wait);
+portBASE_TYPE xQueueSendToBack(xQueueHandle queue, const void *item, unsigned long wait);
+portBASE_TYPE xQueueSendToFront(xQueueHandle queue, const void *item, unsigned long wait);
+portBASE_TYPE xQueueSendToFrontFromISR(xQueueHandle queue, const void *item,
+                                       portBASE_TYPE *woken);
+
+////////////////////////////////////////////////////////////////////////////
+// LCD and uptime
+////////////////////////////////////////////////////////////////////////////
+
+#define Blue  0x001F
+#define Red   0xF800
+#define Green 0x07E0
+
+void lcd_printf(uint8_t col, uint8_t row, uint8_t ww, const char *fmt, ...);
+void lcd_DrawRect(int x1, int y1, int x2, int y2, int col);
+
+extern volatile unsigned long ulUptimeMs;
+
+////////////////////////////////////////////////////////////////////////////
+// The simulation
+////////////////////////////////////////////////////////////////////////////
+
+struct crane_sim_stats
+{
+    uint32_t pulses;        // rising edges at the step pin
+    uint32_t runts;         // pulses shorter than CRANE_PULSE_US
+};
+
+// Carriage at `carriage' steps, counted up from where the lower switch
+// closes; the upper switch closes at `upper'.
+void    crane_sim_init(int32_t carriage, int32_t upper);
+
+// us of time, interrupts included. Returns early, with the time left,
+// once the timer has stopped if `until_idle' is set.
+uint32_t crane_sim_run(uint32_t us, uint8_t until_idle);
+
+int32_t crane_sim_carriage(void);
+uint8_t crane_sim_enabled(void);      // driver enable at its active level
+void    crane_sim_stats(struct crane_sim_stats *stats);
+
+// Time an interrupt waits between being pended and running
+void    crane_sim_latency(uint32_t us);
+
+// With `nest' set a limit switch closing while the step interrupt is
+// waiting to run interrupts it instead, at its first peripheral call
+void    crane_sim_nest(uint8_t nest);
+
+#endif
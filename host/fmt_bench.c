@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// fmt.c against the C library. Formats random values through a spread of
+// conversions, flags, widths and precisions with both and counts where
+// they differ: integers and strings must match exactly; doubles may be
+// one out in the last place (see fmt.c), which is counted separately.
+// Then times the display and console lines the firmware prints. The
+// stack and cycles on the board come from the shell's "bench" command.
+//
+// Build on Linux from the top of the tree:
+//   gcc -O2 -DFMT_HOST -I. -o fmt_bench host/fmt_bench.c fmt.c -lm
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <ctype.h>
+#include "fmt.h"
+
+#define ROUNDS   200000
+#define TIMED    1000000
+
+static const char *int_formats[] =
+{
+    "%d", "%i", "%5d", "%-5d|", "%05d", "%+d", "% d", "%.3d", "%8.3d",
+    "%u", "%x", "%X", "%#x", "%08x", "%#010x", "%o", "%#o", "%.0d",
+    "%ld", "%lu", "%lx", "%hd", "%hu", "%hhx", "%c", "%3c|", "%-3c|",
+};
+
+static const char *ll_formats[] = { "%lld", "%llu", "%llx", "%20lld|", "%-20llu|" };
+
+static const char *str_formats[] = { "%s", "%10s|", "%-10s|", "%.3s", "%8.2s|" };
+
+static const char *double_formats[] =
+{
+    "%f", "%.0f", "%.1f", "%.2f", "%.9f", "%10.3f|", "%-10.2f|", "%010.2f",
+    "%+.2f", "% .1f", "%#.0f", "%e", "%.2e", "%E", "%12.4e|", "%g", "%.3g",
+    "%G", "%#g", "%.9g", "%F",
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int64_t random64(void)
+{
+    int64_t val = (int64_t)rand() << 33 ^ (int64_t)rand() << 11 ^ rand();
+
+    // mostly small ones, as in the firmware
+    switch (rand() % 4)
+    {
+    case 0:  return val % 100;
+    case 1:  return val % 100000;
+    case 2:  return (int32_t)val;
+    default: return val;
+    }
+}
+
+static double random_double(void)
+{
+    double val = (double)rand() / RAND_MAX;
+
+    switch (rand() % 5)
+    {
+    case 0:  return 0;
+    case 1:  return (rand() % 20000 - 10000) / 100.0;   // temperatures
+    case 2:  return val * pow(10, rand() % 40 - 20);
+    case 3:  return -val * pow(10, rand() % 600 - 300);
+    default: return val * 1000;
+    }
+}
+
+// no more than one apart in the last place printed
+static int last_place(const char *aa, const char *bb)
+{
+    const char *point = strchr(aa, '.');
+    const char *exp = strpbrk(aa, "eE");
+    double unit = 1;
+
+    if (point)
+        unit = pow(10, -((exp ? exp : aa + strlen(aa)) - point - 1));
+    if (exp)
+        unit *= pow(10, atoi(exp + 1));
+    return fabs(strtod(aa, NULL) - strtod(bb, NULL)) <= unit * 1.01;
+}
+
+int main(void)
+{
+    char ours[128], theirs[128];
+    unsigned long tried = 0, wrong = 0, rounded = 0, too_big = 0;
+    double t0, t_ours, t_theirs;
+    unsigned ii, ff;
+
+    srand(1);
+    for (ii = 0; ii < ROUNDS; ii++)
+    {
+        int64_t val = random64();
+        double dd = random_double();
+        const char *fmt;
+
+        for (ff = 0; ff < sizeof(int_formats) / sizeof(int_formats[0]); ff++)
+        {
+            fmt = int_formats[ff];
+            if (strchr(fmt, 'l'))
+            {
+                fmt_snprintf(ours, sizeof(ours), fmt, (long)val);
+                snprintf(theirs, sizeof(theirs), fmt, (long)val);
+            }
+            else
+            {
+                fmt_snprintf(ours, sizeof(ours), fmt, (int)val);
+                snprintf(theirs, sizeof(theirs), fmt, (int)val);
+            }
+            tried++;
+            if (strcmp(ours, theirs))
+            {
+                if (wrong++ < 10)
+                    printf("%-10s %s, %s\n", fmt, ours, theirs);
+            }
+        }
+
+        for (ff = 0; ff < sizeof(ll_formats) / sizeof(ll_formats[0]); ff++)
+        {
+            fmt_snprintf(ours, sizeof(ours), ll_formats[ff], (long long)val);
+            snprintf(theirs, sizeof(theirs), ll_formats[ff], (long long)val);
+            tried++;
+            if (strcmp(ours, theirs) && wrong++ < 10)
+                printf("%-10s %s, %s\n", ll_formats[ff], ours, theirs);
+        }
+
+        for (ff = 0; ff < sizeof(str_formats) / sizeof(str_formats[0]); ff++)
+        {
+            static const char *words[] = { "", "HLT", "Cabinet", "Heating the mash" };
+            const char *ww = words[ii % 4];
+
+            fmt_snprintf(ours, sizeof(ours), str_formats[ff], ww);
+            snprintf(theirs, sizeof(theirs), str_formats[ff], ww);
+            tried++;
+            if (strcmp(ours, theirs) && wrong++ < 10)
+                printf("%-10s %s, %s\n", str_formats[ff], ours, theirs);
+        }
+
+        for (ff = 0; ff < sizeof(double_formats) / sizeof(double_formats[0]); ff++)
+        {
+            fmt = double_formats[ff];
+            // past 64 bits of whole part %f is done as %e, see fmt.h
+            if (fabs(dd) >= 1.8e19 && tolower(fmt[strlen(fmt) - 1 - (fmt[strlen(fmt) - 1] == '|')]) == 'f')
+            {
+                too_big++;
+                continue;
+            }
+            fmt_snprintf(ours, sizeof(ours), fmt, dd);
+            snprintf(theirs, sizeof(theirs), fmt, dd);
+            tried++;
+            if (strcmp(ours, theirs) == 0)
+                continue;
+            if (last_place(ours, theirs))
+                rounded++;
+            else if (wrong++ < 10)
+                printf("%-10s %s, %s\n", fmt, ours, theirs);
+        }
+    }
+
+    // %q against the same thing done by hand
+    for (ii = 0; ii < ROUNDS; ii++)
+    {
+        int32_t val = (int32_t)random64();
+        char hundredths[16];
+
+        fmt_snprintf(ours, sizeof(ours), "%8.2q|%.1q|%q", val, val, val);
+        snprintf(hundredths, sizeof(hundredths), "%s%lld.%02lld", val < 0 ? "-" : "",
+                 llabs(val) / 100, llabs(val) % 100);
+        snprintf(theirs, sizeof(theirs), "%8s|%s%lld.%lld|%s", hundredths,
+                 val < 0 ? "-" : "", llabs(val) / 10, llabs(val) % 10, hundredths);
+        tried++;
+        if (strcmp(ours, theirs) && wrong++ < 10)
+            printf("%%q         %s, %s\n", ours, theirs);
+    }
+
+    // cut short
+    fmt_snprintf(ours, 6, "%s %d", "Mash", 12345);
+    tried++;
+    if (strcmp(ours, "Mash "))
+        wrong++;
+    if (fmt_snprintf(NULL, 0, "%d", 12345) != 5)
+        wrong++;
+
+    printf("%lu conversions, %lu wrong, %lu doubles out in the last place\n",
+           tried, wrong, rounded);
+    printf("%lu %%f past 1.8e19 not compared\n", too_big);
+
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+        fmt_snprintf(ours, sizeof(ours), "HLT %.2q Mash %.2q out %d%%",
+                     6525 + (ii & 7), 6650, 503);
+    t_ours = now() - t0;
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+        snprintf(theirs, sizeof(theirs), "HLT %.2f Mash %.2f out %d%%",
+                 65.25 + (ii & 7) / 100.0, 66.5, 503);
+    t_theirs = now() - t0;
+    printf("display line   %6.1f ns fmt %%q, %6.1f ns libc %%f\n",
+           t_ours * 1e9 / TIMED, t_theirs * 1e9 / TIMED);
+
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+        fmt_snprintf(ours, sizeof(ours), "HLT %.2f Mash %.2f out %d%%",
+                     65.25 + (ii & 7) / 100.0, 66.5, 503);
+    t_ours = now() - t0;
+    printf("               %6.1f ns fmt %%f\n", t_ours * 1e9 / TIMED);
+
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+        fmt_snprintf(ours, sizeof(ours), "%-8s %-8s %s\r\n", "Mash", "FAILED", "open");
+    t_ours = now() - t0;
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+        snprintf(theirs, sizeof(theirs), "%-8s %-8s %s\r\n", "Mash", "FAILED", "open");
+    t_theirs = now() - t0;
+    printf("console line   %6.1f ns fmt,     %6.1f ns libc\n",
+           t_ours * 1e9 / TIMED, t_theirs * 1e9 / TIMED);
+
+    return wrong != 0;
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "iflash.h"
+#include "iflash_sim.h"
+
+static uint8_t *region;
+static uint32_t region_size;
+static uint32_t budget;
+static jmp_buf *reset_to;
+static uint32_t erases;
+static uint32_t halfwords;
+
+uint8_t *iflash_sim_init(uint32_t pages)
+{
+    free(region);
+    region_size = pages * IFLASH_PAGE_SIZE;
+    region = malloc(region_size);
+    memset(region, 0xFF, region_size);
+    budget = 0;
+    return region;
+}
+
+void iflash_sim_cut_after(uint32_t count, jmp_buf *reset)
+{
+    budget = count;
+    reset_to = reset;
+}
+
+uint32_t iflash_sim_erases(void)
+{
+    return erases;
+}
+
+uint32_t iflash_sim_halfwords(void)
+{
+    return halfwords;
+}
+
+static void power_check(uint32_t cost)
+{
+    if (!budget)
+        return;
+    if (budget <= cost)
+    {
+        budget = 0;
+        longjmp(*reset_to, 1);
+    }
+    budget -= cost;
+}
+
+static uint8_t in_region(const void *pp, uint32_t len)
+{
+    const uint8_t *bp = pp;
+
+    return bp >= region && bp + len <= region + region_size;
+}
+
+uint8_t iflash_erase_page(const void *page)
+{
+    uint8_t *pp = (uint8_t *)page;
+    uint32_t cut = budget;
+
+    if (!in_region(pp, IFLASH_PAGE_SIZE) || (pp - region) % IFLASH_PAGE_SIZE)
+        return IFLASH_ERROR;
+
+    // a cut part way through leaves the page partly erased
+    if (cut && cut <= 16)
+        memset(pp, 0xFF, IFLASH_PAGE_SIZE * (cut - 1) / 16);
+    power_check(16);
+
+    memset(pp, 0xFF, IFLASH_PAGE_SIZE);
+    erases++;
+    return IFLASH_OK;
+}
+
+uint8_t iflash_program(const void *dst, const void *src, uint32_t len)
+{
+    uint8_t *dp = (uint8_t *)dst;
+    const uint8_t *sp = src;
+
+    if (!in_region(dp, (len + 1) & ~1) || ((dp - region) & 1))
+        return IFLASH_ERROR;
+
+    for (; len > 0; dp += 2, sp += 2)
+    {
+        uint8_t hi = len > 1 ? sp[1] : 0xFF;
+
+        if ((dp[0] != 0xFF || dp[1] != 0xFF) && (sp[0] != 0 || hi != 0))
+            return IFLASH_ERROR;
+        power_check(1);
+        dp[0] = sp[0];
+        dp[1] = hi;
+        halfwords++;
+        len = len > 1 ? len - 2 : 0;
+    }
+    return IFLASH_OK;
+}
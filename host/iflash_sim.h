@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// RAM backed stand in for iflash.c. Programming follows the real part:
+// only erased half words can be written, anything else is a PGERR, bar
+// 0x0000 which can go over anything. A
+// power cut can be armed to hit after a number of half word writes; the
+// write in progress is left torn and control returns to the setjmp given.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IFLASH_SIM_H
+#define IFLASH_SIM_H
+
+#include <stdint.h>
+#include <setjmp.h>
+
+// allocate an erased region of `pages' pages
+uint8_t *iflash_sim_init(uint32_t pages);
+
+// after `halfwords' more half word writes (an erase counts as 16) the
+// power goes; 0 disarms
+void     iflash_sim_cut_after(uint32_t halfwords, jmp_buf *reset);
+
+uint32_t iflash_sim_erases(void);
+uint32_t iflash_sim_halfwords(void);
+
+#endif
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Sets and deletes random keys in the settings store on a simulated SPI
+// flash and cuts the power at random points, including part way through
+// erases and clear outs. After every cut the store is reopened and each
+// key must hold its last written value, bar the one being written at the
+// time, which may hold either. An open that a failed read cuts short must
+// not leave a table that later sets trust, and a read failing in a clear
+// out must not lose the values being moved. Also reports what opening
+// costs as the log fills and how evenly the sectors wear.
+//
+// Build on Linux from the top of the tree:
+//   gcc -DSFLASH_SIM -I. -Ihost -o kv_bench host/kv_bench.c host/sflash_sim.c
+//       kv.c cobs.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kv.h"
+#include "sflash.h"
+#include "sflash_sim.h"
+
+#define TRIALS  20000
+#define KEYS    24
+
+struct value
+{
+    uint8_t len;
+    uint8_t data[KV_MAX_VALUE];
+};
+
+static struct value model[KEYS];
+
+static void random_value(struct value *val)
+{
+    uint8_t ii;
+
+    // one in eight a delete
+    val->len = rand() % 8 ? 1 + rand() % KV_MAX_VALUE : 0;
+    for (ii = 0; ii < val->len; ii++)
+        val->data[ii] = rand();
+}
+
+static uint8_t matches(uint8_t key, const struct value *val)
+{
+    uint8_t got[KV_MAX_VALUE];
+
+    return kv_get(key, got, sizeof(got)) == val->len &&
+           memcmp(got, val->data, val->len) == 0;
+}
+
+int main(void)
+{
+    static jmp_buf reset;
+    static struct value pending;
+    static volatile uint8_t pending_key;
+    static volatile uint32_t sets;
+    struct kv_stats stats;
+    uint32_t trial, failures = 0, sector, fill, collections;
+    uint32_t max_reads = 0, max_bytes = 0, wear_min = ~0u, wear_max = 0;
+    uint8_t key;
+
+    srand(1);
+    sflash_sim_init();
+    kv_init();
+    kv_open();
+
+    for (trial = 0; trial < TRIALS; trial++)
+    {
+        if (setjmp(reset) == 0)
+        {
+            // somewhere in the next few hundred sets
+            sflash_sim_cut_after(1 + rand() % 8000, &reset);
+            for (;;)
+            {
+                pending_key = rand() % KEYS;
+                random_value(&pending);
+                if (!kv_set(pending_key, pending.data, pending.len))
+                {
+                    printf("set failed after %lu\n", (unsigned long)sets);
+                    return 1;
+                }
+                model[pending_key] = pending;
+                sets++;
+            }
+        }
+
+        // power is back
+        sflash_sim_clear_reads();
+        kv_open();
+        if (sflash_sim_reads() > max_reads)
+            max_reads = sflash_sim_reads();
+        if (sflash_sim_read_bytes() > max_bytes)
+            max_bytes = sflash_sim_read_bytes();
+
+        if (matches(pending_key, &pending))
+            model[pending_key] = pending;
+        for (key = 0; key < KEYS; key++)
+        {
+            if (!matches(key, &model[key]))
+            {
+                printf("trial %lu: key %u wrong\n", (unsigned long)trial, key);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    printf("%u power cuts, %lu sets, %u bad recoveries\n",
+           TRIALS, (unsigned long)sets, failures);
+    printf("reopen: at most %lu reads, %lu bytes\n",
+           (unsigned long)max_reads, (unsigned long)max_bytes);
+
+    // each read of an open failing in turn, then a set, which must open
+    // the store again before it appends
+    for (fill = 1; fill <= max_reads; fill++)
+    {
+        sflash_sim_fail_read(fill);
+        kv_open();
+        sflash_sim_fail_read(0);
+        pending_key = rand() % KEYS;
+        random_value(&pending);
+        if (!kv_set(pending_key, pending.data, pending.len))
+        {
+            printf("set after failed read %lu failed\n", (unsigned long)fill);
+            failures++;
+        }
+        model[pending_key] = pending;
+        kv_open();
+        for (key = 0; key < KEYS; key++)
+        {
+            if (!matches(key, &model[key]))
+            {
+                printf("failed read %lu: key %u wrong\n", (unsigned long)fill, key);
+                failures++;
+                break;
+            }
+        }
+    }
+    printf("failed reads: %lu opens cut short, %u failures\n",
+           (unsigned long)max_reads, failures);
+
+    // Key 0 churns through the log with its length changing each time,
+    // so the only reads are the clear outs copying the other keys on;
+    // one of those reads fails in every trial
+    kv_get_stats(&stats);
+    collections = stats.collections;
+    for (trial = 0; trial < 300; trial++)
+    {
+        sflash_sim_fail_read(1 + rand() % (KEYS - 1));
+        for (fill = 0; fill < 2000; fill++)
+        {
+            random_value(&pending);
+            pending.len = model[0].len % KV_MAX_VALUE + 1;
+            if (kv_set(0, pending.data, pending.len))
+                model[0] = pending;
+        }
+        sflash_sim_fail_read(0);
+        kv_open();
+        for (key = 0; key < KEYS; key++)
+        {
+            if (!matches(key, &model[key]))
+            {
+                printf("clear out trial %lu: key %u wrong\n", (unsigned long)trial, key);
+                failures++;
+                break;
+            }
+        }
+    }
+    kv_get_stats(&stats);
+    printf("failed reads in clear outs: 300 trials, %lu collections, %u failures\n",
+           (unsigned long)(stats.collections - collections), failures);
+
+    // what opening costs as the log grows, from empty
+    sflash_sim_init();
+    kv_open();
+    printf("\n sets  log bytes  reads  read bytes  records\n");
+    for (fill = 0; fill <= 20; fill++)
+    {
+        sflash_sim_clear_reads();
+        kv_open();
+        kv_get_stats(&stats);
+        printf("%5lu %10lu %6lu %11lu %8lu\n", (unsigned long)fill * 1000,
+               (unsigned long)stats.used, (unsigned long)sflash_sim_reads(),
+               (unsigned long)sflash_sim_read_bytes(), (unsigned long)stats.open_records);
+
+        for (sets = 0; sets < 1000; sets++)
+        {
+            key = rand() % KEYS;
+            random_value(&pending);
+            kv_set(key, pending.data, pending.len);
+        }
+    }
+
+    for (sector = 0; sector < KV_SECTORS; sector++)
+    {
+        uint32_t erases = sflash_sim_erases(KV_BASE + sector * SFLASH_SECTOR_SIZE);
+        if (erases < wear_min)
+            wear_min = erases;
+        if (erases > wear_max)
+            wear_max = erases;
+    }
+    printf("\nwear: %lu to %lu erases per sector\n",
+           (unsigned long)wear_min, (unsigned long)wear_max);
+    return failures != 0;
+}
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Log ring bench. Times LOG() against what the console queue did, a
+// sprintf into a stack buffer and a copy of all 255 bytes of it, and
+// compares the RAM each takes. Then writes random entries with the reader
+// falling behind and catching up, so the ring wraps and fills, and checks
+// every entry read back is whole and comes after the one before it.
+//
+// Build on Linux from the top of the tree:
+//   gcc -O2 -DLOG_HOST -I. -o log_bench host/log_bench.c log.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log.h"
+
+#define QUEUE_LEN      30      // what console.h had
+#define MESSAGE_LEN    0xFF
+#define TIMED          1000000
+#define ENTRIES        1000000
+
+volatile unsigned long ulUptimeMs;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// format pointers the reader can check without them pointing anywhere
+static const char *fake_fmt(uint32_t nn)
+{
+    return (const char *)(uintptr_t)(0x08001000 + (nn & 0xFFF) * 4);
+}
+
+// an entry's number is its time, and everything else follows from that
+static int check(const struct log_entry *entry, long *last)
+{
+    uint32_t nn = entry->time_ms;
+    int ii, ok;
+
+    ok = (long)nn > *last && entry->fmt == fake_fmt(nn) &&
+         entry->nargs == nn % (LOG_MAX_ARGS + 1);
+    for (ii = 0; ii < entry->nargs; ii++)
+        ok &= entry->args[ii] == nn + ii;
+    *last = nn;
+    return ok;
+}
+
+int main(void)
+{
+    static char queue[MESSAGE_LEN], message[MESSAGE_LEN];
+    struct log_entry entry;
+    unsigned long written = 0, read = 0, bad = 0, full = 0;
+    long last = -1;
+    double t0, t_queue, t_log;
+    int ii;
+
+    // the old way, one entry's worth
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+    {
+        char buf[MESSAGE_LEN];
+
+        sprintf(buf, "Sensor %d %s %s\r\n", ii & 3, "FAILED", "open");
+        memcpy(queue, buf, MESSAGE_LEN);       // into the queue
+        __asm__ volatile("" ::: "memory");
+        memcpy(message, queue, MESSAGE_LEN);   // and out
+        __asm__ volatile("" ::: "memory");
+    }
+    t_queue = (now() - t0) * 1e9 / TIMED;
+
+    t0 = now();
+    for (ii = 0; ii < TIMED; ii++)
+    {
+        LOG("Sensor %d %s %s\r\n", ii & 3, 0x08002000, 0x08002010);
+        if ((ii & 15) == 15)
+            while (log_take(&entry))
+                ;
+    }
+    t_log = (now() - t0) * 1e9 / TIMED;
+    while (log_take(&entry))
+        ;
+    log_clear_stats();
+
+    printf("per message    %6.1f ns sprintf + queue, %6.1f ns LOG() and take\n",
+           t_queue, t_log);
+    printf("RAM            %6d bytes queue,         %6d bytes ring\n\n",
+           QUEUE_LEN * MESSAGE_LEN, LOG_RING_WORDS * 4);
+
+    // random entries, the reader sometimes well behind
+    srand(1);
+    while (written < ENTRIES)
+    {
+        int burst = rand() % 80;
+
+        for (ii = 0; ii < burst; ii++)
+        {
+            uint32_t nn = written + full;
+            int nargs = nn % (LOG_MAX_ARGS + 1);
+
+            ulUptimeMs = nn;
+            if (log_write(fake_fmt(nn), nargs, nn, nn + 1, nn + 2, nn + 3, nn + 4, nn + 5))
+                written++;
+            else
+                full++;
+        }
+
+        burst = rand() % 80;
+        for (ii = 0; ii < burst && log_take(&entry); ii++, read++)
+            bad += !check(&entry, &last);
+    }
+    for (; log_take(&entry); read++)
+        bad += !check(&entry, &last);
+
+    printf("%lu written, %lu dropped with the ring full (count %lu)\n",
+           written, full, (unsigned long)log_dropped());
+    printf("%lu read back, %lu wrong\n", read, bad);
+    return bad || read != written || full != log_dropped();
+}
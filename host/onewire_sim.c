@@ -0,0 +1,511 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// 1-Wire bus simulator. The line is modelled as a wired-AND of the master
+// and every device: the master's low time decides what kind of slot it was
+// (reset, write 1, write 0 or read) when it lets go, and devices that are
+// transmitting hold the line low for 30us after the falling edge of a read
+// slot when sending a 0.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "onewire.h"
+#include "onewire_sim.h"
+
+// FUNCTION COMMANDS
+#define CONVERT_TEMP     0x44
+#define COPY_SCRATCHPAD  0x48
+#define WRITE_SCRATCHPAD 0x4E
+#define READ_SCRATCHPAD  0xBE
+#define RECALL_EEPROM    0xB8
+#define READ_PS          0xB4
+
+// bus timings in us
+#define RESET_MIN_LOW     480
+#define WRITE1_MAX_LOW    15
+#define WRITE0_MIN_LOW    60
+#define PRESENCE_DELAY    30
+#define PRESENCE_LEN      120
+#define READ0_HOLD        30
+
+#define DEFAULT_CONV_US   750000
+#define POWER_ON_TEMP     (85 * 16)
+
+enum dev_state
+{
+    DEV_IDLE,      // waiting for a reset
+    DEV_ROM_CMD,   // receiving the ROM command
+    DEV_MATCH,     // comparing MATCH_ROM bits against our ROM
+    DEV_SEARCH,    // taking part in a search triplet sequence
+    DEV_FUNC_CMD,  // receiving the function command
+    DEV_TX,        // sending buf[]
+    DEV_RX,        // receiving scratchpad writes into buf[]
+    DEV_BUSY       // converting, read slots return 0 until done
+};
+
+struct ow_sim_device
+{
+    uint8_t  rom[8];
+    uint8_t  used;
+    uint8_t  present;
+
+    int16_t  temp_c16;     // what the probe is immersed in
+    int16_t  latched_c16;  // result of the last completed conversion
+    uint8_t  th, tl, config;
+
+    uint32_t conv_time_us;
+    uint64_t conv_done_at;
+    uint8_t  converting;
+
+    uint32_t flip_every;
+    uint32_t tx_count;
+
+    enum dev_state state;
+    uint8_t  buf[9];
+    uint8_t  nbits;        // bits to send/receive in buf[]
+    uint8_t  pos;          // current bit in buf[] or ROM
+    uint8_t  phase;        // search triplet phase
+};
+
+static struct ow_sim_device devices[OW_SIM_MAX_DEVICES];
+static struct ow_sim_stats  stats;
+
+static uint64_t now;
+static uint8_t  master_low;
+static uint64_t low_start;
+static uint64_t presence_from, presence_to;
+static uint64_t hold_until;
+static uint8_t  bus_short;
+
+////////////////////////////////////////////////////////////////////////////
+// Device model
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t get_bit(const uint8_t *buf, uint8_t bit)
+{
+    return (buf[bit >> 3] >> (bit & 7)) & 1;
+}
+
+static void put_bit(uint8_t *buf, uint8_t bit, uint8_t val)
+{
+    if (val)
+        buf[bit >> 3] |= 1 << (bit & 7);
+    else
+        buf[bit >> 3] &= ~(1 << (bit & 7));
+}
+
+static void dev_update(struct ow_sim_device *dev)
+{
+    if (dev->converting && now >= dev->conv_done_at)
+    {
+        dev->latched_c16 = dev->temp_c16;
+        dev->converting = 0;
+    }
+}
+
+static uint8_t dev_alarm(struct ow_sim_device *dev)
+{
+    int16_t whole = dev->latched_c16 >> 4;
+    return whole > (int8_t)dev->th || whole < (int8_t)dev->tl;
+}
+
+static void dev_scratchpad(struct ow_sim_device *dev)
+{
+    uint8_t *sp = dev->buf;
+    int16_t t16 = dev->latched_c16;
+
+    if (dev->rom[0] == OW_FAMILY_DS18S20)
+    {
+        // 0.5 degC register with COUNT_REMAIN giving the extended
+        // resolution: T = TEMP_READ - 0.25 + (16 - COUNT_REMAIN) / 16
+        int16_t whole = t16 >> 4;
+        int16_t frac  = t16 & 15;
+        int16_t remain;
+        int16_t raw;
+
+        if (frac > 12)
+        {
+            whole++;
+            remain = 28 - frac;
+        }
+        else
+            remain = 12 - frac;
+
+        raw = whole * 2;
+        sp[0] = raw & 0xFF;
+        sp[1] = (raw >> 8) & 0xFF;
+        sp[2] = dev->th;
+        sp[3] = dev->tl;
+        sp[4] = 0xFF;
+        sp[5] = 0xFF;
+        sp[6] = remain;
+        sp[7] = 0x10;
+    }
+    else
+    {
+        sp[0] = t16 & 0xFF;
+        sp[1] = (t16 >> 8) & 0xFF;
+        sp[2] = dev->th;
+        sp[3] = dev->tl;
+        sp[4] = dev->config;
+        sp[5] = 0xFF;
+        sp[6] = 0x0C;
+        sp[7] = 0x10;
+    }
+    sp[8] = ow_crc8(sp, 8);
+}
+
+// a bit driven onto the bus by the device, subject to injected flips
+static uint8_t dev_tx_bit(struct ow_sim_device *dev, uint8_t bit)
+{
+    dev->tx_count++;
+    if (dev->flip_every && (dev->tx_count % dev->flip_every) == 0)
+    {
+        stats.bits_flipped++;
+        bit ^= 1;
+    }
+    return bit;
+}
+
+static void dev_start_tx(struct ow_sim_device *dev, const uint8_t *data, uint8_t nbytes)
+{
+    memcpy(dev->buf, data, nbytes);
+    dev->nbits = nbytes * 8;
+    dev->pos = 0;
+    dev->state = DEV_TX;
+}
+
+static void dev_rom_command(struct ow_sim_device *dev, uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case READ_ROM:
+        dev_start_tx(dev, dev->rom, 8);
+        break;
+    case MATCH_ROM:
+        dev->pos = 0;
+        dev->state = DEV_MATCH;
+        break;
+    case SKIP_ROM:
+        dev->pos = 0;
+        dev->state = DEV_FUNC_CMD;
+        break;
+    case ALARM_SEARCH:
+        if (!dev_alarm(dev))
+        {
+            dev->state = DEV_IDLE;
+            break;
+        }
+        // fall through
+    case SEARCH_ROM:
+        dev->pos = 0;
+        dev->phase = 0;
+        dev->state = DEV_SEARCH;
+        break;
+    default:
+        dev->state = DEV_IDLE;
+        break;
+    }
+}
+
+static void dev_function_command(struct ow_sim_device *dev, uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case CONVERT_TEMP:
+        dev->converting = 1;
+        dev->conv_done_at = now + dev->conv_time_us;
+        dev->state = DEV_BUSY;
+        break;
+    case READ_SCRATCHPAD:
+        dev_update(dev);
+        dev_scratchpad(dev);
+        dev_start_tx(dev, dev->buf, 9);
+        break;
+    case WRITE_SCRATCHPAD:
+        dev->nbits = dev->rom[0] == OW_FAMILY_DS18S20 ? 16 : 24;
+        dev->pos = 0;
+        dev->state = DEV_RX;
+        break;
+    default:
+        // COPY_SCRATCHPAD, RECALL_EEPROM and READ_PS complete instantly
+        // on an externally powered device, so every read slot returns 1
+        dev->state = DEV_IDLE;
+        break;
+    }
+}
+
+//
+// One time slot as seen by a device. `written' is the bit the master wrote
+// if this was a write slot. Returns 0 if the device pulls the line low.
+//
+static uint8_t dev_slot(struct ow_sim_device *dev, uint8_t written)
+{
+    uint8_t bit;
+
+    dev_update(dev);
+
+    switch (dev->state)
+    {
+    case DEV_ROM_CMD:
+    case DEV_FUNC_CMD:
+        put_bit(dev->buf, dev->pos, written);
+        if (++dev->pos == 8)
+        {
+            dev->pos = 0;
+            if (dev->state == DEV_ROM_CMD)
+                dev_rom_command(dev, dev->buf[0]);
+            else
+                dev_function_command(dev, dev->buf[0]);
+        }
+        return 1;
+
+    case DEV_MATCH:
+        if (written != get_bit(dev->rom, dev->pos))
+            dev->state = DEV_IDLE;
+        else if (++dev->pos == 64)
+        {
+            dev->pos = 0;
+            dev->state = DEV_FUNC_CMD;
+        }
+        return 1;
+
+    case DEV_SEARCH:
+        bit = get_bit(dev->rom, dev->pos);
+        if (dev->phase == 0)
+        {
+            dev->phase = 1;
+            return dev_tx_bit(dev, bit);
+        }
+        if (dev->phase == 1)
+        {
+            dev->phase = 2;
+            return dev_tx_bit(dev, !bit);
+        }
+        dev->phase = 0;
+        if (written != bit)
+            dev->state = DEV_IDLE;
+        else if (++dev->pos == 64)
+        {
+            dev->pos = 0;
+            dev->state = DEV_FUNC_CMD;
+        }
+        return 1;
+
+    case DEV_TX:
+        bit = dev_tx_bit(dev, get_bit(dev->buf, dev->pos));
+        if (++dev->pos == dev->nbits)
+            dev->state = DEV_IDLE;
+        return bit;
+
+    case DEV_RX:
+        put_bit(dev->buf, dev->pos, written);
+        if (++dev->pos == dev->nbits)
+        {
+            dev->th = dev->buf[0];
+            dev->tl = dev->buf[1];
+            if (dev->nbits == 24)
+                dev->config = dev->buf[2] | 0x1F;
+            dev->state = DEV_IDLE;
+        }
+        return 1;
+
+    case DEV_BUSY:
+        return dev->converting ? 0 : 1;
+
+    case DEV_IDLE:
+    default:
+        return 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Bus
+////////////////////////////////////////////////////////////////////////////
+
+static void bus_reset(void)
+{
+    int ii;
+    uint8_t any = 0;
+
+    stats.resets++;
+    hold_until = 0;
+
+    for (ii = 0; ii < OW_SIM_MAX_DEVICES; ii++)
+    {
+        struct ow_sim_device *dev = &devices[ii];
+        if (!dev->used || !dev->present)
+            continue;
+        dev_update(dev);
+        dev->state = DEV_ROM_CMD;
+        dev->pos = 0;
+        any = 1;
+    }
+
+    if (any)
+    {
+        presence_from = now + PRESENCE_DELAY;
+        presence_to = presence_from + PRESENCE_LEN;
+    }
+}
+
+static void bus_slot(uint64_t low_time)
+{
+    int ii;
+    uint8_t written;
+
+    if (bus_short)
+        return;
+
+    if (low_time >= RESET_MIN_LOW)
+    {
+        bus_reset();
+        return;
+    }
+
+    stats.slots++;
+    if (low_time >= WRITE1_MAX_LOW && low_time < WRITE0_MIN_LOW)
+        stats.timing_errors++;
+    written = low_time < WRITE1_MAX_LOW;
+
+    for (ii = 0; ii < OW_SIM_MAX_DEVICES; ii++)
+    {
+        struct ow_sim_device *dev = &devices[ii];
+        if (!dev->used || !dev->present)
+            continue;
+        if (dev_slot(dev, written) == 0 && hold_until < low_start + READ0_HOLD)
+            hold_until = low_start + READ0_HOLD;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// onewire.h bus binding
+////////////////////////////////////////////////////////////////////////////
+
+void ow_hw_init(void)
+{
+    master_low = 0;
+}
+
+void ow_hw_drive_low(void)
+{
+    if (!master_low)
+    {
+        master_low = 1;
+        low_start = now;
+    }
+}
+
+void ow_hw_release(void)
+{
+    if (master_low)
+    {
+        master_low = 0;
+        bus_slot(now - low_start);
+    }
+}
+
+uint8_t ow_hw_read(void)
+{
+    if (bus_short || master_low)
+        return 0;
+    if (now >= presence_from && now < presence_to)
+        return 0;
+    if (now < hold_until)
+        return 0;
+    return 1;
+}
+
+void ow_hw_delay_us(uint16_t count)
+{
+    now += count;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Simulator control
+////////////////////////////////////////////////////////////////////////////
+
+void ow_sim_init(void)
+{
+    memset(devices, 0, sizeof(devices));
+    memset(&stats, 0, sizeof(stats));
+    now = 0;
+    master_low = 0;
+    presence_from = presence_to = 0;
+    hold_until = 0;
+    bus_short = 0;
+}
+
+struct ow_sim_device *ow_sim_add(const uint8_t *rom)
+{
+    int ii;
+
+    for (ii = 0; ii < OW_SIM_MAX_DEVICES; ii++)
+    {
+        struct ow_sim_device *dev = &devices[ii];
+        if (dev->used)
+            continue;
+
+        memset(dev, 0, sizeof(*dev));
+        memcpy(dev->rom, rom, 7);
+        dev->rom[7] = ow_crc8(dev->rom, 7);
+        dev->used = 1;
+        dev->present = 1;
+        dev->temp_c16 = 20 * 16;
+        dev->latched_c16 = POWER_ON_TEMP;
+        dev->th = 0x4B;
+        dev->tl = 0x46;
+        dev->config = 0x7F;
+        dev->conv_time_us = DEFAULT_CONV_US;
+        dev->state = DEV_IDLE;
+        return dev;
+    }
+    return NULL;
+}
+
+void ow_sim_set_temp(struct ow_sim_device *dev, int16_t temp_c16)
+{
+    dev->temp_c16 = temp_c16;
+}
+
+const uint8_t *ow_sim_rom(struct ow_sim_device *dev)
+{
+    return dev->rom;
+}
+
+void ow_sim_set_present(struct ow_sim_device *dev, uint8_t present)
+{
+    dev->present = present;
+    if (!present)
+        dev->state = DEV_IDLE;
+}
+
+void ow_sim_set_bit_flip(struct ow_sim_device *dev, uint32_t every_n_bits)
+{
+    dev->flip_every = every_n_bits;
+    dev->tx_count = 0;
+}
+
+void ow_sim_set_conversion_time(struct ow_sim_device *dev, uint32_t us)
+{
+    dev->conv_time_us = us;
+}
+
+void ow_sim_set_bus_short(uint8_t shorted)
+{
+    bus_short = shorted;
+}
+
+uint64_t ow_sim_time_us(void)
+{
+    return now;
+}
+
+void ow_sim_get_stats(struct ow_sim_stats *out)
+{
+    *out = stats;
+}
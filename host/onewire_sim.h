@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Host side model of a 1-Wire bus with DS18S20/DS18B20 devices hanging off
+// it. It supplies the ow_hw_* hooks from onewire.h so the real bit layer in
+// onewire.c runs unmodified on Linux when built with -DONEWIRE_SIM.
+//
+// Time is virtual: it only advances through ow_hw_delay_us(), so the
+// microsecond totals reported are exactly the bus time the driver asked
+// for, independent of how fast the host is.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ONEWIRE_SIM_H
+#define ONEWIRE_SIM_H
+
+#include <stdint.h>
+
+#define OW_SIM_MAX_DEVICES 8
+
+#define OW_FAMILY_DS18S20 0x10
+#define OW_FAMILY_DS18B20 0x28
+
+struct ow_sim_device;
+
+struct ow_sim_stats
+{
+    uint32_t resets;
+    uint32_t slots;
+    uint32_t bits_flipped;
+    uint32_t timing_errors;  // write slots released inside the 15-60us window
+};
+
+void     ow_sim_init(void);
+
+// Attach a device. rom[7] is recomputed so the ROM CRC is always valid.
+struct ow_sim_device *ow_sim_add(const uint8_t *rom);
+
+// temperature in 1/16 degC, as a DS18B20 would hold it
+void     ow_sim_set_temp(struct ow_sim_device *dev, int16_t temp_c16);
+const uint8_t *ow_sim_rom(struct ow_sim_device *dev);
+
+// Fault injection
+void     ow_sim_set_present(struct ow_sim_device *dev, uint8_t present);
+void     ow_sim_set_bit_flip(struct ow_sim_device *dev, uint32_t every_n_bits);
+void     ow_sim_set_conversion_time(struct ow_sim_device *dev, uint32_t us);
+void     ow_sim_set_bus_short(uint8_t shorted);
+
+uint64_t ow_sim_time_us(void);
+void     ow_sim_get_stats(struct ow_sim_stats *stats);
+
+#endif
@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Runs the onewire.c bit layer against the bus simulator and reports bus
+// time per operation and how each injected fault shows up to the driver.
+//
+// Build on Linux from the top of the tree:
+//   gcc -DONEWIRE_SIM -I. -Ihost -o ow_bench
+//       host/ow_bench.c host/onewire_sim.c onewire.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "onewire.h"
+#include "onewire_sim.h"
+
+#define CONVERT_TEMP     0x44
+#define READ_SCRATCHPAD  0xBE
+
+#define NUM_PROBES 4
+
+static const uint8_t probe_roms[NUM_PROBES][8] =
+{
+    {0x10, 0x9c, 0xa4, 0x1e, 0x02, 0x08, 0x00},
+    {0x10, 0xe3, 0x9b, 0x1e, 0x02, 0x08, 0x00},
+    {0x10, 0x99, 0xd7, 0x39, 0x01, 0x08, 0x00},
+    {0x28, 0xe3, 0x9b, 0x1e, 0x02, 0x08, 0x00},
+};
+
+static struct ow_sim_device *probes[NUM_PROBES];
+
+// decode as the target does, in hundredths of a degree
+static int decode_c100(const uint8_t *rom, const uint8_t *sp)
+{
+    int16_t raw = (int16_t)(sp[0] | (sp[1] << 8));
+
+    if (rom[0] == OW_FAMILY_DS18B20)
+        return (raw * 100) / 16;
+
+    return (raw >> 1) * 100 - 25 + (100 * 16 - sp[6] * 100) / 16;
+}
+
+// 0 = ok, otherwise the onewire error code or 1 for a CRC failure
+static int read_probe(const uint8_t *rom, int *c100)
+{
+    uint8_t sp[9];
+    uint8_t err;
+    int ii;
+
+    err = ow_reset();
+    if (err != NO_ERROR)
+        return err;
+
+    ow_match_rom(rom);
+    ow_write_byte(READ_SCRATCHPAD);
+    for (ii = 0; ii < 9; ii++)
+        sp[ii] = ow_read_byte();
+
+    if (ow_crc8(sp, 9) != 0)
+        return 1;
+
+    *c100 = decode_c100(rom, sp);
+    return 0;
+}
+
+static void convert_all(uint32_t wait_us)
+{
+    ow_reset();
+    ow_write_byte(SKIP_ROM);
+    ow_write_byte(CONVERT_TEMP);
+
+    while (wait_us)
+    {
+        uint16_t step = wait_us > 60000 ? 60000 : wait_us;
+        ow_hw_delay_us(step);
+        wait_us -= step;
+    }
+}
+
+static void setup(void)
+{
+    int ii;
+
+    ow_sim_init();
+    ow_hw_init();
+    for (ii = 0; ii < NUM_PROBES; ii++)
+    {
+        probes[ii] = ow_sim_add(probe_roms[ii]);
+        ow_sim_set_temp(probes[ii], (int16_t)((60 + ii * 5) * 16 + ii * 3));
+    }
+}
+
+static void read_cycle(const char *title, uint32_t wait_us)
+{
+    int ii;
+
+    printf("%s\n", title);
+    convert_all(wait_us);
+    for (ii = 0; ii < NUM_PROBES; ii++)
+    {
+        int c100 = 0;
+        uint64_t start = ow_sim_time_us();
+        int ret = read_probe(ow_sim_rom(probes[ii]), &c100);
+        uint64_t took = ow_sim_time_us() - start;
+
+        if (ret == 0)
+            printf("  probe %d  %3d.%02d degC  %6llu us\n", ii,
+                   c100 / 100, c100 % 100, (unsigned long long)took);
+        else if (ret == 1)
+            printf("  probe %d  CRC error      %6llu us\n", ii,
+                   (unsigned long long)took);
+        else
+            printf("  probe %d  bus error %02X   %6llu us\n", ii, ret,
+                   (unsigned long long)took);
+    }
+}
+
+int main(void)
+{
+    struct ow_sim_stats st;
+    uint8_t rom[8];
+    uint64_t start;
+    int found;
+
+    setup();
+
+    start = ow_sim_time_us();
+    found = 0;
+    if (ow_search_first(rom, SEARCH_ROM))
+    {
+        do
+        {
+            printf("found %02x-%02x-%02x-%02x-%02x-%02x-%02x-%02x\n",
+                   rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6], rom[7]);
+            found++;
+        } while (ow_search_next(rom, SEARCH_ROM));
+    }
+    printf("search: %d devices in %llu us\n\n", found,
+           (unsigned long long)(ow_sim_time_us() - start));
+
+    read_cycle("nominal", 800000);
+
+    ow_sim_set_conversion_time(probes[1], 1500000);
+    ow_sim_set_temp(probes[1], 70 * 16);
+    read_cycle("probe 1 now 70 degC, slow conversion (reads previous result)", 800000);
+    ow_sim_set_conversion_time(probes[1], 750000);
+
+    ow_sim_set_present(probes[2], 0);
+    read_cycle("probe 2 missing", 800000);
+    ow_sim_set_present(probes[2], 1);
+
+    ow_sim_set_bit_flip(probes[3], 50);
+    read_cycle("probe 3 flipping every 50th bit", 800000);
+    ow_sim_set_bit_flip(probes[3], 0);
+
+    ow_sim_set_bus_short(1);
+    read_cycle("bus shorted", 0);
+    ow_sim_set_bus_short(0);
+
+    ow_sim_get_stats(&st);
+    printf("\nresets %u  slots %u  flipped %u  timing errors %u  bus time %llu us\n",
+           st.resets, st.slots, st.bits_flipped, st.timing_errors,
+           (unsigned long long)ow_sim_time_us());
+    return 0;
+}
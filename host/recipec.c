@@ -0,0 +1,306 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Recipe compiler. Turns a text recipe file into the binary image
+// described in recipe.h, checks the result with the same code the
+// target uses, and prints the image CRC.
+//
+//   recipe "Pale Ale"
+//   fill   hlt  timeout=30
+//   heat   hlt  temp=72.0 timeout=120
+//   mash   mash temp=66.0 min=60 timeout=180
+//   sparge mash min=15 timeout=30
+//   boil   mash temp=99.0 min=60 timeout=180 hops=60,15,0
+//   chill  mash temp=20.0 timeout=90
+//   end
+//
+// Temperatures are in degC, times in minutes. '#' starts a comment.
+//
+// Build on Linux from the top of the tree:
+//   gcc -DRECIPE_HOST -I. -o recipec host/recipec.c recipe.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "recipe.h"
+#include "heater.h"
+
+static const char *step_names[BREW_STEP_TYPES] =
+{
+    "fill", "heat", "mash", "sparge", "boil", "chill"
+};
+
+static uint8_t image[RECIPE_MAX_SIZE];
+static struct brew_recipe recipes[RECIPE_DIR_SLOTS];
+static int n_recipes;
+
+static const char *filename;
+static int line_no;
+
+static void fail(const char *msg, const char *arg)
+{
+    fprintf(stderr, "%s:%d: %s%s%s\n", filename, line_no, msg,
+            arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+static int parse_temp(const char *val)
+{
+    char *end;
+    double temp = strtod(val, &end);
+
+    if (end == val || *end || temp < -20.0 || temp > 120.0)
+        fail("bad temperature", val);
+    return (int)(temp * 100.0 + (temp < 0 ? -0.5 : 0.5));
+}
+
+static unsigned parse_minutes(const char *val)
+{
+    char *end;
+    unsigned long mins = strtoul(val, &end, 10);
+
+    if (end == val || *end || mins > 0xFFFF)
+        fail("bad number of minutes", val);
+    return (unsigned)mins;
+}
+
+static void parse_hops(struct brew_step *step, char *val)
+{
+    char *tok;
+
+    for (tok = strtok(val, ","); tok; tok = strtok(NULL, ","))
+    {
+        unsigned mins = parse_minutes(tok);
+
+        if (step->hops >= BREW_MAX_HOPS)
+            fail("too many hop additions", NULL);
+        if (mins > step->minutes || mins > 255)
+            fail("hop addition outside the boil", tok);
+        if (step->hops && mins > step->hop_minutes[step->hops - 1])
+            fail("hop additions must be in order, earliest first", tok);
+        step->hop_minutes[step->hops++] = (uint8_t)mins;
+    }
+}
+
+static void parse_step(struct brew_recipe *recipe, char *line)
+{
+    struct brew_step *step;
+    char *tok = strtok(line, " \t");
+    char *opts[8];
+    int n_opts = 0;
+    int ii;
+
+    if (recipe->n_steps >= BREW_MAX_STEPS)
+        fail("too many steps", NULL);
+    step = &recipe->steps[recipe->n_steps];
+    memset(step, 0, sizeof(*step));
+
+    for (ii = 0; ii < BREW_STEP_TYPES; ii++)
+        if (strcmp(tok, step_names[ii]) == 0)
+            break;
+    if (ii == BREW_STEP_TYPES)
+        fail("unknown step", tok);
+    step->type = ii;
+
+    tok = strtok(NULL, " \t");
+    if (!tok)
+        fail("missing vessel", NULL);
+    if (strcmp(tok, "hlt") == 0)
+        step->vessel = HEATER_HLT;
+    else if (strcmp(tok, "mash") == 0)
+        step->vessel = HEATER_MASH;
+    else
+        fail("unknown vessel", tok);
+
+    // collect the options first, hops are checked against min=
+    while ((tok = strtok(NULL, " \t")) != NULL && n_opts < 8)
+        opts[n_opts++] = tok;
+    if (tok)
+        fail("too many options", tok);
+
+    for (ii = 0; ii < n_opts; ii++)
+    {
+        char *val = strchr(opts[ii], '=');
+
+        if (!val)
+            fail("expected name=value", opts[ii]);
+        *val++ = 0;
+        if (strcmp(opts[ii], "temp") == 0)
+            step->temp = parse_temp(val);
+        else if (strcmp(opts[ii], "min") == 0)
+            step->minutes = parse_minutes(val);
+        else if (strcmp(opts[ii], "timeout") == 0)
+            step->timeout = parse_minutes(val);
+        else if (strcmp(opts[ii], "hops") != 0)
+            fail("unknown option", opts[ii]);
+    }
+    for (ii = 0; ii < n_opts; ii++)
+    {
+        if (strcmp(opts[ii], "hops") == 0)
+        {
+            if (step->type != BREW_BOIL)
+                fail("hops only go in a boil", NULL);
+            parse_hops(step, opts[ii] + strlen(opts[ii]) + 1);
+        }
+    }
+
+    if ((step->type == BREW_HEAT || step->type == BREW_MASH ||
+         step->type == BREW_BOIL || step->type == BREW_CHILL) && step->temp == 0)
+        fail("step needs temp=", step_names[step->type]);
+    if ((step->type == BREW_MASH || step->type == BREW_SPARGE ||
+         step->type == BREW_BOIL) && step->minutes == 0)
+        fail("step needs min=", step_names[step->type]);
+
+    recipe->n_steps++;
+}
+
+static void parse_file(FILE *fp)
+{
+    char line[256];
+    struct brew_recipe *recipe = NULL;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        char *pp, *name;
+
+        line_no++;
+        if ((pp = strchr(line, '#')) != NULL)
+            *pp = 0;
+        for (pp = line + strlen(line); pp > line && isspace((unsigned char)pp[-1]); )
+            *--pp = 0;
+        for (pp = line; isspace((unsigned char)*pp); pp++)
+            ;
+        if (!*pp)
+            continue;
+
+        if (strncmp(pp, "recipe", 6) == 0 && isspace((unsigned char)pp[6]))
+        {
+            if (recipe)
+                fail("missing end", NULL);
+            if (n_recipes >= RECIPE_DIR_SLOTS)
+                fail("too many recipes", NULL);
+            name = strchr(pp, '"');
+            if (!name || !strchr(name + 1, '"'))
+                fail("recipe name must be quoted", NULL);
+            name++;
+            *strchr(name, '"') = 0;
+            if (!*name || strlen(name) >= RECIPE_NAME_LEN)
+                fail("recipe name empty or too long", name);
+
+            recipe = &recipes[n_recipes];
+            memset(recipe, 0, sizeof(*recipe));
+            strcpy(recipe->name, name);
+        }
+        else if (strcmp(pp, "end") == 0)
+        {
+            if (!recipe)
+                fail("end without recipe", NULL);
+            if (recipe->n_steps == 0)
+                fail("recipe has no steps", recipe->name);
+            recipe = NULL;
+            n_recipes++;
+        }
+        else if (recipe)
+            parse_step(recipe, pp);
+        else
+            fail("step outside a recipe", pp);
+    }
+    if (recipe)
+        fail("missing end at end of file", NULL);
+}
+
+static uint32_t build_image(void)
+{
+    struct recipe_header *hdr = (struct recipe_header *)image;
+    struct recipe_dir_entry *dir = (struct recipe_dir_entry *)(image + RECIPE_DIR_OFFSET);
+    uint32_t offset = RECIPE_STEPS_OFFSET;
+    int ii;
+
+    // erased flash reads as 0xFF, so unused space matches what is there
+    memset(image, 0xFF, sizeof(image));
+    memset(image, 0, RECIPE_STEPS_OFFSET);
+
+    for (ii = 0; ii < n_recipes; ii++)
+    {
+        uint32_t len = recipes[ii].n_steps * sizeof(struct brew_step);
+
+        if (offset + len > RECIPE_MAX_SIZE)
+            fail("image too big", recipes[ii].name);
+        memcpy(dir[ii].name, recipes[ii].name, RECIPE_NAME_LEN);
+        dir[ii].offset = offset;
+        dir[ii].n_steps = recipes[ii].n_steps;
+        memcpy(image + offset, recipes[ii].steps, len);
+        dir[ii].crc = recipe_crc32(0, image + offset, len);
+        offset += len;
+    }
+
+    hdr->magic = RECIPE_MAGIC;
+    hdr->version = RECIPE_VERSION;
+    hdr->count = n_recipes;
+    hdr->size = offset;
+    hdr->crc = recipe_crc32(0, image + sizeof(*hdr), offset - sizeof(*hdr));
+    return offset;
+}
+
+// read the image back the way the target will
+static void verify_image(void)
+{
+    struct brew_recipe check;
+    int ii;
+
+    if (recipe_check(image, RECIPE_MAX_SIZE) != RECIPE_OK)
+        fail("image failed its own check", NULL);
+    for (ii = 0; ii < n_recipes; ii++)
+    {
+        if (recipe_find(image, recipes[ii].name) != ii ||
+            recipe_load(image, ii, &check) != RECIPE_OK ||
+            memcmp(check.steps, recipes[ii].steps,
+                   recipes[ii].n_steps * sizeof(struct brew_step)) != 0)
+            fail("recipe did not read back", recipes[ii].name);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FILE *fp;
+    uint32_t size;
+    int ii;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s recipes.txt recipes.bin\n", argv[0]);
+        return 2;
+    }
+
+    filename = argv[1];
+    fp = fopen(filename, "r");
+    if (!fp)
+    {
+        perror(filename);
+        return 1;
+    }
+    parse_file(fp);
+    fclose(fp);
+
+    size = build_image();
+    verify_image();
+
+    fp = fopen(argv[2], "wb");
+    if (!fp || fwrite(image, 1, size, fp) != size || fclose(fp) != 0)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    for (ii = 0; ii < n_recipes; ii++)
+        printf("%2d  %-24s %2d steps\n", ii, recipes[ii].name, recipes[ii].n_steps);
+    printf("%s: %lu bytes, crc %08lx\n", argv[2], (unsigned long)size,
+           (unsigned long)((struct recipe_header *)image)->crc);
+    return 0;
+}
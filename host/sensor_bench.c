@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Feeds sensor.c streams of probe readings with faults injected into
+// them, one reading every two seconds as the DS1820 task takes them, and
+// checks the state changes it logs against what each fault should give.
+// Exits non-zero if any case goes wrong.
+//
+// Build on Linux from the top of the tree:
+//   gcc -I. -o sensor_bench host/sensor_bench.c sensor.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "sensor.h"
+
+#define PERIOD_MS 2000
+
+struct reading
+{
+    uint8_t read;
+    int32_t c100;
+    uint8_t expect_change;
+};
+
+// A case builds its stream into here
+static struct reading stream[400];
+static int length;
+
+static void add(int count, uint8_t read, int32_t start, int32_t step, uint8_t expect)
+{
+    while (count-- > 0 && length < (int)(sizeof(stream) / sizeof(stream[0])))
+    {
+        stream[length].read = read;
+        stream[length].c100 = start;
+        stream[length].expect_change = expect;
+        length++;
+        start += step;
+    }
+}
+
+static void heating(int count, int32_t start)
+{
+    add(count, SENSOR_READ_OK, start, 6, 0);   // ~2 degC a minute
+}
+
+struct bench_case
+{
+    const char *name;
+    void (*build)(void);
+    const char *changes;   // expected log, oldest first
+    uint8_t state;         // expected at the end
+    int32_t value;         // expected last good reading, or 0 to skip
+};
+
+static void clean(void)
+{
+    heating(100, 2000);
+}
+
+static void crc_glitch(void)
+{
+    heating(10, 5000);
+    add(1, SENSOR_READ_CRC, 0, 0, 0);
+    heating(10, 5066);
+}
+
+static void unplugged(void)
+{
+    heating(10, 5000);
+    add(20, SENSOR_READ_ABSENT, 0, 0, 0);
+    heating(10, 5200);
+}
+
+static void bus_short(void)
+{
+    heating(10, 5000);
+    add(5, SENSOR_READ_SHORT, 0, 0, 0);
+}
+
+static void spike(void)
+{
+    heating(10, 5000);
+    add(1, SENSOR_READ_OK, 8500, 0, 0);
+    heating(10, 5066);
+}
+
+static void out_of_range(void)
+{
+    // 211.00 is what the driver used to hand on for a probe that
+    // didn't answer
+    heating(10, 6000);
+    add(4, SENSOR_READ_OK, 21100, 0, 0);
+}
+
+static void stuck(void)
+{
+    heating(10, 4000);
+    add(SENSOR_STUCK_SAMPLES + 10, SENSOR_READ_OK, 4060, 0, 1);
+    heating(10, 4060);
+}
+
+static void flat_while_idle(void)
+{
+    // holding temperature with the element off is not stuck
+    add(SENSOR_STUCK_SAMPLES + 50, SENSOR_READ_OK, 6500, 0, 0);
+}
+
+static void probe_moved(void)
+{
+    // a real step that holds is believed after one reading
+    heating(10, 2000);
+    add(10, SENSOR_READ_OK, 6000, 0, 0);
+}
+
+static const struct bench_case cases[] =
+{
+    { "clean heating",  clean,           "",                               SENSOR_OK,     2594 },
+    { "one CRC error",  crc_glitch,      "SUSPECT/CRC OK",                 SENSOR_OK,     5120 },
+    { "unplugged",      unplugged,       "SUSPECT/open FAILED/open OK",    SENSOR_OK,     5254 },
+    { "bus shorted",    bus_short,       "SUSPECT/shorted FAILED/shorted", SENSOR_FAILED, 5054 },
+    { "single spike",   spike,           "SUSPECT/slew OK",                SENSOR_OK,     5120 },
+    { "211.00",         out_of_range,    "SUSPECT/range FAILED/range",     SENSOR_FAILED, 6054 },
+    { "stuck",          stuck,           "FAILED/stuck OK",                SENSOR_OK,     4114 },
+    { "flat and idle",  flat_while_idle, "",                               SENSOR_OK,     6500 },
+    { "probe moved",    probe_moved,     "SUSPECT/slew OK",                SENSOR_OK,     6000 },
+};
+
+static int run(const struct bench_case *bc)
+{
+    struct sensor s;
+    struct sensor_event ev;
+    char log[200] = "";
+    uint32_t ii, count;
+    int ok;
+
+    length = 0;
+    bc->build();
+    sensor_init(&s);
+    sensor_clear_log();
+
+    for (ii = 0; ii < (uint32_t)length; ii++)
+        sensor_update(&s, 0, stream[ii].read, stream[ii].c100,
+                      1000 + ii * PERIOD_MS, stream[ii].expect_change);
+
+    count = sensor_event_count();
+    for (ii = count; ii > 0; ii--)
+    {
+        if (!sensor_get_event(ii - 1, &ev))
+            continue;
+        snprintf(log + strlen(log), sizeof(log) - strlen(log), "%s%s%s%s",
+                 log[0] ? " " : "", sensor_state_name(ev.state),
+                 ev.fault ? "/" : "", sensor_fault_name(ev.fault));
+    }
+
+    ok = strcmp(log, bc->changes) == 0 && s.state == bc->state &&
+         (bc->value == 0 || s.value == bc->value);
+    printf("%-14s %-4s %-30s -> %-7s %3ld.%02ld\n", bc->name, ok ? "ok" : "FAIL",
+           count ? log : "(no changes)", sensor_state_name(s.state),
+           (long)s.value / 100, (long)s.value % 100);
+    if (!ok)
+        printf("    expected %s -> %s %ld\n", bc->changes,
+               sensor_state_name(bc->state), (long)bc->value);
+    return ok;
+}
+
+int main(void)
+{
+    int failed = 0;
+    unsigned ii;
+
+    for (ii = 0; ii < sizeof(cases) / sizeof(cases[0]); ii++)
+        if (!run(&cases[ii]))
+            failed++;
+
+    printf("%d of %u cases failed\n", failed, (unsigned)(sizeof(cases) / sizeof(cases[0])));
+    return failed != 0;
+}
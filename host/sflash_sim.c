@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "sflash.h"
+#include "sflash_sim.h"
+
+#define SECTORS  (SFLASH_SIZE / SFLASH_SECTOR_SIZE)
+#define ERASE_COST 256
+
+static uint8_t *chip;
+static uint32_t budget;
+static jmp_buf *reset_to;
+static uint32_t reads, read_bytes;
+static uint32_t fail_read;
+static uint32_t erases[SECTORS];
+
+void sflash_sim_init(void)
+{
+    if (!chip)
+        chip = malloc(SFLASH_SIZE);
+    memset(chip, 0xFF, SFLASH_SIZE);
+    budget = 0;
+    fail_read = 0;
+    sflash_sim_clear_reads();
+    memset(erases, 0, sizeof(erases));
+}
+
+void sflash_sim_cut_after(uint32_t bytes, jmp_buf *reset)
+{
+    budget = bytes;
+    reset_to = reset;
+}
+
+void sflash_sim_fail_read(uint32_t nth)
+{
+    fail_read = nth;
+}
+
+uint32_t sflash_sim_reads(void)
+{
+    return reads;
+}
+
+uint32_t sflash_sim_read_bytes(void)
+{
+    return read_bytes;
+}
+
+uint32_t sflash_sim_erases(uint32_t addr)
+{
+    return erases[addr / SFLASH_SECTOR_SIZE];
+}
+
+void sflash_sim_clear_reads(void)
+{
+    reads = 0;
+    read_bytes = 0;
+}
+
+static void power_check(uint32_t cost)
+{
+    if (!budget)
+        return;
+    if (budget <= cost)
+    {
+        budget = 0;
+        longjmp(*reset_to, 1);
+    }
+    budget -= cost;
+}
+
+static uint8_t run(struct sflash_req *req)
+{
+    uint8_t *pp = chip + req->addr;
+    uint32_t ii, cut = budget;
+
+    switch (req->op)
+    {
+    case SFLASH_READ:
+        if (fail_read && --fail_read == 0)
+            return 0;
+        memcpy(req->buf, pp, req->len);
+        reads++;
+        read_bytes += req->len;
+        return 1;
+
+    case SFLASH_PROGRAM:
+        for (ii = 0; ii < req->len; ii++)
+        {
+            power_check(1);
+            pp[ii] &= req->buf[ii];
+        }
+        return 1;
+
+    case SFLASH_ERASE:
+        pp = chip + req->addr / SFLASH_SECTOR_SIZE * SFLASH_SECTOR_SIZE;
+        // a cut part way through leaves some of it erased
+        if (cut && cut <= ERASE_COST)
+            for (ii = 0; ii < SFLASH_SECTOR_SIZE; ii++)
+                if ((uint32_t)(rand() % ERASE_COST) < cut)
+                    pp[ii] = 0xFF;
+        power_check(ERASE_COST);
+        memset(pp, 0xFF, SFLASH_SECTOR_SIZE);
+        erases[req->addr / SFLASH_SECTOR_SIZE]++;
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t sflash_submit(struct sflash_req *req)
+{
+    if (req->addr >= SFLASH_SIZE ||
+        (req->op == SFLASH_PROGRAM &&
+         (req->len == 0 || (req->addr % SFLASH_PAGE_SIZE) + req->len > SFLASH_PAGE_SIZE)) ||
+        (req->op == SFLASH_READ && (req->len == 0 || req->addr + req->len > SFLASH_SIZE)))
+    {
+        req->status = SFLASH_FAILED;
+        return 0;
+    }
+    req->status = run(req) ? SFLASH_DONE : SFLASH_FAILED;
+    return req->status == SFLASH_DONE;
+}
+
+uint8_t sflash_do(struct sflash_req *req)
+{
+    return sflash_submit(req);
+}
+
+xSemaphoreHandle sflash_done_create(void)
+{
+    return NULL;
+}
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// RAM backed stand in for sflash.c, each request done as it is submitted.
+// Programming follows the M25P64: bits only go from 1 to 0 and a program
+// must stay in its page. A power cut can be armed to hit after a number
+// of bytes programmed; the program or erase in progress is left part done
+// and control returns to the setjmp given. A read can be made to fail.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SFLASH_SIM_H
+#define SFLASH_SIM_H
+
+#include <stdint.h>
+#include <setjmp.h>
+
+// the whole chip erased
+void     sflash_sim_init(void);
+
+// after `bytes' more bytes programmed (an erase counts as 256) the power
+// goes; 0 disarms
+void     sflash_sim_cut_after(uint32_t bytes, jmp_buf *reset);
+
+// the `nth' read from now fails; 0 disarms
+void     sflash_sim_fail_read(uint32_t nth);
+
+uint32_t sflash_sim_reads(void);
+uint32_t sflash_sim_read_bytes(void);
+uint32_t sflash_sim_erases(uint32_t addr);   // of the sector addr is in
+void     sflash_sim_clear_reads(void);
+
+#endif
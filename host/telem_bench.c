@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Telemetry throughput. Frames each record type with telemetry.c and
+// reports its size on the wire, how many a second 115200 baud carries,
+// and how much of the link the default periods use. Then streams frames
+// with random bodies through a decoder with console text mixed in and
+// bits flipped in some of them, and counts what gets through.
+//
+// Build on Linux from the top of the tree:
+//   gcc -DTELEM_HOST -I. -o telem_bench host/telem_bench.c telemetry.c cobs.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cobs.h"
+#include "telemetry.h"
+
+#define LINK_BYTES_PER_S  (115200 / 10)   // 8N1
+#define FRAMES            100000
+#define CORRUPT_ONE_IN    50
+
+static const struct
+{
+    const char *name;
+    uint8_t len;
+    uint16_t period_ms;
+} types[] =
+{
+    { "temps",    TELEM_TEMPS_LEN,    TELEM_TEMPS_MS },
+    { "heaters",  TELEM_HEATERS_LEN,  TELEM_HEATERS_MS },
+    { "brew",     TELEM_BREW_LEN,     TELEM_BREW_MS },
+    { "tasks(6)", TELEM_TASKS_LEN(6), TELEM_TASKS_MS },
+};
+
+static void random_body(uint8_t *body, uint8_t len)
+{
+    int ii;
+
+    // readings are mostly small numbers, so plenty of zero bytes to stuff
+    for (ii = 0; ii < len; ii++)
+        body[ii] = rand() % 3 ? rand() : 0;
+}
+
+int main(void)
+{
+    static uint8_t stream[FRAMES * (COBS_MAX_ENCODED(TELEM_MAX_FRAME) + 2 + 32)];
+    static uint8_t damaged[FRAMES];
+    uint8_t body[TELEM_MAX_BODY];
+    uint8_t frame[COBS_MAX_ENCODED(TELEM_MAX_FRAME) + 2];
+    unsigned long used = 0, corrupted = 0, good = 0, rejected = 0, false_ok = 0;
+    double load = 0;
+    size_t at = 0, start;
+    unsigned ii, tt;
+
+    printf("record    body  wire  per second at 115200\n");
+    for (tt = 0; tt < sizeof(types) / sizeof(types[0]); tt++)
+    {
+        uint16_t nn;
+
+        random_body(body, types[tt].len);
+        nn = telem_frame(frame, tt + 1, 0, 0, body, types[tt].len);
+        printf("%-9s %4u  %4u  %6lu\n", types[tt].name, types[tt].len, nn,
+               (unsigned long)(LINK_BYTES_PER_S / nn));
+        load += nn * 1000.0 / types[tt].period_ms;
+    }
+    printf("default periods: %.0f bytes/s, %.1f%% of the link\n\n",
+           load, load * 100 / LINK_BYTES_PER_S);
+
+    // a stream with text between some frames and damage in others
+    srand(1);
+    for (ii = 0; ii < FRAMES; ii++)
+    {
+        uint8_t len = types[ii % 4].len;
+        uint16_t nn;
+
+        random_body(body, len);
+        nn = telem_frame(frame, ii % 4 + 1, ii, ii * 100, body, len);
+        if (rand() % CORRUPT_ONE_IN == 0)
+        {
+            // one bit anywhere between the delimiters
+            frame[1 + rand() % (nn - 2)] ^= 1 << (rand() % 8);
+            damaged[ii] = 1;
+            corrupted++;
+        }
+        memcpy(stream + at, frame, nn);
+        at += nn;
+        if (rand() % 10 == 0)
+        {
+            static const char text[] = "HLT Temp = 65.25Deg-C\r\n";
+
+            memcpy(stream + at, text, sizeof(text) - 1);
+            at += sizeof(text) - 1;
+        }
+    }
+    used = at;
+
+    // decode it the way host/telemdump.c does
+    for (at = 0, start = 0; at < used; at++)
+    {
+        uint16_t nn, len;
+        uint32_t time;
+
+        if (stream[at] != 0)
+            continue;
+        len = at - start;
+        nn = len ? cobs_decode(stream + start, len, stream + start) : 0;
+        if (len == 0)
+            ;
+        else if (nn < TELEM_HEADER_LEN + TELEM_CRC_LEN ||
+                 crc16_ccitt(0xFFFF, stream + start, nn - TELEM_CRC_LEN) !=
+                 (stream[start + nn - 2] | stream[start + nn - 1] << 8))
+            rejected++;
+        else
+        {
+            // the time field says which frame it was
+            time = stream[start + 3] | stream[start + 4] << 8 |
+                   stream[start + 5] << 16 | (uint32_t)stream[start + 6] << 24;
+            if (time / 100 >= FRAMES || damaged[time / 100])
+                false_ok++;
+            else
+                good++;
+        }
+        start = at + 1;
+    }
+
+    printf("%d frames, %lu with a bit flipped, text after 1 in 10\n",
+           FRAMES, corrupted);
+    printf("%lu decoded, %lu rejected (frames and text), %lu bad accepted\n",
+           good, rejected, false_ok);
+    printf("%lu lost, %.1f bytes a record on average\n",
+           FRAMES - good, (double)used / FRAMES);
+    return 0;
+}
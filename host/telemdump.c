@@ -0,0 +1,396 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Telemetry decoder. Reads the console stream (see telemetry.h) from a
+// file or stdin and writes one line per record, as CSV with a header
+// line for each record type the first time it appears, or with -j as one
+// JSON object per line. Anything that is not a good frame, such as printf
+// text, is skipped. Frame and loss counts go to stderr at the end.
+//
+// Log records carry an offset into the LOG() format strings rather than
+// text; given the strings from the same build with -s (make logstr.bin)
+// they are formatted here, with a %s shown as the address it was given.
+// %q is fixed point, as fmt.h. The data logger's records come out the same
+// way, as "datalog" records, after the shell's "dump" command.
+//
+//   stty -F /dev/ttyUSB0 115200 raw
+//   telemdump [-j] [-s logstr.bin] < /dev/ttyUSB0
+//
+// Build on Linux from the top of the tree:
+//   gcc -DTELEM_HOST -I. -o telemdump host/telemdump.c cobs.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cobs.h"
+#include "telemetry.h"
+
+enum kind { U8, I16, U16, I32, U32 };
+
+struct field
+{
+    const char *name;
+    enum kind kind;
+};
+
+static const struct field temps_fields[] =
+{
+    { "hlt", I16 }, { "hlt_rate", I16 }, { "hlt_state", U8 },
+    { "mash", I16 }, { "mash_rate", I16 }, { "mash_state", U8 },
+    { "cabinet", I16 }, { "cabinet_rate", I16 }, { "cabinet_state", U8 },
+    { "ambient", I16 }, { "ambient_rate", I16 }, { "ambient_state", U8 },
+    { NULL }
+};
+
+static const struct field heaters_fields[] =
+{
+    { "hlt_mode", U8 }, { "hlt_flags", U8 }, { "hlt_target", I16 },
+    { "hlt_temp", I16 }, { "hlt_output", U16 }, { "hlt_granted", U16 },
+    { "hlt_ff", U16 },
+    { "mash_mode", U8 }, { "mash_flags", U8 }, { "mash_target", I16 },
+    { "mash_temp", I16 }, { "mash_output", U16 }, { "mash_granted", U16 },
+    { "mash_ff", U16 },
+    { NULL }
+};
+
+static const struct field brew_fields[] =
+{
+    { "state", U8 }, { "step", U8 }, { "n_steps", U8 }, { "elapsed", U32 },
+    { "remaining", I32 }, { "brew_time", U32 }, { "target", I16 },
+    { "temp", I16 },
+    { NULL }
+};
+
+static const struct field tasks_fields[] =
+{
+    { "heap", U32 }, { "tasks", U8 }, { "rx_overruns", U16 },
+    { "dropped", U16 }, { "watched", U8 },
+    { NULL }
+};
+
+static const struct field log_fields[] =
+{
+    { "format", U16 }, { "nargs", U8 },
+    { NULL }
+};
+
+static const struct field datalog_fields[] =
+{
+    { "record", U32 }, { "hlt", I16 }, { "mash", I16 }, { "cabinet", I16 },
+    { "ambient", I16 }, { "hlt_target", I16 }, { "mash_target", I16 },
+    { "hlt_output", U16 }, { "mash_output", U16 }, { "state", U8 },
+    { "step", U8 }, { "hlt_mode", U8 }, { "mash_mode", U8 }, { "flags", U8 },
+    { NULL }
+};
+
+struct record_type
+{
+    const char *name;
+    const struct field *fields;
+    uint8_t len;        // fixed part of the body
+};
+
+static const struct record_type types[TELEM_TYPES] =
+{
+    { NULL },
+    { "temps",   temps_fields,   TELEM_TEMPS_LEN },
+    { "heaters", heaters_fields, TELEM_HEATERS_LEN },
+    { "brew",    brew_fields,    TELEM_BREW_LEN },
+    { "tasks",   tasks_fields,   TELEM_TASKS_LEN(0) },
+    { "log",     log_fields,     TELEM_LOG_LEN(0) },
+    { "datalog", datalog_fields, TELEM_DATALOG_LEN },
+};
+
+static int json;
+static char *strings;           // logstr.bin
+static long strings_len;
+static int header_done[TELEM_TYPES];
+static unsigned long good, bad, lost;
+
+static uint32_t get(const uint8_t *pp, enum kind kind, long *val)
+{
+    uint32_t raw;
+
+    switch (kind)
+    {
+    case U8:
+        *val = pp[0];
+        return 1;
+    case I16:
+    case U16:
+        raw = pp[0] | pp[1] << 8;
+        *val = kind == I16 ? (long)(int16_t)raw : (long)raw;
+        return 2;
+    default:
+        raw = pp[0] | pp[1] << 8 | pp[2] << 16 | (uint32_t)pp[3] << 24;
+        *val = kind == I32 ? (long)(int32_t)raw : (long)raw;
+        return 4;
+    }
+}
+
+// printf for a log record, each conversion given one 32 bit argument
+static void format_log(char *out, size_t size, uint16_t offset,
+                       const uint8_t *args, int nargs)
+{
+    const char *ff;
+    size_t used = 0;
+    int ai = 0;
+
+    if (!strings || offset >= strings_len)
+    {
+        snprintf(out, size, "format %u?", offset);
+        return;
+    }
+    for (ff = strings + offset; *ff && used < size - 1; )
+    {
+        char spec[20], *ss;
+        size_t len;
+        long val = 0;
+
+        if (*ff != '%')
+        {
+            if (*ff != '\r' && *ff != '\n')
+                out[used++] = *ff;
+            ff++;
+            continue;
+        }
+
+        // flags, width and precision, any length, then the conversion
+        len = strspn(ff + 1, "-+ #0123456789.lh") + 2;
+        if (len >= sizeof(spec) - 2 || ff[len - 1] == '\0')
+            break;
+        for (ss = spec; len--; ff++)
+            if (*ff != 'l' && *ff != 'h')
+                *ss++ = *ff;
+        *ss = '\0';
+
+        if (ss[-1] != '%' && ai < nargs)
+            get(args + 4 * ai++, strchr("diq", ss[-1]) ? I32 : U32, &val);
+        if (ss[-1] == 'q')
+        {
+            // fixed point, see fmt.h; keep the width, lose the places
+            char *dot = strchr(spec, '.');
+            int places = dot ? atoi(dot + 1) : 2;
+            long scale = 1;
+            char num[32];
+            int ii;
+
+            for (ii = 0; ii < places; ii++)
+                scale *= 10;
+            if (places)
+                snprintf(num, sizeof(num), "%s%ld.%0*ld", val < 0 ? "-" : "",
+                         labs(val) / scale, places, labs(val) % scale);
+            else
+                snprintf(num, sizeof(num), "%ld", val);
+            strcpy(dot ? dot : ss - 1, "s");
+            snprintf(out + used, size - used, spec, num);
+            used += strlen(out + used);
+            continue;
+        }
+        if (ss[-1] == 's')
+            strcpy(spec, "<%#lx>");
+        else if (ss[-1] != '%' && ss[-1] != 'c')
+        {
+            // a long, now the length is gone
+            ss[0] = ss[-1];
+            ss[-1] = 'l';
+            ss[1] = '\0';
+        }
+        if (ss[-1] == 'c')
+            snprintf(out + used, size - used, spec, (int)val);
+        else
+            snprintf(out + used, size - used, spec, val);
+        used += strlen(out + used);
+    }
+    out[used < size ? used : size - 1] = '\0';
+}
+
+static void print_text(const char *text)
+{
+    // JSON escapes a quote with \, CSV doubles it
+    putchar('"');
+    for (; *text; text++)
+    {
+        if (*text == '"' || (json && *text == '\\'))
+            putchar(json ? '\\' : '"');
+        putchar(*text);
+    }
+    putchar('"');
+}
+
+static void print_record(uint8_t type, uint16_t seq, uint32_t time,
+                         const uint8_t *body, uint16_t len)
+{
+    const struct record_type *rt = &types[type];
+    const struct field *ff;
+    long val;
+    int ii, n;
+
+    if (!json && !header_done[type])
+    {
+        printf("#record,seq,time_ms");
+        for (ff = rt->fields; ff->name; ff++)
+            printf(",%s", ff->name);
+        if (type == TELEM_TASKS)
+            printf(",name,stack_free...");
+        if (type == TELEM_LOG)
+            printf(",text,args...");
+        printf("\n");
+        header_done[type] = 1;
+    }
+
+    if (json)
+        printf("{\"record\":\"%s\",\"seq\":%u,\"time_ms\":%lu", rt->name, seq,
+               (unsigned long)time);
+    else
+        printf("%s,%u,%lu", rt->name, seq, (unsigned long)time);
+
+    for (ff = rt->fields; ff->name; ff++)
+    {
+        body += get(body, ff->kind, &val);
+        if (json)
+            printf(",\"%s\":%ld", ff->name, val);
+        else
+            printf(",%ld", val);
+    }
+
+    if (type == TELEM_TASKS)
+    {
+        n = body[-1];
+        if (json)
+            printf(",\"stacks\":{");
+        for (ii = 0; ii < n && (ii + 1) * 6 <= len - rt->len; ii++, body += 6)
+        {
+            get(body + 4, U16, &val);
+            if (json)
+                printf("%s\"%.4s\":%ld", ii ? "," : "", body, val);
+            else
+                printf(",%.4s,%ld", body, val);
+        }
+        if (json)
+            printf("}");
+    }
+
+    if (type == TELEM_LOG)
+    {
+        char text[256];
+        uint16_t offset = body[-3] | body[-2] << 8;
+
+        n = body[-1];
+        if (n > (len - rt->len) / 4)
+            n = (len - rt->len) / 4;
+        format_log(text, sizeof(text), offset, body, n);
+        printf(json ? ",\"text\":" : ",");
+        print_text(text);
+        if (json)
+            printf(",\"args\":[");
+        for (ii = 0; ii < n; ii++)
+        {
+            get(body + 4 * ii, U32, &val);
+            printf("%s%ld", json && !ii ? "" : ",", val);
+        }
+        if (json)
+            printf("]");
+    }
+    printf(json ? "}\n" : "\n");
+}
+
+static void frame(uint8_t *buf, uint16_t len)
+{
+    static int have_seq;
+    static uint16_t next_seq;
+    uint16_t nn, seq;
+    uint32_t time;
+    long val;
+    uint8_t type;
+
+    nn = cobs_decode(buf, len, buf);
+    if (nn < TELEM_HEADER_LEN + TELEM_CRC_LEN ||
+        crc16_ccitt(0xFFFF, buf, nn - TELEM_CRC_LEN) !=
+        (buf[nn - 2] | buf[nn - 1] << 8))
+    {
+        bad++;
+        return;
+    }
+    type = buf[0];
+    nn -= TELEM_HEADER_LEN + TELEM_CRC_LEN;
+    if (type == 0 || type >= TELEM_TYPES || nn < types[type].len)
+    {
+        bad++;
+        return;
+    }
+
+    get(buf + 1, U16, &val);
+    seq = val;
+    get(buf + 3, U32, &val);
+    time = val;
+    if (have_seq)
+        lost += (uint16_t)(seq - next_seq);
+    have_seq = 1;
+    next_seq = seq + 1;
+    good++;
+
+    print_record(type, seq, time, buf + TELEM_HEADER_LEN, nn);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[1024];
+    uint16_t len = 0;
+    int cc, ii;
+
+    for (ii = 1; ii < argc; ii++)
+    {
+        if (strcmp(argv[ii], "-j") == 0)
+            json = 1;
+        else if (strcmp(argv[ii], "-s") == 0 && ii + 1 < argc)
+        {
+            FILE *fp = fopen(argv[++ii], "rb");
+
+            if (!fp)
+            {
+                perror(argv[ii]);
+                return 1;
+            }
+            fseek(fp, 0, SEEK_END);
+            strings_len = ftell(fp);
+            rewind(fp);
+            // zero after, in case the last one isn't
+            strings = calloc(1, strings_len + 1);
+            if (fread(strings, 1, strings_len, fp) != (size_t)strings_len)
+                strings_len = 0;
+            fclose(fp);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-j] [-s logstr.bin] < stream\n", argv[0]);
+            return 1;
+        }
+    }
+
+    while ((cc = getchar()) != EOF)
+    {
+        if (cc != 0)
+        {
+            // too long to be a frame, wait for the next zero
+            if (len < sizeof(buf))
+                buf[len] = cc;
+            len++;
+            continue;
+        }
+        if (len > 0 && len <= sizeof(buf))
+            frame(buf, len);
+        else if (len > sizeof(buf))
+            bad++;
+        len = 0;
+    }
+
+    fprintf(stderr, "%lu records, %lu bad frames, %lu lost\n", good, bad, lost);
+    return 0;
+}
@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Fits thermal.c's model to a logged run on a simulated vessel (the same
+// first order lag with dead time as autotune_bench.c), then runs the
+// loop as heater.c does, with and without the feed-forward, through a
+// setpoint step up, one down, and through the grain going in.
+//
+// Build on Linux from the top of the tree:
+//   gcc -I. -Ihost -o thermal_bench host/thermal_bench.c thermal.c pid.c
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "thermal.h"
+#include "pid.h"
+#include "heater.h"
+
+#define WINDOW_S    (HEATER_WINDOW_MS / 1000.0)
+#define MAX_DELAY   64
+
+struct vessel
+{
+    double temp;           // degC
+    double ambient;
+    double rise_full;      // degC above ambient at full power, steady state
+    double tau;            // s
+    int    delay;          // windows of dead time
+    double history[MAX_DELAY];
+    int    head;
+};
+
+static void vessel_init(struct vessel *v, double litres, double watts, double tau,
+                        double dead_s, double start)
+{
+    memset(v, 0, sizeof(*v));
+    v->temp = start;
+    v->ambient = 18.0;
+    v->tau = tau;
+    v->rise_full = watts / (litres * 4186.0) * tau;
+    v->delay = (int)(dead_s / WINDOW_S);
+    if (v->delay >= MAX_DELAY)
+        v->delay = MAX_DELAY - 1;
+}
+
+static void vessel_step(struct vessel *v, int output)
+{
+    double heat = v->history[(v->head + MAX_DELAY - v->delay) % MAX_DELAY];
+
+    v->history[v->head] = output / (double)HEATER_OUTPUT_MAX;
+    v->head = (v->head + 1) % MAX_DELAY;
+    v->temp += WINDOW_S * (heat * v->rise_full - (v->temp - v->ambient)) / v->tau;
+}
+
+static int32_t vessel_read(const struct vessel *v)
+{
+    int32_t c16 = (int32_t)(v->temp * 16.0);
+    return (c16 * 100) / 16;
+}
+
+// 25l mash tun, 2.4kW, better lagged and slower to respond than the
+// defaults in heater.h assume
+#define LITRES  25
+#define WATTS   2400
+#define TAU_S   15000
+#define DEAD_S  80
+
+static void new_vessel(struct vessel *v, double start)
+{
+    vessel_init(v, LITRES, WATTS, TAU_S, DEAD_S, start);
+}
+
+// Log an hour of whatever a brewer might do by hand and fit it
+static void fit_run(struct thermal_model *m)
+{
+    static const struct { int minutes; int output; } plan[] =
+    {
+        { 8, 0 }, { 20, 1000 }, { 10, 0 }, { 12, 400 }, { 10, 700 }, { 10, 150 },
+    };
+    struct thermal_fit fit;
+    struct vessel v;
+    unsigned ii;
+    int jj;
+
+    new_vessel(&v, 20.0);
+    memset(&fit, 0, sizeof(fit));      // no dead time measured yet
+    thermal_fit_reset(&fit);
+
+    for (ii = 0; ii < sizeof(plan) / sizeof(plan[0]); ii++)
+    {
+        for (jj = 0; jj < plan[ii].minutes * 60 / WINDOW_S; jj++)
+        {
+            thermal_fit_sample(&fit, m, plan[ii].output, vessel_read(&v));
+            vessel_step(&v, plan[ii].output);
+        }
+    }
+
+    printf("vessel    gain %6.0f  tau %5.0f  dead %2d  ambient %4.0f\n",
+           v.rise_full * 100, TAU_S / WINDOW_S, v.delay, v.ambient * 100);
+    printf("defaults  gain %6ld  tau %5u  dead %2u  ambient %4ld\n",
+           (long)m->gain, m->tau, m->dead, (long)m->ambient);
+    if (!thermal_fit_solve(&fit, m))
+    {
+        printf("fit failed after %u blocks\n", fit.blocks);
+        return;
+    }
+    printf("fitted    gain %6ld  tau %5u  dead %2u  ambient %4ld  (%u blocks)\n\n",
+           (long)m->gain, m->tau, m->dead, (long)m->ambient, fit.blocks);
+}
+
+struct result
+{
+    int32_t peak;          // overshoot, or lowest point after a disturbance
+                           // or a step down
+    int     settled;       // windows until it stays inside +/-0.25 degC
+};
+
+// As heater_run() does it. use_ff 0 is the plain PID loop.
+static void run_loop(const struct thermal_model *m, int use_ff, double start,
+                     int32_t target, double drop, struct result *res)
+{
+    struct vessel v;
+    struct pid pid;
+    struct thermal_ff ff;
+    int low = drop || target < start * 100;
+    int ii;
+
+    new_vessel(&v, start);
+    pid_init(&pid, HEATER_DEFAULT_KP, HEATER_DEFAULT_KI, HEATER_DEFAULT_KD,
+             0, HEATER_OUTPUT_MAX);
+    thermal_ff_reset(&ff, m, vessel_read(&v));
+    res->peak = low ? 100000 : -100000;
+    res->settled = -1;
+
+    for (ii = 0; ii < 7200; ii++)
+    {
+        int32_t temp = vessel_read(&v);
+        int32_t output;
+
+        // settle at the target first, then the grain goes in
+        if (drop && ii == 1800)
+        {
+            v.temp -= drop;
+            if (use_ff)
+                thermal_ff_disturb(&ff, (int32_t)(-drop * 100));
+        }
+
+        if (use_ff)
+        {
+            thermal_ff_step(&ff, m, target);
+            pid_set_feedforward(&pid, ff.output);
+            output = pid_update(&pid, ff.reference, temp);
+        }
+        else
+            output = pid_update(&pid, target, temp);
+        vessel_step(&v, output);
+
+        if (drop && ii < 1800)
+            continue;
+        if (low ? temp < res->peak : temp > res->peak)
+            res->peak = temp;
+        if (temp > target - 25 && temp < target + 25)
+        {
+            if (res->settled < 0)
+                res->settled = ii - (drop ? 1800 : 0);
+        }
+        else
+            res->settled = -1;
+    }
+    res->peak -= target;
+}
+
+static void print_result(const char *title, const struct result *res)
+{
+    int32_t peak = res->peak < 0 ? -res->peak : res->peak;
+
+    printf("  %-16s %s%ld.%02ld degC  settled ", title, res->peak < 0 ? "-" : " ",
+           (long)peak / 100, (long)peak % 100);
+    if (res->settled >= 0)
+        printf("after %3d min\n", (int)(res->settled * WINDOW_S / 60));
+    else
+        printf("never\n");
+}
+
+int main(void)
+{
+    struct thermal_model m;
+    struct result res;
+
+    thermal_init(&m, HEATER_MODEL_GAIN, HEATER_MODEL_TAU, HEATER_MODEL_DEAD,
+                 HEATER_MODEL_AMBIENT, HEATER_OUTPUT_MAX);
+    fit_run(&m);
+
+    printf("20 -> 66 degC, overshoot:\n");
+    run_loop(&m, 0, 20.0, 6600, 0, &res);
+    print_result("PID", &res);
+    run_loop(&m, 1, 20.0, 6600, 0, &res);
+    print_result("feed-forward", &res);
+
+    // the feed-forward plans no output until the vessel has cooled
+    printf("72 -> 66 degC, lowest point:\n");
+    run_loop(&m, 0, 72.0, 6600, 0, &res);
+    print_result("PID", &res);
+    run_loop(&m, 1, 72.0, 6600, 0, &res);
+    print_result("feed-forward", &res);
+
+    printf("grain in at 66 degC, 5 degC fall, lowest point:\n");
+    run_loop(&m, 0, 66.0, 6600, 5.0, &res);
+    print_result("PID", &res);
+    run_loop(&m, 1, 66.0, 6600, 5.0, &res);
+    print_result("feed-forward", &res);
+    return 0;
+}
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "iflash.h"
+
+uint8_t iflash_erase_page(const void *page)
+{
+    FLASH_Status st;
+
+    vTaskSuspendAll();
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+    st = FLASH_ErasePage((uint32_t)page);
+    FLASH_Lock();
+    xTaskResumeAll();
+
+    return st == FLASH_COMPLETE ? IFLASH_OK : IFLASH_ERROR;
+}
+
+uint8_t iflash_program(const void *dst, const void *src, uint32_t len)
+{
+    uint32_t addr = (uint32_t)dst;
+    const uint8_t *pp = src;
+    FLASH_Status st = FLASH_COMPLETE;
+
+    vTaskSuspendAll();
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+    for (; len > 0 && st == FLASH_COMPLETE; addr += 2, pp += 2)
+    {
+        uint16_t hw = pp[0] | ((len > 1 ? pp[1] : 0xFF) << 8);
+
+        st = FLASH_ProgramHalfWord(addr, hw);
+        len = len > 1 ? len - 2 : 0;
+    }
+    FLASH_Lock();
+    xTaskResumeAll();
+
+    return st == FLASH_COMPLETE ? IFLASH_OK : IFLASH_ERROR;
+}
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Erase and program the STM32's own flash for data kept in the regions
+// reserved in stm32_flash.ld. On the host (IFLASH_SIM) the same calls are
+// served by host/iflash_sim.c from RAM, with power cuts injected.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IFLASH_H
+#define IFLASH_H
+
+#include <stdint.h>
+
+#define IFLASH_PAGE_SIZE 2048   // high density parts
+
+enum iflash_error
+{
+    IFLASH_OK,
+    IFLASH_ERROR
+};
+
+// The CPU stalls on flash reads while these run: about 20ms for an erase
+// and 50us per half word programmed. No other task runs between the
+// unlock and the lock, so callers in different tasks can't trip over each
+// other; interrupts are left on, though any that fetch from flash wait.
+uint8_t iflash_erase_page(const void *page);
+
+// dst must be half word aligned and erased, except that 0x0000 can be
+// written over anything; len is rounded up to even.
+uint8_t iflash_program(const void *dst, const void *src, uint32_t len);
+
+#endif
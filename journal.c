@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Append only brew journal in internal flash. The region is a ring of 2K
+// pages, each holding 64 fixed size records written in order. Records are
+// complete snapshots, each with its own CRC, so a record torn by a reset
+// part way through programming just fails its check and the one before
+// it is used.
+//
+// The first record in a page carries the page's place in the ring (its
+// seq), so the newest page is found by reading one record per page. That
+// page is then scanned for its last good record, falling back to the page
+// before it when even its first record is torn. Finding the resume point
+// therefore costs at most (pages + 2 * 64) record reads, however long the
+// journal has been running.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "iflash.h"
+#include "journal.h"
+#include "recipe.h"
+
+typedef char journal_rec_size_check[sizeof(struct journal_rec) == JOURNAL_REC_SIZE ? 1 : -1];
+
+static const uint8_t *j_base;
+static uint32_t j_pages;
+static uint32_t j_next;          // record index the next write goes to
+static uint32_t j_seq;           // seq of the newest good record
+static uint8_t  j_have_last;
+static struct journal_rec j_last;
+
+static const struct journal_rec *rec_at(uint32_t index)
+{
+    return (const struct journal_rec *)(j_base + index * JOURNAL_REC_SIZE);
+}
+
+static uint32_t rec_crc(const struct journal_rec *rec)
+{
+    return recipe_crc32(0, rec, JOURNAL_REC_SIZE - sizeof(rec->crc));
+}
+
+static uint8_t rec_valid(const struct journal_rec *rec)
+{
+    return rec->event != 0xFF && rec_crc(rec) == rec->crc;
+}
+
+static uint8_t rec_erased(const struct journal_rec *rec)
+{
+    const uint32_t *pp = (const uint32_t *)rec;
+    int ii;
+
+    for (ii = 0; ii < JOURNAL_REC_SIZE / 4; ii++)
+        if (pp[ii] != 0xFFFFFFFF)
+            return 0;
+    return 1;
+}
+
+static uint8_t page_erased(uint32_t page)
+{
+    int ii;
+
+    for (ii = 0; ii < JOURNAL_PAGE_RECS; ii++)
+        if (!rec_erased(rec_at(page * JOURNAL_PAGE_RECS + ii)))
+            return 0;
+    return 1;
+}
+
+//
+// Last good record in a page. Returns its index in the page or -1. The
+// page is written in order, so scanning stops at the first erased slot.
+//
+static int scan_page(uint32_t page)
+{
+    int last = -1;
+    int ii;
+
+    for (ii = 0; ii < JOURNAL_PAGE_RECS; ii++)
+    {
+        const struct journal_rec *rec = rec_at(page * JOURNAL_PAGE_RECS + ii);
+
+        if (rec_erased(rec))
+            break;
+        if (rec_valid(rec))
+            last = ii;
+    }
+    return last;
+}
+
+void journal_init(const uint8_t *base, uint32_t size)
+{
+    uint32_t page, newest = 0;
+    uint32_t best_seq = 0;
+    uint8_t  found = 0;
+    int      last;
+
+    j_base = base;
+    j_pages = size / IFLASH_PAGE_SIZE;
+    j_have_last = 0;
+    j_seq = 0;
+    j_next = 0;
+
+    for (page = 0; page < j_pages; page++)
+    {
+        const struct journal_rec *rec = rec_at(page * JOURNAL_PAGE_RECS);
+
+        if (rec_valid(rec) && (!found || (int32_t)(rec->seq - best_seq) > 0))
+        {
+            best_seq = rec->seq;
+            newest = page;
+            found = 1;
+        }
+    }
+
+    if (!found)
+        return;
+
+    last = scan_page(newest);
+    if (last < 0)
+        return;     // can't happen, the page's first record is valid
+
+    j_last = *rec_at(newest * JOURNAL_PAGE_RECS + last);
+    j_have_last = 1;
+    j_seq = j_last.seq;
+
+    // carry on after whatever is in the page, good or torn
+    for (j_next = newest * JOURNAL_PAGE_RECS + last + 1;
+         j_next < (newest + 1) * JOURNAL_PAGE_RECS && !rec_erased(rec_at(j_next));
+         j_next++)
+        ;
+    if (j_next >= j_pages * JOURNAL_PAGE_RECS)
+        j_next = 0;
+}
+
+uint8_t journal_write(struct journal_rec *rec)
+{
+    uint32_t slot;
+
+    if (!j_base || j_pages < 2)
+        return 1;
+
+    for (;;)
+    {
+        slot = j_next;
+
+        // starting a page: erase it first. Its first record then doubles
+        // as the page header.
+        if (slot % JOURNAL_PAGE_RECS == 0 &&
+            !page_erased(slot / JOURNAL_PAGE_RECS) &&
+            iflash_erase_page(rec_at(slot)) != IFLASH_OK)
+            return 1;
+
+        j_next = (slot + 1) % (j_pages * JOURNAL_PAGE_RECS);
+        if (rec_erased(rec_at(slot)))
+            break;
+        // a slot left dirty by a torn write is skipped
+    }
+
+    rec->seq = j_seq + 1;
+    rec->crc = rec_crc(rec);
+    if (iflash_program(rec_at(slot), rec, JOURNAL_REC_SIZE) != IFLASH_OK ||
+        !rec_valid(rec_at(slot)))
+        return 1;
+
+    j_seq = rec->seq;
+    j_last = *rec;
+    j_have_last = 1;
+    return 0;
+}
+
+// Page the journal moves into next, or 0xFFFFFFFF without a journal
+static uint32_t page_ahead(void)
+{
+    if (!j_base || j_pages < 2)
+        return 0xFFFFFFFF;
+    if (j_next % JOURNAL_PAGE_RECS == 0)
+        return j_next / JOURNAL_PAGE_RECS;
+    return (j_next / JOURNAL_PAGE_RECS + 1) % j_pages;
+}
+
+uint8_t journal_erase_due(void)
+{
+    return j_base && j_pages >= 2 && j_next % JOURNAL_PAGE_RECS == 0 &&
+           !page_erased(j_next / JOURNAL_PAGE_RECS);
+}
+
+// The newest record is always in the page before, so this never loses it
+uint8_t journal_erase_ahead(void)
+{
+    uint32_t page = page_ahead();
+
+    if (page == 0xFFFFFFFF || page_erased(page))
+        return 0;
+    return iflash_erase_page(rec_at(page * JOURNAL_PAGE_RECS)) != IFLASH_OK;
+}
+
+uint8_t journal_last(struct journal_rec *rec)
+{
+    if (!j_have_last)
+        return 0;
+    *rec = j_last;
+    return 1;
+}
+
+#ifndef IFLASH_SIM
+// Region reserved in stm32_flash.ld
+extern const uint8_t __journal_start[];
+extern const uint8_t __journal_end[];
+
+void journal_open(void)
+{
+    journal_init(__journal_start, __journal_end - __journal_start);
+}
+#endif
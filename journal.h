@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "iflash.h"
+
+enum journal_event
+{
+    JOURNAL_CHECKPOINT,     // periodic, nothing changed
+    JOURNAL_START,
+    JOURNAL_STEP,           // entered rec.step
+    JOURNAL_RESUMED,
+    JOURNAL_FAILED,
+    JOURNAL_ABORTED,
+    JOURNAL_DONE
+};
+
+// One record is a complete snapshot of the brew, so the newest valid
+// record is all that is needed to resume.
+struct journal_rec
+{
+    uint8_t  event;
+    uint8_t  state;          // enum brew_state
+    uint8_t  step;
+    uint8_t  recipe;         // flash directory slot, 0xFF for the built in
+    uint32_t seq;            // increases by one per record, never wraps in practice
+    uint32_t brew_time;      // seconds since START
+    uint32_t elapsed;        // seconds in the step
+    int32_t  hold_start;     // see struct brew_task
+    uint16_t element_s[2];   // full power seconds per element
+    uint16_t recipe_crc;     // low half of the recipe's step CRC
+    uint8_t  next_hop;
+    uint8_t  reserved;
+    uint32_t crc;            // CRC-32 of the above; a torn write fails it
+};
+
+#define JOURNAL_REC_SIZE   32
+#define JOURNAL_PAGE_RECS  (IFLASH_PAGE_SIZE / JOURNAL_REC_SIZE)
+
+// Scan the region for the newest valid record. Reads at most every page's
+// first record and all of two pages.
+void    journal_init(const uint8_t *base, uint32_t size);
+
+// Append a record; seq and crc are filled in. Returns 0 on success.
+uint8_t journal_write(struct journal_rec *rec);
+
+// A page erase holds the flash for 20-40ms, stalling every interrupt
+// that runs from it. journal_write() erases a page when it starts one,
+// unless journal_erase_ahead() has already done it at a better moment.
+// journal_erase_due() says the next write would erase.
+uint8_t journal_erase_due(void);
+
+// Erase the page the journal moves into next, if it needs it. Returns 0
+// on success.
+uint8_t journal_erase_ahead(void);
+
+// Newest valid record. Returns 0 if the journal is empty.
+uint8_t journal_last(struct journal_rec *rec);
+
+#ifndef IFLASH_SIM
+// journal_init() on the region reserved in stm32_flash.ld
+void    journal_open(void);
+#endif
+
+#endif
@@ -0,0 +1,470 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Settings store, see kv.h. Each sector in use starts with a header
+// holding its place in the log, then records one after another:
+//
+//   key    2 bytes
+//   len    1 byte, 0 for a deleted key
+//   spare  1 byte, 0xFF
+//   value  len bytes
+//   crc    2 bytes, CRC-16/CCITT of the above
+//
+// A record torn by a reset fails its CRC and is stepped over; a header
+// too mangled to step over ends the sector there.
+//
+// The sectors are used in turn round the ring and the one after the
+// newest is always kept erased. Moving into a new sector uses that one up,
+// so the sector after it, the oldest, is cleared out there and then:
+// the values still current in it are copied to the new sector and it is
+// erased. A reset part way through leaves the oldest sector whole, and
+// opening the store finishes the job. Every value fits in the first few
+// K of the new sector, so this never runs out of room.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "kv.h"
+#include "sflash.h"
+#include "cobs.h"
+
+#ifndef SFLASH_SIM
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timer.h"
+#endif
+
+#define KV_MAGIC       0x3153564B      // "KVS1"
+#define HDR_SIZE       16
+#define REC_HDR        4
+#define REC_CRC        2
+#define REC_MAX        (REC_HDR + KV_MAX_VALUE + REC_CRC)
+#define WINDOW         SFLASH_PAGE_SIZE
+
+struct sector_hdr
+{
+    uint32_t magic;
+    uint32_t seq;            // 1 for the first sector ever, then one more each
+    uint16_t crc;
+    uint8_t  spare[6];
+};
+
+struct slot
+{
+    uint32_t addr;           // of the record, 0 for no value
+    uint8_t  len;
+};
+
+typedef char sector_hdr_size_check[sizeof(struct sector_hdr) == HDR_SIZE ? 1 : -1];
+
+static struct slot slots[KV_KEYS];
+static uint32_t sector_seq[KV_SECTORS];   // 0 when erased
+static uint8_t  head_sector;
+static uint32_t head;                     // the next record goes here
+static uint8_t  opened;
+static struct kv_stats stats;
+static struct sflash_req req;
+static uint32_t win_base, win_have;       // what window() has read
+
+#ifndef SFLASH_SIM
+static xSemaphoreHandle lock;
+#endif
+
+static void kv_lock(void)
+{
+#ifndef SFLASH_SIM
+    xSemaphoreTake(lock, portMAX_DELAY);
+#endif
+}
+
+static void kv_unlock(void)
+{
+#ifndef SFLASH_SIM
+    xSemaphoreGive(lock);
+#endif
+}
+
+static uint32_t sector_addr(uint8_t sector)
+{
+    return KV_BASE + (uint32_t)sector * SFLASH_SECTOR_SIZE;
+}
+
+static uint8_t sector_of(uint32_t addr)
+{
+    return (addr - KV_BASE) / SFLASH_SECTOR_SIZE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Flash
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t flash_read(uint32_t addr, void *buf, uint16_t len)
+{
+    req.op = SFLASH_READ;
+    req.addr = addr;
+    req.buf = buf;
+    req.len = len;
+    return sflash_do(&req);
+}
+
+// A page program at a time
+static uint8_t flash_write(uint32_t addr, const uint8_t *buf, uint16_t len)
+{
+    uint16_t run;
+
+    while (len)
+    {
+        run = SFLASH_PAGE_SIZE - addr % SFLASH_PAGE_SIZE;
+        if (run > len)
+            run = len;
+        req.op = SFLASH_PROGRAM;
+        req.addr = addr;
+        req.buf = (uint8_t *)buf;
+        req.len = run;
+        if (!sflash_do(&req))
+            return 0;
+        addr += run;
+        buf += run;
+        len -= run;
+    }
+    return 1;
+}
+
+static uint8_t flash_erase(uint8_t sector)
+{
+    req.op = SFLASH_ERASE;
+    req.addr = sector_addr(sector);
+    stats.erases++;
+    return sflash_do(&req);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// The log
+////////////////////////////////////////////////////////////////////////////
+
+static uint16_t hdr_crc(const struct sector_hdr *hdr)
+{
+    return crc16_ccitt(0xFFFF, (const uint8_t *)hdr, 8);
+}
+
+static uint8_t start_sector(uint8_t sector, uint32_t seq)
+{
+    struct sector_hdr hdr;
+
+    memset(&hdr, 0xFF, sizeof(hdr));
+    hdr.magic = KV_MAGIC;
+    hdr.seq = seq;
+    hdr.crc = hdr_crc(&hdr);
+
+    // nothing is trusted to be erased that hasn't just been
+    sector_seq[sector] = 0;
+    if (!flash_erase(sector) || !flash_write(sector_addr(sector), (const uint8_t *)&hdr, HDR_SIZE))
+        return 0;
+    sector_seq[sector] = seq;
+    head_sector = sector;
+    head = sector_addr(sector) + HDR_SIZE;
+    return 1;
+}
+
+// Bytes from addr, reading WINDOW at a time but never past end. NULL if
+// the read failed.
+static const uint8_t *window(uint32_t addr, uint16_t len, uint32_t end)
+{
+    static uint8_t win[WINDOW];
+
+    if (addr < win_base || addr + len > win_base + win_have)
+    {
+        win_base = addr;
+        win_have = end - addr < WINDOW ? end - addr : WINDOW;
+        stats.open_reads++;
+        if (!flash_read(win_base, win, win_have))
+        {
+            win_have = 0;
+            return NULL;
+        }
+    }
+    return win + (addr - win_base);
+}
+
+// Puts the sector's records in the table. Returns where its log ends, 0
+// if it couldn't be read.
+static uint32_t scan(uint8_t sector)
+{
+    uint32_t addr = sector_addr(sector) + HDR_SIZE;
+    uint32_t end = sector_addr(sector) + SFLASH_SECTOR_SIZE;
+    const uint8_t *pp;
+    uint16_t key, size;
+    uint8_t len;
+
+    while (addr + REC_HDR + REC_CRC <= end)
+    {
+        pp = window(addr, REC_HDR, end);
+        if (!pp)
+            return 0;
+        key = pp[0] | pp[1] << 8;
+        len = pp[2];
+        if (key == 0xFFFF && len == 0xFF && pp[3] == 0xFF)
+            break;
+        size = REC_HDR + len + REC_CRC;
+        if (len > KV_MAX_VALUE || addr + size > end)
+            return end;
+
+        pp = window(addr, size, end);
+        if (!pp)
+            return 0;
+        stats.open_records++;
+        if (key < KV_KEYS &&
+            crc16_ccitt(0xFFFF, pp, size - REC_CRC) == (pp[size - 2] | pp[size - 1] << 8))
+        {
+            slots[key].addr = len ? addr : 0;
+            slots[key].len = len;
+        }
+        addr += size;
+    }
+    return addr;
+}
+
+static uint8_t append(uint8_t key, const uint8_t *value, uint8_t len);
+
+static uint8_t collecting;       // collect() is appending
+
+// The values still current in the sector go to the head, then it is
+// erased. If any of them can't be copied the sector is left as it is,
+// still in use, and 0 returned.
+static uint8_t collect(uint8_t sector)
+{
+    uint8_t value[KV_MAX_VALUE];
+    uint8_t key, ok = 1;
+
+    collecting = 1;
+    for (key = 0; key < KV_KEYS && ok; key++)
+    {
+        if (!slots[key].addr || sector_of(slots[key].addr) != sector)
+            continue;
+        ok = flash_read(slots[key].addr + REC_HDR, value, slots[key].len) &&
+             append(key, value, slots[key].len);
+    }
+    collecting = 0;
+    if (!ok)
+        return 0;
+
+    sector_seq[sector] = 0;
+    stats.collections++;
+    return flash_erase(sector);
+}
+
+static uint8_t make_room(uint16_t size)
+{
+    uint8_t next = (head_sector + 1) % KV_SECTORS;
+
+    // the sector after the head is kept free; a clear out of it that
+    // failed is tried again on each write until it works
+    if (sector_seq[next] && !collecting)
+        collect(next);
+    if (head + size <= sector_addr(head_sector) + SFLASH_SECTOR_SIZE)
+        return 1;
+    // never start over values that haven't been copied out
+    if (sector_seq[next])
+        return 0;
+    if (!start_sector(next, sector_seq[head_sector] + 1))
+        return 0;
+
+    // keep the one after free
+    next = (next + 1) % KV_SECTORS;
+    if (sector_seq[next])
+        collect(next);
+    return 1;
+}
+
+static uint8_t append(uint8_t key, const uint8_t *value, uint8_t len)
+{
+    uint8_t rec[REC_MAX];
+    uint16_t size = REC_HDR + len + REC_CRC;
+    uint16_t crc;
+    uint32_t at;
+
+    if (!make_room(size))
+        return 0;
+
+    rec[0] = key;
+    rec[1] = 0;
+    rec[2] = len;
+    rec[3] = 0xFF;
+    if (len)
+        memcpy(rec + REC_HDR, value, len);
+    crc = crc16_ccitt(0xFFFF, rec, REC_HDR + len);
+    rec[REC_HDR + len] = crc;
+    rec[REC_HDR + len + 1] = crc >> 8;
+
+    // the space is used whether or not the write worked
+    at = head;
+    head += size;
+    if (!flash_write(at, rec, size))
+        return 0;
+    slots[key].addr = len ? at : 0;
+    slots[key].len = len;
+    stats.writes++;
+    return 1;
+}
+
+// Nothing from a failed open is kept; appending after a log only partly
+// read would write over the rest of it
+static uint8_t open_failed(void)
+{
+    memset(slots, 0, sizeof(slots));
+    win_have = 0;
+    return 0;
+}
+
+// Builds the table. Returns 0, with the store left closed, if the flash
+// couldn't be read.
+static uint8_t open_locked(void)
+{
+    struct sector_hdr hdr;
+    uint8_t order[KV_SECTORS];
+    uint8_t n = 0, ii, jj;
+    uint32_t end = 0;
+#ifndef SFLASH_SIM
+    uint32_t start = ulUptimeMs;
+#endif
+
+    opened = 0;
+    memset(slots, 0, sizeof(slots));
+    win_have = 0;
+    stats.open_reads = 0;
+    stats.open_records = 0;
+
+    // oldest first
+    for (ii = 0; ii < KV_SECTORS; ii++)
+    {
+        sector_seq[ii] = 0;
+        stats.open_reads++;
+        if (!flash_read(sector_addr(ii), &hdr, sizeof(hdr)))
+            return open_failed();
+        if (hdr.magic != KV_MAGIC || hdr.crc != hdr_crc(&hdr) || hdr.seq == 0)
+            continue;
+        sector_seq[ii] = hdr.seq;
+        for (jj = n; jj > 0 && sector_seq[order[jj - 1]] > hdr.seq; jj--)
+            order[jj] = order[jj - 1];
+        order[jj] = ii;
+        n++;
+    }
+
+    for (ii = 0; ii < n; ii++)
+        if ((end = scan(order[ii])) == 0)
+            return open_failed();
+
+    opened = 1;
+    if (n == 0)
+    {
+        start_sector(0, 1);
+    }
+    else
+    {
+        head_sector = order[n - 1];
+        head = end;
+        // a clear out the power cut short; make_room() tries again if
+        // this one fails
+        ii = (head_sector + 1) % KV_SECTORS;
+        if (sector_seq[ii])
+            collect(ii);
+    }
+
+#ifndef SFLASH_SIM
+    stats.open_ms = ulUptimeMs - start;
+#endif
+    return 1;
+}
+
+static uint8_t open_once(void)
+{
+    return opened || open_locked();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////////////////////////////////
+
+void kv_init(void)
+{
+#ifndef SFLASH_SIM
+    lock = xSemaphoreCreateMutex();
+#endif
+    req.done = sflash_done_create();
+}
+
+void kv_open(void)
+{
+    kv_lock();
+    open_locked();
+    kv_unlock();
+}
+
+uint8_t kv_get(uint8_t key, void *value, uint8_t size)
+{
+    uint8_t len = 0;
+
+    if (key >= KV_KEYS)
+        return 0;
+
+    kv_lock();
+    if (open_once() && slots[key].addr)
+    {
+        len = slots[key].len;
+        if (!flash_read(slots[key].addr + REC_HDR, value, len < size ? len : size))
+            len = 0;
+    }
+    kv_unlock();
+    return len;
+}
+
+uint8_t kv_set(uint8_t key, const void *value, uint8_t len)
+{
+    uint8_t old[KV_MAX_VALUE];
+    uint8_t ok = 1;
+
+    if (key >= KV_KEYS || len > KV_MAX_VALUE)
+        return 0;
+
+    kv_lock();
+    if (!open_once())
+        ok = 0;
+    else if (len == 0 && !slots[key].addr)
+        ok = 1;
+    else if (len && slots[key].addr && slots[key].len == len &&
+             flash_read(slots[key].addr + REC_HDR, old, len) && memcmp(old, value, len) == 0)
+        ok = 1;
+    else
+        ok = append(key, value, len);
+    kv_unlock();
+    return ok;
+}
+
+uint8_t kv_delete(uint8_t key)
+{
+    return kv_set(key, NULL, 0);
+}
+
+void kv_get_stats(struct kv_stats *out)
+{
+    uint8_t ii;
+
+    kv_lock();
+    if (open_once())
+    {
+        stats.used = head - sector_addr(head_sector);
+        stats.live = 0;
+        for (ii = 0; ii < KV_SECTORS; ii++)
+            if (sector_seq[ii] && ii != head_sector)
+                stats.used += SFLASH_SECTOR_SIZE;
+        for (ii = 0; ii < KV_KEYS; ii++)
+            stats.live += slots[ii].addr != 0;
+    }
+    *out = stats;
+    kv_unlock();
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Settings store on the SPI flash. Each kv_set() appends a record to a
+// log that runs round a ring of sectors, and a table in RAM holds where
+// each key's newest value is, so kv_get() is one flash read. Old values
+// are cleared out a sector at a time, oldest first, so every sector gets
+// its turn at being erased. On the host (SFLASH_SIM) the flash is
+// host/sflash_sim.c.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef KV_H
+#define KV_H
+
+#include <stdint.h>
+
+// Above the data logger's ring, see datalog.h
+#define KV_BASE        0x780000
+#define KV_SECTORS     4
+#define KV_MAX_VALUE   48
+
+// Keys are table indexes and must never be reused for something else
+enum kv_key
+{
+    KV_GAINS_HLT,            // int32 kp, ki, kd
+    KV_GAINS_MASH,
+    KV_SENSOR_ROMS,          // 8 byte ROM code each, HLT MASH CABINET AMBIENT
+    KV_KEYS = 32
+};
+
+struct kv_stats
+{
+    uint32_t open_ms;        // rebuilding the table at start up
+    uint32_t open_reads;     // flash reads that took
+    uint32_t open_records;
+    uint32_t used;           // bytes of log, live values and dead
+    uint32_t live;           // keys with a value
+    uint32_t writes;         // since power up
+    uint32_t collections;
+    uint32_t erases;
+};
+
+// Before the scheduler starts, after sflash_init()
+void    kv_init(void);
+
+// Reads the sectors and builds the table; the first kv_get() or kv_set()
+// does it if nobody has. Costs a read per 256 bytes or so of log, which
+// the clearing out keeps to under (KV_SECTORS - 1) sectors: at most about
+// 830 reads and 210K, so 100ms or so at 18MHz. host/kv_bench.c measures it.
+// If a read fails the store stays closed, with kv_get() finding nothing
+// and kv_set() failing, and the next call tries again.
+void    kv_open(void);
+
+// Copies up to size bytes of the value. Returns the value's length, 0 if
+// the key has none.
+uint8_t kv_get(uint8_t key, void *value, uint8_t size);
+
+// Returns 1 once the value is in flash; the same value again writes
+// nothing.
+uint8_t kv_set(uint8_t key, const void *value, uint8_t len);
+uint8_t kv_delete(uint8_t key);
+
+void    kv_get_stats(struct kv_stats *stats);
+
+#endif
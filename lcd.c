@@ -1,9 +1,7 @@
-#include <stdio.h>
 #include <stdint.h>
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "task.h"
-#include "console.h"
 #include "menu.h"
 #include "lcd.h"
 #include "touch.h"
@@ -11,6 +9,10 @@
 #include "ili9320_font.h"
 #include "semphr.h"
 #include "stm32f10x.h"
+#include "fmt.h"
+
+#define LOG_MODULE LOG_MOD_LCD
+#include "log.h"
 
 
 // Doco for our LCD driver is here:
@@ -150,13 +152,13 @@ void lcd_init(void)
     deviceid = read_reg(0x00); 
     if(deviceid != 0x4532)
     {
-        printf("Invalid LCD ID:%08X\r\n",deviceid);
-        printf("Please check you hardware and configure.");
+        fmt_printf("Invalid LCD ID:%08X\r\n",deviceid);
+        fmt_printf("Please check you hardware and configure.");
         while(1);
     }
     else
     {
-        printf("\r\nLCD Device ID : %04X ",deviceid);
+        fmt_printf("\r\nLCD Device ID : %04X ",deviceid);
     }
     
     //SET UP//
@@ -186,7 +188,7 @@ void lcd_init(void)
 
     Delay(1000);     
 #endif
-    printf("Lcd_init done\r\n");
+    fmt_printf("Lcd_init done\r\n");
 }
 
 //---------------------------------------------------------------------/
@@ -380,7 +382,7 @@ static void lcd_data_bus_test(void)
 {
     unsigned short temp1;
     unsigned short temp2;
-    printf("bus test\r\n");
+    fmt_printf("bus test\r\n");
 
     /* [5:4]-ID~ID0 [3]-AM-1ֱ-0ˮƽ */
     write_reg(0x0003,(1<<12)|(1<<5)|(1<<4) | (0<<3) );
@@ -398,11 +400,11 @@ static void lcd_data_bus_test(void)
     temp2 = lcd_read_gram(1,0);
     if( (temp1 == 0x5555) && (temp2 == 0xAAAA) )
     {
-        printf("Data bus test pass!\r\n");
+        fmt_printf("Data bus test pass!\r\n");
     }
     else
     {
-        printf("Data bus test error: %04X %04X\r\n",temp1,temp2);
+        fmt_printf("Data bus test error: %04X %04X\r\n",temp1,temp2);
     }
 }
 
@@ -412,7 +414,7 @@ static void lcd_gram_test(void)
     unsigned int test_x;
     unsigned int test_y;
 
-    printf("LCD GRAM test....\r\n");
+    fmt_printf("LCD GRAM test....\r\n");
 
     /* write */
     temp=0;
@@ -434,12 +436,12 @@ static void lcd_gram_test(void)
 	{
 	    if(  lcd_read_gram(test_x,test_y) != temp++)
 	    {
-		printf("LCD GRAM ERR!!");
+		fmt_printf("LCD GRAM ERR!!");
 		// while(1);
 	    }
 	}
     }
-    printf("TEST PASS!\r\n");
+    fmt_printf("TEST PASS!\r\n");
 }
 
 /*******************************************************************************
@@ -462,7 +464,7 @@ void LCD_SetDisplayWindow(uint8_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t
     }
     else
     {
-	printf("outside region\r\n");
+	fmt_printf("outside region\r\n");
 	write_reg(0x0080, 0);
     }
     /* Horizontal GRAM End Address */
@@ -474,7 +476,7 @@ void LCD_SetDisplayWindow(uint8_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t
     }
     else
     {
-	printf("outside region\r\n");
+	fmt_printf("outside region\r\n");
 	write_reg(0x0081, 0);
     }
     /* Vertical GRAM End Address */
@@ -658,7 +660,7 @@ void lcd_lock()
 {
     while( xSemaphoreTake( xLcdSemaphore, ( portTickType ) 100 ) != pdTRUE )
     {
-	printf("Waiting a long time for LCD\r\n");
+	LOG_WARN("Waiting a long time for LCD\r\n");
     }
     lcdUsingTask = xTaskGetCurrentTaskHandle();
 }
@@ -682,7 +684,8 @@ void lcd_text_xy(uint16_t Xpos, uint16_t Ypos, const char *str,uint16_t Color, u
     LCD_LOCK;
     uint8_t TempChar;
 	
-//	printf("lcd text %d,%d %s\r\n", Xpos, Ypos, str);
+    // not the text, which may be gone by the time this is printed
+    LOG_DEBUG("lcd text %d,%d\r\n", Xpos, Ypos);
 	
     while ((TempChar=*str++))
     {
@@ -729,10 +732,12 @@ void lcd_fill(uint16_t xx, uint16_t yy, uint16_t ww, uint16_t hh, uint16_t color
 void lcd_printf(uint8_t col, uint8_t row, uint8_t ww, const char *fmt, ...)
 {
     LCD_LOCK;
-    char message[31];
+    char message[LCD_W / 8 + 2];  // all 40 columns of 8 pixel text
     va_list ap;
     va_start(ap, fmt);
-    int len = vsnprintf(message, sizeof(message) - 1, fmt, ap);
+    int len = fmt_vsnprintf(message, sizeof(message) - 1, fmt, ap);
+    if (len > sizeof(message) - 2)
+        len = sizeof(message) - 2;
     va_end(ap);
 
     while (len < ww && len < sizeof(message) - 2)
@@ -51,6 +51,8 @@ void lcd_draw_buttons(void);
 void lcd_draw_back_button(void);
 void lcd_draw_applet_options(const char * text_1, char * text_2, char * text_3, char * text_4);
 void lcd_DrawRect(int x1, int y1, int x2, int y2, int col);
+void lcd_fill(uint16_t xx, uint16_t yy, uint16_t ww, uint16_t hh, uint16_t color);
+void lcd_printf(uint8_t col, uint8_t row, uint8_t ww, const char *fmt, ...);
 void LCD_SetDisplayWindow(uint8_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t Width);
 void DrawBMP(uint8_t* ptrBitmap);
 /**
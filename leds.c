@@ -24,6 +24,9 @@
 #include <stdio.h>
 #include "ds1820.h"
 
+#define LOG_MODULE LOG_MOD_LEDS
+#include "log.h"
+
 static unsigned portSHORT usOutputValue = 0;
 
 void vStartupLEDTask ( void *pvParameters );
@@ -37,11 +40,6 @@ void vLEDInit( void )
     
     //D1 = PC6, D2 = PC7 , D3 = PD13, D4 = PD6
        
-    GPIO_InitStructure.GPIO_Pin =  D2_PIN;
-    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
-    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_Init( D2_PORT, &GPIO_InitStructure );
-
     GPIO_InitStructure.GPIO_Pin =  D3_PIN;
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
@@ -64,14 +62,12 @@ void vLEDInit( void )
 }
 
 void vStartupLEDTask ( void *pvParameters ) {
-    vLEDSet(D2_PORT, D2_PIN, ON);
     vLEDSet(D3_PORT, D3_PIN, ON);
     vLEDSet(D4_PORT, D4_PIN, ON);
     
     vTaskDelay(500/portTICK_RATE_MS);
     
     
-    vLEDSet(D2_PORT, D2_PIN, OFF);
     vLEDSet(D3_PORT, D3_PIN, OFF);
     vLEDSet(D4_PORT, D4_PIN, OFF);
     
@@ -81,7 +77,7 @@ void vStartupLEDTask ( void *pvParameters ) {
                  NULL,
                  tskIDLE_PRIORITY+2,
                  NULL);
-    // printf("LEDStartup HWM = %d1\r\n", uxTaskGetStackHighWaterMark(NULL));
+    LOG_DEBUG("LEDStartup HWM = %d\r\n", uxTaskGetStackHighWaterMark(NULL));
     
         
     vTaskDelete(NULL);
@@ -90,7 +86,7 @@ void vStartupLEDTask ( void *pvParameters ) {
     {
         //Should never get here
         vTaskPrioritySet(NULL, tskIDLE_PRIORITY);
-        // printf("LcdStartup Still Running\r\n");
+        LOG_ERROR("LcdStartup Still Running\r\n");
     }
 }
 
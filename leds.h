@@ -14,12 +14,12 @@
 #define LEDS_H
 
 //#define D1_PIN GPIO_Pin_6 cant be used as its the IRQ pin for the TP 
-#define D2_PIN GPIO_Pin_7
+//#define D2_PIN GPIO_Pin_7 cant be used as its the crane driver enable
 #define D3_PIN GPIO_Pin_13
 #define D4_PIN GPIO_Pin_6
 
 //#define D1_PORT GPIOC
-#define D2_PORT GPIOC
+//#define D2_PORT GPIOC
 #define D3_PORT GPIOD
 #define D4_PORT GPIOD
 
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Log ring, see log.h. An entry is whole words:
+//
+//   fmt   the format string's address, written last
+//   info  nargs in the top 4 bits, ulUptimeMs in the rest
+//   args  nargs words
+//
+// A writer claims its words by moving head on with LDREX/STREX, so a
+// task or interrupt that gets in halfway just claims the next ones. Until
+// its fmt word is written the entry reads as 0 and the reader waits for
+// it. An entry never wraps; if it won't fit before the end of the ring
+// the rest of the ring is claimed with a LOG_PAD word and the entry goes
+// at the start. The reader zeroes every word it is finished with before
+// giving them back, so a new entry reads as 0 until it is written.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdarg.h>
+#include "log.h"
+#include "fmt.h"
+
+#define LOG_PAD        1
+#define LOG_MASK       (LOG_RING_WORDS - 1)
+#define LOG_TIME_MASK  0x0FFFFFFF
+
+#ifdef LOG_HOST
+extern volatile unsigned long ulUptimeMs;
+#else
+#include "stm32f10x.h"
+#include "timer.h"
+#endif
+
+volatile uint8_t log_levels[LOG_MOD_MODULES] =
+{
+    [0 ... LOG_MOD_MODULES - 1] = LOG_LEVEL_INFO
+};
+
+static const char *module_names[LOG_MOD_MODULES] =
+{
+    "misc", "lcd", "menu", "touch", "leds", "ds1820"
+};
+
+static const char *level_names[] =
+{
+    "none", "error", "warn", "info", "debug"
+};
+
+static volatile uint32_t ring[LOG_RING_WORDS];
+static uint32_t head;            // words claimed by writers
+static volatile uint32_t tail;   // words given back by the reader
+static volatile uint32_t dropped;
+
+int log_write(const char *fmt, int nargs, ...)
+{
+    uint32_t words = 2 + nargs;
+    uint32_t at, pad;
+    va_list ap;
+    int ii;
+
+    // claim the entry and any padding before it in one go
+#ifdef LOG_HOST
+    at = head;
+    pad = (at & LOG_MASK) + words > LOG_RING_WORDS ? LOG_RING_WORDS - (at & LOG_MASK) : 0;
+    if (at + pad + words - tail > LOG_RING_WORDS)
+    {
+        dropped++;
+        return 0;
+    }
+    head = at + pad + words;
+#else
+    do
+    {
+        at = __LDREXW(&head);
+        pad = (at & LOG_MASK) + words > LOG_RING_WORDS ? LOG_RING_WORDS - (at & LOG_MASK) : 0;
+        if (at + pad + words - tail > LOG_RING_WORDS)
+        {
+            __CLREX();
+            dropped++;
+            return 0;
+        }
+    } while (__STREXW(at + pad + words, &head));
+#endif
+
+    if (pad)
+    {
+        ring[at & LOG_MASK] = LOG_PAD;
+        at += pad;
+    }
+
+    at &= LOG_MASK;
+    ring[at + 1] = (uint32_t)nargs << 28 | (ulUptimeMs & LOG_TIME_MASK);
+    va_start(ap, nargs);
+    for (ii = 0; ii < nargs; ii++)
+        ring[at + 2 + ii] = va_arg(ap, uint32_t);
+    va_end(ap);
+    ring[at] = (uint32_t)(uintptr_t)fmt;
+    return 1;
+}
+
+int log_take(struct log_entry *entry)
+{
+    uint32_t at, words, ii;
+    uint32_t fmt;
+
+    for (;;)
+    {
+        at = tail & LOG_MASK;
+        fmt = ring[at];
+        if (fmt == 0)
+            return 0;
+        if (fmt != LOG_PAD)
+            break;
+
+        // padding runs to the end of the ring
+        words = LOG_RING_WORDS - at;
+        for (ii = 0; ii < words; ii++)
+            ring[at + ii] = 0;
+        tail += words;
+    }
+
+    entry->fmt = (const char *)(uintptr_t)fmt;
+    entry->nargs = ring[at + 1] >> 28;
+    entry->time_ms = ring[at + 1] & LOG_TIME_MASK;
+    if (entry->nargs > LOG_MAX_ARGS)
+        entry->nargs = LOG_MAX_ARGS;
+    for (ii = 0; ii < LOG_MAX_ARGS; ii++)
+        entry->args[ii] = ii < entry->nargs ? ring[at + 2 + ii] : 0;
+
+    words = 2 + entry->nargs;
+    for (ii = 0; ii < words; ii++)
+        ring[at + ii] = 0;
+    tail += words;
+    return 1;
+}
+
+const char *log_module_name(uint8_t module)
+{
+    return module < LOG_MOD_MODULES ? module_names[module] : "?";
+}
+
+const char *log_level_name(uint8_t level)
+{
+    return level <= LOG_LEVEL_DEBUG ? level_names[level] : "?";
+}
+
+uint32_t log_dropped(void)
+{
+    return dropped;
+}
+
+void log_clear_stats(void)
+{
+    dropped = 0;
+}
+
+#ifndef LOG_HOST
+void log_print(const struct log_entry *entry)
+{
+    const uint32_t *aa = entry->args;
+
+    fmt_printf(entry->fmt, aa[0], aa[1], aa[2], aa[3], aa[4], aa[5]);
+}
+
+// from stm32_flash.ld
+extern const char __logstr_start[];
+
+uint16_t log_fmt_offset(const char *fmt)
+{
+    return fmt - __logstr_start;
+}
+#endif
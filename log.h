@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Deferred logging. LOG() stores the format string's address, the time
+// and its arguments as raw words in a ring; nothing is formatted until
+// the shell task takes the entry out, or, with the ring drained as
+// TELEM_LOG records, on the PC from the format strings pulled out of the
+// elf (make logstr.bin).
+//
+// Arguments are stored as 32 bit words, so they must be integers or
+// pointers, no more than LOG_MAX_ARGS of them, and a %s must point to a
+// string that is still there later, eg. a name table. Floats can't be
+// logged; use hundredths and %.2q (see fmt.h).
+//
+// Modules log through LOG_ERROR() to LOG_DEBUG(), setting their module
+// first and, optionally, the most detail they are ever built with:
+//
+//   #define LOG_MODULE        LOG_MOD_LCD
+//   #define LOG_MODULE_LEVEL  LOG_LEVEL_INFO
+//   #include "log.h"
+//
+// A level above LOG_MODULE_LEVEL or the build's LOG_LEVEL_MAX (make
+// LOG_LEVEL=2 for a production build) is not compiled at all: no code,
+// no string, and its arguments are not evaluated. What is compiled in is
+// filtered again by each module's threshold, set from the shell with
+// "level", which starts at LOG_LEVEL_INFO.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+#define LOG_RING_WORDS   256    // power of two, 1K
+#define LOG_MAX_ARGS     6
+
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX    LOG_LEVEL_DEBUG
+#endif
+
+// names in log.c
+enum log_module
+{
+    LOG_MOD_MISC,
+    LOG_MOD_LCD,
+    LOG_MOD_MENU,
+    LOG_MOD_TOUCH,
+    LOG_MOD_LEDS,
+    LOG_MOD_DS1820,
+    LOG_MOD_MODULES
+};
+
+// Each format string goes in .logstr, see stm32_flash.ld
+#ifdef LOG_HOST
+#define LOG_SECTION
+#else
+#define LOG_SECTION __attribute__((section(".logstr")))
+#endif
+
+#define LOG(fmt, ...)                                                   \
+    do {                                                                \
+        static const char log_fmt_[] LOG_SECTION = fmt;                 \
+        log_write(log_fmt_, LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);     \
+    } while (0)
+
+#define LOG_NARGS(...)  LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+
+#ifndef LOG_MODULE
+#define LOG_MODULE       LOG_MOD_MISC
+#endif
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL_MAX
+#endif
+
+#define LOG_AT(level, fmt, ...)                                         \
+    do {                                                                \
+        if ((level) <= log_levels[LOG_MODULE])                          \
+            LOG(fmt, ##__VA_ARGS__);                                    \
+    } while (0)
+
+#define LOG_OUT(fmt, ...) do { } while (0)
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR && LOG_LEVEL_MAX >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR LOG_OUT
+#endif
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARN && LOG_LEVEL_MAX >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN LOG_OUT
+#endif
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO && LOG_LEVEL_MAX >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO LOG_OUT
+#endif
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG && LOG_LEVEL_MAX >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG LOG_OUT
+#endif
+
+// Runtime thresholds, by module
+extern volatile uint8_t log_levels[LOG_MOD_MODULES];
+
+struct log_entry
+{
+    const char *fmt;
+    uint32_t time_ms;      // ulUptimeMs, wraps after 3 days
+    uint8_t  nargs;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+// Safe from any task or interrupt. Returns 0 if the ring was full and
+// the entry was dropped.
+int      log_write(const char *fmt, int nargs, ...);
+
+// Next entry, oldest first; only the shell task takes them. Returns 0
+// if there are none ready.
+int      log_take(struct log_entry *entry);
+
+// Prints an entry, the arguments as the format expects them
+void     log_print(const struct log_entry *entry);
+
+uint32_t log_dropped(void);
+void     log_clear_stats(void);
+
+const char *log_module_name(uint8_t module);
+const char *log_level_name(uint8_t level);
+
+// Offset of a format string in .logstr, which is what the PC is sent
+uint16_t log_fmt_offset(const char *fmt);
+
+#endif
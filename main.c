@@ -19,7 +19,6 @@
 /*app includes. */
 //#include "stm3210e_lcd.h"
 #include "LCD_Message.h"
-#include "console.h" 
 #include "leds.h"
 #include "touch.h"
 #include "lcd.h"
@@ -28,7 +27,18 @@
 #include "timer.h"
 #include "crane.h"
 #include "ds1820.h"
+#include "heater.h"
+#include "analog.h"
+#include "brew.h"
 #include "serial.h"
+#include "telemetry.h"
+#include "shell.h"
+#include "fmt.h"
+#include "spibus.h"
+#include "sflash.h"
+#include "datalog.h"
+#include "kv.h"
+#include "eeprom.h"
 /*-----------------------------------------------------------*/
 
 /* The period of the system clock in nano seconds.  This is used to calculate
@@ -76,7 +86,14 @@ xTaskHandle xLCDTaskHandle,
     xTerminalTaskHandle , 
     xBeepTaskHandle, 
     xTimerSetupHandle,
-    xDS1820Handle;
+    xDS1820Handle,
+    xCraneTaskHandle,
+    xHeaterTaskHandle,
+    xBrewTaskHandle,
+    xTelemetryHandle,
+    xDataLogHandle,
+    xSFlashHandle,
+    xShellHandle;
 
 
 // Needed by file core_cm3.h
@@ -113,12 +130,21 @@ GPIO_InitTypeDef GPIO_InitStructure;
     speaker_init();
 
     vCraneInit();
+    crane_task_init();
+
+    analog_init();
+    vHeaterInit();
+    brew_init();
+    eeprom_open();
 
         
     vLEDInit();
         
-// SPI_FLASH_Init(); cant use this ATM because of conflict with
-    // tft Pins
+    // the SPI flash shares its pins with the touch controller
+    spibus_init();
+    sflash_init();
+    datalog_init();
+    kv_init();
 
       
  
@@ -129,35 +155,90 @@ GPIO_InitTypeDef GPIO_InitStructure;
                  NULL, 
                  tskIDLE_PRIORITY+2,
                  &xTouchTaskHandle );
-    
-/*
-    xTaskCreate( vTerminalMessagesTask, 
-                 ( signed portCHAR * ) "term", 
-                 configMINIMAL_STACK_SIZE + 1500, 
+
+    xTaskCreate( vCraneTask, 
+                 ( signed portCHAR * ) "crane", 
+                 configMINIMAL_STACK_SIZE + 500, 
                  NULL, 
-                 tskIDLE_PRIORITY,
-                 &xTerminalTaskHandle );
+                 tskIDLE_PRIORITY+3,
+                 &xCraneTaskHandle );
 
-    xTaskCreate( vBeepTask, 
-                 ( signed portCHAR * ) "beep", 
-                 configMINIMAL_STACK_SIZE, 
+    xTaskCreate( vHeaterTask, 
+                 ( signed portCHAR * ) "heater", 
+                 configMINIMAL_STACK_SIZE + 200, 
                  NULL, 
-                 tskIDLE_PRIORITY,
-                 &xBeepTaskHandle );
+                 tskIDLE_PRIORITY+3,
+                 &xHeaterTaskHandle );
+
+    xTaskCreate( vBrewTask, 
+                 ( signed portCHAR * ) "brew", 
+                 configMINIMAL_STACK_SIZE + 400, 
+                 NULL, 
+                 tskIDLE_PRIORITY+2,
+                 &xBrewTaskHandle );
 
-   
+    // the heater loops run on these readings
     xTaskCreate( vTaskDS1820Convert, 
                  ( signed portCHAR * ) "DS1820", 
                  configMINIMAL_STACK_SIZE + 500, 
                  NULL, 
-                 tskIDLE_PRIORITY,
+                 tskIDLE_PRIORITY+1,
                  &xDS1820Handle );
+
+    xTaskCreate( vTelemetryTask, 
+                 ( signed portCHAR * ) "telem", 
+                 configMINIMAL_STACK_SIZE + 200, 
+                 NULL, 
+                 tskIDLE_PRIORITY+1,
+                 &xTelemetryHandle );
+
+    // owns the SPI flash, sleeps while it programs or erases
+    xTaskCreate( vSFlashTask, 
+                 ( signed portCHAR * ) "flash", 
+                 configMINIMAL_STACK_SIZE + 100, 
+                 NULL, 
+                 tskIDLE_PRIORITY+1,
+                 &xSFlashHandle );
+
+    // flash writes only wait on the chip, never the loops
+    xTaskCreate( vDataLogTask, 
+                 ( signed portCHAR * ) "dlog", 
+                 configMINIMAL_STACK_SIZE + 200, 
+                 NULL, 
+                 tskIDLE_PRIORITY+1,
+                 &xDataLogHandle );
+
+    telemetry_watch( xTouchTaskHandle, "tuch" );
+    telemetry_watch( xCraneTaskHandle, "cran" );
+    telemetry_watch( xHeaterTaskHandle, "heat" );
+    telemetry_watch( xBrewTaskHandle, "brew" );
+    telemetry_watch( xDS1820Handle, "1wir" );
+    telemetry_watch( xTelemetryHandle, "tlem" );
+    telemetry_watch( xDataLogHandle, "dlog" );
+    telemetry_watch( xSFlashHandle, "sfla" );
+
+    // lowest priority, typing at it never holds up the loops
+    xTaskCreate( vShellTask, 
+                 ( signed portCHAR * ) "shell", 
+                 configMINIMAL_STACK_SIZE + 400, 
+                 NULL, 
+                 tskIDLE_PRIORITY,
+                 &xShellHandle );
+    telemetry_watch( xShellHandle, "shel" );
+    
+/*
+    xTaskCreate( vBeepTask, 
+                 ( signed portCHAR * ) "beep", 
+                 configMINIMAL_STACK_SIZE, 
+                 NULL, 
+                 tskIDLE_PRIORITY,
+                 &xBeepTaskHandle );
 */
        
     /* Start the scheduler. */
     vTaskStartScheduler();
     
-    printf("FAIL\r\n");
+    fmt_printf("FAIL\r\n");
 
     /* Will only get here if there was insufficient memory to create the idle
        task. */
@@ -238,7 +319,8 @@ static void prvSetupHardware( void )
 }
 
 /*-----------------------------------------------------------*/
-// STACK OVERFLOW HOOK -  TURNS ON LED
+// STACK OVERFLOW HOOK -  TURNS ON LED D2, WHICH ALSO DISABLES THE CRANE
+// DRIVER AS PC7 IS ITS ACTIVE LOW ENABLE
 /*-----------------------------------------------------------*/
 void vApplicationStackOverflowHook( xTaskHandle *pxTask, signed portCHAR *pcTaskName )
 {
@@ -260,7 +342,7 @@ void vApplicationStackOverflowHook( xTaskHandle *pxTask, signed portCHAR *pcTask
 /* Keep the linker happy. */
 void assert_failed( unsigned portCHAR* pcFile, unsigned portLONG ulLine )
 {
-    printf("FAILED %s %d\r\n", pcFile, ulLine);
+    fmt_printf("FAILED %s %d\r\n", pcFile, ulLine);
 
 	for( ;; )
 	{
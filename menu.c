@@ -15,8 +15,11 @@
 #include "menu.h"
 #include "queue.h"
 #include "lcd.h"
-#include "console.h"
 #include "crane.h"
+
+#define LOG_MODULE LOG_MOD_MENU
+#include "log.h"
+
 #define HEIGHT 6
 
 #define KEY_UP    0x8
@@ -88,7 +91,7 @@ static void menu_paint_cell(int index)
 	int offset = g_rows == g_entries ? 55 : 10;
 	uint16_t bgCol = COL_BG_NORM; 
 
-	//printf("ii %d, row %d, xx %d, yy %d\r\n", index, row, xx, yy);
+	LOG_DEBUG("ii %d, row %d, xx %d, yy %d\r\n", index, row, xx, yy);
 
 	if (index == g_item)
 	{
@@ -109,7 +112,7 @@ static void menu_two_column()
     g_rows = (g_entries / 2) + ((g_entries % 2) != 0);    
     g_rowh = (LCD_H - CRUMB_H) / g_rows;
 
-    //printf("Rows: %d rowh: %d entries: %d\r\n", g_rows, g_rowh, g_entries);
+    LOG_DEBUG("Rows: %d rowh: %d entries: %d\r\n", g_rows, g_rowh, g_entries);
     
     // draw the grid
     lcd_fill(COL_W, CRUMB_H, 1, LCD_H - CRUMB_H, 0xFFFF);
@@ -195,7 +198,7 @@ void menu_set_root(struct menu *root_menu)
 static void menu_back_after_applet()
 {
     void (*callback)(int) = g_menu[g_index][g_item].activate;
-	//printf("Item %d %x\r\n", g_item, callback);
+	LOG_DEBUG("Item %d %x\r\n", g_item, callback);
     if (callback)
     	callback(0); // deactivate
 
@@ -0,0 +1,324 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// 1-Wire bit and byte layer, split out of ds1820.c so the same code can be
+// run against host/onewire_sim.c. Slot timings are unchanged from the
+// original driver.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "onewire.h"
+
+#ifndef ONEWIRE_SIM
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f10x.h"
+#include "ds1820.h"
+
+#define OW_ENTER_CRITICAL() portENTER_CRITICAL()
+#define OW_EXIT_CRITICAL()  portEXIT_CRITICAL()
+#else
+#define OW_ENTER_CRITICAL()
+#define OW_EXIT_CRITICAL()
+#endif
+
+// search state
+static uint8_t last_discrepancy;
+static uint8_t last_device;
+static uint8_t search_rom[8];
+
+////////////////////////////////////////////////////////////////////////////
+
+unsigned char ow_reset(void)
+{
+    OW_ENTER_CRITICAL();
+
+    // a bus held low by a short or a stuck device can never signal presence
+    ow_hw_release();
+    if (ow_hw_read() == 0)
+    {
+        OW_EXIT_CRITICAL();
+        return BUS_ERROR;
+    }
+
+    ow_hw_drive_low();
+    ow_hw_delay_us(500);
+    ow_hw_release();
+
+    ow_hw_delay_us(60);
+    if (ow_hw_read() != 0)
+    {
+        OW_EXIT_CRITICAL();
+        return PRESENCE_ERROR;
+    }
+    OW_EXIT_CRITICAL();
+
+    ow_hw_delay_us(240);
+
+    return NO_ERROR;
+}
+////////////////////////////////////////////////////////////////////////////
+
+void ow_write_bit(uint8_t bit)
+{
+    OW_ENTER_CRITICAL();
+    ow_hw_drive_low(); // pull low for 2us
+    ow_hw_delay_us(2);
+    if (bit)
+        ow_hw_release();
+    ow_hw_delay_us(60);
+    OW_EXIT_CRITICAL();
+    ow_hw_release(); // return bus
+}
+////////////////////////////////////////////////////////////////////////////
+
+uint8_t ow_read_bit(void)
+{
+    uint8_t bit;
+    ow_hw_delay_us(1);
+    OW_ENTER_CRITICAL();
+    ow_hw_drive_low(); // pull low for 1us
+    ow_hw_delay_us(1);
+    ow_hw_release(); // give bus back to the device
+    ow_hw_delay_us(5);
+    bit = ow_hw_read();
+    ow_hw_delay_us(56);
+    OW_EXIT_CRITICAL();
+    return bit ? 1 : 0;
+}
+////////////////////////////////////////////////////////////////////////////
+
+void ow_write_byte(uint8_t byte)
+{
+    int ii;
+
+    ow_hw_delay_us(100);
+    OW_ENTER_CRITICAL();
+    for (ii = 0; ii < 8; ii++)
+    {
+        ow_write_bit(byte & 0x01);
+        byte = byte >> 1;
+    }
+    OW_EXIT_CRITICAL();
+}
+////////////////////////////////////////////////////////////////////////////
+
+uint8_t ow_read_byte(void)
+{
+    int ii;
+    uint8_t byte = 0;
+
+    OW_ENTER_CRITICAL();
+    ow_hw_delay_us(1);
+    for (ii = 0; ii < 8; ii++)
+    {
+        byte = byte >> 1;
+        if (ow_read_bit())
+            byte |= 0x80;
+    }
+    OW_EXIT_CRITICAL();
+    return byte;
+}
+////////////////////////////////////////////////////////////////////////////
+
+void ow_match_rom(const uint8_t *rom)
+{
+    int ii;
+
+    ow_write_byte(MATCH_ROM);
+    for (ii = 0; ii < 8; ii++)
+        ow_write_byte(rom[ii]);
+}
+////////////////////////////////////////////////////////////////////////////
+
+// Only meaningful with a single device on the bus.
+uint8_t ow_read_rom(uint8_t *rom)
+{
+    uint8_t ii, err;
+
+    err = ow_reset();
+    if (err != NO_ERROR)
+        return err;
+
+    ow_write_byte(READ_ROM);
+    OW_ENTER_CRITICAL();
+    for (ii = 0; ii < 8; ii++)
+        rom[ii] = ow_read_byte();
+    OW_EXIT_CRITICAL();
+
+    return NO_ERROR;
+}
+////////////////////////////////////////////////////////////////////////////
+
+uint8_t ow_crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    uint8_t ii, byte;
+
+    while (len--)
+    {
+        byte = *data++;
+        for (ii = 0; ii < 8; ii++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+////////////////////////////////////////////////////////////////////////////
+
+static uint8_t ow_search(uint8_t *rom, uint8_t command)
+{
+    uint8_t bit_number;
+    uint8_t last_zero = 0;
+    uint8_t id_bit, cmp_id_bit, direction;
+
+    if (last_device)
+        return 0;
+
+    if (ow_reset() != NO_ERROR)
+    {
+        last_discrepancy = 0;
+        return 0;
+    }
+
+    ow_write_byte(command);
+
+    for (bit_number = 1; bit_number <= 64; bit_number++)
+    {
+        uint8_t byte = (bit_number - 1) >> 3;
+        uint8_t mask = 1 << ((bit_number - 1) & 7);
+
+        id_bit     = ow_read_bit();
+        cmp_id_bit = ow_read_bit();
+
+        if (id_bit && cmp_id_bit)
+        {
+            // nobody answered
+            last_discrepancy = 0;
+            return 0;
+        }
+
+        if (id_bit != cmp_id_bit)
+        {
+            direction = id_bit;
+        }
+        else
+        {
+            // collision: devices with both values are still listening
+            if (bit_number < last_discrepancy)
+                direction = (search_rom[byte] & mask) ? 1 : 0;
+            else
+                direction = (bit_number == last_discrepancy);
+
+            if (direction == 0)
+                last_zero = bit_number;
+        }
+
+        if (direction)
+            search_rom[byte] |= mask;
+        else
+            search_rom[byte] &= ~mask;
+
+        ow_write_bit(direction);
+    }
+
+    last_discrepancy = last_zero;
+    if (last_discrepancy == 0)
+        last_device = 1;
+
+    if (ow_crc8(search_rom, 8) != 0)
+    {
+        last_discrepancy = 0;
+        last_device = 0;
+        return 0;
+    }
+
+    memcpy(rom, search_rom, 8);
+    return 1;
+}
+
+uint8_t ow_search_first(uint8_t *rom, uint8_t command)
+{
+    last_discrepancy = 0;
+    last_device = 0;
+    memset(search_rom, 0, sizeof(search_rom));
+    return ow_search(rom, command);
+}
+
+uint8_t ow_search_next(uint8_t *rom, uint8_t command)
+{
+    return ow_search(rom, command);
+}
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef ONEWIRE_SIM
+
+// BUS COMMANDS
+#define DQ_IN()  {DS1820_PORT->CRH&=0xFFFFF0FF;DS1820_PORT->CRH |= 0x00000400;}
+#define DQ_OUT() {DS1820_PORT->CRH&=0xFFFFF0FF;DS1820_PORT->CRH |= 0x00000300;}
+#define DQ_SET()   GPIO_SetBits(DS1820_PORT, DS1820_PIN)
+#define DQ_RESET() GPIO_ResetBits(DS1820_PORT, DS1820_PIN)
+#define DQ_READ()  GPIO_ReadInputDataBit(DS1820_PORT, DS1820_PIN)
+
+void ow_hw_init(void)
+{
+    // intialise timer 2 for counting
+    TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+    TIM_TimeBaseStructure.TIM_Period = 1;
+    TIM_TimeBaseStructure.TIM_Prescaler = 72;       //72MHz->1MHz
+    TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Down;
+    TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
+
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    // PC10-DQ
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOC, ENABLE);
+
+    GPIO_InitStructure.GPIO_Pin =  DS1820_PIN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_Init(DS1820_PORT, &GPIO_InitStructure);
+}
+
+void ow_hw_drive_low(void)
+{
+    DQ_OUT();
+    DQ_SET(); // make sure bus is high
+    DQ_RESET();
+}
+
+void ow_hw_release(void)
+{
+    DQ_IN();
+}
+
+uint8_t ow_hw_read(void)
+{
+    return DQ_READ();
+}
+
+void ow_hw_delay_us(uint16_t count)
+{
+    uint16_t TIMCounter = count;
+    TIM_Cmd(TIM2, ENABLE);
+    TIM_SetCounter(TIM2, TIMCounter);
+    while (TIMCounter)
+    {
+        TIMCounter = TIM_GetCounter(TIM2);
+    }
+    TIM_Cmd(TIM2, DISABLE);
+}
+
+#endif
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ONEWIRE_H
+#define ONEWIRE_H
+
+#include <stdint.h>
+
+// ERROR DEFINES
+#define BUS_ERROR      0xFE
+#define PRESENCE_ERROR 0xFD
+#define NO_ERROR       0x00
+
+// ROM COMMANDS
+#define MATCH_ROM	0x55
+#define	SEARCH_ROM	0xF0
+#define SKIP_ROM	0xCC
+#define READ_ROM        0x33
+#define ALARM_SEARCH    0xEC
+
+unsigned char ow_reset(void);
+void          ow_write_bit(uint8_t bit);
+uint8_t       ow_read_bit(void);
+void          ow_write_byte(uint8_t byte);
+uint8_t       ow_read_byte(void);
+void          ow_match_rom(const uint8_t *rom);
+uint8_t       ow_read_rom(uint8_t *rom);
+
+// ROM search (Maxim AN187). ow_search_first() restarts the search,
+// ow_search_next() returns the following device. Both return 1 and fill
+// rom[] when a device with a valid ROM CRC was found, 0 otherwise.
+uint8_t       ow_search_first(uint8_t *rom, uint8_t command);
+uint8_t       ow_search_next(uint8_t *rom, uint8_t command);
+
+// Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1). A block with its trailing
+// CRC byte included yields 0.
+uint8_t       ow_crc8(const uint8_t *data, uint8_t len);
+
+//
+// Bus binding. On the target these are the GPIO/TIM2 routines at the
+// bottom of onewire.c. Building with ONEWIRE_SIM defined drops them so
+// host/onewire_sim.c can supply its own.
+//
+void          ow_hw_init(void);
+void          ow_hw_drive_low(void);
+void          ow_hw_release(void);
+uint8_t       ow_hw_read(void);
+void          ow_hw_delay_us(uint16_t count);
+
+#endif
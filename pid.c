@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Integer PID loop. The derivative acts on the measurement rather than the
+// error so setpoint steps don't kick the output. The integral is clamped
+// to the output range and only grows while the output is not already
+// saturated in the same direction, so it does not wind up while the
+// elements are flat out heating a cold vessel.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "pid.h"
+
+static int32_t clamp(int64_t val, int32_t lo, int32_t hi)
+{
+    if (val < lo)
+        return lo;
+    if (val > hi)
+        return hi;
+    return (int32_t)val;
+}
+
+void pid_init(struct pid *pid, int32_t kp, int32_t ki, int32_t kd,
+              int32_t out_min, int32_t out_max)
+{
+    memset(pid, 0, sizeof(*pid));
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    pid_set_gains(pid, kp, ki, kd);
+    pid_reset(pid, out_min);
+}
+
+void pid_set_gains(struct pid *pid, int32_t kp, int32_t ki, int32_t kd)
+{
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+}
+
+void pid_set_feedforward(struct pid *pid, int32_t feedforward)
+{
+    pid->feedforward = feedforward;
+}
+
+void pid_reset(struct pid *pid, int32_t output)
+{
+    pid->output = clamp(output, pid->out_min, pid->out_max);
+    pid->integral = (pid->output - pid->feedforward) << PID_Q;
+    pid->primed = 0;
+}
+
+int32_t pid_update(struct pid *pid, int32_t setpoint, int32_t input)
+{
+    int32_t lo = (pid->out_min - pid->feedforward) << PID_Q;
+    int32_t hi = (pid->out_max - pid->feedforward) << PID_Q;
+    int32_t error = setpoint - input;
+    int64_t p, d, out;
+
+    if (!pid->primed)
+    {
+        pid->last_input = input;
+        pid->primed = 1;
+    }
+
+    p = (int64_t)pid->kp * error;
+    d = -(int64_t)pid->kd * (input - pid->last_input);
+    pid->last_input = input;
+
+    // conditional integration: hold the integral while the output is
+    // pinned at a limit and the error would push it further
+    if (!((pid->output >= pid->out_max && error > 0) ||
+          (pid->output <= pid->out_min && error < 0)))
+    {
+        pid->integral = clamp(pid->integral + (int64_t)pid->ki * error, lo, hi);
+    }
+
+    out = p + pid->integral + d + ((int64_t)pid->feedforward << PID_Q);
+    pid->output = clamp(out >> PID_Q, pid->out_min, pid->out_max);
+    return pid->output;
+}
+
+void pid_track(struct pid *pid, int32_t applied)
+{
+    int32_t lo = (pid->out_min - pid->feedforward) << PID_Q;
+    int32_t hi = (pid->out_max - pid->feedforward) << PID_Q;
+
+    if (applied >= pid->output)
+        return;
+    pid->integral = clamp(pid->integral - ((int64_t)(pid->output - applied) << PID_Q), lo, hi);
+    pid->output = applied;
+}
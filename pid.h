@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PID_H
+#define PID_H
+
+#include <stdint.h>
+
+// Gains are fixed point with PID_Q fractional bits. The loop runs at a
+// fixed rate, so the sample time is folded into ki and kd: ki is output
+// per unit of error per sample, kd is output per unit change of input
+// between samples.
+#define PID_Q     8
+#define PID_ONE   (1 << PID_Q)
+
+struct pid
+{
+    int32_t kp;
+    int32_t ki;
+    int32_t kd;
+    int32_t out_min;
+    int32_t out_max;
+    int32_t integral;     // output units << PID_Q
+    int32_t last_input;
+    int32_t output;
+    int32_t feedforward;  // added to the output, output units
+    uint8_t primed;       // last_input is valid
+};
+
+void    pid_init(struct pid *pid, int32_t kp, int32_t ki, int32_t kd,
+                 int32_t out_min, int32_t out_max);
+void    pid_set_gains(struct pid *pid, int32_t kp, int32_t ki, int32_t kd);
+
+// Start again from the given output without a bump, eg. when switching
+// from manual control to the loop.
+void    pid_reset(struct pid *pid, int32_t output);
+
+// Output the loop adds its correction to, eg. from a plant model. The
+// integral then only makes up what the feed-forward gets wrong.
+void    pid_set_feedforward(struct pid *pid, int32_t feedforward);
+
+// The output actually applied was less than asked for, eg. the element
+// was held back. Unwinds the integral by the shortfall so it does not
+// keep growing over power the loop was never given.
+void    pid_track(struct pid *pid, int32_t applied);
+
+// One sample. Returns the new output, clamped to out_min..out_max.
+int32_t pid_update(struct pid *pid, int32_t setpoint, int32_t input);
+
+#endif
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Element load scheduler. The elements together draw more than the
+// supply breaker will carry, so rather than each one switching on at the
+// start of the window, their on slots are placed so the current in every
+// slot stays within the budget. A load that cannot have all it asked for
+// gets what is left, lowest priority first to go short.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "power.h"
+
+void power_schedule(struct power_load *loads, uint8_t n, uint16_t budget_ma)
+{
+    uint16_t headroom[POWER_SLOTS];
+    uint8_t  order[8];
+    uint8_t  start = 0;
+    int ii, jj;
+
+    if (n > sizeof(order))
+        n = sizeof(order);
+
+    for (ii = 0; ii < POWER_SLOTS; ii++)
+        headroom[ii] = budget_ma;
+
+    // highest priority first, in channel order within a priority
+    for (ii = 0; ii < n; ii++)
+    {
+        for (jj = ii; jj > 0 && loads[order[jj - 1]].priority < loads[ii].priority; jj--)
+            order[jj] = order[jj - 1];
+        order[jj] = ii;
+    }
+
+    for (ii = 0; ii < n; ii++)
+    {
+        struct power_load *ld = &loads[order[ii]];
+        int last = start;
+        int kk;
+
+        memset(ld->mask, 0, sizeof(ld->mask));
+        ld->granted = 0;
+
+        for (kk = 0; kk < POWER_SLOTS && ld->granted < ld->slots; kk++)
+        {
+            int slot = (start + kk) % POWER_SLOTS;
+
+            if (headroom[slot] < ld->ma)
+                continue;
+            headroom[slot] -= ld->ma;
+            ld->mask[slot >> 5] |= 1UL << (slot & 31);
+            ld->granted++;
+            last = slot + 1;
+        }
+        start = last % POWER_SLOTS;
+    }
+}
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// Slots in a time-proportioning window, one bit each in a mask
+#define POWER_SLOTS       100
+#define POWER_MASK_WORDS  ((POWER_SLOTS + 31) / 32)
+
+#define POWER_SLOT_ON(mask, slot) (((mask)[(slot) >> 5] >> ((slot) & 31)) & 1)
+
+enum power_priority
+{
+    POWER_PRIO_LOW,      // eg. HLT pre-heat, can wait
+    POWER_PRIO_NORMAL,
+    POWER_PRIO_HIGH      // eg. holding the boil
+};
+
+struct power_load
+{
+    uint16_t ma;         // current drawn while on
+    uint8_t  priority;
+    uint8_t  slots;      // asked for this window
+    uint8_t  granted;    // slots it got
+    uint32_t mask[POWER_MASK_WORDS];
+};
+
+// Lays the loads' slots out over the window so the summed current in
+// any slot stays within budget_ma. Higher priorities are placed first
+// and get all they ask for if it fits; each load starts where the last
+// one finished so they interleave rather than stack up at the start of
+// the window.
+void power_schedule(struct power_load *loads, uint8_t n, uint16_t budget_ma);
+
+#endif
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Reads recipe images laid out as described in recipe.h. Apart from
+// recipe_image() nothing here depends on the target, so host/recipec.c
+// links this file to verify the images it writes.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "recipe.h"
+#include "heater.h"
+
+typedef char recipe_step_size_check[sizeof(struct brew_step) == 16 ? 1 : -1];
+typedef char recipe_dir_size_check[sizeof(struct recipe_dir_entry) == 32 ? 1 : -1];
+
+// CRC-32 (IEEE 802.3), a nibble at a time to keep the table small
+uint32_t recipe_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    static const uint32_t table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t *pp = data;
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *pp++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+uint8_t recipe_check(const uint8_t *image, uint32_t max_size)
+{
+    const struct recipe_header *hdr = (const struct recipe_header *)image;
+
+    if (hdr->magic != RECIPE_MAGIC)
+        return RECIPE_BAD_MAGIC;
+    if (hdr->version != RECIPE_VERSION)
+        return RECIPE_BAD_VERSION;
+    if (hdr->size < RECIPE_STEPS_OFFSET || hdr->size > max_size ||
+        hdr->count > RECIPE_DIR_SLOTS)
+        return RECIPE_BAD_SIZE;
+    if (recipe_crc32(0, image + sizeof(*hdr), hdr->size - sizeof(*hdr)) != hdr->crc)
+        return RECIPE_BAD_CRC;
+    return RECIPE_OK;
+}
+
+uint8_t recipe_count(const uint8_t *image)
+{
+    return ((const struct recipe_header *)image)->count;
+}
+
+const struct recipe_dir_entry *recipe_entry(const uint8_t *image, uint8_t index)
+{
+    if (index >= recipe_count(image))
+        return NULL;
+    return (const struct recipe_dir_entry *)(image + RECIPE_DIR_OFFSET) + index;
+}
+
+int recipe_find(const uint8_t *image, const char *name)
+{
+    uint8_t ii;
+
+    for (ii = 0; ii < recipe_count(image); ii++)
+    {
+        if (strncmp(recipe_entry(image, ii)->name, name, RECIPE_NAME_LEN) == 0)
+            return ii;
+    }
+    return -1;
+}
+
+uint8_t recipe_load(const uint8_t *image, uint8_t index, struct brew_recipe *recipe)
+{
+    const struct recipe_header *hdr = (const struct recipe_header *)image;
+    const struct recipe_dir_entry *ent = recipe_entry(image, index);
+    uint32_t len;
+    uint8_t ii;
+
+    if (!ent)
+        return RECIPE_NOT_FOUND;
+
+    len = ent->n_steps * sizeof(struct brew_step);
+    if (ent->n_steps > BREW_MAX_STEPS || ent->offset < RECIPE_STEPS_OFFSET ||
+        ent->offset + len > hdr->size)
+        return RECIPE_BAD_SIZE;
+    if (recipe_crc32(0, image + ent->offset, len) != ent->crc)
+        return RECIPE_BAD_CRC;
+
+    memset(recipe, 0, sizeof(*recipe));
+    memcpy(recipe->name, ent->name, RECIPE_NAME_LEN);
+    recipe->name[RECIPE_NAME_LEN - 1] = 0;
+    recipe->n_steps = ent->n_steps;
+    memcpy(recipe->steps, image + ent->offset, len);
+
+    // the brew task indexes its step table and the heaters with these
+    for (ii = 0; ii < recipe->n_steps; ii++)
+    {
+        const struct brew_step *step = &recipe->steps[ii];
+
+        if (step->type >= BREW_STEP_TYPES || step->vessel >= HEATER_COUNT ||
+            step->hops > BREW_MAX_HOPS)
+        {
+            memset(recipe, 0, sizeof(*recipe));
+            return RECIPE_BAD_STEP;
+        }
+    }
+    return RECIPE_OK;
+}
+
+#ifndef RECIPE_HOST
+// Region reserved in stm32_flash.ld
+extern const uint8_t __recipe_start[];
+extern const uint8_t __recipe_end[];
+
+const uint8_t *recipe_image(void)
+{
+    static int8_t valid = -1;
+
+    if (valid < 0)
+        valid = recipe_check(__recipe_start, __recipe_end - __recipe_start) == RECIPE_OK;
+    return valid ? __recipe_start : NULL;
+}
+#endif
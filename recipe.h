@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Recipes and their binary image. The image is built on the PC by
+// host/recipec.c and written to its own internal flash region (see
+// stm32_flash.ld). Everything in it is fixed size, so a recipe is found
+// by indexing the directory and loaded with a single copy.
+//
+//   struct recipe_header                 16 bytes
+//   struct recipe_dir_entry [16]         32 bytes each
+//   struct brew_step records             16 bytes each, per recipe
+//
+// All fields are little endian, as on both the target and the PC.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef RECIPE_H
+#define RECIPE_H
+
+#include <stdint.h>
+
+#define BREW_MAX_STEPS    16
+#define BREW_MAX_HOPS     6
+#define RECIPE_NAME_LEN   24
+
+enum brew_step_type
+{
+    BREW_FILL,      // operator fills the vessel and presses NEXT
+    BREW_HEAT,      // heat to temp, then keep holding it
+    BREW_MASH,      // basket down, hold temp for minutes
+    BREW_SPARGE,    // basket up, drain for minutes
+    BREW_BOIL,      // full power, minutes from reaching temp, hop alarms
+    BREW_CHILL,     // elements off until below temp
+    BREW_STEP_TYPES
+};
+
+// Also the on-flash step record, so keep it at 16 bytes
+struct brew_step
+{
+    uint8_t  type;
+    uint8_t  vessel;                     // heater channel
+    int16_t  temp;                       // hundredths of a degree
+    uint16_t minutes;
+    uint16_t timeout;                    // minutes in the step, 0 for none
+    uint8_t  hops;
+    uint8_t  hop_minutes[BREW_MAX_HOPS]; // before the end of the boil
+    uint8_t  reserved;
+};
+
+struct brew_recipe
+{
+    char     name[RECIPE_NAME_LEN];
+    uint8_t  n_steps;
+    struct brew_step steps[BREW_MAX_STEPS];
+};
+
+#define RECIPE_MAGIC      0x31504352UL   // "RCP1"
+#define RECIPE_VERSION    1
+#define RECIPE_DIR_SLOTS  16
+#define RECIPE_MAX_SIZE   (16 * 1024)
+
+struct recipe_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;        // directory slots in use
+    uint32_t size;         // whole image in bytes
+    uint32_t crc;          // CRC-32 of everything after the header
+};
+
+struct recipe_dir_entry
+{
+    char     name[RECIPE_NAME_LEN];
+    uint16_t offset;       // first step record, from the start of the image
+    uint8_t  n_steps;
+    uint8_t  flags;
+    uint32_t crc;          // CRC-32 of this recipe's step records
+};
+
+#define RECIPE_DIR_OFFSET   sizeof(struct recipe_header)
+#define RECIPE_STEPS_OFFSET (RECIPE_DIR_OFFSET + RECIPE_DIR_SLOTS * sizeof(struct recipe_dir_entry))
+
+enum recipe_error
+{
+    RECIPE_OK,
+    RECIPE_BAD_MAGIC,
+    RECIPE_BAD_VERSION,
+    RECIPE_BAD_SIZE,
+    RECIPE_BAD_CRC,
+    RECIPE_NOT_FOUND,
+    RECIPE_BAD_STEP        // type, vessel or hop count out of range
+};
+
+uint32_t recipe_crc32(uint32_t crc, const void *data, uint32_t len);
+
+// Checks the header and whole image CRC.
+uint8_t  recipe_check(const uint8_t *image, uint32_t max_size);
+
+// Directory lookups on an image that has passed recipe_check().
+// recipe_load() also checks each step's type, vessel and hop count.
+uint8_t  recipe_count(const uint8_t *image);
+const struct recipe_dir_entry *recipe_entry(const uint8_t *image, uint8_t index);
+int      recipe_find(const uint8_t *image, const char *name);
+uint8_t  recipe_load(const uint8_t *image, uint8_t index, struct brew_recipe *recipe);
+
+#ifndef RECIPE_HOST
+// The image in flash, or NULL when the region does not hold a valid one.
+// The check is done once and remembered.
+const uint8_t *recipe_image(void);
+#endif
+
+#endif
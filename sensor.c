@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Temperature probe fault detection. Each reading is checked for what a
+// DS1820 on a long cable actually does when it goes wrong: drops off the
+// bus, gets the bus shorted, returns a corrupted scratchpad, reads a
+// value no vessel could be at, jumps further than the water can move in
+// the time, or sits on one value while the element is driving it. One
+// bad reading makes the probe SUSPECT and the last good value stands; a
+// few in a row fail it. It takes a run of good readings to come back, so
+// a flaky connector doesn't flap the heater between modes.
+//
+// No RTOS calls in here so it can be driven from a host bench.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor.h"
+
+// Written only by the probe task. The entry is filled in before the
+// count moves on, and a reader would need SENSOR_LOG_SIZE more changes
+// while it copies one out to see it torn.
+static struct sensor_event event_log[SENSOR_LOG_SIZE];
+static volatile uint32_t event_count;
+
+static const char *state_names[] = { "OK", "SUSPECT", "FAILED" };
+
+static const char *fault_names[] =
+{
+    "", "open", "shorted", "CRC", "stuck", "slew", "range"
+};
+
+void sensor_init(struct sensor *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->state = SENSOR_OK;
+}
+
+static void sensor_log(uint8_t id, struct sensor *s, int32_t value, unsigned long time)
+{
+    struct sensor_event *ev = &event_log[event_count % SENSOR_LOG_SIZE];
+
+    ev->time_ms = time;
+    ev->sensor  = id;
+    ev->state   = s->state;
+    ev->fault   = s->fault;
+    ev->value   = value;
+    event_count++;
+}
+
+static uint8_t sensor_check(struct sensor *s, uint8_t read, int32_t c100,
+                            unsigned long time, uint8_t expect_change)
+{
+    switch (read)
+    {
+    case SENSOR_READ_OK:
+        break;
+    case SENSOR_READ_ABSENT:
+        return SENSOR_FAULT_OPEN;
+    case SENSOR_READ_SHORT:
+        return SENSOR_FAULT_SHORTED;
+    default:
+        return SENSOR_FAULT_CRC;
+    }
+
+    if (c100 < SENSOR_MIN_C100 || c100 > SENSOR_MAX_C100)
+        return SENSOR_FAULT_RANGE;
+
+    if (!s->primed)
+        return SENSOR_FAULT_NONE;
+
+    // Against the last reading rather than the last good one, so a single
+    // spike costs two readings but a real step (probe moved to another
+    // vessel) is believed once it holds.
+    if (time - s->prev_time < SENSOR_SLEW_GAP_MS)
+    {
+        int32_t step = c100 - s->prev_raw;
+        unsigned long dt = time - s->prev_time;
+
+        if (step < 0)
+            step = -step;
+        if (dt == 0 || (unsigned long)step * 1000 > (unsigned long)SENSOR_MAX_SLEW * dt)
+            return SENSOR_FAULT_SLEW;
+    }
+
+    if (expect_change && c100 == s->prev_raw)
+    {
+        if (s->same < SENSOR_STUCK_SAMPLES)
+            s->same++;
+        if (s->same >= SENSOR_STUCK_SAMPLES)
+            return SENSOR_FAULT_STUCK;
+    }
+    else
+        s->same = 0;
+
+    return SENSOR_FAULT_NONE;
+}
+
+uint8_t sensor_update(struct sensor *s, uint8_t id, uint8_t read, int32_t c100,
+                      unsigned long time, uint8_t expect_change)
+{
+    uint8_t fault = sensor_check(s, read, c100, time, expect_change);
+    uint8_t state = s->state;
+
+    if (read == SENSOR_READ_OK)
+    {
+        s->prev_raw  = c100;
+        s->prev_time = time;
+        s->primed    = 1;
+    }
+
+    if (fault == SENSOR_FAULT_NONE)
+    {
+        s->value = c100;
+        s->bad = 0;
+        if (s->good < SENSOR_RECOVER_SAMPLES)
+            s->good++;
+
+        // a SUSPECT probe only missed a reading or two
+        if (state == SENSOR_SUSPECT ||
+            (state == SENSOR_FAILED && s->good >= SENSOR_RECOVER_SAMPLES))
+        {
+            s->state = SENSOR_OK;
+            s->fault = SENSOR_FAULT_NONE;
+        }
+    }
+    else
+    {
+        s->good = 0;
+        if (s->bad < SENSOR_FAIL_SAMPLES)
+            s->bad++;
+
+        // stuck has already had minutes to show itself
+        if (s->bad >= SENSOR_FAIL_SAMPLES || fault == SENSOR_FAULT_STUCK)
+            s->state = SENSOR_FAILED;
+        else if (state == SENSOR_OK)
+            s->state = SENSOR_SUSPECT;
+
+        // a FAILED probe keeps the fault that failed it
+        if (state != SENSOR_FAILED)
+            s->fault = fault;
+    }
+
+    if (s->state != state)
+        sensor_log(id, s, c100, time);
+
+    return s->state;
+}
+
+uint32_t sensor_event_count(void)
+{
+    return event_count;
+}
+
+uint8_t sensor_get_event(uint32_t nth, struct sensor_event *ev)
+{
+    uint32_t count = event_count;
+
+    if (nth >= count || nth >= SENSOR_LOG_SIZE)
+        return 0;
+    *ev = event_log[(count - 1 - nth) % SENSOR_LOG_SIZE];
+    return 1;
+}
+
+void sensor_clear_log(void)
+{
+    event_count = 0;
+}
+
+const char *sensor_state_name(uint8_t state)
+{
+    if (state >= sizeof(state_names) / sizeof(state_names[0]))
+        return "?";
+    return state_names[state];
+}
+
+const char *sensor_fault_name(uint8_t fault)
+{
+    if (fault >= sizeof(fault_names) / sizeof(fault_names[0]))
+        return "?";
+    return fault_names[fault];
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <stdint.h>
+
+// How a read of the probe went, from the bus driver
+enum sensor_read
+{
+    SENSOR_READ_OK,
+    SENSOR_READ_ABSENT,    // no presence pulse, or nothing answered its ROM
+    SENSOR_READ_SHORT,     // bus held low
+    SENSOR_READ_CRC        // scratchpad failed its CRC
+};
+
+enum sensor_state
+{
+    SENSOR_OK,
+    SENSOR_SUSPECT,        // the last few readings were bad, the last good one stands
+    SENSOR_FAILED
+};
+
+enum sensor_fault
+{
+    SENSOR_FAULT_NONE,
+    SENSOR_FAULT_OPEN,
+    SENSOR_FAULT_SHORTED,
+    SENSOR_FAULT_CRC,
+    SENSOR_FAULT_STUCK,    // not moving while the element is driving it
+    SENSOR_FAULT_SLEW,     // jumped further than a vessel can
+    SENSOR_FAULT_RANGE
+};
+
+#define SENSOR_NONE            0xFF
+
+#define SENSOR_FAIL_SAMPLES    3      // bad readings in a row to fail
+#define SENSOR_RECOVER_SAMPLES 5      // good readings in a row to come back
+#define SENSOR_MIN_C100        -2000
+#define SENSOR_MAX_C100        12000
+#define SENSOR_MAX_SLEW        50     // hundredths of a degree a second
+#define SENSOR_SLEW_GAP_MS     30000  // readings further apart aren't compared
+#define SENSOR_STUCK_SAMPLES   150    // 5 minutes of identical readings
+
+#define SENSOR_LOG_SIZE        16
+
+struct sensor
+{
+    uint8_t  state;
+    uint8_t  fault;        // why it is SUSPECT or FAILED
+    uint8_t  bad;          // bad readings in a row
+    uint8_t  good;         // good readings in a row
+    uint16_t same;         // unchanged readings while expected to move
+    uint8_t  primed;
+    int32_t  value;        // last good reading
+    int32_t  prev_raw;     // last reading, good or not, for the slew check
+    unsigned long prev_time;
+};
+
+struct sensor_event
+{
+    unsigned long time_ms;
+    uint8_t  sensor;
+    uint8_t  state;
+    uint8_t  fault;
+    int32_t  value;        // the reading that caused it
+};
+
+void     sensor_init(struct sensor *s);
+
+// One reading of sensor number id at time ms. expect_change says the
+// temperature should be moving, eg. an element is on flat out, which is
+// the only time a reading that never changes counts against it. Returns
+// the new state; s->value is the reading consumers should use.
+uint8_t  sensor_update(struct sensor *s, uint8_t id, uint8_t read, int32_t c100,
+                       unsigned long time, uint8_t expect_change);
+
+// Every state change is logged. nth 0 is the most recent; returns 0 past
+// the end of the log.
+uint32_t sensor_event_count(void);
+uint8_t  sensor_get_event(uint32_t nth, struct sensor_event *ev);
+void     sensor_clear_log(void);
+
+const char *sensor_state_name(uint8_t state);
+const char *sensor_fault_name(uint8_t fault);
+
+#endif
@@ -0,0 +1,302 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// SPI flash service, see sflash.h. A command goes out as a few polled
+// bytes, the opcode and address, then the data by DMA: SPI1_RX on
+// channel 2 and SPI1_TX on channel 3 always run together, with a fixed
+// 0xFF byte as the source for reads and a sink byte as the destination
+// for programs, and the RX transfer complete interrupt wakes the task.
+// A program or erase is finished, and only then signalled, when the
+// status register's WIP bit clears, and has failed if it hasn't by its
+// timeout.
+//
+// FAST_READ has a dummy byte after the address and is good to 50MHz
+// where READ is only good to 20MHz; SPI1 is at 18MHz, the most the F103
+// does, so it buys headroom rather than speed.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "sflash.h"
+#include "spibus.h"
+
+#define M25P_WREN      0x06
+#define M25P_RDSR      0x05
+#define M25P_PP        0x02
+#define M25P_SE        0xD8
+#define M25P_FAST_READ 0x0B
+#define M25P_WIP       0x01
+
+#define RX_DMA         DMA1_Channel2
+#define TX_DMA         DMA1_Channel3
+
+static xQueueHandle queue;           // reads and programs
+static xQueueHandle erase_queue;
+static xSemaphoreHandle work;        // given on every submit
+static xSemaphoreHandle dma_done;
+
+static const uint8_t ones = 0xFF;
+static uint8_t sink;
+
+static void cs_low(void)
+{
+    GPIO_ResetBits(GPIOA, GPIO_Pin_4);
+}
+
+static void cs_high(void)
+{
+    GPIO_SetBits(GPIOA, GPIO_Pin_4);
+}
+
+static uint8_t send_byte(uint8_t byte)
+{
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) == RESET)
+        ;
+    SPI_I2S_SendData(SPI1, byte);
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET)
+        ;
+    return SPI_I2S_ReceiveData(SPI1);
+}
+
+static void command(uint8_t op, uint32_t addr)
+{
+    cs_low();
+    send_byte(op);
+    send_byte(addr >> 16);
+    send_byte(addr >> 8);
+    send_byte(addr);
+}
+
+static void write_enable(void)
+{
+    cs_low();
+    send_byte(M25P_WREN);
+    cs_high();
+}
+
+// A transfer that never finished leaves the channels' flags and SPI1's
+// receive side part way; both are put back for the next one
+static void dma_reset(void)
+{
+    DMA_ClearFlag(DMA1_FLAG_GL2 | DMA1_FLAG_GL3);
+    xSemaphoreTake(dma_done, 0);        // in case it finished after all
+    SPI_Cmd(SPI1, DISABLE);
+    SPI_I2S_ReceiveData(SPI1);          // the byte left, and clears OVR
+    SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_OVR);
+    SPI_Cmd(SPI1, ENABLE);
+}
+
+// rx or tx NULL for the fixed byte. Returns 0 if it never finished.
+static uint8_t dma(uint8_t *rx, const uint8_t *tx, uint16_t len)
+{
+    uint8_t ok;
+
+    RX_DMA->CMAR = (uint32_t)(rx ? rx : &sink);
+    RX_DMA->CNDTR = len;
+    if (rx)
+        RX_DMA->CCR |= DMA_CCR1_MINC;
+    else
+        RX_DMA->CCR &= ~DMA_CCR1_MINC;
+
+    TX_DMA->CMAR = (uint32_t)(tx ? tx : &ones);
+    TX_DMA->CNDTR = len;
+    if (tx)
+        TX_DMA->CCR |= DMA_CCR1_MINC;
+    else
+        TX_DMA->CCR &= ~DMA_CCR1_MINC;
+
+    // RX first so it is ready for the first byte
+    RX_DMA->CCR |= DMA_CCR1_EN;
+    TX_DMA->CCR |= DMA_CCR1_EN;
+    ok = xSemaphoreTake(dma_done, SFLASH_DMA_TIMEOUT_MS / portTICK_RATE_MS) == pdTRUE;
+    RX_DMA->CCR &= ~DMA_CCR1_EN;
+    TX_DMA->CCR &= ~DMA_CCR1_EN;
+    if (!ok)
+        dma_reset();
+    return ok;
+}
+
+// Sleeps between polls, letting the bus go. Returns 0 if the chip is
+// still busy after timeout_ms.
+static uint8_t wait_ready(uint16_t poll_ms, uint16_t timeout_ms)
+{
+    portTickType start = xTaskGetTickCount();
+    uint8_t status;
+
+    for (;;)
+    {
+        spibus_take(SPIBUS_FLASH);
+        cs_low();
+        send_byte(M25P_RDSR);
+        status = send_byte(0xFF);
+        cs_high();
+        spibus_give();
+        if (!(status & M25P_WIP))
+            return 1;
+        if ((portTickType)(xTaskGetTickCount() - start) >= timeout_ms / portTICK_RATE_MS)
+            return 0;
+        vTaskDelay(poll_ms / portTICK_RATE_MS);
+    }
+}
+
+static uint8_t run(struct sflash_req *req)
+{
+    uint8_t ok = 1;
+
+    switch (req->op)
+    {
+    case SFLASH_READ:
+        spibus_take(SPIBUS_FLASH);
+        command(M25P_FAST_READ, req->addr);
+        send_byte(0xFF);
+        ok = dma(req->buf, NULL, req->len);
+        cs_high();
+        spibus_give();
+        break;
+
+    case SFLASH_PROGRAM:
+        spibus_take(SPIBUS_FLASH);
+        write_enable();
+        command(M25P_PP, req->addr);
+        ok = dma(NULL, req->buf, req->len);
+        cs_high();
+        spibus_give();
+        // a cut short transfer still programs what got there
+        if (!wait_ready(SFLASH_PROGRAM_POLL_MS, SFLASH_PROGRAM_TIMEOUT_MS))
+            ok = 0;
+        break;
+
+    case SFLASH_ERASE:
+        spibus_take(SPIBUS_FLASH);
+        write_enable();
+        command(M25P_SE, req->addr);
+        cs_high();
+        spibus_give();
+        ok = wait_ready(SFLASH_ERASE_POLL_MS, SFLASH_ERASE_TIMEOUT_MS);
+        break;
+    }
+    return ok;
+}
+
+void vSFlashTask( void *pvParameters )
+{
+    struct sflash_req *req;
+
+    for (;;)
+    {
+        // erases only when nothing else is waiting
+        if (xQueueReceive(queue, &req, 0) != pdTRUE &&
+            xQueueReceive(erase_queue, &req, 0) != pdTRUE)
+        {
+            xSemaphoreTake(work, portMAX_DELAY);
+            continue;
+        }
+
+        req->status = run(req) ? SFLASH_DONE : SFLASH_FAILED;
+        if (req->done)
+            xSemaphoreGive(req->done);
+    }
+}
+
+uint8_t sflash_submit(struct sflash_req *req)
+{
+    uint8_t ok;
+
+    if (req->addr >= SFLASH_SIZE ||
+        (req->op == SFLASH_PROGRAM &&
+         (req->len == 0 || (req->addr % SFLASH_PAGE_SIZE) + req->len > SFLASH_PAGE_SIZE)) ||
+        (req->op == SFLASH_READ && (req->len == 0 || req->addr + req->len > SFLASH_SIZE)))
+    {
+        req->status = SFLASH_FAILED;
+        return 0;
+    }
+
+    req->status = SFLASH_QUEUED;
+    ok = xQueueSend(req->op == SFLASH_ERASE ? erase_queue : queue, &req, 0) == pdTRUE;
+    if (!ok)
+        req->status = SFLASH_FAILED;
+    else
+        xSemaphoreGive(work);
+    return ok;
+}
+
+uint8_t sflash_do(struct sflash_req *req)
+{
+    if (!sflash_submit(req))
+        return 0;
+    xSemaphoreTake(req->done, portMAX_DELAY);
+    return req->status == SFLASH_DONE;
+}
+
+xSemaphoreHandle sflash_done_create(void)
+{
+    xSemaphoreHandle sem;
+
+    vSemaphoreCreateBinary(sem);
+    xSemaphoreTake(sem, 0);
+    return sem;
+}
+
+void sflash_init(void)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    queue = xQueueCreate(SFLASH_QUEUE_LEN, sizeof(struct sflash_req *));
+    erase_queue = xQueueCreate(SFLASH_ERASE_LEN, sizeof(struct sflash_req *));
+    work = sflash_done_create();
+    dma_done = sflash_done_create();
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    // the addresses, counts and MINC are set per transfer
+    DMA_DeInit(RX_DMA);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&SPI1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&sink;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(RX_DMA, &DMA_InitStructure);
+    DMA_ITConfig(RX_DMA, DMA_IT_TC, ENABLE);
+
+    DMA_DeInit(TX_DMA);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&ones;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_Init(TX_DMA, &DMA_InitStructure);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = SFLASH_IRQ_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    // SPI1 only asks while it is enabled, which is only for the flash
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+void DMA1_Channel2_IRQHandler(void)
+{
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+    if (DMA_GetFlagStatus(DMA1_FLAG_TC2) == SET)
+    {
+        DMA_ClearFlag(DMA1_FLAG_TC2);
+        xSemaphoreGiveFromISR(dma_done, &xHigherPriorityTaskWoken);
+    }
+    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
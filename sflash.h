@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// M25P64 SPI flash service. One task owns the chip and works through two
+// queues: reads and page programs first, then sector erases, which only
+// start when nothing else is waiting. Data moves by SPI1 DMA, reads are
+// FAST_READ, and while the chip is busy programming or erasing the task
+// sleeps between status polls with the bus free for the touch task, so
+// no caller spins for the second an erase takes.
+//
+// A caller fills in a request and submits it; the request belongs to the
+// service until its status leaves SFLASH_QUEUED. If done is set it is
+// given then, otherwise the caller polls status. On the host (SFLASH_SIM)
+// host/sflash_sim.c does each request as it is submitted.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SFLASH_H
+#define SFLASH_H
+
+#include <stdint.h>
+
+#ifdef SFLASH_SIM
+typedef void *xSemaphoreHandle;
+#else
+#include "FreeRTOS.h"
+#include "semphr.h"
+#endif
+
+#define SFLASH_PAGE_SIZE      256
+#define SFLASH_SECTOR_SIZE    0x10000
+#define SFLASH_SIZE           0x800000
+
+#define SFLASH_QUEUE_LEN      8        // reads and programs
+#define SFLASH_ERASE_LEN      4
+#define SFLASH_PROGRAM_POLL_MS 1       // 1.4ms typical, 5ms max
+#define SFLASH_ERASE_POLL_MS  20       // 1s typical, 3s max
+#define SFLASH_PROGRAM_TIMEOUT_MS 10
+#define SFLASH_ERASE_TIMEOUT_MS 5000
+#define SFLASH_DMA_TIMEOUT_MS 10
+#define SFLASH_IRQ_PRIORITY   14
+
+enum sflash_op
+{
+    SFLASH_READ,
+    SFLASH_PROGRAM,          // len bytes, not past the end of the page
+    SFLASH_ERASE             // the sector addr is in
+};
+
+enum sflash_status
+{
+    SFLASH_IDLE,
+    SFLASH_QUEUED,
+    SFLASH_DONE,
+    SFLASH_FAILED
+};
+
+struct sflash_req
+{
+    uint8_t  op;
+    volatile uint8_t status;
+    uint16_t len;
+    uint32_t addr;
+    uint8_t  *buf;
+    xSemaphoreHandle done;   // given when finished, NULL to poll status
+};
+
+#ifndef SFLASH_SIM
+// Before the scheduler starts, after spibus_init()
+void sflash_init(void);
+void vSFlashTask( void *pvParameters );
+#endif
+
+// Queues the request. Returns 0, with it SFLASH_FAILED, if it is bad or
+// its queue is full.
+uint8_t sflash_submit(struct sflash_req *req);
+
+// Submits and waits for it; done must be set. Returns 1 if it worked.
+uint8_t sflash_do(struct sflash_req *req);
+
+// A binary semaphore for done, taken so the first wait blocks
+xSemaphoreHandle sflash_done_create(void);
+
+#endif
@@ -0,0 +1,716 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Command shell on the console USART. The line is edited in a fixed
+// buffer and split into words in place, so nothing is allocated; a
+// command is a function in the table below taking argc/argv. LOG()
+// entries are formatted here and printed above the line being typed,
+// which is then drawn again, or after "log binary" are passed on
+// unformatted as telemetry records.
+//
+// The task runs at idle priority, and everything it calls only takes
+// the same short critical sections the applets do, so a command can't
+// hold up the control loops.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f10x.h"
+#include "queue.h"
+#include "shell.h"
+#include "serial.h"
+#include "timer.h"
+#include "ds1820.h"
+#include "sensor.h"
+#include "heater.h"
+#include "crane.h"
+#include "telemetry.h"
+#include "log.h"
+#include "fmt.h"
+#include "datalog.h"
+#include "kv.h"
+#include "eeprom.h"
+
+struct shell_cmd
+{
+    const char *name;
+    const char *usage;
+    void (*fn)(int argc, char **argv);
+};
+
+static char line[SHELL_LINE_LEN];
+static char last[SHELL_LINE_LEN];   // for up arrow
+static uint8_t len;
+static uint8_t log_binary;          // send LOG() entries as TELEM_LOG
+
+static const char *names[4] = { "HLT", "Mash", "Cabinet", "Ambient" };
+
+// -12.34 from hundredths, for a %s that might be "-" instead. Good for
+// up to C100_BUFS in one printf.
+#define C100_BUFS 3
+
+static const char *c100(int32_t val)
+{
+    static char buf[C100_BUFS][12];
+    static uint8_t which;
+    char *bb = buf[which];
+
+    which = (which + 1) % C100_BUFS;
+
+    fmt_snprintf(bb, sizeof(buf[0]), "%.2q", val);
+    return bb;
+}
+
+// "66.5" to 6650, 0 if it isn't a number
+static int parse_c100(const char *str, int32_t *val)
+{
+    char *end;
+    long whole = strtol(str, &end, 10);
+    long frac = 0;
+
+    if (end == str && *end != '.')
+        return 0;
+    if (*end == '.')
+    {
+        const char *ff = ++end;
+
+        frac = strtol(ff, &end, 10);
+        if (end - ff == 1)
+            frac *= 10;
+        else if (end - ff != 2)
+            return 0;
+    }
+    if (*end != '\0')
+        return 0;
+    *val = whole * 100 + (str[0] == '-' ? -frac : frac);
+    return 1;
+}
+
+static int vessel(const char *str)
+{
+    if (strcmp(str, "hlt") == 0)
+        return HEATER_HLT;
+    if (strcmp(str, "mash") == 0)
+        return HEATER_MASH;
+    fmt_printf("no vessel '%s', hlt or mash\r\n", str);
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Commands
+////////////////////////////////////////////////////////////////////////////
+
+static void cmd_tasks(int argc, char **argv)
+{
+    static signed char list[40 * 12];
+
+    vTaskList(list);
+    fmt_printf("name          state pri stack num\r\n%s", (char *)list);
+}
+
+static void cmd_heap(int argc, char **argv)
+{
+    fmt_printf("%lu bytes free\r\n", (unsigned long)xPortGetFreeHeapSize());
+}
+
+static void cmd_temps(int argc, char **argv)
+{
+    int ii;
+
+    for (ii = 0; ii < 4; ii++)
+    {
+        int32_t filtered = ds1820_get_filtered_c100(ii);
+
+        fmt_printf("%-8s %7s  filtered %7s  %s/min\r\n", names[ii],
+               c100(ds1820_get_temp_c100(ii)),
+               filtered == DS1820_TEMP_ERROR ? "-" : c100(filtered),
+               c100(ds1820_get_rate(ii)));
+    }
+}
+
+// "sensors rom <0-3> <16 hex digits>", family byte first
+static void sensor_rom(int argc, char **argv)
+{
+    uint8_t code[8];
+    char pair[3] = { 0, 0, 0 };
+    uint32_t ii;
+
+    if (argc != 4 || strlen(argv[3]) != 16)
+    {
+        fmt_printf("sensors rom <0-3> <16 hex digits>\r\n");
+        return;
+    }
+    for (ii = 0; ii < 8; ii++)
+    {
+        pair[0] = argv[3][ii * 2];
+        pair[1] = argv[3][ii * 2 + 1];
+        if (!isxdigit((unsigned char)pair[0]) || !isxdigit((unsigned char)pair[1]))
+        {
+            fmt_printf("bad ROM code '%s'\r\n", argv[3]);
+            return;
+        }
+        code[ii] = (uint8_t)strtoul(pair, NULL, 16);
+    }
+    fmt_printf("%s\r\n", ds1820_set_rom(strtoul(argv[2], NULL, 10), code) ? "saved" : "failed");
+}
+
+static void cmd_sensors(int argc, char **argv)
+{
+    struct sensor_event ev;
+    uint32_t ii;
+
+    if (argc > 1 && strcmp(argv[1], "rom") == 0)
+    {
+        sensor_rom(argc, argv);
+        return;
+    }
+    for (ii = 0; ii < 4; ii++)
+        fmt_printf("%-8s %-8s %s\r\n", names[ii],
+               sensor_state_name(ds1820_sensor_state(ii)),
+               sensor_fault_name(ds1820_sensor_fault(ii)));
+    for (ii = 0; sensor_get_event(ii, &ev); ii++)
+        fmt_printf("%6lu.%03lus %-8s %-8s %-8s %.2q\r\n", ev.time_ms / 1000, ev.time_ms % 1000,
+               names[ev.sensor], sensor_state_name(ev.state),
+               sensor_fault_name(ev.fault), ev.value);
+}
+
+static void cmd_set(int argc, char **argv)
+{
+    int32_t target;
+    int ch;
+
+    if (argc != 3 || (ch = vessel(argv[1])) < 0)
+    {
+        fmt_printf("set hlt|mash <degC>|off\r\n");
+        return;
+    }
+    if (strcmp(argv[2], "off") == 0)
+        heater_off(ch);
+    else if (parse_c100(argv[2], &target) && target >= 0 && target <= 10000)
+        heater_set_target(ch, target);
+    else
+        fmt_printf("bad temperature '%s'\r\n", argv[2]);
+}
+
+static void cmd_heaters(int argc, char **argv)
+{
+    static const char *modes[] = { "off", "pid", "manual", "autotune" };
+    struct heater_status st;
+    int ii;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        heater_get_status(ii, &st);
+        fmt_printf("%-4s %-8s target %7.2q temp %7.2q out %5.1q%% got %5.1q%%%s\r\n",
+               names[ii], modes[st.mode], st.target, st.temp, st.output, st.granted,
+               st.holding ? " holding" : st.stale ? " stale" : "");
+    }
+}
+
+static void cmd_crane(int argc, char **argv)
+{
+    portBASE_TYPE ok = pdFAIL;
+
+    if (argc == 2 && strcmp(argv[1], "home") == 0)
+        ok = crane_post_home(NULL);
+    else if (argc == 2 && strcmp(argv[1], "stop") == 0)
+        ok = crane_post_stop();
+    else if (argc == 3 && strcmp(argv[1], "move") == 0)
+        ok = crane_post_move(strtol(argv[2], NULL, 0), NULL);
+    else if (argc == 1)
+    {
+        fmt_printf("at %ld%s%s\r\n", (long)crane_get_position(),
+               crane_is_homed() ? "" : ", not homed",
+               crane_is_running() ? ", moving" : "");
+        return;
+    }
+    else
+    {
+        fmt_printf("crane [home|stop|move <steps>]\r\n");
+        return;
+    }
+    if (ok != pdPASS)
+        fmt_printf("crane busy\r\n");
+}
+
+static void cmd_log(int argc, char **argv)
+{
+    struct crane_fault fault;
+    uint32_t ii;
+
+    if (argc == 2 && strcmp(argv[1], "text") == 0)
+    {
+        log_binary = 0;
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "binary") == 0)
+    {
+        log_binary = 1;
+        return;
+    }
+    if (argc != 1)
+    {
+        fmt_printf("log [text|binary]\r\n");
+        return;
+    }
+
+    fmt_printf("log entries dropped %lu\r\n", (unsigned long)log_dropped());
+    fmt_printf("crane faults, %lu total\r\n", (unsigned long)crane_fault_count());
+    for (ii = 0; crane_get_fault(ii, &fault) == pdPASS; ii++)
+        fmt_printf("%6lu.%03lus %-11s pos %ld\r\n", (unsigned long)fault.time_ms / 1000,
+               (unsigned long)fault.time_ms % 1000, crane_fault_name(fault.type),
+               (long)fault.position);
+    fmt_printf("sensor changes, %lu total\r\n", (unsigned long)sensor_event_count());
+    cmd_sensors(argc, argv);
+}
+
+static void cmd_reset(int argc, char **argv)
+{
+    if (argc != 2 || strcmp(argv[1], "stats") != 0)
+    {
+        fmt_printf("reset stats\r\n");
+        return;
+    }
+    crane_clear_faults();
+    sensor_clear_log();
+    comm_clear_stats();
+    telemetry_clear_stats();
+    log_clear_stats();
+}
+
+static void cmd_level(int argc, char **argv)
+{
+    int mod, level;
+
+    if (argc == 1)
+    {
+        for (mod = 0; mod < LOG_MOD_MODULES; mod++)
+            fmt_printf("  %-8s %s\r\n", log_module_name(mod),
+                       log_level_name(log_levels[mod]));
+        fmt_printf("built with up to %s\r\n", log_level_name(LOG_LEVEL_MAX));
+        return;
+    }
+
+    for (level = LOG_LEVEL_NONE; level <= LOG_LEVEL_DEBUG; level++)
+        if (argc == 3 && strcmp(argv[2], log_level_name(level)) == 0)
+            break;
+    for (mod = 0; mod < LOG_MOD_MODULES; mod++)
+        if (argc == 3 && strcmp(argv[1], log_module_name(mod)) == 0)
+            break;
+    if (argc != 3 || level > LOG_LEVEL_DEBUG ||
+        (mod == LOG_MOD_MODULES && strcmp(argv[1], "all") != 0))
+    {
+        fmt_printf("level [<module>|all none|error|warn|info|debug]\r\n");
+        return;
+    }
+
+    if (mod < LOG_MOD_MODULES)
+        log_levels[mod] = level;
+    else
+        for (mod = 0; mod < LOG_MOD_MODULES; mod++)
+            log_levels[mod] = level;
+}
+
+// DWT cycle counter; this CMSIS has no struct for it
+#define DWT_CTRL       (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT     (*(volatile uint32_t *)0xE0001004)
+#define BENCH_STACK    512     // words
+#define BENCH_RUNS     3
+
+// newlib's only with FMT_BENCH_NEWLIB, see the Makefile, as its %f
+// brings in the float printf that fmt.c is there to keep out
+enum
+{
+    BENCH_FMT_F, BENCH_FMT_Q, BENCH_FMT_S,
+#ifdef FMT_BENCH_NEWLIB
+    BENCH_NEWLIB_F, BENCH_NEWLIB_S,
+#endif
+    BENCH_CASES
+};
+
+static const char *bench_names[BENCH_CASES] =
+{
+    "fmt %f", "fmt %q", "fmt %s",
+#ifdef FMT_BENCH_NEWLIB
+    "newlib %f", "newlib %s"
+#endif
+};
+
+struct bench
+{
+    uint8_t which;
+    uint32_t cycles;            // best of BENCH_RUNS
+    size_t heap;                // taken and not given back
+    volatile uint8_t done;
+};
+
+// Runs in a task of its own, so the stack it used is its high water mark
+static void bench_task(void *pvParameters)
+{
+    struct bench *bb = pvParameters;
+    size_t heap = xPortGetFreeHeapSize();
+    char buf[48];
+    int ii;
+
+    bb->cycles = ~0;
+    for (ii = 0; ii < BENCH_RUNS; ii++)
+    {
+        uint32_t start = DWT_CYCCNT;
+
+        switch (bb->which)
+        {
+        case BENCH_FMT_F:
+            fmt_snprintf(buf, sizeof(buf), "HLT %.2f Mash %.2f out %d%%", 65.25, 66.5, 503);
+            break;
+        case BENCH_FMT_Q:
+            fmt_snprintf(buf, sizeof(buf), "HLT %.2q Mash %.2q out %d%%", 6525, 6650, 503);
+            break;
+#ifdef FMT_BENCH_NEWLIB
+        case BENCH_NEWLIB_F:
+            snprintf(buf, sizeof(buf), "HLT %.2f Mash %.2f out %d%%", 65.25, 66.5, 503);
+            break;
+        case BENCH_NEWLIB_S:
+            snprintf(buf, sizeof(buf), "%-8s %-8s %s\r\n", "Mash", "FAILED", "open");
+            break;
+#endif
+        default:
+            fmt_snprintf(buf, sizeof(buf), "%-8s %-8s %s\r\n", "Mash", "FAILED", "open");
+            break;
+        }
+        start = DWT_CYCCNT - start;
+        if (start < bb->cycles)
+            bb->cycles = start;
+    }
+    bb->heap = heap - xPortGetFreeHeapSize();
+    bb->done = 1;
+    vTaskSuspend(NULL);
+}
+
+static void cmd_bench(int argc, char **argv)
+{
+    struct bench bb;
+    xTaskHandle task;
+    unsigned ii;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= 1;
+
+    fmt_printf("           cycles  stack  heap\r\n");
+    for (ii = 0; ii < BENCH_CASES; ii++)
+    {
+        bb.which = ii;
+        bb.done = 0;
+        if (xTaskCreate(bench_task, (signed char *)"bnch", BENCH_STACK, &bb,
+                        tskIDLE_PRIORITY + 1, &task) != pdPASS)
+        {
+            fmt_printf("no room for the task\r\n");
+            return;
+        }
+        while (!bb.done)
+            vTaskDelay(1);
+        fmt_printf("%-10s %6lu %6u %5u\r\n", bench_names[ii], (unsigned long)bb.cycles,
+                   (unsigned)(BENCH_STACK - uxTaskGetStackHighWaterMark(task)) * 4,
+                   (unsigned)bb.heap);
+        vTaskDelete(task);
+    }
+}
+
+static void cmd_datalog(int argc, char **argv)
+{
+    struct datalog_status st;
+
+    if (argc == 3 && strcmp(argv[1], "period") == 0)
+    {
+        datalog_set_period(strtoul(argv[2], NULL, 10));
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "flush") == 0)
+    {
+        datalog_flush();
+        return;
+    }
+    if (argc != 1)
+    {
+        fmt_printf("datalog [period <ms>|flush]\r\n");
+        return;
+    }
+
+    datalog_get_status(&st);
+    fmt_printf("period %lu ms, %lu records, next at %06lx\r\n", (unsigned long)st.period,
+               (unsigned long)st.next_seq, (unsigned long)st.head);
+    fmt_printf("%lu in RAM, %lu pages, %lu erases, %lu dropped, %lu failed\r\n",
+               (unsigned long)st.buffered, (unsigned long)st.pages,
+               (unsigned long)st.erases, (unsigned long)st.dropped,
+               (unsigned long)st.failed);
+}
+
+// As fast as the TX ring empties; any key stops it
+static uint8_t dump_send(const struct datalog_rec *rec)
+{
+    char cc;
+
+    while (!telemetry_datalog(rec))
+        vTaskDelay(1);
+    return comm_read(&cc, 1, 0) == 0;
+}
+
+static void cmd_dump(int argc, char **argv)
+{
+    uint32_t sent;
+
+    sent = datalog_dump(argc > 1 ? strtoul(argv[1], NULL, 10) : 0, dump_send);
+    fmt_printf("\r\n%lu records\r\n", (unsigned long)sent);
+}
+
+static void cmd_kv(int argc, char **argv)
+{
+    struct kv_stats st;
+
+    if (argc == 3 && strcmp(argv[1], "save") == 0 && strcmp(argv[2], "gains") == 0)
+    {
+        fmt_printf("%s\r\n", heater_save_gains() ? "saved" : "failed");
+        return;
+    }
+    if (argc == 3 && strcmp(argv[1], "del") == 0)
+    {
+        fmt_printf("%s\r\n", kv_delete(strtoul(argv[2], NULL, 10)) ? "deleted" : "failed");
+        return;
+    }
+    if (argc != 1)
+    {
+        fmt_printf("kv [save gains|del <key>]\r\n");
+        return;
+    }
+
+    kv_get_stats(&st);
+    fmt_printf("opened in %lu ms, %lu reads, %lu records\r\n", (unsigned long)st.open_ms,
+               (unsigned long)st.open_reads, (unsigned long)st.open_records);
+    fmt_printf("%lu keys, %lu bytes of log, %lu writes, %lu clear outs, %lu erases\r\n",
+               (unsigned long)st.live, (unsigned long)st.used, (unsigned long)st.writes,
+               (unsigned long)st.collections, (unsigned long)st.erases);
+}
+
+static void cmd_eeprom(int argc, char **argv)
+{
+    struct eeprom_stats st;
+    uint16_t var, value;
+
+    eeprom_get_stats(&st);
+    fmt_printf("page %u, %u of %u entries, %u live\r\n", st.page, st.used,
+               EEPROM_PAGE_ENTRIES, st.live);
+    fmt_printf("%lu writes, %lu swaps, %lu erases\r\n", (unsigned long)st.writes,
+               (unsigned long)st.swaps, (unsigned long)st.erases);
+    for (var = 0; var < EEPROM_VARS; var++)
+        if (eeprom_read(var, &value) == EEPROM_OK)
+            fmt_printf("%2u %5u\r\n", var, value);
+}
+
+static void cmd_help(int argc, char **argv);
+
+static const struct shell_cmd commands[] =
+{
+    { "help",    "this list",                cmd_help },
+    { "tasks",   "stack left and state",     cmd_tasks },
+    { "heap",    "bytes free",               cmd_heap },
+    { "temps",   "probe readings",           cmd_temps },
+    { "sensors", "faults, [rom <n> <hex>]",  cmd_sensors },
+    { "heaters", "loop outputs",             cmd_heaters },
+    { "set",     "hlt|mash <degC>|off",      cmd_set },
+    { "crane",   "[home|stop|move <steps>]", cmd_crane },
+    { "log",     "faults, [text|binary]",    cmd_log },
+    { "reset",   "stats, zero logs, counts", cmd_reset },
+    { "level",   "[<module>|all <level>]",   cmd_level },
+    { "bench",   "printf cycles and stack",  cmd_bench },
+    { "datalog", "[period <ms>|flush]",      cmd_datalog },
+    { "dump",    "[n] datalog as telemetry", cmd_dump },
+    { "kv",      "[save gains|del <key>]",   cmd_kv },
+    { "eeprom",  "internal flash settings",  cmd_eeprom },
+    { NULL }
+};
+
+static void cmd_help(int argc, char **argv)
+{
+    const struct shell_cmd *cmd;
+
+    for (cmd = commands; cmd->name; cmd++)
+        fmt_printf("  %-8s %s\r\n", cmd->name, cmd->usage);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Line editing
+////////////////////////////////////////////////////////////////////////////
+
+static void shell_prompt(void)
+{
+    fmt_printf("> %.*s", len, line);
+}
+
+static void shell_execute(void)
+{
+    char *argv[SHELL_MAX_ARGS];
+    const struct shell_cmd *cmd;
+    char *pp = line;
+    int argc = 0;
+
+    line[len] = '\0';
+    if (len)
+        memcpy(last, line, len + 1);
+
+    // split on spaces in place
+    while (argc < SHELL_MAX_ARGS)
+    {
+        while (*pp == ' ')
+            *pp++ = '\0';
+        if (*pp == '\0')
+            break;
+        argv[argc++] = pp;
+        while (*pp && *pp != ' ')
+            pp++;
+    }
+
+    fmt_printf("\r\n");
+    if (argc)
+    {
+        for (cmd = commands; cmd->name; cmd++)
+        {
+            if (strcmp(cmd->name, argv[0]) == 0)
+            {
+                cmd->fn(argc, argv);
+                break;
+            }
+        }
+        if (!cmd->name)
+            fmt_printf("no command '%s', try help\r\n", argv[0]);
+    }
+    len = 0;
+    fmt_printf("> ");
+}
+
+static void shell_erase(uint8_t count)
+{
+    while (count-- && len)
+    {
+        len--;
+        fmt_printf("\b \b");
+    }
+}
+
+static void shell_char(char cc)
+{
+    static uint8_t escape;     // how far into an ESC [ x sequence
+    static char prev;
+
+    if (escape == 1)
+    {
+        escape = cc == '[' ? 2 : 0;
+        return;
+    }
+    if (escape == 2)
+    {
+        escape = 0;
+        cc = cc == 'A' ? 0x10 : 0;   // up arrow is ^P, the others are ignored
+    }
+
+    switch (cc)
+    {
+    case 0x1B:
+        escape = 1;
+        break;
+    case '\r':
+        shell_execute();
+        break;
+    case '\n':
+        if (prev != '\r')
+            shell_execute();
+        break;
+    case '\b':
+    case 0x7F:
+        shell_erase(1);
+        break;
+    case 0x15:          // ^U, the whole line
+        shell_erase(len);
+        break;
+    case 0x17:          // ^W, back to the start of the word
+        while (len && line[len - 1] == ' ')
+            shell_erase(1);
+        while (len && line[len - 1] != ' ')
+            shell_erase(1);
+        break;
+    case 0x03:          // ^C
+        len = 0;
+        fmt_printf("^C\r\n");
+        shell_prompt();
+        break;
+    case 0x10:          // ^P, the last line again
+        shell_erase(len);
+        len = strlen(last);
+        memcpy(line, last, len);
+        fmt_printf("%.*s", len, line);
+        break;
+    default:
+        if (cc >= ' ' && cc < 0x7F && len < SHELL_LINE_LEN - 1)
+        {
+            line[len++] = cc;
+            comm_put(cc);
+        }
+        break;
+    }
+    prev = cc;
+}
+
+// Prints, or sends, whatever has been logged since last time
+static void shell_log(void)
+{
+    struct log_entry entry;
+    int shown = 0;
+
+    while (log_take(&entry))
+    {
+        if (log_binary)
+        {
+            telemetry_log(&entry);
+            continue;
+        }
+        // over the top of the line being typed
+        if (!shown)
+            fmt_printf("\r\033[K");
+        fmt_printf("%6lu.%03lus ", (unsigned long)entry.time_ms / 1000,
+               (unsigned long)entry.time_ms % 1000);
+        log_print(&entry);
+        shown = 1;
+    }
+    if (shown)
+    {
+        shell_prompt();
+    }
+}
+
+void vShellTask( void *pvParameters )
+{
+    char input[16];
+    int ii, nn;
+
+    fmt_printf("\r\nBrew Machine MkIV, type help\r\n");
+    shell_prompt();
+
+    for (;;)
+    {
+        shell_log();
+        heater_save_tuned();
+
+        nn = comm_read(input, sizeof(input), 0);
+        for (ii = 0; ii < nn; ii++)
+            shell_char(input[ii]);
+
+        vTaskDelay(SHELL_POLL_MS / portTICK_RATE_MS);
+    }
+}
@@ -0,0 +1,18 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHELL_H
+#define SHELL_H
+
+#define SHELL_LINE_LEN  64
+#define SHELL_MAX_ARGS  6
+#define SHELL_POLL_MS   20
+
+void vShellTask( void *pvParameters );
+
+#endif
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// SPI1 shared between the flash and the touch controller, see spibus.h.
+// The pins are only set up again when the other user takes the bus, so
+// the touch task polling on its own costs just the lock.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "spibus.h"
+
+static xSemaphoreHandle lock;
+static uint8_t owner = SPIBUS_NONE;   // how the pins are set up
+
+void spibus_init(void)
+{
+    SPI_InitTypeDef  SPI_InitStructure;
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1 | RCC_APB2Periph_GPIOA |
+                           RCC_APB2Periph_GPIOB, ENABLE);
+
+    // flash CS, deselected
+    GPIO_SetBits(GPIOA, GPIO_Pin_4);
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_4;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    SPI_InitStructure.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
+    SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
+    SPI_InitStructure.SPI_DataSize = SPI_DataSize_8b;
+    SPI_InitStructure.SPI_CPOL = SPI_CPOL_High;
+    SPI_InitStructure.SPI_CPHA = SPI_CPHA_2Edge;
+    SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
+    SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_4;
+    SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
+    SPI_InitStructure.SPI_CRCPolynomial = 7;
+    SPI_Init(SPI1, &SPI_InitStructure);
+
+    lock = xSemaphoreCreateMutex();
+}
+
+static void set_pins(uint8_t user)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_5 | GPIO_Pin_7;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    if (user == SPIBUS_FLASH)
+    {
+        GPIO_SetBits(GPIOB, GPIO_Pin_7);      // touch nCS
+        GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+        GPIO_Init(GPIOA, &GPIO_InitStructure);
+        SPI_Cmd(SPI1, ENABLE);
+    }
+    else
+    {
+        SPI_Cmd(SPI1, DISABLE);
+        GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+        GPIO_Init(GPIOA, &GPIO_InitStructure);
+    }
+    // MISO is an input either way
+    owner = user;
+}
+
+void spibus_take(uint8_t user)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (user != owner)
+        set_pins(user);
+}
+
+void spibus_give(void)
+{
+    xSemaphoreGive(lock);
+}
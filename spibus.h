@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// SPI1's pins, PA5 SCK, PA6 MISO and PA7 MOSI, go to both the M25P64
+// flash (CS on PA4) and the touch controller, which touch.c bit-bangs
+// (nCS on PB7). Whoever holds the bus gets the pins set up their way:
+// alternate function with SPI1 running for the flash, plain outputs for
+// the touch controller. Taking it for the flash deselects the touch
+// controller, which otherwise sits selected driving MISO.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SPIBUS_H
+#define SPIBUS_H
+
+#include <stdint.h>
+
+enum spibus_user
+{
+    SPIBUS_NONE,
+    SPIBUS_TOUCH,
+    SPIBUS_FLASH
+};
+
+// Before the scheduler starts: SPI1 as SPI_FLASH_Init() has it, the
+// flash deselected, and the lock
+void spibus_init(void);
+
+// Blocks until the bus is free. Don't hold it across a vTaskDelay().
+void spibus_take(uint8_t user);
+void spibus_give(void);
+
+#endif
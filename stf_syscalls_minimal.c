@@ -25,6 +25,7 @@
 #include <time.h>
 #include <sys/stat.h>
 #include "FreeRTOS.h"
+#include "serial.h"
 
 // Function declaration.
 void _exit(int i);
@@ -65,14 +66,8 @@ void _exit(int i)
 
 int _write(int file, char *buffer, unsigned int count)
 {
-	register int i;
-	for (i=0; i<count; ++i) {
-            //putChar(*buffer++);
-            comm_put(*buffer++);
-            //xSerialPutChar(NULL, *buffer++, 0);
-	}
-
-	return count;
+	// queued for the USART's DMA, waits only if the ring is full
+	return comm_write(buffer, count, 1);
 }
 
 int _close(int file)
@@ -98,7 +93,7 @@ int _lseek(int file, int ptr, int dir)
 
 int _read(int file, char *ptr, int len)
 {
-	return 0;
+	return comm_read(ptr, len, 1);
 }
 
 caddr_t _sbrk(int incr)
@@ -24,14 +24,14 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Uncomment the line below to enable peripheral header file inclusion */
-/* #include "stm32f10x_adc.h" */
+#include "stm32f10x_adc.h"
 /* #include "stm32f10x_bkp.h" */
 /* #include "stm32f10x_can.h" */
 /* #include "stm32f10x_crc.h" */
 /* #include "stm32f10x_dac.h" */
 /* #include "stm32f10x_dbgmcu.h" */
-/* #include "stm32f10x_dma.h" */
-/* #include "stm32f10x_exti.h" */
+#include "stm32f10x_dma.h"
+#include "stm32f10x_exti.h"
 #include "stm32f10x_flash.h"
 #include "stm32f10x_fsmc.h"
 #include "stm32f10x_gpio.h"
@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Telemetry records, see telemetry.h for the frame layout. The task wakes
+// every TELEM_TICK_MS and sends whichever records are due. A frame only
+// goes out if the whole of it fits in the serial TX ring; otherwise it is
+// dropped rather than holding up the task or splitting it.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "telemetry.h"
+#include "cobs.h"
+
+static uint8_t *put16(uint8_t *pp, uint16_t val)
+{
+    *pp++ = val;
+    *pp++ = val >> 8;
+    return pp;
+}
+
+static uint8_t *put32(uint8_t *pp, uint32_t val)
+{
+    pp = put16(pp, val);
+    return put16(pp, val >> 16);
+}
+
+uint16_t telem_frame(uint8_t *out, uint8_t type, uint16_t seq, uint32_t time,
+                     const uint8_t *body, uint8_t len)
+{
+    uint8_t raw[TELEM_MAX_FRAME];
+    uint8_t *pp = raw;
+    uint16_t crc, nn;
+
+    *pp++ = type;
+    pp = put16(pp, seq);
+    pp = put32(pp, time);
+    memcpy(pp, body, len);
+    pp += len;
+    crc = crc16_ccitt(0xFFFF, raw, pp - raw);
+    pp = put16(pp, crc);
+
+    out[0] = 0;
+    nn = cobs_encode(raw, pp - raw, out + 1);
+    out[nn + 1] = 0;
+    return nn + 2;
+}
+
+#ifndef TELEM_HOST
+#include "FreeRTOS.h"
+#include "task.h"
+#include "serial.h"
+#include "timer.h"
+#include "ds1820.h"
+#include "heater.h"
+#include "brew.h"
+#include "log.h"
+#include "datalog.h"
+
+struct telem_task
+{
+    xTaskHandle handle;
+    char name[4];
+};
+
+static uint16_t periods[TELEM_TYPES] =
+{
+    0, TELEM_TEMPS_MS, TELEM_HEATERS_MS, TELEM_BREW_MS, TELEM_TASKS_MS, 0, 0
+};
+
+static struct telem_task watched[TELEM_MAX_TASKS];
+static uint8_t  n_watched;
+static uint16_t seq;
+static uint16_t dropped;
+
+static uint8_t telem_temps(uint8_t *body)
+{
+    uint8_t *pp = body;
+    int ii;
+
+    for (ii = 0; ii < TELEM_TEMP_SENSORS; ii++)
+    {
+        int32_t rate = ds1820_get_rate(ii);
+
+        if (rate > 32767)
+            rate = 32767;
+        if (rate < -32768)
+            rate = -32768;
+        pp = put16(pp, ds1820_get_temp_c100(ii));
+        pp = put16(pp, rate);
+        *pp++ = ds1820_sensor_state(ii);
+    }
+    return pp - body;
+}
+
+static uint8_t telem_heaters(uint8_t *body)
+{
+    uint8_t *pp = body;
+    int ii;
+
+    for (ii = 0; ii < HEATER_COUNT; ii++)
+    {
+        struct heater_status st;
+
+        heater_get_status(ii, &st);
+        *pp++ = st.mode;
+        *pp++ = (st.stale ? TELEM_HEATER_STALE : 0) |
+                (st.holding ? TELEM_HEATER_HOLDING : 0);
+        pp = put16(pp, st.target);
+        pp = put16(pp, st.temp);
+        pp = put16(pp, st.output);
+        pp = put16(pp, st.granted);
+        pp = put16(pp, st.feedforward);
+    }
+    return pp - body;
+}
+
+static uint8_t telem_brew(uint8_t *body)
+{
+    struct brew_status st;
+    uint8_t *pp = body;
+
+    brew_get_status(&st);
+    *pp++ = st.state;
+    *pp++ = st.step;
+    *pp++ = st.n_steps;
+    pp = put32(pp, st.elapsed);
+    pp = put32(pp, st.remaining);
+    pp = put32(pp, st.brew_time);
+    pp = put16(pp, st.target);
+    pp = put16(pp, st.temp);
+    return pp - body;
+}
+
+static uint8_t telem_tasks(uint8_t *body)
+{
+    uint8_t *pp = body;
+    int ii;
+
+    pp = put32(pp, xPortGetFreeHeapSize());
+    *pp++ = uxTaskGetNumberOfTasks();
+    pp = put16(pp, comm_rx_overruns());
+    pp = put16(pp, dropped);
+    *pp++ = n_watched;
+    for (ii = 0; ii < n_watched; ii++)
+    {
+        memcpy(pp, watched[ii].name, 4);
+        pp = put16(pp + 4, uxTaskGetStackHighWaterMark(watched[ii].handle));
+    }
+    return pp - body;
+}
+
+// Log records come from the shell task, so seq is shared
+static void telem_put(uint8_t type, uint32_t time, const uint8_t *body, uint8_t len)
+{
+    uint8_t frame[COBS_MAX_ENCODED(TELEM_MAX_FRAME) + 2];
+    uint16_t nn, this_seq;
+
+    taskENTER_CRITICAL();
+    this_seq = seq++;
+    taskEXIT_CRITICAL();
+
+    nn = telem_frame(frame, type, this_seq, time, body, len);
+    if (comm_tx_space() < nn || comm_write((char *)frame, nn, 0) != nn)
+        dropped++;
+}
+
+static void telem_send(uint8_t type)
+{
+    uint8_t body[TELEM_MAX_BODY];
+    uint8_t len;
+
+    switch (type)
+    {
+    case TELEM_TEMPS:   len = telem_temps(body);   break;
+    case TELEM_HEATERS: len = telem_heaters(body); break;
+    case TELEM_BREW:    len = telem_brew(body);    break;
+    case TELEM_TASKS:   len = telem_tasks(body);   break;
+    default:
+        return;
+    }
+    telem_put(type, ulUptimeMs, body, len);
+}
+
+void telemetry_log(const struct log_entry *entry)
+{
+    uint8_t body[TELEM_LOG_LEN(LOG_MAX_ARGS)];
+    uint8_t *pp = body;
+    int ii;
+
+    pp = put16(pp, log_fmt_offset(entry->fmt));
+    *pp++ = entry->nargs;
+    for (ii = 0; ii < entry->nargs; ii++)
+        pp = put32(pp, entry->args[ii]);
+    telem_put(TELEM_LOG, entry->time_ms, body, pp - body);
+}
+
+uint8_t telemetry_datalog(const struct datalog_rec *rec)
+{
+    uint8_t body[TELEM_DATALOG_LEN];
+    uint8_t *pp = body;
+    int ii;
+
+    if (comm_tx_space() < COBS_MAX_ENCODED(TELEM_HEADER_LEN + TELEM_DATALOG_LEN +
+                                           TELEM_CRC_LEN) + 2)
+        return 0;
+
+    pp = put32(pp, rec->seq);
+    for (ii = 0; ii < 4; ii++)
+        pp = put16(pp, rec->temp[ii]);
+    for (ii = 0; ii < 2; ii++)
+        pp = put16(pp, rec->target[ii]);
+    for (ii = 0; ii < 2; ii++)
+        pp = put16(pp, rec->output[ii]);
+    *pp++ = rec->state;
+    *pp++ = rec->step;
+    *pp++ = rec->mode[0];
+    *pp++ = rec->mode[1];
+    *pp++ = rec->flags;
+    telem_put(TELEM_DATALOG, rec->time, body, pp - body);
+    return 1;
+}
+
+void vTelemetryTask( void *pvParameters )
+{
+    unsigned long due[TELEM_TYPES] = { 0 };
+    portTickType wake = xTaskGetTickCount();
+    int ii;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&wake, TELEM_TICK_MS / portTICK_RATE_MS);
+
+        for (ii = 1; ii < TELEM_TYPES; ii++)
+        {
+            if (periods[ii] == 0 || (long)(ulUptimeMs - due[ii]) < 0)
+                continue;
+            due[ii] = ulUptimeMs + periods[ii];
+            telem_send(ii);
+        }
+    }
+}
+
+void telemetry_set_period(uint8_t type, uint16_t ms)
+{
+    if (type > 0 && type < TELEM_TYPES)
+        periods[type] = ms;
+}
+
+void telemetry_clear_stats(void)
+{
+    dropped = 0;
+}
+
+void telemetry_watch(xTaskHandle task, const char *name)
+{
+    if (n_watched >= TELEM_MAX_TASKS)
+        return;
+    watched[n_watched].handle = task;
+    strncpy(watched[n_watched].name, name, 4);
+    n_watched++;
+}
+#endif
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// Binary telemetry on the console USART, decoded on the PC by
+// host/telemdump.c. Each record goes out as one frame:
+//
+//   0x00  COBS( type  seq  time  body  crc )  0x00
+//
+//   type   1 byte, enum telem_type
+//   seq    2 bytes, counts every frame, sent or dropped, so gaps show loss
+//   time   4 bytes, ulUptimeMs
+//   body   per type, below
+//   crc    2 bytes, CRC-16/CCITT of type to the end of the body
+//
+// A zero both ends means printf text on the same port falls between
+// frames, where it fails the CRC and is skipped. All fields are little
+// endian.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+enum telem_type
+{
+    TELEM_TEMPS = 1,
+    TELEM_HEATERS,
+    TELEM_BREW,
+    TELEM_TASKS,
+    TELEM_LOG,
+    TELEM_DATALOG,
+    TELEM_TYPES
+};
+
+#define TELEM_HEADER_LEN   7
+#define TELEM_CRC_LEN      2
+
+// TELEM_TEMPS, per sensor HLT, MASH, CABINET, AMBIENT:
+//   int16 temp, int16 rate per minute (hundredths), uint8 sensor state
+#define TELEM_TEMP_SENSORS 4
+#define TELEM_TEMPS_LEN    (TELEM_TEMP_SENSORS * 5)
+
+// TELEM_HEATERS, per channel HLT, MASH:
+//   uint8 mode, uint8 flags, int16 target, int16 temp, uint16 output,
+//   uint16 granted, uint16 feedforward
+#define TELEM_HEATER_STALE   0x01
+#define TELEM_HEATER_HOLDING 0x02
+#define TELEM_HEATERS_LEN  (2 * 12)
+
+// TELEM_BREW:
+//   uint8 state, uint8 step, uint8 n_steps, uint32 elapsed s,
+//   int32 remaining s, uint32 brew time s, int16 target, int16 temp
+#define TELEM_BREW_LEN     19
+
+// TELEM_TASKS:
+//   uint32 free heap, uint8 tasks, uint16 serial RX overruns,
+//   uint16 telemetry frames dropped, uint8 n, then n of
+//   char name[4], uint16 stack never used (words)
+#define TELEM_MAX_TASKS    10
+#define TELEM_TASKS_LEN(n) (10 + (n) * 6)
+
+// TELEM_LOG, one LOG() entry, sent instead of printed after "log binary":
+//   uint16 format offset in logstr.bin, uint8 n, then n of uint32 arg
+#define TELEM_LOG_LEN(n)   (3 + (n) * 4)
+
+// TELEM_DATALOG, one record read back from the data logger by "dump",
+// time is the record's:
+//   uint32 record seq, int16 temp x4, int16 target x2, uint16 output x2,
+//   uint8 state, uint8 step, uint8 mode x2, uint8 flags
+#define TELEM_DATALOG_LEN  25
+
+#define TELEM_MAX_BODY     TELEM_TASKS_LEN(TELEM_MAX_TASKS)
+#define TELEM_MAX_FRAME    (TELEM_HEADER_LEN + TELEM_MAX_BODY + TELEM_CRC_LEN)
+
+// Default record periods in ms, 0 for off
+#define TELEM_TEMPS_MS     2000
+#define TELEM_HEATERS_MS   2000
+#define TELEM_BREW_MS      5000
+#define TELEM_TASKS_MS     10000
+#define TELEM_TICK_MS      100
+
+// Builds a complete frame, delimiters included, into out (at least
+// COBS_MAX_ENCODED(TELEM_MAX_FRAME) + 2 bytes). Returns its length.
+uint16_t telem_frame(uint8_t *out, uint8_t type, uint16_t seq, uint32_t time,
+                     const uint8_t *body, uint8_t len);
+
+#ifndef TELEM_HOST
+#include "FreeRTOS.h"
+#include "task.h"
+
+void vTelemetryTask( void *pvParameters );
+
+// Period for a record type in ms, 0 stops it
+void telemetry_set_period(uint8_t type, uint16_t ms);
+
+// Adds a task to the TELEM_TASKS record
+void telemetry_watch(xTaskHandle task, const char *name);
+
+// Sends a log entry as a TELEM_LOG record
+struct log_entry;
+void telemetry_log(const struct log_entry *entry);
+
+// Sends a data logger record as a TELEM_DATALOG record. Returns 0, and
+// sends nothing, while the serial TX ring hasn't room for it.
+struct datalog_rec;
+uint8_t telemetry_datalog(const struct datalog_rec *rec);
+
+// Zeroes the dropped frame count
+void telemetry_clear_stats(void);
+#endif
+
+#endif
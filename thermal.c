@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+//
+// First order plus dead time vessel model, feed-forward planned on it,
+// and a least squares fit of it from logged heating.
+//
+// The fit works on blocks of windows: over a block of length B the
+// vessel rises by
+//
+//     d = B/tau * (gain * u / out_max - (t - ambient))
+//
+// which is linear in the block's mean output u and mean temperature t.
+// Regressing d on the centred u and t gives gain and tau, and the means
+// then give the ambient. The output is delayed by the dead time
+// first, which is timed separately from each step out of zero.
+//
+// All integer; the sums are 64 bit and kept centred so the 2x2 solve
+// stays in range. Nothing here touches hardware, so it runs on the host
+// as well (host/thermal_bench.c).
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "thermal.h"
+
+#define NO_TEMP  INT32_MIN
+
+// a * b / c without overflowing the product
+static int64_t muldiv(int64_t a, int32_t b, int64_t c)
+{
+    int64_t lim;
+
+    // no output is the usual b == 0, with the vessel above its target
+    if (a == 0 || b == 0)
+        return 0;
+    lim = INT64_MAX / (b < 0 ? -b : b);
+    while (a > lim || a < -lim)
+    {
+        a >>= 1;
+        c >>= 1;
+    }
+    return c ? a * b / c : 0;
+}
+
+void thermal_init(struct thermal_model *m, int32_t gain, uint16_t tau,
+                  uint8_t dead, int32_t ambient, uint16_t out_max)
+{
+    m->gain = gain;
+    m->tau = tau;
+    m->dead = dead < THERMAL_MAX_DEAD ? dead : THERMAL_MAX_DEAD - 1;
+    m->ambient = ambient;
+    m->out_max = out_max;
+}
+
+uint16_t thermal_hold_output(const struct thermal_model *m, int32_t temp)
+{
+    int64_t out = muldiv(temp - m->ambient, m->out_max, m->gain);
+
+    if (out < 0)
+        return 0;
+    if (out > m->out_max)
+        return m->out_max;
+    return (uint16_t)out;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Feed-forward
+////////////////////////////////////////////////////////////////////////////
+
+void thermal_ff_reset(struct thermal_ff *ff, const struct thermal_model *m,
+                      int32_t temp)
+{
+    int ii;
+
+    memset(ff, 0, sizeof(*ff));
+    ff->model_q = temp << THERMAL_Q;
+    for (ii = 0; ii < THERMAL_MAX_DEAD; ii++)
+        ff->history[ii] = ff->model_q;
+    ff->reference = temp;
+    ff->output = thermal_hold_output(m, temp);
+}
+
+// The vessel takes the step now, so the reference does too, not just
+// the plan.
+void thermal_ff_disturb(struct thermal_ff *ff, int32_t c100)
+{
+    int ii;
+
+    ff->model_q += c100 << THERMAL_Q;
+    for (ii = 0; ii < THERMAL_MAX_DEAD; ii++)
+        ff->history[ii] += c100 << THERMAL_Q;
+    ff->reference += c100;
+}
+
+void thermal_ff_step(struct thermal_ff *ff, const struct thermal_model *m,
+                     int32_t target)
+{
+    int32_t temp = ff->model_q >> THERMAL_Q;
+    int64_t out, delta;
+
+    // the output that would land the model on the target this window,
+    // which is flat out (or off) for any real step
+    out = muldiv((int64_t)(target - temp) * m->tau + (temp - m->ambient),
+                 m->out_max, m->gain);
+    if (out < 0)
+        out = 0;
+    if (out > m->out_max)
+        out = m->out_max;
+    ff->output = (uint16_t)out;
+
+    delta = ((muldiv(m->gain, ff->output, m->out_max) - (temp - m->ambient))
+             << THERMAL_Q) + ff->rem;
+    ff->model_q += (int32_t)(delta / m->tau);
+    ff->rem = (int32_t)(delta % m->tau);
+
+    ff->history[ff->head] = ff->model_q;
+    ff->reference = ff->history[(ff->head + THERMAL_MAX_DEAD - m->dead) % THERMAL_MAX_DEAD]
+        >> THERMAL_Q;
+    ff->head = (ff->head + 1) % THERMAL_MAX_DEAD;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Fit
+////////////////////////////////////////////////////////////////////////////
+
+void thermal_fit_reset(struct thermal_fit *fit)
+{
+    uint8_t dead = fit->dead;
+
+    memset(fit, 0, sizeof(*fit));
+    fit->block_start = NO_TEMP;
+    fit->dead = dead;
+}
+
+// Time from the output stepping up out of zero to the vessel starting to
+// rise. The rise is timed to one and two THERMAL_RISE_DETECT and the
+// line through them taken back to the starting temperature, so the
+// time the lag takes to show a rise is not counted as dead time.
+static void thermal_fit_dead(struct thermal_fit *fit, uint16_t output, int32_t temp)
+{
+    if (output == 0)
+    {
+        fit->step_windows = 0;
+        if (fit->off_windows < 0xFFFF)
+            fit->off_windows++;
+        return;
+    }
+
+    if (fit->off_windows >= THERMAL_STEP_MIN_OFF)
+    {
+        fit->step_temp = temp;
+        fit->step_windows = 1;
+        fit->step_rise_at = 0;
+    }
+    fit->off_windows = 0;
+
+    if (fit->step_windows == 0)
+        return;
+
+    // still cooling off at the start of the step
+    if (temp < fit->step_temp && !fit->step_rise_at)
+        fit->step_temp = temp;
+
+    if (!fit->step_rise_at && temp >= fit->step_temp + THERMAL_RISE_DETECT)
+        fit->step_rise_at = fit->step_windows;
+
+    if (temp >= fit->step_temp + 2 * THERMAL_RISE_DETECT)
+    {
+        int32_t dead = 2 * fit->step_rise_at - fit->step_windows;
+
+        if (dead < 1)
+            dead = 1;
+        fit->dead = dead < THERMAL_MAX_DEAD ? dead : THERMAL_MAX_DEAD - 1;
+        fit->step_windows = 0;
+    }
+    else if (++fit->step_windows > 4 * THERMAL_MAX_DEAD)
+        fit->step_windows = 0;
+}
+
+void thermal_fit_sample(struct thermal_fit *fit, const struct thermal_model *m,
+                        uint16_t output, int32_t temp)
+{
+    int64_t u, t, d;
+    uint8_t dead;
+
+    thermal_fit_dead(fit, output, temp);
+
+    fit->history[fit->head] = output;
+    dead = fit->dead ? fit->dead : m->dead;
+    u = fit->history[(fit->head + THERMAL_MAX_DEAD - dead) % THERMAL_MAX_DEAD];
+    fit->head = (fit->head + 1) % THERMAL_MAX_DEAD;
+
+    if (fit->block_start == NO_TEMP)
+    {
+        fit->block_start = temp;
+        fit->origin = temp;
+        return;
+    }
+    if (fit->blocks >= THERMAL_FIT_BLOCKS)
+        return;
+
+    fit->block_out += (uint32_t)u;
+    if (++fit->windows < THERMAL_FIT_WINDOWS)
+        return;
+
+    // losses go with the mean temperature over the block
+    u = fit->block_out / THERMAL_FIT_WINDOWS;
+    d = temp - fit->block_start;
+    t = fit->block_start + d / 2 - fit->origin;
+
+    fit->su += u;
+    fit->st += t;
+    fit->sd += d;
+    fit->suu += u * u;
+    fit->stt += t * t;
+    fit->sut += u * t;
+    fit->sud += u * d;
+    fit->std += t * d;
+    fit->blocks++;
+
+    fit->windows = 0;
+    fit->block_out = 0;
+    fit->block_start = temp;
+}
+
+uint8_t thermal_fit_solve(const struct thermal_fit *fit, struct thermal_model *m)
+{
+    int64_t n = fit->blocks;
+    int64_t suu, stt, sut, sud, std;
+    int64_t det, na, nb, tau, gain, ambient;
+
+    if (n < THERMAL_FIT_MIN_BLOCKS)
+        return 0;
+
+    // centred sums
+    suu = fit->suu - fit->su * fit->su / n;
+    stt = fit->stt - fit->st * fit->st / n;
+    sut = fit->sut - fit->su * fit->st / n;
+    sud = fit->sud - fit->su * fit->sd / n;
+    std = fit->std - fit->st * fit->sd / n;
+
+    // without the output moving about there is nothing to separate the
+    // element from the losses
+    if (suu < n * (THERMAL_FIT_MIN_SPREAD / 2) * (THERMAL_FIT_MIN_SPREAD / 2))
+        return 0;
+
+    det = suu * stt - sut * sut;
+    na = sud * stt - std * sut;      // d per unit u, times det
+    nb = sut * sud - suu * std;      // d lost per unit t, times det
+    if (det <= 0 || na <= 0 || nb <= 0)
+        return 0;
+
+    tau = muldiv(det, THERMAL_FIT_WINDOWS, nb);
+    gain = muldiv(na, m->out_max, nb);
+    if (tau < THERMAL_TAU_MIN || tau > THERMAL_TAU_MAX ||
+        gain < THERMAL_GAIN_MIN || gain > THERMAL_GAIN_MAX)
+        return 0;
+
+    ambient = fit->origin + fit->st / n
+        + fit->sd * tau / (n * THERMAL_FIT_WINDOWS)
+        - gain * fit->su / (n * m->out_max);
+    if (ambient < -1000 || ambient > 4000)
+        return 0;
+
+    m->gain = (int32_t)gain;
+    m->tau = (uint16_t)tau;
+    m->ambient = (int32_t)ambient;
+    if (fit->dead)
+        m->dead = fit->dead;
+    return 1;
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2026, Brew Machine MkIV contributors
+//
+// Licensed under the GNU General Public License v3 or greater
+//
+// Date: 18 Oct 2026
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include <stdint.h>
+
+// Model state is kept in hundredths of a degree << THERMAL_Q
+#define THERMAL_Q          8
+
+// Dead time the model can represent, windows
+#define THERMAL_MAX_DEAD   64
+
+// Least squares fit: windows averaged into one block, and how many
+// blocks make a fit. 15 windows is 30s, 120 blocks an hour.
+#define THERMAL_FIT_WINDOWS     15
+#define THERMAL_FIT_BLOCKS      120
+#define THERMAL_FIT_MIN_BLOCKS  30
+#define THERMAL_FIT_MIN_SPREAD  100   // output must vary by ~10% to fit
+
+// Rise that counts as the vessel responding when measuring dead time,
+// four DS1820 counts. Timed to this and twice this, then extrapolated
+// back to the start.
+#define THERMAL_RISE_DETECT     25
+#define THERMAL_STEP_MIN_OFF    30    // windows off before a step is timed
+
+// Sanity limits on a fitted model
+#define THERMAL_TAU_MIN         150     // windows, 5 min
+#define THERMAL_TAU_MAX         30000
+#define THERMAL_GAIN_MIN        2000    // 20 degC at full power
+#define THERMAL_GAIN_MAX        100000
+
+// First order plus dead time: at a constant output u the vessel heads
+// for ambient + gain * u / out_max with time constant tau, and responds
+// to the element dead windows late. Times are in heater windows.
+struct thermal_model
+{
+    int32_t  gain;       // steady rise at full output, hundredths of a degree
+    uint16_t tau;        // windows
+    uint8_t  dead;       // windows
+    int32_t  ambient;    // hundredths of a degree
+    uint16_t out_max;
+};
+
+// Feed-forward. The output is planned on the model rather than the
+// vessel: flat out until the model reaches the target, then the power
+// that holds it there. The model's temperature, delayed by the dead
+// time, is the reference the PID loop tracks, so the loop only acts on
+// what the model got wrong.
+struct thermal_ff
+{
+    int32_t  model_q;    // model temperature << THERMAL_Q
+    int32_t  rem;        // division remainder carried between windows
+    int32_t  history[THERMAL_MAX_DEAD];
+    uint8_t  head;
+    uint16_t output;     // feed-forward output for this window
+    int32_t  reference;  // what the vessel should read now
+};
+
+// Accumulates blocks of logged (output, temperature) for a least
+// squares fit of the model.
+struct thermal_fit
+{
+    uint16_t history[THERMAL_MAX_DEAD];   // outputs, to apply the dead time
+    uint8_t  head;
+    uint8_t  windows;        // in the current block
+    uint32_t block_out;
+    int32_t  block_start;    // temperature at the start of the block
+
+    uint16_t blocks;
+    int32_t  origin;         // temperatures are taken relative to this
+    int64_t  su, st, sd;     // sums of output, temperature, rise
+    int64_t  suu, stt, sut, sud, std;
+
+    // dead time, from the last step of the output out of zero
+    uint16_t off_windows;
+    int32_t  step_temp;
+    uint16_t step_windows;   // 0 when no step is being timed
+    uint16_t step_rise_at;   // window the first THERMAL_RISE_DETECT showed
+    uint8_t  dead;           // last measured, 0 until one has been
+};
+
+void     thermal_init(struct thermal_model *m, int32_t gain, uint16_t tau,
+                      uint8_t dead, int32_t ambient, uint16_t out_max);
+
+// Output that holds the vessel at temp once it is there
+uint16_t thermal_hold_output(const struct thermal_model *m, int32_t temp);
+
+// Start planning from the measured temperature, eg. when the loop is
+// switched on.
+void     thermal_ff_reset(struct thermal_ff *ff, const struct thermal_model *m,
+                          int32_t temp);
+
+// A step the vessel is known to be about to take, eg. cold grain going in
+// (negative). The plan heats through it rather than waiting for the loop.
+void     thermal_ff_disturb(struct thermal_ff *ff, int32_t c100);
+
+// Once per window. Sets ff->output and ff->reference.
+void     thermal_ff_step(struct thermal_ff *ff, const struct thermal_model *m,
+                         int32_t target);
+
+// Starts the sums again but keeps the measured dead time, so the fit
+// must start out zeroed
+void     thermal_fit_reset(struct thermal_fit *fit);
+
+// Once per window with the output applied and the newest sample
+void     thermal_fit_sample(struct thermal_fit *fit, const struct thermal_model *m,
+                            uint16_t output, int32_t temp);
+
+// Fills in m and returns 1 if the blocks so far give a believable model.
+// m keeps its dead time until a step has been timed.
+uint8_t  thermal_fit_solve(const struct thermal_fit *fit, struct thermal_model *m);
+
+#endif
@@ -16,7 +16,6 @@
 /* Scheduler includes. */
 #include "FreeRTOS.h"
 #include "queue.h" 
-#include "console.h"
 /* Library includes. */
 #include "stm32f10x.h"
 //#include "timer.h"
@@ -52,6 +51,14 @@ void TIM2_IRQHandler( void );
 
 /* Stores the value of the maximum recorded jitter between interrupts. */
 volatile unsigned portSHORT usMaxJitter = 0;
+
+volatile unsigned long ulUptimeMs = 0;
+
+void vApplicationTickHook( void )
+{
+    ulUptimeMs += 1000 / configTICK_RATE_HZ;
+}
+
 void vSetupTimerTest( void )
 {
     unsigned long ulFrequency;
@@ -109,18 +116,6 @@ void vSetupTimerTest( void )
 
 
 /*-----------------------------------------------------------*/
-char buf[50];
-void TIM3_IRQHandler( void )
-{
-    unsigned portBASE_TYPE xStatus, xHPTW = pdFALSE;
-
-    //
-//    printf("%u\r\n", TIM2->CNT);
-    //
-    TIM_ClearITPendingBit( TIM3, TIM_IT_Update );
-    
-}
-
 void vTimerSetupTask( void * pvParameters)
 {
     
@@ -15,4 +15,9 @@
 #define SetTIM3Duty( val )    TIM3->CCR3 = val 
 void vTimerSetupTask( void * pvParameters);
 
+// Milliseconds since the scheduler started. A single aligned word, so it
+// can be read from any context, including interrupts above
+// configMAX_SYSCALL_INTERRUPT_PRIORITY.
+extern volatile unsigned long ulUptimeMs;
+
 #endif
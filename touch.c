@@ -14,10 +14,17 @@
 #include "task.h"
 #include "lcd.h"
 #include "menu.h"
-#include "console.h"
 #include "speaker.h"
 #include "timer.h"
 #include "crane.h"
+#include "heater.h"
+#include "brew.h"
+#include "ds1820.h"
+#include "fmt.h"
+#include "spibus.h"
+
+#define LOG_MODULE LOG_MOD_TOUCH
+#include "log.h"
 
 
 #define CH_X  0xd0//0x90
@@ -166,7 +173,7 @@ void Touch_Initializtion()
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
     GPIO_Init(GPIOB, &GPIO_InitStructure);
     
-    printf("Touch Hardware Initialised!\r\n");
+    fmt_printf("Touch Hardware Initialised!\r\n");
 
 }
 
@@ -215,7 +222,7 @@ int16_t  Touch_MeasurementX(void)
     for (i=0;i<8;i++)
     {
         p+=Touch_GetPhyY();
-        //printf("in y\r\n");
+        LOG_DEBUG("in y\r\n");
         SPI_delay(1000);
     }
     p>>=3;
@@ -249,36 +256,22 @@ u16  Touch_GetPhyY(void)
     return (Touch_Read());
 }
 
-static void led_on(unsigned char button_down)
-{
-	if (button_down)     GPIO_WriteBit( GPIOC, GPIO_Pin_7, 1 );
-}
-static void led_off(unsigned char button_down)
-{
-	if (button_down)     GPIO_WriteBit( GPIOC, GPIO_Pin_7, 0 );
-}
-static void led_pulse(unsigned char button_down)
-{
-	GPIO_WriteBit( GPIOC, GPIO_Pin_7, button_down );
-}
-
-
 struct menu manual_menu[] =
 {
-    {"Manual Crane",   NULL, NULL, NULL},
+    {"Manual Crane",   NULL, manual_crane_applet, NULL, manual_crane_key},
     {"Beep",     NULL,     NULL, NULL}, 
-    {"Man_6",    NULL,     NULL, NULL},
-    {"Led On",   NULL,     NULL, led_on},
-    {"Led Off",  NULL,     NULL, led_off},
-    {"Led Pulse",NULL,     NULL, led_pulse},
+    {"Crane Faults", NULL, crane_faults_applet, NULL, crane_faults_key},
+    {"Sensor Faults", NULL, ds1820_faults_applet, NULL, ds1820_faults_key},
+    {"HLT Autotune", NULL, heater_autotune_applet, NULL, heater_autotune_key},
+    {"Power",        NULL, heater_power_applet, NULL, heater_power_key},
     {NULL, NULL, NULL, NULL}
 };
 
 struct menu main_menu[] =
 {
 	{"Settings",          NULL,             NULL,      NULL, NULL},
-	{"Brew Start",        NULL,             NULL,            NULL, NULL},
-	{"Brew Resume",       NULL,             NULL,           NULL, NULL},
+	{"Brew Start",        NULL,             brew_start_applet,  NULL, brew_key},
+	{"Brew Resume",       NULL,             brew_resume_applet, NULL, brew_key},
 	{"Diagnostics",       manual_menu,        NULL,      NULL, NULL},
 	{NULL, NULL, NULL, NULL}
 };
@@ -286,9 +279,11 @@ struct menu main_menu[] =
 
 void vTouchTask( void *pvParameters ) 
 {
-    printf("Touch start\r\n");
+    fmt_printf("Touch start\r\n");
 
+    spibus_take(SPIBUS_TOUCH);
     Touch_Initializtion();
+    spibus_give();
     unsigned int x = 0, y = 0, beep = TOUCH_BEEP; // current x,y value
  
     lcd_clear(0);
@@ -300,11 +295,13 @@ void vTouchTask( void *pvParameters )
     {
 	int x,y;
 
-        //measure x,y
+        //measure x,y, the flash shares the pins
+        spibus_take(SPIBUS_TOUCH);
         x = Touch_MeasurementX(); 
         y = Touch_MeasurementY();
+        spibus_give();
 
-	//printf("x %d y %d\r\n", x, y);
+	LOG_DEBUG("x %d y %d\r\n", x, y);
 
 	if (x >=0 && x < 320 && y >= 0 && y < 240)
 	{